@@ -0,0 +1,206 @@
+# coding=utf-8
+#
+# stream_bench.py - stream the Resources/gcode corpus into g2core as fast as it will accept it,
+# and record how long each line takes to be acknowledged.
+#
+# Meant for host builds with XIO_HAS_HOST_SOCKET=1, but a serial port works as well:
+#
+#   python3 stream_bench.py                              # all of ../gcode/*.h over /tmp/g2core.sock
+#   python3 stream_bench.py --tty /dev/ttyACM0 ../gcode/gcode_braid2d.h
+#   python3 stream_bench.py --window 8 --repeat 5 --csv latency.csv
+#
+# Flow control is line mode: at most --window lines are outstanding. Every JSON response
+# ({"r":...}) acknowledges the oldest outstanding line. Status reports and exception reports are
+# counted but otherwise ignored. The controller is put in JSON mode ({"ej":1}) first.
+
+import argparse
+import glob
+import os
+import re
+import select
+import socket
+import sys
+import termios
+import time
+import tty
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+DEFAULT_CORPUS = os.path.join(HERE, '..', 'gcode', '*.h')
+
+
+def load_corpus_file(filename):
+    """Return the G-code lines held in a 'const char PROGMEM gcode_file[] = "...";' header."""
+    with open(filename) as f:
+        text = f.read()
+    match = re.search(r'=\s*"(.*)"\s*;', text, re.S)
+    if not match:
+        return []
+    body = match.group(1).replace('\\\n', '')           # line continuations
+    body = body.replace('\\n', '\n').replace('\\"', '"').replace('\\\\', '\\')
+    return [line.strip() for line in body.split('\n') if line.strip()]
+
+
+class SocketLink(object):
+    def __init__(self, path):
+        self.sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        self.sock.connect(path)
+        self.sock.setblocking(False)
+
+    def fileno(self):
+        return self.sock.fileno()
+
+    def write(self, data):
+        self.sock.sendall(data)
+
+    def read(self):
+        try:
+            return self.sock.recv(4096)
+        except BlockingIOError:
+            return b''
+
+    def close(self):
+        self.sock.close()
+
+
+class TTYLink(object):
+    def __init__(self, path):
+        self.fd = os.open(path, os.O_RDWR | os.O_NOCTTY | os.O_NONBLOCK)
+        tty.setraw(self.fd)
+        attrs = termios.tcgetattr(self.fd)
+        attrs[2] |= termios.HUPCL                           # drop DTR on close
+        termios.tcsetattr(self.fd, termios.TCSANOW, attrs)
+
+    def fileno(self):
+        return self.fd
+
+    def write(self, data):
+        while data:
+            try:
+                data = data[os.write(self.fd, data):]
+            except BlockingIOError:
+                select.select([], [self.fd], [])
+
+    def read(self):
+        try:
+            return os.read(self.fd, 4096)
+        except BlockingIOError:
+            return b''
+
+    def close(self):
+        os.close(self.fd)
+
+
+class Bench(object):
+    def __init__(self, link, window, timeout):
+        self.link = link
+        self.window = window
+        self.timeout = timeout
+        self.rx = b''
+        self.outstanding = []       # (line, send time)
+        self.latencies = []         # (line, seconds)
+        self.errors = 0
+        self.status_reports = 0
+        self.exceptions = 0
+        self.bytes_sent = 0
+
+    def send(self, line):
+        data = (line + '\n').encode('ascii')
+        self.link.write(data)
+        self.bytes_sent += len(data)
+        self.outstanding.append((line, time.perf_counter()))
+
+    def poll(self, wait):
+        """Read whatever has arrived and match responses to outstanding lines."""
+        ready, _, _ = select.select([self.link], [], [], wait)
+        if not ready:
+            return False
+        now = time.perf_counter()
+        self.rx += self.link.read()
+        while b'\n' in self.rx:
+            response, self.rx = self.rx.split(b'\n', 1)
+            response = response.strip()
+            if response.startswith(b'{"r":'):
+                if self.outstanding:
+                    line, sent = self.outstanding.pop(0)
+                    self.latencies.append((line, now - sent))
+                footer = re.search(rb'"f":\[\d+,(\d+)', response)
+                if footer and int(footer.group(1)) != 0:
+                    self.errors += 1
+            elif response.startswith(b'{"sr":'):
+                self.status_reports += 1
+            elif response.startswith(b'{"er":'):
+                self.exceptions += 1
+        return True
+
+    def run(self, lines):
+        for line in lines:
+            while len(self.outstanding) >= self.window:
+                self._wait()
+            self.send(line)
+            self.poll(0)
+        while self.outstanding:
+            self._wait()
+
+    def _wait(self):
+        if not self.poll(self.timeout):
+            raise RuntimeError('no response for %.1fs - %d lines outstanding, oldest: %s'
+                               % (self.timeout, len(self.outstanding), self.outstanding[0][0]))
+
+
+def percentile(values, fraction):
+    index = min(len(values) - 1, int(round(fraction * (len(values) - 1))))
+    return values[index]
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Stream G-code into g2core and measure per-line ack latency')
+    parser.add_argument('files', nargs='*', help='corpus headers (default: Resources/gcode/*.h)')
+    parser.add_argument('--socket', default='/tmp/g2core.sock', help='Unix-domain socket of a host build')
+    parser.add_argument('--tty', help='serial device to use instead of the socket')
+    parser.add_argument('--window', type=int, default=4, help='lines outstanding at once (default 4)')
+    parser.add_argument('--repeat', type=int, default=1, help='times to stream the corpus')
+    parser.add_argument('--timeout', type=float, default=30.0, help='seconds to wait for an ack')
+    parser.add_argument('--csv', help='write every line latency to this file')
+    args = parser.parse_args()
+
+    files = args.files or sorted(glob.glob(DEFAULT_CORPUS))
+    lines = []
+    for filename in files:
+        lines.extend(load_corpus_file(filename))
+    if not lines:
+        sys.exit('no G-code found in %s' % ', '.join(files))
+
+    link = TTYLink(args.tty) if args.tty else SocketLink(args.socket)
+    bench = Bench(link, args.window, args.timeout)
+    try:
+        bench.send('{"ej":1}')
+        bench.run([])                                       # wait for JSON mode before timing
+        bench.latencies = []
+        bench.bytes_sent = 0
+
+        start = time.perf_counter()
+        for _ in range(args.repeat):
+            bench.run(lines)
+        elapsed = time.perf_counter() - start
+    finally:
+        link.close()
+
+    latencies = sorted(latency for _, latency in bench.latencies)
+    print('files:          %d' % len(files))
+    print('lines:          %d in %.3fs (%.0f lines/s, %.0f bytes/s)'
+          % (len(latencies), elapsed, len(latencies) / elapsed, bench.bytes_sent / elapsed))
+    print('window:         %d' % args.window)
+    print('latency ms:     p50 %.3f  p90 %.3f  p99 %.3f  max %.3f'
+          % tuple(1000.0 * percentile(latencies, f) for f in (0.50, 0.90, 0.99, 1.0)))
+    print('errors:         %d' % bench.errors)
+    print('status reports: %d   exceptions: %d' % (bench.status_reports, bench.exceptions))
+
+    if args.csv:
+        with open(args.csv, 'w') as f:
+            f.write('line,latency_ms\n')
+            for line, latency in bench.latencies:
+                f.write('"%s",%.3f\n' % (line.replace('"', '""'), 1000.0 * latency))
+
+
+if __name__ == '__main__':
+    main()
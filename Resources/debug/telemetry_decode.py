@@ -0,0 +1,111 @@
+# coding=utf-8
+#
+# telemetry_decode.py - decode the binary motion telemetry stream (see g2core/telemetry.h) to CSV.
+#
+#   python3 telemetry_decode.py --tty /dev/ttyACM1 > motion.csv     # read a live channel
+#   python3 telemetry_decode.py capture.bin > motion.csv             # or a capture file
+#
+# --axes and --motors must match the build (AXES and MOTORS). Frames with a bad checksum are
+# skipped by resynchronizing on the next sync byte. Sequence gaps (samples dropped in the
+# controller's ring) are counted and reported on stderr.
+
+import argparse
+import os
+import struct
+import sys
+import termios
+import tty
+
+SYNC = 0xA5
+POSITION, VELOCITY, FOLLOWING_ERROR, LINE, SECTION = 0x01, 0x02, 0x04, 0x08, 0x10
+
+
+def field_layout(fields, axes, motors):
+    """Return the struct format and column names of the fields part of a frame."""
+    fmt, names = '<', []
+    if fields & POSITION:
+        fmt += 'f' * axes
+        names += ['pos%d' % a for a in range(axes)]
+    if fields & VELOCITY:
+        fmt += 'f'
+        names += ['vel']
+    if fields & FOLLOWING_ERROR:
+        fmt += 'f' * motors
+        names += ['ferr%d' % (m + 1) for m in range(motors)]
+    if fields & LINE:
+        fmt += 'i'
+        names += ['line']
+    if fields & SECTION:
+        fmt += 'B'
+        names += ['section']
+    return fmt, names
+
+
+def frames(data, axes, motors, stats):
+    """Yield (fields, sequence, time_us, values) for each good frame in data."""
+    i = 0
+    while i + 9 <= len(data):
+        if data[i] != SYNC:
+            i += 1
+            continue
+        fields = data[i + 1]
+        fmt, _ = field_layout(fields, axes, motors)
+        length = 8 + struct.calcsize(fmt) + 1
+        if i + length > len(data):
+            break
+        frame = data[i:i + length]
+        checksum = 0
+        for b in frame[:-1]:
+            checksum ^= b
+        if checksum != frame[-1]:
+            stats['bad'] += 1
+            i += 1
+            continue
+        sequence, time_us = struct.unpack_from('<HI', frame, 2)
+        yield fields, sequence, time_us, struct.unpack_from(fmt, frame, 8)
+        i += length
+    stats['rest'] = data[i:]
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Decode g2core binary telemetry frames to CSV')
+    parser.add_argument('file', nargs='?', help='capture file (default: --tty, or stdin)')
+    parser.add_argument('--tty', help='serial device of the telemetry channel')
+    parser.add_argument('--axes', type=int, default=6, help='AXES of the build (default 6)')
+    parser.add_argument('--motors', type=int, default=6, help='MOTORS of the build (default 6)')
+    args = parser.parse_args()
+
+    if args.tty:
+        fd = os.open(args.tty, os.O_RDONLY | os.O_NOCTTY)
+        tty.setraw(fd)
+        termios.tcflush(fd, termios.TCIFLUSH)
+        read = lambda: os.read(fd, 4096)
+    else:
+        stream = open(args.file, 'rb') if args.file else sys.stdin.buffer
+        read = lambda: stream.read(4096)
+
+    stats = {'bad': 0, 'gaps': 0, 'frames': 0, 'rest': b''}
+    header_fields = None
+    last_sequence = None
+    try:
+        while True:
+            chunk = read()
+            if not chunk:
+                break
+            for fields, sequence, time_us, values in frames(stats['rest'] + chunk, args.axes, args.motors, stats):
+                if fields != header_fields:
+                    header_fields = fields
+                    print(','.join(['seq', 'time_us'] + field_layout(fields, args.axes, args.motors)[1]))
+                if (last_sequence is not None) and (sequence != ((last_sequence + 1) & 0xFFFF)):
+                    stats['gaps'] += 1
+                last_sequence = sequence
+                stats['frames'] += 1
+                print(','.join([str(sequence), str(time_us)] + ['%g' % v for v in values]))
+    except KeyboardInterrupt:
+        pass
+    sys.stderr.write('frames: %d  bad checksums: %d  sequence gaps: %d\n'
+                     % (stats['frames'], stats['bad'], stats['gaps']))
+
+
+if __name__ == '__main__':
+    main()
@@ -33,11 +33,14 @@
 #include "controller.h"
 #include "text_parser.h"
 #include "board_xio.h"
+#include "persistence.h"
 
 #include "MotateUtilities.h"
 #include "MotateUniqueID.h"
 #include "MotatePower.h"
 
+#include "sam.h"
+
 /*
  * hardware_init() - lowest level hardware init
  */
@@ -89,6 +92,132 @@ void _get_id(char *id)
 
 /***** END OF SYSTEM FUNCTIONS *****/
 
+/***********************************************************************************
+ * NVM DEVICE
+ * The settings log (see persistence.h) in the top NVM_SECTORS * NVM_SECTOR_SIZE bytes
+ * of flash bank 1 - a single 16K lock region with the default sizes
+ ***********************************************************************************/
+/*
+ *  The EEFC has no sector erase. A sector is erased a page at a time by erase-and-write
+ *  of an all 0xFF page. Program loads the page latch with 0xFF around the new bytes and
+ *  uses write-page, which can only clear bits - the same as the host file device.
+ *
+ *  Flash can't be read while it is being written, so the command is issued and waited
+ *  for from RAM with interrupts off (in case the vectors or handlers sit in bank 1).
+ *  That holds interrupts off for a few ms per page, which is why persistence only
+ *  writes when there is no motion.
+ */
+
+#define NVM_BASE        (IFLASH1_ADDR + IFLASH1_SIZE - (NVM_SECTORS * NVM_SECTOR_SIZE))
+#define NVM_SIZE        (NVM_SECTORS * NVM_SECTOR_SIZE)
+#define EEFC_FKEY       0x5A
+#define EEFC_WP         0x01        // write page
+#define EEFC_EWP        0x03        // erase page and write page
+#define EEFC_CLB        0x09        // clear lock bit
+
+extern uint32_t _etext;             // end of the flash image, from the linker script
+extern uint32_t _srelocate;
+extern uint32_t _erelocate;
+
+__attribute__((section(".ramfunc"), noinline, long_call))
+static uint32_t _eefc_command(uint8_t command, uint16_t page)
+{
+    EFC1->EEFC_FCR = EEFC_FCR_FKEY(EEFC_FKEY) | EEFC_FCR_FARG(page) | EEFC_FCR_FCMD(command);
+    uint32_t status;
+    while (((status = EFC1->EEFC_FSR) & EEFC_FSR_FRDY) == 0);
+    return (status);
+}
+
+static stat_t _flash_command(uint8_t command, uint32_t address)
+{
+    uint16_t page = (NVM_BASE - IFLASH1_ADDR + address) / IFLASH1_PAGE_SIZE;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uint32_t status = _eefc_command(command, page);
+    __set_PRIMASK(primask);
+    return ((status & (EEFC_FSR_FCMDE | EEFC_FSR_FLOCKE)) ? STAT_PERSISTENCE_ERROR : STAT_OK);
+}
+
+/*
+ * _load_latch() - fill the page latch for the page at address: 0xFF except data at offset
+ *
+ *  The latch is loaded by writing 32 bit words anywhere in the page's address range.
+ */
+
+static void _load_latch(uint32_t address, uint16_t offset, const uint8_t *data, uint16_t length)
+{
+    volatile uint32_t *latch = (volatile uint32_t *)(NVM_BASE + address);
+    for (uint16_t i=0; i<IFLASH1_PAGE_SIZE; i+=4) {
+        uint32_t word = 0xFFFFFFFF;
+        for (uint8_t b=0; b<4; b++) {
+            if ((i+b >= offset) && (i+b < offset+length)) {
+                ((uint8_t *)&word)[b] = data[i+b-offset];
+            }
+        }
+        latch[i/4] = word;
+    }
+    __DSB();
+}
+
+stat_t nvm_device_open()
+{
+    uint32_t image_end = (uint32_t)&_etext + ((uint32_t)&_erelocate - (uint32_t)&_srelocate);
+    if (image_end > NVM_BASE) {                     // the firmware has grown into the log
+        return (STAT_PERSISTENCE_ERROR);
+    }
+    for (uint32_t address=0; address<NVM_SIZE; address+=IFLASH1_LOCK_REGION_SIZE) {
+        ritorno(_flash_command(EEFC_CLB, address));
+    }
+    return (STAT_OK);
+}
+
+stat_t nvm_device_read(uint32_t address, void *data, uint16_t length)
+{
+    if ((address + length) > NVM_SIZE) {
+        memset(data, 0xFF, length);
+        return (STAT_PERSISTENCE_ERROR);
+    }
+    memcpy(data, (const void *)(NVM_BASE + address), length);
+    return (STAT_OK);
+}
+
+stat_t nvm_device_program(uint32_t address, const void *data, uint16_t length)
+{
+    if ((address + length) > NVM_SIZE) {
+        return (STAT_PERSISTENCE_ERROR);
+    }
+    const uint8_t *bytes = (const uint8_t *)data;
+    while (length > 0) {                            // one page at a time
+        uint16_t offset = address % IFLASH1_PAGE_SIZE;
+        uint16_t count = IFLASH1_PAGE_SIZE - offset;
+        if (count > length) {
+            count = length;
+        }
+        _load_latch(address - offset, offset, bytes, count);
+        ritorno(_flash_command(EEFC_WP, address));
+        address += count;
+        bytes += count;
+        length -= count;
+    }
+    return (STAT_OK);
+}
+
+stat_t nvm_device_erase(uint8_t sector)
+{
+    if (sector >= NVM_SECTORS) {
+        return (STAT_PERSISTENCE_ERROR);
+    }
+    uint32_t address = (uint32_t)sector * NVM_SECTOR_SIZE;
+    for (uint32_t page=0; page<(NVM_SECTOR_SIZE / IFLASH1_PAGE_SIZE); page++) {
+        _load_latch(address, 0, NULL, 0);
+        ritorno(_flash_command(EEFC_EWP, address));
+        address += IFLASH1_PAGE_SIZE;
+    }
+    return (STAT_OK);
+}
+
+/***** END OF NVM DEVICE *****/
+
 /***********************************************************************************
  * CONFIGURATION AND INTERFACE FUNCTIONS
  * Functions to get and set variables from the cfgArray table
@@ -107,6 +107,10 @@ using Motate::OutputPin;
 #define FREQUENCY_DWELL		1000UL
 #define FREQUENCY_SGI		200000UL		// 200,000 Hz means software interrupts will fire 5 uSec after being called
 
+/**** Settings NVM ****/
+
+#define HAS_NVM_DEVICE              // settings log in the top of flash bank 1 - see hardware.cpp
+
 /**** Motate Definitions ****/
 
 // Timer definitions. See stepper.h and other headers for setup
@@ -1353,7 +1353,7 @@ stat_t cm_select_tool(const uint8_t tool_select)
         return (STAT_T_WORD_IS_INVALID);
     }
     float value[] = { (float)tool_select };
-    mp_queue_command(_exec_select_tool, value, nullptr);
+    mp_defer_command(_exec_select_tool, value, nullptr);      // T doesn't need motion to stop - M6 does
     return (STAT_OK);
 }
 
@@ -1658,6 +1658,7 @@ void cm_optional_program_stop()
 
 void cm_program_end()
 {
+    cm->gm.spindle_control = SPINDLE_OFF;                   // laser mode runs S and M3/M4 from the model
     float value[] = { (float)MACHINE_PROGRAM_END };
     mp_queue_command(_exec_program_finalize, value, nullptr);
 }
@@ -1949,7 +1950,19 @@ static const char msg_g01[] = "G1  - linear feed";
 static const char msg_g02[] = "G2  - clockwise arc feed";
 static const char msg_g03[] = "G3  - counter clockwise arc feed";
 static const char msg_g80[] = "G80 - cancel motion mode (none active)";
-static const char *const msg_momo[] = { msg_g00, msg_g01, msg_g02, msg_g03, msg_g80 };
+static const char msg_g382[] = "G38.2 - straight probe";
+static const char msg_g81[] = "G81 - drilling cycle";
+static const char msg_g82[] = "G82 - drilling cycle with dwell";
+static const char msg_g83[] = "G83 - peck drilling cycle";
+static const char msg_g84[] = "G84 - tapping cycle";
+static const char msg_g85[] = "G85 - boring cycle, feed out";
+static const char msg_g86[] = "G86 - boring cycle, spindle stop, rapid out";
+static const char msg_g87[] = "G87 - back boring cycle";
+static const char msg_g88[] = "G88 - boring cycle, spindle stop, manual out";
+static const char msg_g89[] = "G89 - boring cycle, dwell, feed out";
+static const char *const msg_momo[] = { msg_g00, msg_g01, msg_g02, msg_g03, msg_g80, msg_g382,
+                                        msg_g81, msg_g82, msg_g83, msg_g84, msg_g85,
+                                        msg_g86, msg_g87, msg_g88, msg_g89 };
 
 static const char msg_g17[] = "G17 - XY plane";
 static const char msg_g18[] = "G18 - XZ plane";
@@ -514,6 +514,25 @@ stat_t cm_probing_cycle_callback(void);                         // G38.x main lo
 stat_t cm_get_prbr(nvObj_t *nv);                                // enable/disable probe report
 stat_t cm_set_prbr(nvObj_t *nv);
 
+// Canned cycles (cycle_canned.cpp)
+stat_t cm_set_retract_mode(const uint8_t mode);                 // G98, G99
+stat_t cm_canned_cycle_feed(const float target[], const bool target_f[],    // G81-G89 - hole position and depth
+                            const float R_word, const bool R_word_f,        // R plane
+                            const float Q_word, const bool Q_word_f,        // peck depth
+                            const float P_word, const bool P_word_f,        // dwell at the bottom
+                            const uint8_t L_word, const bool L_word_f,      // repeats
+                            const bool modal_g1_f,                          // modal group flag for motion group
+                            const cmMotionMode motion_mode);                // defined motion mode
+stat_t cm_canned_cycle_callback(void);                          // G81-G89 main loop callback
+void cm_abort_canned_cycle(void);
+
+// Laser raster rows (cycle_raster.cpp)
+stat_t cm_raster_feed(const float target[], const bool flags[], char *active_comment);     // G1 with a raster row
+stat_t cm_raster_callback(void);                                // raster row main loop callback
+void cm_abort_raster(void);
+void cm_raster_start_block(const uint8_t row);                  // runtime: called as each aline starts
+float cm_raster_power(const uint8_t row, const float from[], const float to[]);  // runtime: pixel power over a segment
+
 // Jogging cycle (cycle_jogging.cpp)
 stat_t cm_jogging_cycle_callback(void);                         // jogging cycle main loop
 stat_t cm_jogging_cycle_start(uint8_t axis);                    // {"jogx":-100.3}
@@ -42,6 +42,7 @@
 #include "xio.h"
 
 static void _set_defa(nvObj_t *nv, bool print);
+static void _set_persisted(nvObj_t *nv);
 
 /***********************************************************************************
  **** STRUCTURE ALLOCATIONS ********************************************************
@@ -83,7 +84,7 @@ void nv_print(nvObj_t *nv)
     if (nv->index >= nv_index_max()) {
         return;
     }
-    ((fptrCmd)cfgArray[nv->index].print)(nv);
+    cfgArray[nv->index].print(nv);
 }
 
 stat_t nv_persist(nvObj_t *nv)
@@ -113,19 +114,26 @@ void config_init()
 {
     nvObj_t *nv = nv_reset_nv_list();
     config_init_assertions();
+    nv_index_init();
     js.json_mode = JSON_MODE;                    // initial value until persistence is read
-    _set_defa(nv, false);
+    if (persistence_is_loaded()) {
+        _set_persisted(nv);
+    } else {
+        _set_defa(nv, false);
+    }
     rpt_print_loading_configs_message();
 }
 
 /*
  * set_defaults() - reset persistence with default values for machine profile
  * _set_defa() - helper function and called directly from config_init()
+ * _set_persisted() - load persisted values, and defaults for everything else not persisted
  */
 
 static void _set_defa(nvObj_t *nv, bool print)
 {
     cm_set_units_mode(MILLIMETERS);             // must do inits in MM mode
+    persistence_reset();                        // every persisted value is written again below
     for (nv->index=0; nv_index_is_single(nv->index); nv->index++) {
         if (cfgArray[nv->index].flags & F_INITIALIZE) {
             if ((cfgArray[nv->index].flags & TYPE_INTEGER) ||
@@ -141,12 +149,37 @@ static void _set_defa(nvObj_t *nv, bool print)
             }            
         }
     }
-    sr_init_status_report();                    // reset status reports
+    sr_init_status_report(true);                // reset status reports
     if (print) {
         rpt_print_initializing_message();       // don't start TX until all the NVM persistence is done
     }
 }
 
+static void _set_persisted(nvObj_t *nv)
+{
+    index_t sr_start = nv_get_index((const char *)"", (const char *)"se00");
+    bool sr_persisted = false;
+
+    cm_set_units_mode(MILLIMETERS);             // values are persisted in internal units
+    for (nv->index=0; nv_index_is_single(nv->index); nv->index++) {
+        if ((cfgArray[nv->index].flags & F_PERSIST) && (read_persistent_value(nv) == STAT_OK)) {
+            sr_persisted |= (nv->index == sr_start);
+        } else if (cfgArray[nv->index].flags & F_INITIALIZE) {
+            if ((cfgArray[nv->index].flags & TYPE_INTEGER) ||
+                (cfgArray[nv->index].flags & TYPE_BOOLEAN)) {
+                nv->value_int = cfgArray[nv->index].def_value;
+            } else {
+                nv->value_flt = cfgArray[nv->index].def_value;
+            }
+        } else {
+            continue;
+        }
+        strncpy(nv->token, cfgArray[nv->index].token, TOKEN_LEN);
+        cfgArray[nv->index].set(nv);
+    }
+    sr_init_status_report(!sr_persisted);       // default status report if there isn't one in the log
+}
+
 stat_t set_defaults(nvObj_t *nv)
 {
     // failsafe. nv->value_int must be true or no action occurs
@@ -313,7 +346,10 @@ stat_t set_data(nvObj_t *nv)
  *  to a TYPE_PARENT. The group field of the first nvOBJ is left nul - as the group
  *  field refers to a parent group, which this group has none.
  *
- *  All subsequent nvObjs in the body will be populated with their values.
+ *  The children are populated one at a time in the second nvObj and printed as they
+ *  are produced (see nv_stream_begin()), so the response is complete when get_grp()
+ *  returns STAT_COMPLETE. When streaming is off (e.g. a get run from the exec) the
+ *  children fill the nv list instead, as far as it goes, and get_grp() returns STAT_OK.
  *  The token field will be populated as will the parent name in the group field.
  *
  *  The sys group is an exception where the children carry a blank group field, even though
@@ -328,12 +364,27 @@ stat_t get_grp(nvObj_t *nv)
     nv_reset_nv_list();                             // start with a clean list
     strcpy(nv->token, group);                       // re-write the group string
     nv->valuetype = TYPE_PARENT;                    // make first object the parent
+    if (!nv_stream_begin(nv)) {
+        for (index_t i=0; nv_index_is_single(i); i++) {
+            if (strcmp(group, cfgArray[i].group) != 0) { continue; }
+            if ((nv = nv->nx) == NULL) { break; }   // the list is full - the rest of the group is dropped
+            nv->index = i;
+            nv_get_nvObj(nv);
+        }
+        return (STAT_OK);
+    }
+
+    nvObj_t *child = nv->nx;                        // one child at a time - no limit on group size
+    uint16_t string_wp = nvStr.wp;
     for (index_t i=0; nv_index_is_single(i); i++) {
         if (strcmp(group, cfgArray[i].group) != 0) { continue; }
-        (++nv)->index = i;
-        nv_get_nvObj(nv);
+        child->index = i;
+        nv_get_nvObj(child);
+        nv_stream_object(child);
+        nvStr.wp = string_wp;                       // the child's strings have been sent
     }
-    return (STAT_OK);
+    nv_stream_end(STAT_OK);
+    return (STAT_COMPLETE);                         // the response has already been printed
 }
 
 /*
@@ -372,19 +423,45 @@ stat_t set_grp(nvObj_t *nv)
  * nvObj helper functions and other low-level nv helpers
  */
 
-/* nv_get_index() - get index from mnenonic token + group
+/* nv_index_init() - sort the token index used by nv_get_index()
+ * nv_get_index() - get index from mnenonic token + group
+ *
+ * nv_get_index() is the most expensive routine in the whole config. Tokens match
+ * on their first NV_TOKEN_MATCH_LEN characters. nv_index_init() sorts the cfgArray
+ * indexes by token once, at config_init(), so lookups are a binary search - about
+ * 11 string compares instead of a scan of the whole table. Equal tokens are ordered
+ * by index so the first entry in cfgArray still wins, as it did with the scan.
  *
- * nv_get_index() is the most expensive routine in the whole config. It does a
- * linear table scan of the strings, which of course could be further
- * optimized with indexes or hashing.
+ * Anything that looks up a token before config_init() gets the original linear scan.
  */
-index_t nv_get_index(const char *group, const char *token)
+#define NV_TOKEN_MATCH_LEN 5
+
+static bool nv_index_ready = false;
+
+static int _token_compare(const void *a, const void *b)
 {
-    char c;
-    char str[TOKEN_LEN + GROUP_LEN+1];    // should actually never be more than TOKEN_LEN+1
-    strncpy(str, group, GROUP_LEN+1);
-    strncat(str, token, TOKEN_LEN+1);
+    index_t i = *(const index_t *)a;
+    index_t j = *(const index_t *)b;
+    int cmp = strncmp(cfgArray[i].token, cfgArray[j].token, NV_TOKEN_MATCH_LEN);
+    if (cmp != 0) {
+        return (cmp);
+    }
+    return ((i < j) ? -1 : 1);                  // i != j, qsort never compares an element to itself
+}
 
+void nv_index_init()
+{
+    index_t index_max = nv_index_max();
+    for (index_t i=0; i < index_max; i++) {
+        nv_token_index[i] = i;
+    }
+    qsort(nv_token_index, index_max, sizeof(index_t), _token_compare);
+    nv_index_ready = true;
+}
+
+static index_t _nv_scan_index(const char *str)
+{
+    char c;
     index_t i;
     index_t index_max = nv_index_max();
 
@@ -403,6 +480,32 @@ index_t nv_get_index(const char *group, const char *token)
     return (NO_MATCH);
 }
 
+index_t nv_get_index(const char *group, const char *token)
+{
+    char str[TOKEN_LEN + GROUP_LEN+1];    // should actually never be more than TOKEN_LEN+1
+    strncpy(str, group, GROUP_LEN+1);
+    strncat(str, token, TOKEN_LEN+1);
+
+    if (!nv_index_ready) {
+        return (_nv_scan_index(str));
+    }
+
+    index_t low = 0;                            // lower bound: first entry not less than str
+    index_t high = nv_index_max();
+    while (low < high) {
+        index_t mid = low + (high - low) / 2;
+        if (strncmp(cfgArray[nv_token_index[mid]].token, str, NV_TOKEN_MATCH_LEN) < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    if ((low < nv_index_max()) && (strncmp(cfgArray[nv_token_index[low]].token, str, NV_TOKEN_MATCH_LEN) == 0)) {
+        return (nv_token_index[low]);
+    }
+    return (NO_MATCH);
+}
+
 /*
  * nv_get_type() - returns command type as a NV_TYPE enum
  *
@@ -696,6 +799,57 @@ void nv_print_list(stat_t status, uint8_t text_flags, uint8_t json_flags)
     }
 }
 
+/**** nv_stream_begin(), nv_stream_object(), nv_stream_end() - print as you go ****
+ *
+ *  For a parent with an unbounded number of children, e.g. a group. Instead of building
+ *  the whole body and calling nv_print_list(), call nv_stream_begin() with the parent,
+ *  nv_stream_object() for each child as soon as it is populated (the nvObj can then be
+ *  reused), and nv_stream_end() when done. Text mode prints each child as a formatted
+ *  line, JSON mode writes a response with the children in the parent object.
+ *
+ *  Streaming writes to xio, so it is only allowed while the main loop is producing the
+ *  response to a command line - the dispatcher turns it on with nv_stream_enable() and
+ *  the exec-level parser turns it off. nv_stream_begin() returns false when streaming is
+ *  off, and the caller must fill the nv list instead (or refuse, if it can't).
+ */
+
+static bool nv_streaming = false;
+
+bool nv_stream_enable(bool enable)              // returns the previous setting
+{
+    bool was_enabled = nv_streaming;
+    nv_streaming = enable;
+    return (was_enabled);
+}
+
+bool nv_stream_begin(nvObj_t *parent)
+{
+    if (!nv_streaming) {
+        return (false);
+    }
+    if ((js.json_mode == JSON_MODE) || (js.json_mode == MARLIN_COMM_MODE)) {
+        json_stream_begin(parent);
+    }
+    return (true);
+}
+
+void nv_stream_object(nvObj_t *nv)
+{
+    if ((js.json_mode == JSON_MODE) || (js.json_mode == MARLIN_COMM_MODE)) {
+        json_stream_object(nv);
+    } else if ((nv->valuetype != TYPE_PARENT) && (nv->valuetype != TYPE_EMPTY)) {
+        convert_outgoing_float(nv);
+        nv_print(nv);
+    }
+}
+
+void nv_stream_end(stat_t status)
+{
+    if ((js.json_mode == JSON_MODE) || (js.json_mode == MARLIN_COMM_MODE)) {
+        json_stream_end(status);
+    }
+}
+
 /****************************************************************************
  ***** Diagnostics **********************************************************
  ****************************************************************************/
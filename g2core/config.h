@@ -238,6 +238,7 @@ typedef enum {                      // value typing for config and JSON
 #define F_NOSTRIP       0x20        // do not strip the group prefix from the token
 #define F_CONVERT       0x40        // set if unit conversion is required
 #define F_ICONVERT      0x80        // set if unit conversion is required AND value is an inverse quantity
+#define F_VERBATIM      0x100       // JSON string value is taken as sent - no lower casing or whitespace stripping
 
 // Shorthand
 // _n(ull) (used by commands or other case where there is no target data)
@@ -253,6 +254,7 @@ typedef enum {                      // value typing for config and JSON
 
 #define _s0     (TYPE_STRING)
 #define _sn     (TYPE_STRING | F_NOSTRIP)
+#define _sv     (TYPE_STRING | F_VERBATIM)
 
 #define _d0	    (TYPE_DATA)
 #define _dip    (TYPE_DATA | F_INITIALIZE | F_PERSIST)
@@ -320,7 +322,7 @@ typedef struct nvList {
 typedef struct cfgItem {
     char group[GROUP_LEN+1];            // group prefix (with NUL termination)
     char token[TOKEN_LEN+1];            // token - stripped of group prefix (w/NUL termination)
-    uint8_t flags;                      // operations flags - see defines below
+    uint16_t flags;                     // operations flags - see defines below
     int8_t precision;                   // decimal precision for display (JSON)
     fptrPrint print;                    // print binding: aka void (*print)(nvObj_t *nv);
     fptrCmd get;                        // GET binding aka uint8_t (*get)(nvObj_t *nv)
@@ -356,8 +358,10 @@ stat_t nv_persist(nvObj_t *nv);         // main entry point for persistence
 // helpers
 uint8_t nv_get_type(nvObj_t *nv);
 void nv_coerce_types(nvObj_t *nv);
+void nv_index_init(void);
 index_t nv_get_index(const char *group, const char *token);
 index_t nv_index_max(void);             // (see config_app.c)
+extern index_t nv_token_index[];        // (see config_app.c)
 bool nv_index_is_single(index_t index); // (see config_app.c)
 bool nv_index_is_group(index_t index);  // (see config_app.c)
 bool nv_index_lt_groups(index_t index); // (see config_app.c)
@@ -391,6 +395,10 @@ nvObj_t *nv_add_float(const char *token, const float value);
 nvObj_t *nv_add_string(const char *token, const char *string);
 nvObj_t *nv_add_conditional_message(const char *string);
 void nv_print_list(stat_t status, uint8_t text_flags, uint8_t json_flags);
+bool nv_stream_enable(bool enable);
+bool nv_stream_begin(nvObj_t *parent);
+void nv_stream_object(nvObj_t *nv);
+void nv_stream_end(stat_t status);
 
 // application specific helpers and functions (config_app.c)
 
@@ -47,6 +47,9 @@
 #include "util.h"
 #include "help.h"
 #include "xio.h"
+#include "telemetry.h"
+#include "scope.h"
+#include "persistence.h"
 
 /*** structures ***/
 
@@ -567,11 +570,21 @@ const cfgItem_t cfgArray[] = {
     { "he1","he1p", _fip, 3, tx_print_nul, cm_get_heater_p,        cm_set_heater_p,        nullptr, H1_DEFAULT_P },
     { "he1","he1i", _fip, 5, tx_print_nul, cm_get_heater_i,        cm_set_heater_i,        nullptr, H1_DEFAULT_I },
     { "he1","he1d", _fip, 5, tx_print_nul, cm_get_heater_d,        cm_set_heater_d,        nullptr, H1_DEFAULT_D },
+    { "he1","he1tn",_f0,  0, tx_print_nul, cm_get_heater_autotune, cm_set_heater_autotune, nullptr, 0 },
+    { "he1","he1ku",_f0,  3, tx_print_nul, cm_get_heater_ku,       set_ro,                 nullptr, 0 },
+    { "he1","he1tu",_f0,  1, tx_print_nul, cm_get_heater_tu,       set_ro,                 nullptr, 0 },
+    { "he1","he1mm",_bip, 0, tx_print_nul, cm_get_heater_model_enable, cm_set_heater_model_enable, nullptr, H1_DEFAULT_MODEL_ENABLE },
+    { "he1","he1mw",_fip, 1, tx_print_nul, cm_get_heater_model,    cm_set_heater_model,    nullptr, H1_DEFAULT_MODEL_POWER },
+    { "he1","he1mc",_fip, 3, tx_print_nul, cm_get_heater_model,    cm_set_heater_model,    nullptr, H1_DEFAULT_MODEL_CAPACITY },
+    { "he1","he1mh",_fip, 4, tx_print_nul, cm_get_heater_model,    cm_set_heater_model,    nullptr, H1_DEFAULT_MODEL_LOSS },
+    { "he1","he1mf",_fip, 4, tx_print_nul, cm_get_heater_model,    cm_set_heater_model,    nullptr, H1_DEFAULT_MODEL_FAN_LOSS },
+    { "he1","he1me",_fip, 5, tx_print_nul, cm_get_heater_model,    cm_set_heater_model,    nullptr, H1_DEFAULT_MODEL_FILAMENT },
+    { "he1","he1mr",_fip, 3, tx_print_nul, cm_get_heater_model,    cm_set_heater_model,    nullptr, H1_DEFAULT_MODEL_SENSOR },
     { "he1","he1st",_fi,  1, tx_print_nul, cm_get_set_temperature, cm_set_set_temperature, nullptr, 0 },
     { "he1","he1t", _fi,  1, tx_print_nul, cm_get_temperature,     set_ro,                 nullptr, 0 },
     { "he1","he1op",_fi,  3, tx_print_nul, cm_get_heater_output,   set_ro,                 nullptr, 0 },
     { "he1","he1tr",_fi,  3, tx_print_nul, cm_get_thermistor_resistance, set_ro,           nullptr, 0 },
-    { "he1","he1an",_fi,  0, tx_print_nul, cm_get_heater_adc,      set_ro,                 nullptr, 0 },
+    { "he1","he1an",_fi,  1, tx_print_nul, cm_get_heater_adc,      set_ro,                 nullptr, 0 },
     { "he1","he1fp",_fi,  1, tx_print_nul, cm_get_fan_power,       cm_set_fan_power,       nullptr, 0 },
     { "he1","he1fm",_fi,  1, tx_print_nul, cm_get_fan_min_power,   cm_set_fan_min_power,   nullptr, 0 },
     { "he1","he1fl",_fi,  1, tx_print_nul, cm_get_fan_low_temp,    cm_set_fan_low_temp,    nullptr, 0 },
@@ -582,11 +595,21 @@ const cfgItem_t cfgArray[] = {
     { "he2","he2p", _fip, 3, tx_print_nul, cm_get_heater_p,        cm_set_heater_p,        nullptr, H2_DEFAULT_P },
     { "he2","he2i", _fip, 5, tx_print_nul, cm_get_heater_i,        cm_set_heater_i,        nullptr, H2_DEFAULT_I },
     { "he2","he2d", _fip, 5, tx_print_nul, cm_get_heater_d,        cm_set_heater_d,        nullptr, H2_DEFAULT_D },
+    { "he2","he2tn",_f0,  0, tx_print_nul, cm_get_heater_autotune, cm_set_heater_autotune, nullptr, 0 },
+    { "he2","he2ku",_f0,  3, tx_print_nul, cm_get_heater_ku,       set_ro,                 nullptr, 0 },
+    { "he2","he2tu",_f0,  1, tx_print_nul, cm_get_heater_tu,       set_ro,                 nullptr, 0 },
+    { "he2","he2mm",_bip, 0, tx_print_nul, cm_get_heater_model_enable, cm_set_heater_model_enable, nullptr, H2_DEFAULT_MODEL_ENABLE },
+    { "he2","he2mw",_fip, 1, tx_print_nul, cm_get_heater_model,    cm_set_heater_model,    nullptr, H2_DEFAULT_MODEL_POWER },
+    { "he2","he2mc",_fip, 3, tx_print_nul, cm_get_heater_model,    cm_set_heater_model,    nullptr, H2_DEFAULT_MODEL_CAPACITY },
+    { "he2","he2mh",_fip, 4, tx_print_nul, cm_get_heater_model,    cm_set_heater_model,    nullptr, H2_DEFAULT_MODEL_LOSS },
+    { "he2","he2mf",_fip, 4, tx_print_nul, cm_get_heater_model,    cm_set_heater_model,    nullptr, H2_DEFAULT_MODEL_FAN_LOSS },
+    { "he2","he2me",_fip, 5, tx_print_nul, cm_get_heater_model,    cm_set_heater_model,    nullptr, H2_DEFAULT_MODEL_FILAMENT },
+    { "he2","he2mr",_fip, 3, tx_print_nul, cm_get_heater_model,    cm_set_heater_model,    nullptr, H2_DEFAULT_MODEL_SENSOR },
     { "he2","he2st",_fi,  0, tx_print_nul, cm_get_set_temperature, cm_set_set_temperature, nullptr, 0 },
     { "he2","he2t", _fi,  1, tx_print_nul, cm_get_temperature,     set_ro,                 nullptr, 0 },
     { "he2","he2op",_fi,  3, tx_print_nul, cm_get_heater_output,   set_ro,                 nullptr, 0 },
     { "he2","he2tr",_fi,  3, tx_print_nul, cm_get_thermistor_resistance, set_ro,           nullptr, 0 },
-    { "he2","he2an",_fi,  0, tx_print_nul, cm_get_heater_adc,      set_ro,                 nullptr, 0 },
+    { "he2","he2an",_fi,  1, tx_print_nul, cm_get_heater_adc,      set_ro,                 nullptr, 0 },
     { "he2","he2fp",_fi,  1, tx_print_nul, cm_get_fan_power,       cm_set_fan_power,       nullptr, 0 },
     { "he2","he2fm",_fi,  1, tx_print_nul, cm_get_fan_min_power,   cm_set_fan_min_power,   nullptr, 0 },
     { "he2","he2fl",_fi,  1, tx_print_nul, cm_get_fan_low_temp,    cm_set_fan_low_temp,    nullptr, 0 },
@@ -597,11 +620,21 @@ const cfgItem_t cfgArray[] = {
     { "he3","he3p", _fip, 3, tx_print_nul, cm_get_heater_p,        cm_set_heater_p,        nullptr, H3_DEFAULT_P },
     { "he3","he3i", _fip, 5, tx_print_nul, cm_get_heater_i,        cm_set_heater_i,        nullptr, H3_DEFAULT_I },
     { "he3","he3d", _fip, 5, tx_print_nul, cm_get_heater_d,        cm_set_heater_d,        nullptr, H3_DEFAULT_D },
+    { "he3","he3tn",_f0,  0, tx_print_nul, cm_get_heater_autotune, cm_set_heater_autotune, nullptr, 0 },
+    { "he3","he3ku",_f0,  3, tx_print_nul, cm_get_heater_ku,       set_ro,                 nullptr, 0 },
+    { "he3","he3tu",_f0,  1, tx_print_nul, cm_get_heater_tu,       set_ro,                 nullptr, 0 },
+    { "he3","he3mm",_bip, 0, tx_print_nul, cm_get_heater_model_enable, cm_set_heater_model_enable, nullptr, H3_DEFAULT_MODEL_ENABLE },
+    { "he3","he3mw",_fip, 1, tx_print_nul, cm_get_heater_model,    cm_set_heater_model,    nullptr, H3_DEFAULT_MODEL_POWER },
+    { "he3","he3mc",_fip, 3, tx_print_nul, cm_get_heater_model,    cm_set_heater_model,    nullptr, H3_DEFAULT_MODEL_CAPACITY },
+    { "he3","he3mh",_fip, 4, tx_print_nul, cm_get_heater_model,    cm_set_heater_model,    nullptr, H3_DEFAULT_MODEL_LOSS },
+    { "he3","he3mf",_fip, 4, tx_print_nul, cm_get_heater_model,    cm_set_heater_model,    nullptr, H3_DEFAULT_MODEL_FAN_LOSS },
+    { "he3","he3me",_fip, 5, tx_print_nul, cm_get_heater_model,    cm_set_heater_model,    nullptr, H3_DEFAULT_MODEL_FILAMENT },
+    { "he3","he3mr",_fip, 3, tx_print_nul, cm_get_heater_model,    cm_set_heater_model,    nullptr, H3_DEFAULT_MODEL_SENSOR },
     { "he3","he3st",_fi,  0, tx_print_nul, cm_get_set_temperature, cm_set_set_temperature, nullptr, 0 },
     { "he3","he3t", _fi,  1, tx_print_nul, cm_get_temperature,     set_ro,                 nullptr, 0 },
     { "he3","he3op",_fi,  3, tx_print_nul, cm_get_heater_output,   set_ro,                 nullptr, 0 },
     { "he3","he3tr",_fi,  3, tx_print_nul, cm_get_thermistor_resistance, set_ro,           nullptr, 0 },
-    { "he3","he3an",_fi,  0, tx_print_nul, cm_get_heater_adc,      set_ro,                 nullptr, 0 },
+    { "he3","he3an",_fi,  1, tx_print_nul, cm_get_heater_adc,      set_ro,                 nullptr, 0 },
     { "he3","he3fp",_fi,  1, tx_print_nul, cm_get_fan_power,       cm_set_fan_power,       nullptr, 0 },
     { "he3","he3fm",_fi,  1, tx_print_nul, cm_get_fan_min_power,   cm_set_fan_min_power,   nullptr, 0 },
     { "he3","he3fl",_fi,  1, tx_print_nul, cm_get_fan_low_temp,    cm_set_fan_low_temp,    nullptr, 0 },
@@ -713,6 +746,8 @@ const cfgItem_t cfgArray[] = {
     { "sp","spsm", _fip, 2, sp_print_spsm, sp_get_spsm, sp_set_spsm, nullptr, SPINDLE_SPEED_MAX},
     { "sp","spep", _iip, 0, sp_print_spep, sp_get_spep, sp_set_spep, nullptr, SPINDLE_ENABLE_POLARITY },
     { "sp","spdp", _iip, 0, sp_print_spdp, sp_get_spdp, sp_set_spdp, nullptr, SPINDLE_DIR_POLARITY },
+    { "sp","splm", _fip, 3, sp_print_splm, sp_get_splm, sp_set_splm, nullptr, SPINDLE_LASER_POWER_MIN},
+    { "sp","spov", _fip, 3, sp_print_spov, sp_get_spov, sp_set_spov, nullptr, SPINDLE_LASER_OVERSCAN},
     { "sp","spoe", _bip, 0, sp_print_spoe, sp_get_spoe, sp_set_spoe, nullptr, SPINDLE_OVERRIDE_ENABLE},
     { "sp","spo",  _fip, 3, sp_print_spo,  sp_get_spo,  sp_set_spo,  nullptr, SPINDLE_OVERRIDE_FACTOR},
     { "sp","spc",  _i0,  0, sp_print_spc,  sp_get_spc,  sp_set_spc,  nullptr, 0 },   // spindle state
@@ -763,11 +798,20 @@ const cfgItem_t cfgArray[] = {
 
     // Actions and Reports
     { "", "sr",   _n0, 0, sr_print_sr,   sr_get,    sr_set,    nullptr, 0 },    // request and set status reports
+    { "", "srd",  _f0, 4, sr_print_srd,  sr_get_srd,sr_set_srd,nullptr, 0 },    // get and set status report element deadbands
+    { "", "srm",  _i0, 0, sr_print_srm,  sr_get_srm,sr_set_srm,nullptr, 0 },    // get and set status report element min intervals (ms)
+    { "", "srn",  _i0, 0, tx_print_int,  get_int32, set_ro,    &sr.reports_sent, 0 },  // status reports generated
+    { "", "srr",  _i0, 0, tx_print_int,  get_int32, set_ro,    &sr.elements_read, 0 }, // status report elements read
+    { "", "srf",  _i0, 0, tx_print_int,  get_int32, set_ro,    &sr.elements_sent, 0 }, // status report elements sent
     { "", "qr",   _n0, 0, qr_print_qr,   qr_get,    set_nul,   nullptr, 0 },    // get queue value - planner buffers available
     { "", "qi",   _n0, 0, qr_print_qi,   qi_get,    set_nul,   nullptr, 0 },    // get queue value - buffers added to queue
     { "", "qo",   _n0, 0, qr_print_qo,   qo_get,    set_nul,   nullptr, 0 },    // get queue value - buffers removed from queue
     { "", "er",   _n0, 0, tx_print_nul,  rpt_er,    set_nul,   nullptr, 0 },    // get bogus exception report for testing
     { "", "rx",   _n0, 0, tx_print_int,  get_rx,    set_nul,   nullptr, 0 },    // get RX buffer bytes or packets
+    { "", "txo",  _n0, 0, xio_print_txo, xio_get_txo, set_nul, nullptr, 0 },    // get TX queue overflow count
+    { "", "txd",  _n0, 0, xio_print_txd, xio_get_txd, set_nul, nullptr, 0 },    // get TX bytes dropped
+    { "", "txs",  _n0, 0, xio_print_txs, xio_get_txs, set_nul, nullptr, 0 },    // get status reports superseded
+    { "", "file", _sv, 0, tx_print_str,  xio_get_file,xio_set_file,nullptr,0 },   // get selected job file, SET to run one
     { "", "dw",   _i0, 0, tx_print_int,  st_get_dw, set_noop,  nullptr, 0 },    // get dwell time remaining
     { "", "msg",  _s0, 0, tx_print_str,  get_nul,   set_noop,  nullptr, 0 },    // no operation on messages
     { "", "alarm",_n0, 0, tx_print_nul,  cm_alrm,   cm_alrm,   nullptr, 0 },    // trigger alarm
@@ -778,8 +822,65 @@ const cfgItem_t cfgArray[] = {
     { "", "tick", _n0, 0, tx_print_int,  get_tick,  set_nul,   nullptr, 0 },    // get system time tic
     { "", "tram", _b0, 0, cm_print_tram,cm_get_tram,cm_set_tram,nullptr,0 },    // SET to attempt setting rotation matrix from probes
     { "", "defa", _b0, 0, tx_print_nul,  help_defa,set_defaults,nullptr,0 },    // set/print defaults / help screen
+    { "", "cfgs", _s0, 0, nvm_print_cfgs,nvm_get_cfgs,nvm_set_cfgs,nullptr,0 }, // export/import a config snapshot - see persistence.h
     { "", "flash",_b0, 0, tx_print_nul,  help_flash,hw_flash,  nullptr, 0 },
 
+    // I/O channel statistics - ioN is the Nth device in the xio device list (see xio_stats[])
+    // nm=name, rb=RX bytes, rl=RX lines, dw=line dwell, ps=planner stall, tb=TX backpressure
+    // Histograms are log2 millisecond buckets - see XIO_HISTOGRAM_BUCKETS
+    { "io0","io0nm",_s0, 0, tx_print_str, xio_get_nm,   set_nul, &xio_stats[0], 0 },
+    { "io0","io0rb",_i0, 0, tx_print_int, get_int32,    set_nul, &xio_stats[0].rx_bytes, 0 },
+    { "io0","io0rl",_i0, 0, tx_print_int, get_int32,    set_nul, &xio_stats[0].rx_lines, 0 },
+    { "io0","io0dw",_s0, 0, tx_print_str, xio_get_hist, set_nul, &xio_stats[0].line_dwell, 0 },
+    { "io0","io0ps",_s0, 0, tx_print_str, xio_get_hist, set_nul, &xio_stats[0].planner_stall, 0 },
+    { "io0","io0tb",_s0, 0, tx_print_str, xio_get_hist, set_nul, &xio_stats[0].tx_backpressure, 0 },
+
+    { "io1","io1nm",_s0, 0, tx_print_str, xio_get_nm,   set_nul, &xio_stats[1], 0 },
+    { "io1","io1rb",_i0, 0, tx_print_int, get_int32,    set_nul, &xio_stats[1].rx_bytes, 0 },
+    { "io1","io1rl",_i0, 0, tx_print_int, get_int32,    set_nul, &xio_stats[1].rx_lines, 0 },
+    { "io1","io1dw",_s0, 0, tx_print_str, xio_get_hist, set_nul, &xio_stats[1].line_dwell, 0 },
+    { "io1","io1ps",_s0, 0, tx_print_str, xio_get_hist, set_nul, &xio_stats[1].planner_stall, 0 },
+    { "io1","io1tb",_s0, 0, tx_print_str, xio_get_hist, set_nul, &xio_stats[1].tx_backpressure, 0 },
+
+    { "io2","io2nm",_s0, 0, tx_print_str, xio_get_nm,   set_nul, &xio_stats[2], 0 },
+    { "io2","io2rb",_i0, 0, tx_print_int, get_int32,    set_nul, &xio_stats[2].rx_bytes, 0 },
+    { "io2","io2rl",_i0, 0, tx_print_int, get_int32,    set_nul, &xio_stats[2].rx_lines, 0 },
+    { "io2","io2dw",_s0, 0, tx_print_str, xio_get_hist, set_nul, &xio_stats[2].line_dwell, 0 },
+    { "io2","io2ps",_s0, 0, tx_print_str, xio_get_hist, set_nul, &xio_stats[2].planner_stall, 0 },
+    { "io2","io2tb",_s0, 0, tx_print_str, xio_get_hist, set_nul, &xio_stats[2].tx_backpressure, 0 },
+
+    { "io3","io3nm",_s0, 0, tx_print_str, xio_get_nm,   set_nul, &xio_stats[3], 0 },
+    { "io3","io3rb",_i0, 0, tx_print_int, get_int32,    set_nul, &xio_stats[3].rx_bytes, 0 },
+    { "io3","io3rl",_i0, 0, tx_print_int, get_int32,    set_nul, &xio_stats[3].rx_lines, 0 },
+    { "io3","io3dw",_s0, 0, tx_print_str, xio_get_hist, set_nul, &xio_stats[3].line_dwell, 0 },
+    { "io3","io3ps",_s0, 0, tx_print_str, xio_get_hist, set_nul, &xio_stats[3].planner_stall, 0 },
+    { "io3","io3tb",_s0, 0, tx_print_str, xio_get_hist, set_nul, &xio_stats[3].tx_backpressure, 0 },
+
+    { "io4","io4nm",_s0, 0, tx_print_str, xio_get_nm,   set_nul, &xio_stats[4], 0 },
+    { "io4","io4rb",_i0, 0, tx_print_int, get_int32,    set_nul, &xio_stats[4].rx_bytes, 0 },
+    { "io4","io4rl",_i0, 0, tx_print_int, get_int32,    set_nul, &xio_stats[4].rx_lines, 0 },
+    { "io4","io4dw",_s0, 0, tx_print_str, xio_get_hist, set_nul, &xio_stats[4].line_dwell, 0 },
+    { "io4","io4ps",_s0, 0, tx_print_str, xio_get_hist, set_nul, &xio_stats[4].planner_stall, 0 },
+    { "io4","io4tb",_s0, 0, tx_print_str, xio_get_hist, set_nul, &xio_stats[4].tx_backpressure, 0 },
+    { "", "ioclr",_n0, 0, tx_print_nul, xio_clr_stats,xio_clr_stats,nullptr, 0 },  // clear all I/O channel statistics
+
+    // Binary motion telemetry - see telemetry.h for the frame format
+    { "tm","tmr", _fip, 0, tm_print_tmr, tm_get_tmr, tm_set_tmr, nullptr, TELEMETRY_RATE },
+    { "tm","tmf", _iip, 0, tm_print_tmf, tm_get_tmf, tm_set_tmf, nullptr, TELEMETRY_FIELDS },
+    { "tm","tmc", _iip, 0, tm_print_tmc, tm_get_tmc, tm_set_tmc, nullptr, TELEMETRY_CHANNEL },
+    { "tm","tmn", _i0,  0, tx_print_int, get_int32,  set_ro,     &tlm.samples_sent, 0 }, // frames sent
+    { "tm","tmd", _i0,  0, tx_print_int, get_int32,  set_ro,     &tlm.ring_drops, 0 },   // samples dropped - ring full
+    { "tm","tmx", _i0,  0, tx_print_int, get_int32,  set_ro,     &tlm.tx_drops, 0 },     // frames dropped - channel full
+
+    // Scope mode motion capture - see scope.h
+    { "sc","scm", _iip, 0, sc_print_scm, sc_get_scm, sc_set_scm, nullptr, SCOPE_TRIGGER_MODE },
+    { "sc","scl", _i0,  0, sc_print_scl, sc_get_scl, sc_set_scl, nullptr, 0 },
+    { "sc","scf", _fip, 3, sc_print_scf, sc_get_scf, sc_set_scf, nullptr, SCOPE_FOLLOWING_ERROR },
+    { "sc","scp", _iip, 0, sc_print_scp, sc_get_scp, sc_set_scp, nullptr, SCOPE_PRE_TRIGGER_SAMPLES },
+    { "sc","sca", _iip, 0, sc_print_sca, sc_get_sca, sc_set_sca, nullptr, SCOPE_POST_TRIGGER_SAMPLES },
+    { "sc","scs", _i0,  0, sc_print_scs, sc_get_scs, sc_set_scs, nullptr, 0 },
+    { "",  "scd", _f0,  0, sc_print_scd, sc_get_scd, set_ro,     nullptr, 0 },  // capture download - not in the group, it streams
+
 #ifdef __HELP_SCREENS
     { "", "help",_b0, 0, tx_print_nul, help_config, set_nul, nullptr, 0 },  // prints config help screen
     { "", "h",   _b0, 0, tx_print_nul, help_config, set_nul, nullptr, 0 },  // alias for "help"
@@ -1211,46 +1312,46 @@ const cfgItem_t cfgArray[] = {
 
     // Persistence for status report - must be in sequence
     // *** Count must agree with NV_STATUS_REPORT_LEN in report.h ***
-    { "","se00",_fp, 0, tx_print_nul, get_int32, set_int32, &sr.status_report_list[0],0 },
-    { "","se01",_fp, 0, tx_print_nul, get_int32, set_int32, &sr.status_report_list[1],0 },
-    { "","se02",_fp, 0, tx_print_nul, get_int32, set_int32, &sr.status_report_list[2],0 },
-    { "","se03",_fp, 0, tx_print_nul, get_int32, set_int32, &sr.status_report_list[3],0 },
-    { "","se04",_fp, 0, tx_print_nul, get_int32, set_int32, &sr.status_report_list[4],0 },
-    { "","se05",_fp, 0, tx_print_nul, get_int32, set_int32, &sr.status_report_list[5],0 },
-    { "","se06",_fp, 0, tx_print_nul, get_int32, set_int32, &sr.status_report_list[6],0 },
-    { "","se07",_fp, 0, tx_print_nul, get_int32, set_int32, &sr.status_report_list[7],0 },
-    { "","se08",_fp, 0, tx_print_nul, get_int32, set_int32, &sr.status_report_list[8],0 },
-    { "","se09",_fp, 0, tx_print_nul, get_int32, set_int32, &sr.status_report_list[9],0 },
-    { "","se10",_fp, 0, tx_print_nul, get_int32, set_int32, &sr.status_report_list[10],0 },
-    { "","se11",_fp, 0, tx_print_nul, get_int32, set_int32, &sr.status_report_list[11],0 },
-    { "","se12",_fp, 0, tx_print_nul, get_int32, set_int32, &sr.status_report_list[12],0 },
-    { "","se13",_fp, 0, tx_print_nul, get_int32, set_int32, &sr.status_report_list[13],0 },
-    { "","se14",_fp, 0, tx_print_nul, get_int32, set_int32, &sr.status_report_list[14],0 },
-    { "","se15",_fp, 0, tx_print_nul, get_int32, set_int32, &sr.status_report_list[15],0 },
-    { "","se16",_fp, 0, tx_print_nul, get_int32, set_int32, &sr.status_report_list[16],0 },
-    { "","se17",_fp, 0, tx_print_nul, get_int32, set_int32, &sr.status_report_list[17],0 },
-    { "","se18",_fp, 0, tx_print_nul, get_int32, set_int32, &sr.status_report_list[18],0 },
-    { "","se19",_fp, 0, tx_print_nul, get_int32, set_int32, &sr.status_report_list[19],0 },
-    { "","se20",_fp, 0, tx_print_nul, get_int32, set_int32, &sr.status_report_list[20],0 },
-    { "","se21",_fp, 0, tx_print_nul, get_int32, set_int32, &sr.status_report_list[21],0 },
-    { "","se22",_fp, 0, tx_print_nul, get_int32, set_int32, &sr.status_report_list[22],0 },
-    { "","se23",_fp, 0, tx_print_nul, get_int32, set_int32, &sr.status_report_list[23],0 },
-    { "","se24",_fp, 0, tx_print_nul, get_int32, set_int32, &sr.status_report_list[24],0 },
-    { "","se25",_fp, 0, tx_print_nul, get_int32, set_int32, &sr.status_report_list[25],0 },
-    { "","se26",_fp, 0, tx_print_nul, get_int32, set_int32, &sr.status_report_list[26],0 },
-    { "","se27",_fp, 0, tx_print_nul, get_int32, set_int32, &sr.status_report_list[27],0 },
-    { "","se28",_fp, 0, tx_print_nul, get_int32, set_int32, &sr.status_report_list[28],0 },
-    { "","se29",_fp, 0, tx_print_nul, get_int32, set_int32, &sr.status_report_list[29],0 },
-    { "","se30",_fp, 0, tx_print_nul, get_int32, set_int32, &sr.status_report_list[30],0 },
-    { "","se31",_fp, 0, tx_print_nul, get_int32, set_int32, &sr.status_report_list[31],0 },
-    { "","se32",_fp, 0, tx_print_nul, get_int32, set_int32, &sr.status_report_list[32],0 },
-    { "","se33",_fp, 0, tx_print_nul, get_int32, set_int32, &sr.status_report_list[33],0 },
-    { "","se34",_fp, 0, tx_print_nul, get_int32, set_int32, &sr.status_report_list[34],0 },
-    { "","se35",_fp, 0, tx_print_nul, get_int32, set_int32, &sr.status_report_list[35],0 },
-    { "","se36",_fp, 0, tx_print_nul, get_int32, set_int32, &sr.status_report_list[36],0 },
-    { "","se37",_fp, 0, tx_print_nul, get_int32, set_int32, &sr.status_report_list[37],0 },
-    { "","se38",_fp, 0, tx_print_nul, get_int32, set_int32, &sr.status_report_list[38],0 },
-    { "","se39",_fp, 0, tx_print_nul, get_int32, set_int32, &sr.status_report_list[39],0 },
+    { "","se00",_fp, 0, tx_print_nul, get_int32, sr_set_se, &sr.status_report_list[0],0 },
+    { "","se01",_fp, 0, tx_print_nul, get_int32, sr_set_se, &sr.status_report_list[1],0 },
+    { "","se02",_fp, 0, tx_print_nul, get_int32, sr_set_se, &sr.status_report_list[2],0 },
+    { "","se03",_fp, 0, tx_print_nul, get_int32, sr_set_se, &sr.status_report_list[3],0 },
+    { "","se04",_fp, 0, tx_print_nul, get_int32, sr_set_se, &sr.status_report_list[4],0 },
+    { "","se05",_fp, 0, tx_print_nul, get_int32, sr_set_se, &sr.status_report_list[5],0 },
+    { "","se06",_fp, 0, tx_print_nul, get_int32, sr_set_se, &sr.status_report_list[6],0 },
+    { "","se07",_fp, 0, tx_print_nul, get_int32, sr_set_se, &sr.status_report_list[7],0 },
+    { "","se08",_fp, 0, tx_print_nul, get_int32, sr_set_se, &sr.status_report_list[8],0 },
+    { "","se09",_fp, 0, tx_print_nul, get_int32, sr_set_se, &sr.status_report_list[9],0 },
+    { "","se10",_fp, 0, tx_print_nul, get_int32, sr_set_se, &sr.status_report_list[10],0 },
+    { "","se11",_fp, 0, tx_print_nul, get_int32, sr_set_se, &sr.status_report_list[11],0 },
+    { "","se12",_fp, 0, tx_print_nul, get_int32, sr_set_se, &sr.status_report_list[12],0 },
+    { "","se13",_fp, 0, tx_print_nul, get_int32, sr_set_se, &sr.status_report_list[13],0 },
+    { "","se14",_fp, 0, tx_print_nul, get_int32, sr_set_se, &sr.status_report_list[14],0 },
+    { "","se15",_fp, 0, tx_print_nul, get_int32, sr_set_se, &sr.status_report_list[15],0 },
+    { "","se16",_fp, 0, tx_print_nul, get_int32, sr_set_se, &sr.status_report_list[16],0 },
+    { "","se17",_fp, 0, tx_print_nul, get_int32, sr_set_se, &sr.status_report_list[17],0 },
+    { "","se18",_fp, 0, tx_print_nul, get_int32, sr_set_se, &sr.status_report_list[18],0 },
+    { "","se19",_fp, 0, tx_print_nul, get_int32, sr_set_se, &sr.status_report_list[19],0 },
+    { "","se20",_fp, 0, tx_print_nul, get_int32, sr_set_se, &sr.status_report_list[20],0 },
+    { "","se21",_fp, 0, tx_print_nul, get_int32, sr_set_se, &sr.status_report_list[21],0 },
+    { "","se22",_fp, 0, tx_print_nul, get_int32, sr_set_se, &sr.status_report_list[22],0 },
+    { "","se23",_fp, 0, tx_print_nul, get_int32, sr_set_se, &sr.status_report_list[23],0 },
+    { "","se24",_fp, 0, tx_print_nul, get_int32, sr_set_se, &sr.status_report_list[24],0 },
+    { "","se25",_fp, 0, tx_print_nul, get_int32, sr_set_se, &sr.status_report_list[25],0 },
+    { "","se26",_fp, 0, tx_print_nul, get_int32, sr_set_se, &sr.status_report_list[26],0 },
+    { "","se27",_fp, 0, tx_print_nul, get_int32, sr_set_se, &sr.status_report_list[27],0 },
+    { "","se28",_fp, 0, tx_print_nul, get_int32, sr_set_se, &sr.status_report_list[28],0 },
+    { "","se29",_fp, 0, tx_print_nul, get_int32, sr_set_se, &sr.status_report_list[29],0 },
+    { "","se30",_fp, 0, tx_print_nul, get_int32, sr_set_se, &sr.status_report_list[30],0 },
+    { "","se31",_fp, 0, tx_print_nul, get_int32, sr_set_se, &sr.status_report_list[31],0 },
+    { "","se32",_fp, 0, tx_print_nul, get_int32, sr_set_se, &sr.status_report_list[32],0 },
+    { "","se33",_fp, 0, tx_print_nul, get_int32, sr_set_se, &sr.status_report_list[33],0 },
+    { "","se34",_fp, 0, tx_print_nul, get_int32, sr_set_se, &sr.status_report_list[34],0 },
+    { "","se35",_fp, 0, tx_print_nul, get_int32, sr_set_se, &sr.status_report_list[35],0 },
+    { "","se36",_fp, 0, tx_print_nul, get_int32, sr_set_se, &sr.status_report_list[36],0 },
+    { "","se37",_fp, 0, tx_print_nul, get_int32, sr_set_se, &sr.status_report_list[37],0 },
+    { "","se38",_fp, 0, tx_print_nul, get_int32, sr_set_se, &sr.status_report_list[38],0 },
+    { "","se39",_fp, 0, tx_print_nul, get_int32, sr_set_se, &sr.status_report_list[39],0 },
     // Count is 40, since se00 counts as one.
 
 
@@ -1386,6 +1487,19 @@ const cfgItem_t cfgArray[] = {
     { "","pid2",_f0, 0, tx_print_nul, get_grp, set_grp, nullptr, 0 },   // PID 2 group
     { "","pid3",_f0, 0, tx_print_nul, get_grp, set_grp, nullptr, 0 },   // PID 3 group
 
+#define TELEMETRY_GROUPS 1
+    { "","tm",  _f0, 0, tx_print_nul, get_grp, set_grp, nullptr, 0 },   // telemetry group
+
+#define SCOPE_GROUPS 1
+    { "","sc",  _f0, 0, tx_print_nul, get_grp, set_grp, nullptr, 0 },   // scope group
+
+#define IO_CHANNEL_GROUPS 5
+    { "","io0", _f0, 0, tx_print_nul, get_grp, set_grp, nullptr, 0 },   // I/O channel statistics groups
+    { "","io1", _f0, 0, tx_print_nul, get_grp, set_grp, nullptr, 0 },
+    { "","io2", _f0, 0, tx_print_nul, get_grp, set_grp, nullptr, 0 },
+    { "","io3", _f0, 0, tx_print_nul, get_grp, set_grp, nullptr, 0 },
+    { "","io4", _f0, 0, tx_print_nul, get_grp, set_grp, nullptr, 0 },
+
 #ifdef __USER_DATA
 #define USER_DATA_GROUPS 4
     { "","uda", _f0, 0, tx_print_nul, get_grp, set_grp, nullptr, 0 },   // user data group
@@ -1428,6 +1542,9 @@ const cfgItem_t cfgArray[] = {
                         + TOOL_OFFSET_GROUPS \
                         + MACHINE_STATE_GROUPS \
                         + TEMPERATURE_GROUPS \
+                        + TELEMETRY_GROUPS \
+                        + SCOPE_GROUPS \
+                        + IO_CHANNEL_GROUPS \
                         + USER_DATA_GROUPS \
                         + DIAGNOSTIC_GROUPS)
 
@@ -1439,6 +1556,8 @@ const cfgItem_t cfgArray[] = {
 /* </DO NOT MESS WITH THESE DEFINES> */
 
 index_t nv_index_max() { return ( NV_INDEX_MAX );}
+index_t nv_token_index[NV_INDEX_MAX];   // cfgArray indexes sorted by token - see nv_index_init()
+uint16_t nvm_slot[NV_INDEX_MAX];        // latest persisted record by index - see persistence_init()
 bool nv_index_is_single(index_t index) { return ((index <= NV_INDEX_END_SINGLES) ? true : false);}
 bool nv_index_is_group(index_t index) { return (((index >= NV_INDEX_START_GROUPS) && (index < NV_INDEX_START_UBER_GROUPS)) ? true : false);}
 bool nv_index_lt_groups(index_t index) { return ((index <= NV_INDEX_START_GROUPS) ? true : false);}
@@ -1634,8 +1753,9 @@ static void _do_group(nvObj_t *nv, char *group)   // helper to a group
     nv = nv_body;
     strncpy(nv->token, group, TOKEN_LEN);
     nv->index = nv_get_index((const char *)"", nv->token);
-    nv_get_nvObj(nv);
-    nv_print_list(STAT_OK, TEXT_MULTILINE_FORMATTED, JSON_RESPONSE_FORMAT);
+    if (nv_get(nv) != STAT_COMPLETE) {          // groups print themselves as they are read
+        nv_print_list(STAT_OK, TEXT_MULTILINE_FORMATTED, JSON_RESPONSE_FORMAT);
+    }
 }
 
 static stat_t _do_group_list(nvObj_t *nv, char list[][TOKEN_LEN+1]) // helper to print multiple groups in a list
@@ -32,6 +32,7 @@
 #include "json_parser.h"
 #include "text_parser.h"
 #include "gcode.h"
+#include "gcode_program.h"
 #include "canonical_machine.h"
 #include "plan_arc.h"
 #include "planner.h"
@@ -44,6 +45,9 @@
 #include "help.h"
 #include "util.h"
 #include "xio.h"
+#include "telemetry.h"
+#include "scope.h"
+#include "persistence.h"
 #include "settings.h"
 
 #include "MotatePower.h"
@@ -73,10 +77,13 @@ static stat_t _test_assertions(void);
 static stat_t _test_system_assertions(void);
 
 static stat_t _sync_to_planner(void);
-static stat_t _sync_to_tx_buffer(void);
 static stat_t _dispatch_command(void);
 static stat_t _dispatch_control(void);
 static void _dispatch_kernel(const devflags_t flags);
+static void _dispatch_gcode(bool lookahead);
+static void _dispatch_program_line(void);
+static void _read_ahead(void);
+static void _flush_read_ahead(void);
 static stat_t _controller_state(void);          // manage controller state transitions
 
 static Motate::OutputPin<Motate::kOutputSAFE_PinNumber> safe_pin;
@@ -150,6 +157,9 @@ static void _controller_HSM()
     // Order is important, and line breaks indicate dependency groups
 
     DISPATCH(hardware_periodic());              // give the hardware a chance to do stuff
+    DISPATCH(telemetry_callback());             // queue motion telemetry frames (non-blocking)
+    DISPATCH(scope_callback());                 // finish scope captures once motion stops
+    DISPATCH(xio_callback());                   // push queued output to the devices (non-blocking)
     DISPATCH(_led_indicator());                 // blink LEDs at the current rate
     DISPATCH(_shutdown_handler());              // invoke shutdown
     DISPATCH(_interlock_handler());             // invoke / remove safety interlock
@@ -169,11 +179,14 @@ static void _controller_HSM()
     DISPATCH(mp_planner_callback());            // motion planner
     DISPATCH(cm_operation_runner_callback());   // operation action runner
     DISPATCH(cm_arc_callback(cm));              // arc generation runs as a cycle above lines
+    DISPATCH(cm_canned_cycle_callback());       // canned cycles (G81-G89) run as a cycle above lines
+    DISPATCH(cm_raster_callback());             // laser raster rows, likewise
 
     DISPATCH(cm_homing_cycle_callback());       // homing cycle operation (G28.2)
     DISPATCH(cm_probing_cycle_callback());      // probing cycle operation (G38.2)
     DISPATCH(cm_jogging_cycle_callback());      // jog cycle operation
     DISPATCH(cm_deferred_write_callback());     // persist G10 changes when not in machining cycle
+    DISPATCH(persistence_callback());           // write queued settings to NVM when not in machining cycle
 
     DISPATCH(cm_feedhold_command_blocker());    // blocks new Gcode from arriving while in feedhold
 #if MARLIN_COMPAT_ENABLED == true
@@ -183,7 +196,6 @@ static void _controller_HSM()
 //----- command readers and parsers --------------------------------------------------//
 
     DISPATCH(_sync_to_planner());               // ensure there is at least one free buffer in planning queue
-    DISPATCH(_sync_to_tx_buffer());             // sync with TX buffer (pseudo-blocking)
     DISPATCH(_dispatch_command());              // MUST BE LAST - read and execute next command
 }
 
@@ -214,13 +226,60 @@ static stat_t _dispatch_command()
 {
     if (cs.controller_state != CONTROLLER_PAUSED) {
         devflags_t flags = DEV_IS_BOTH | DEV_IS_MUTED; // expressly state we'll handle muted devices
-        if ((!mp_planner_is_full(mp)) && (cs.bufp = xio_readline(flags, cs.linelen)) != NULL) {
+        if (mp_planner_is_full(mp)) {
+            _read_ahead();
+        } else if ((cs.bufp = gcode_lookahead_line()) != NULL) {     // lines read ahead go first, in order
+            strncpy(cs.saved_buf, cs.bufp, SAVED_BUFFER_LEN-1);
+            _dispatch_gcode(true);
+        } else if (cs.held) {
+            cs.held = false;
+            cs.bufp = cs.held_buf;
+            _dispatch_kernel(cs.held_flags);
+        } else if ((cs.bufp = gcode_program_next_line()) != NULL) {   // O word loops and calls
+            _dispatch_program_line();
+        } else if ((cs.bufp = xio_readline(flags, cs.linelen)) != NULL) {
             _dispatch_kernel(flags);
         }
     }
     return (STAT_OK);
 }
 
+/*
+ * _read_ahead() - read and scan Gcode lines ahead while the planner is full
+ *
+ *  Gcode lines go into the Gcode lookahead (see gcode_parser.cpp). Controls and lines from
+ *  muted devices don't queue behind Gcode - they are dispatched now, as _dispatch_control()
+ *  would. Any other line ($ commands, Gcode too long to scan ahead) is held, and reading
+ *  ahead stops until it has been dispatched in its turn. Nothing is read while O word
+ *  loops or calls are running - lines replayed from the store come first.
+ */
+
+static void _read_ahead()
+{
+    if (cs.held || gcode_lookahead_is_full() || !gcode_program_is_idle()) {
+        return;
+    }
+    devflags_t flags = DEV_IS_BOTH | DEV_IS_MUTED;
+    if ((cs.bufp = xio_readline(flags, cs.linelen)) == NULL) {
+        return;
+    }
+    while ((*cs.bufp == SPC) || (*cs.bufp == TAB)) {        // position past any leading whitespace
+        cs.bufp++;
+    }
+    char c = *cs.bufp;
+    if ((flags & DEV_IS_MUTED) || (c == '{') || xio_is_control_char(c)) {
+        _dispatch_kernel(flags);
+        return;
+    }
+    if ((isalpha(c) || (c == '/') || (c == '(')) && (strchr("Hh", c) == NULL) &&
+        (gcode_lookahead_add(cs.bufp))) {
+        return;
+    }
+    strncpy(cs.held_buf, cs.bufp, RX_BUFFER_SIZE-1);
+    cs.held_flags = flags;
+    cs.held = true;
+}
+
 static void _dispatch_kernel(const devflags_t flags)
 {
     stat_t status;
@@ -260,8 +319,8 @@ static void _dispatch_kernel(const devflags_t flags)
     // trap single character commands
     if      (*cs.bufp == '!') { cm_request_feedhold(FEEDHOLD_TYPE_ACTIONS, FEEDHOLD_EXIT_CYCLE); }
     else if (*cs.bufp == '~') { cm_request_cycle_start(); }
-    else if (*cs.bufp == '%') { cm_request_queue_flush(); xio_flush_to_command(); }
-    else if (*cs.bufp == EOT) { cm_request_job_kill(); xio_flush_to_command(); }
+    else if (*cs.bufp == '%') { cm_request_queue_flush(); xio_flush_to_command(); _flush_read_ahead(); }
+    else if (*cs.bufp == EOT) { cm_request_job_kill(); xio_flush_to_command(); _flush_read_ahead(); }
     else if (*cs.bufp == ENQ) { controller_request_enquiry(); }
     else if (*cs.bufp == CAN) { hw_hard_reset(); }          // reset immediately
 
@@ -270,55 +329,109 @@ static void _dispatch_kernel(const devflags_t flags)
             js.json_mode = JSON_MODE;                       // switch to JSON mode
         }
         cs.comm_request_mode = JSON_MODE;                   // mode of this command
+        nv_stream_enable(true);                             // the response may be printed as it's made
         json_parser(cs.bufp);
+        nv_stream_enable(false);
     }
 #ifdef __TEXT_MODE
     else if (strchr("$?Hh", *cs.bufp) != NULL) {            // process as text mode
         if (cs.comm_mode == AUTO_MODE) { js.json_mode = TEXT_MODE; } // switch to text mode
         cs.comm_request_mode = TEXT_MODE;                   // mode of this command
+        nv_stream_enable(true);
         status = text_parser(cs.bufp);
+        nv_stream_enable(false);
         if (js.json_mode == TEXT_MODE) {                    // needed in case mode was changed by $EJ=1
             text_response(status, cs.saved_buf);
         }
     }
-    else if (js.json_mode == TEXT_MODE) {                   // anything else is interpreted as Gcode
+#endif
+    else {                                                  // anything else is interpreted as Gcode
+        _dispatch_gcode(false);
+    }
+}
+
+/*
+ * _dispatch_gcode() - run the Gcode line in cs.bufp and respond in the current mode
+ *
+ *  With lookahead set cs.bufp is the line of the oldest Gcode lookahead block, and that
+ *  block is run instead of parsing the line again.
+ */
+
+static stat_t _run_gcode(bool lookahead)
+{
+    return (lookahead ? gcode_lookahead_run() : gcode_parser(cs.bufp));
+}
+
+static void _dispatch_gcode(bool lookahead)
+{
+#ifdef __TEXT_MODE
+    if (js.json_mode == TEXT_MODE) {
         cs.comm_request_mode = TEXT_MODE;                   // mode of this command
-        text_response(gcode_parser(cs.bufp), cs.saved_buf);
+        text_response(_run_gcode(lookahead), cs.saved_buf);
+        return;
     }
 #endif
 
 #if MARLIN_COMPAT_ENABLED == true
-    else if (js.json_mode == MARLIN_COMM_MODE) {            // handle marlin-specific protocol gcode
+    if (js.json_mode == MARLIN_COMM_MODE) {                 // handle marlin-specific protocol gcode
         cs.comm_request_mode = MARLIN_COMM_MODE;            // mode of this command
-        marlin_response(gcode_parser(cs.bufp), cs.saved_buf);
+        marlin_response(_run_gcode(lookahead), cs.saved_buf);
+        return;
     }
 #endif
-    else {  // anything else is interpreted as Gcode
-        cs.comm_request_mode = JSON_MODE;                   // mode of this command
 
-        // this optimization bypasses the standard JSON parser and does what it needs directly
-        nvObj_t *nv = nv_reset_nv_list();                   // get a fresh nvObj list
-        strcpy(nv->token, "gc");                            // label is as a Gcode block (do not get an index - not necessary)
-        nv_copy_string(nv, cs.bufp);                        // copy the Gcode line
-        nv->valuetype = TYPE_STRING;
-        status = gcode_parser(cs.bufp);
-        
+    cs.comm_request_mode = JSON_MODE;                       // mode of this command
+
+    // this optimization bypasses the standard JSON parser and does what it needs directly
+    nvObj_t *nv = nv_reset_nv_list();                       // get a fresh nvObj list
+    strcpy(nv->token, "gc");                                // label is as a Gcode block (do not get an index - not necessary)
+    nv_copy_string(nv, cs.bufp);                            // copy the Gcode line
+    nv->valuetype = TYPE_STRING;
+    stat_t status = _run_gcode(lookahead);
+
 #if MARLIN_COMPAT_ENABLED == true
-        if (js.json_mode == MARLIN_COMM_MODE) {             // in case a marlin-specific M-code was found
-            cs.comm_request_mode = MARLIN_COMM_MODE;        // mode of this command
-            // We are switching to marlin_comm_mode, kill status reports and queue reports
-            sr.status_report_verbosity = SR_OFF;
-            qr.queue_report_verbosity = QR_OFF;
-            marlin_response(status, cs.saved_buf);
-            return;
-        }
+    if (js.json_mode == MARLIN_COMM_MODE) {                 // in case a marlin-specific M-code was found
+        cs.comm_request_mode = MARLIN_COMM_MODE;            // mode of this command
+        // We are switching to marlin_comm_mode, kill status reports and queue reports
+        sr.status_report_verbosity = SR_OFF;
+        qr.queue_report_verbosity = QR_OFF;
+        marlin_response(status, cs.saved_buf);
+        return;
+    }
 #endif
 
-        nv_print_list(status, TEXT_NO_PRINT, JSON_RESPONSE_FORMAT);
-        sr_request_status_report(SR_REQUEST_TIMED);         // generate incremental status report to show any changes
+    nv_print_list(status, TEXT_NO_PRINT, JSON_RESPONSE_FORMAT);
+    sr_request_status_report(SR_REQUEST_TIMED);             // generate incremental status report to show any changes
+}
+
+/*
+ * _dispatch_program_line() - run a Gcode line replayed by an O word loop or call
+ *
+ *  The host didn't send the line so there is no response. An error is reported as an
+ *  exception and ends the loops and calls in progress.
+ */
+
+static void _dispatch_program_line()
+{
+    strncpy(cs.saved_buf, cs.bufp, SAVED_BUFFER_LEN-1);     // save input buffer for reporting
+    stat_t status = gcode_parser(cs.bufp);
+    if ((status != STAT_OK) && (status != STAT_EAGAIN) && (status != STAT_NOOP)) {
+        rpt_exception(status, cs.saved_buf);
+        gcode_program_reset();
     }
 }
 
+/*
+ * _flush_read_ahead() - drop the lines read ahead and any O word flow (queue flush, job kill)
+ */
+
+static void _flush_read_ahead()
+{
+    gcode_lookahead_flush();
+    gcode_program_reset();
+    cs.held = false;
+}
+
 /**** Local Functions ******************************************************************/
 
 /*
@@ -444,19 +557,22 @@ static stat_t _led_indicator()
 }
 
 /*
- * _sync_to_tx_buffer() - return eagain if TX queue is backed up
  * _sync_to_planner() - return eagain if planner is not ready for a new command
+ *
+ *  There is no matching TX sync. Output is queued per device and drained by xio_callback(),
+ *  so a slow host never holds up reading commands. While the planner is full and there is
+ *  room to read ahead _dispatch_command() still runs - it only scans Gcode ahead.
  */
-static stat_t _sync_to_tx_buffer()
-{
-    return (STAT_OK);
-}
-
 static stat_t _sync_to_planner()
 {
     if (mp_planner_is_full(mp)) {   // allow up to N planner buffers for this line
-        return (STAT_EAGAIN);
+        xio_planner_stalled(true);
+        if (cs.held || gcode_lookahead_is_full() || !gcode_program_is_idle()) {
+            return (STAT_EAGAIN);
+        }
+        return (STAT_OK);
     }
+    xio_planner_stalled(false);
     return (STAT_OK);
 }
 
@@ -74,6 +74,9 @@ typedef struct controllerSingleton {    // main TG controller struct
     uint16_t linelen;                   // length of currently processing line
     char out_buf[OUTPUT_BUFFER_LEN];    // output buffer
     char saved_buf[SAVED_BUFFER_LEN];   // save the input buffer
+    char held_buf[RX_BUFFER_SIZE];      // line read ahead that has to wait for the Gcode lookahead
+    devflags_t held_flags;              // flags of the held line
+    bool held;                          // held_buf holds a line
 
     // Exceptions - some exceptions cannot be notified by an ER because they are in interrupts 
     bool exec_aline_assertion_failure;  // record an exception deep inside mp_exec_aline()
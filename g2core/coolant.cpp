@@ -59,14 +59,14 @@ void coolant_reset() {
 
 /****************************************************************************************
  * coolant_control_immediate() - execute coolant control immediately
- * coolant_control_sync()      - queue a coolant control to the planner buffer
+ * coolant_control_sync()      - run a coolant control with the next planner buffer
  * _exec_coolant_control()     - actually execute the coolant command
  */
 
 stat_t coolant_control_immediate(coControl control, coSelect select)
 {
     float value[] = { (float)control };
-    bool flags[] = { (select & COOLANT_MIST), (select & COOLANT_FLOOD) };
+    bool flags[] = { (select & COOLANT_MIST) != 0, (select & COOLANT_FLOOD) != 0 };
     _exec_coolant_control(value, flags);
     return(STAT_OK);       
 }    
@@ -79,10 +79,10 @@ stat_t coolant_control_sync(coControl control, coSelect select)
         return (STAT_OK);
     }
     
-    // queue the coolant control
+    // defer the coolant control to the next block - coolant doesn't need the planner to stop
     float value[] = { (float)control };
-    bool flags[]  = { (select & COOLANT_MIST), (select & COOLANT_FLOOD) };
-    mp_queue_command(_exec_coolant_control, value, flags);
+    bool flags[]  = { (select & COOLANT_MIST) != 0, (select & COOLANT_FLOOD) != 0 };
+    mp_defer_command(_exec_coolant_control, value, flags);
     return(STAT_OK);
 }
 
@@ -0,0 +1,461 @@
+/*
+ * cycle_canned.cpp - canned drilling and boring cycles (G81 - G89)
+ * This file is part of the g2core project
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, you may use this file as part of a software library without
+ * restriction. Specifically, if other files instantiate templates or use macros or
+ * inline functions from this file, or you compile this file and link it with  other
+ * files to produce an executable, this file does not by itself cause the resulting
+ * executable to be covered by the GNU General Public License. This exception does not
+ * however invalidate any other reasons why the executable file might be covered by the
+ * GNU General Public License.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/*
+ * CANNED CYCLES
+ *
+ *  A canned cycle block is expanded here, on the controller, into the rapids, feeds,
+ *  dwells and spindle commands that drill its holes. Only the block is sent, so a
+ *  drilling program is one short line per hole:
+ *
+ *      G90 G99 G81 X10 Y10 Z-5 R1 F300     drill the first hole, retract to R
+ *      X20                                 same cycle, same R and Z, at X20 Y10
+ *      X30 Y20 Z-8                         ...deeper
+ *      G80                                 cancel
+ *
+ *  The drilling axis is the axis normal to the active plane (Z for G17). R, Z (the depth),
+ *  Q and P are sticky until the motion mode leaves the canned cycles. L repeats the cycle:
+ *  in G91 each repeat steps by the programmed plane offsets, R is relative to the start
+ *  level and Z is relative to R, as in RS274/NGC.
+ *
+ *  Each hole runs:
+ *      - rapid up to R if starting below it (first hole of the block only)
+ *      - rapid across to the hole
+ *      - rapid down to R
+ *      - feed to Z - in pecks of Q for G83, with a rapid out to R between pecks
+ *      - dwell P seconds (G82, G89), stop the spindle (G86) or reverse it (G84)
+ *      - feed out to R (G84, G85, G89)
+ *      - rapid out to the retract level: R for G99, the start level (or R if higher) for G98
+ *      - restore the spindle (G84, G86)
+ *
+ *  The block is checked and soft limit tested as a whole, then the moves are queued from
+ *  cm_canned_cycle_callback() as the planner has room, the same way arcs are. G84 is
+ *  unsynchronized tapping and needs a floating tap holder. G87 and G88 are not supported.
+ */
+
+#include "g2core.h"
+#include "config.h"
+#include "canonical_machine.h"
+#include "planner.h"
+#include "spindle.h"
+#include "util.h"
+
+#ifndef CANNED_PECK_CLEARANCE
+#define CANNED_PECK_CLEARANCE ((float)0.25)     // mm above the last peck depth that G83 rapids back down to
+#endif
+
+typedef enum {
+    CANNED_INACTIVE = 0,            // no cycle running
+    CANNED_CLEAR,                   // rapid up to R if below it
+    CANNED_HOLE,                    // rapid across to the hole
+    CANNED_R_PLANE,                 // rapid down to R
+    CANNED_FEED_IN,                 // feed to the next peck depth or the bottom
+    CANNED_PECK_OUT,                // rapid out to R between pecks
+    CANNED_PECK_IN,                 // rapid back down to just above the last peck
+    CANNED_BOTTOM,                  // dwell, stop or reverse the spindle
+    CANNED_FEED_OUT,                // feed out to R
+    CANNED_RAPID_OUT,               // rapid out to the retract level
+    CANNED_RESTORE                  // restore the spindle, then the next hole
+} cdCannedState;
+
+/**** Canned cycle singleton structure ****/
+
+struct cdCannedSingleton {
+    cmRetractMode retract_mode;     // G98, G99
+
+    // sticky words - as programmed, valid while the motion mode stays in the canned cycles
+    bool  R_set;
+    bool  Z_set;
+    float R_word;
+    float Z_word;                   // drilling axis word, whichever axis that is
+    float Q_word;
+    float P_word;
+
+    // cycle being run - all positions are machine coordinates in mm
+    cdCannedState state;
+    cmMotionMode cycle;             // G81 ... G89
+    cmAxes plane_axis_0;            // X for G17
+    cmAxes plane_axis_1;            // Y for G17
+    cmAxes drill_axis;              // Z for G17
+    uint8_t holes;                  // holes left, including this one
+    float hole[2];                  // this hole in the plane axes
+    float step[2];                  // plane offset between repeats (G91)
+    float r_plane;
+    float bottom;
+    float retract;                  // level to rapid out to
+    float peck;                     // peck depth, 0 for a single feed
+    float depth;                    // deepest point reached in this hole
+    float dwell;                    // seconds at the bottom
+    float position[AXES];           // position of the last queued move
+    uint8_t spindle_state;          // spControl saved by the spindle exec when it stops or reverses
+
+    GCodeState_t gm;                // Gcode state sent with each move
+};
+static struct cdCannedSingleton cd;
+
+/**** NOTE: global prototypes and other .h info is located in canonical_machine.h ****/
+
+static bool _canned_step(void);
+
+static bool _is_canned_cycle(const cmMotionMode motion_mode)
+{
+    return ((motion_mode >= MOTION_MODE_CANNED_CYCLE_81) && (motion_mode <= MOTION_MODE_CANNED_CYCLE_89));
+}
+
+/****************************************************************************************
+ * cm_set_retract_mode()     - G98, G99
+ * cm_abort_canned_cycle()   - stop queueing the cycle's moves. OK to call if none is running
+ */
+
+stat_t cm_set_retract_mode(const uint8_t mode)
+{
+    cd.retract_mode = (cmRetractMode)mode;
+    return (STAT_OK);
+}
+
+void cm_abort_canned_cycle()
+{
+    cd.state = CANNED_INACTIVE;
+}
+
+/****************************************************************************************
+ * cm_canned_cycle_feed() - canonical machine entry point for G81 - G89
+ *
+ *  Values are as programmed (units, distance mode and offsets not yet applied). The
+ *  R word arrives in the arc radius slot and the depth in target[] of the drilling axis.
+ *  modal_g1_f is set if the G8x word itself is in the block.
+ */
+
+stat_t cm_canned_cycle_feed(const float target[], const bool target_f[],    // hole position and depth
+                            const float R_word, const bool R_word_f,        // R plane
+                            const float Q_word, const bool Q_word_f,        // peck depth
+                            const float P_word, const bool P_word_f,        // dwell at the bottom
+                            const uint8_t L_word, const bool L_word_f,      // repeats
+                            const bool modal_g1_f,                          // modal group flag for motion group
+                            const cmMotionMode motion_mode)                 // defined motion mode
+{
+    if (!_is_canned_cycle(cm->gm.motion_mode)) {            // entering the canned cycles - forget old sticky words
+        cd.R_set = false;
+        cd.Z_set = false;
+        cd.Q_word = 0;
+        cd.P_word = 0;
+    }
+
+    if (cm->gm.select_plane == CANON_PLANE_XY) {            // G17
+        cd.plane_axis_0 = AXIS_X;
+        cd.plane_axis_1 = AXIS_Y;
+        cd.drill_axis   = AXIS_Z;
+    } else if (cm->gm.select_plane == CANON_PLANE_XZ) {     // G18
+        cd.plane_axis_0 = AXIS_Z;
+        cd.plane_axis_1 = AXIS_X;
+        cd.drill_axis   = AXIS_Y;
+    } else {                                                // G19
+        cd.plane_axis_0 = AXIS_Y;
+        cd.plane_axis_1 = AXIS_Z;
+        cd.drill_axis   = AXIS_X;
+    }
+
+    // pick up the sticky words
+    if (R_word_f) {
+        cd.R_word = R_word;
+        cd.R_set = true;
+    }
+    if (target_f[cd.drill_axis]) {
+        cd.Z_word = target[cd.drill_axis];
+        cd.Z_set = true;
+    }
+    if (Q_word_f) { cd.Q_word = Q_word; }
+    if (P_word_f) { cd.P_word = P_word; }
+    cm->gm.motion_mode = motion_mode;
+
+    // A block with no G8x word and no plane or drilling axis words (e.g. just an F or an M
+    // code) leaves the cycle armed but doesn't drill
+    if (!(modal_g1_f | target_f[cd.plane_axis_0] | target_f[cd.plane_axis_1] | target_f[cd.drill_axis])) {
+        return (STAT_OK);
+    }
+
+    // trap specification errors
+    if (cm->gm.feed_rate_mode == INVERSE_TIME_MODE) {
+        return (STAT_INVERSE_TIME_MODE_CANNOT_BE_USED);
+    }
+    if (fp_ZERO(cm->gm.feed_rate)) {
+        return (STAT_FEEDRATE_NOT_SPECIFIED);
+    }
+    if (!cd.R_set) {
+        return (STAT_R_WORD_IS_MISSING);
+    }
+    if (!cd.Z_set) {
+        return (STAT_AXIS_IS_MISSING);
+    }
+    if (motion_mode == MOTION_MODE_CANNED_CYCLE_83) {
+        if (fp_ZERO(cd.Q_word)) {
+            return (STAT_Q_WORD_IS_MISSING);
+        }
+        if (cd.Q_word < 0) {
+            return (STAT_Q_WORD_IS_INVALID);
+        }
+    }
+    if (cd.P_word < 0) {
+        return (STAT_P_WORD_IS_NEGATIVE);
+    }
+    if (L_word_f && (L_word == 0)) {
+        return (STAT_L_WORD_IS_INVALID);
+    }
+
+    // resolve the levels to machine coordinates
+    float start = cm->gmx.position[cd.drill_axis];
+    if (cm->gm.distance_mode == INCREMENTAL_DISTANCE_MODE) {
+        cd.r_plane = start + _to_millimeters(cd.R_word);
+        cd.bottom = cd.r_plane + _to_millimeters(cd.Z_word);
+    } else {
+        cd.r_plane = cm_get_combined_offset(cd.drill_axis) + _to_millimeters(cd.R_word);
+        cd.bottom = cm_get_combined_offset(cd.drill_axis) + _to_millimeters(cd.Z_word);
+    }
+    if (cd.bottom >= cd.r_plane) {                          // the hole has to go down from R
+        return (STAT_R_WORD_IS_INVALID);
+    }
+    cd.retract = cd.r_plane;
+    if ((cd.retract_mode == RETRACT_TO_INITIAL_LEVEL) && (start > cd.r_plane)) {
+        cd.retract = start;
+    }
+    cd.peck = (motion_mode == MOTION_MODE_CANNED_CYCLE_83) ? _to_millimeters(cd.Q_word) : 0;
+    cd.dwell = ((motion_mode == MOTION_MODE_CANNED_CYCLE_82) ||
+                (motion_mode == MOTION_MODE_CANNED_CYCLE_89)) ? cd.P_word : 0;
+
+    // resolve the first hole and the step between repeats
+    bool flags[AXES] = {};
+    flags[cd.plane_axis_0] = target_f[cd.plane_axis_0];
+    flags[cd.plane_axis_1] = target_f[cd.plane_axis_1];
+    cm_set_model_target(target, flags);
+    cd.hole[0] = cm->gm.target[cd.plane_axis_0];
+    cd.hole[1] = cm->gm.target[cd.plane_axis_1];
+    cd.step[0] = 0;
+    cd.step[1] = 0;
+    if (cm->gm.distance_mode == INCREMENTAL_DISTANCE_MODE) {
+        cd.step[0] = cd.hole[0] - cm->gmx.position[cd.plane_axis_0];
+        cd.step[1] = cd.hole[1] - cm->gmx.position[cd.plane_axis_1];
+    }
+    cd.holes = L_word_f ? L_word : 1;
+
+    // soft limit test every hole top and bottom - the cycle can't fail once it starts queueing
+    float test[AXES];
+    copy_vector(test, cm->gmx.position);
+    for (uint8_t i = 0; i < cd.holes; i++) {
+        test[cd.plane_axis_0] = cd.hole[0] + cd.step[0] * i;
+        test[cd.plane_axis_1] = cd.hole[1] + cd.step[1] * i;
+        test[cd.drill_axis] = max(cd.retract, start);
+        ritorno(cm_test_soft_limits(test));
+        test[cd.drill_axis] = cd.bottom;
+        ritorno(cm_test_soft_limits(test));
+    }
+
+    // the model ends up over the last hole at the retract level
+    copy_vector(cd.position, cm->gmx.position);
+    cm->gm.target[cd.plane_axis_0] = test[cd.plane_axis_0];
+    cm->gm.target[cd.plane_axis_1] = test[cd.plane_axis_1];
+    cm->gm.target[cd.drill_axis] = cd.retract;
+    cm_set_display_offsets(&cm->gm);                        // capture the fully resolved offsets to gm
+    memcpy(&cd.gm, &cm->gm, sizeof(GCodeState_t));          // copy Gcode context for the moves
+    cd.cycle = motion_mode;
+    cd.state = CANNED_CLEAR;
+
+    cm_cycle_start();                                       // if not already started
+    cm_update_model_position();
+    return (STAT_OK);
+}
+
+/****************************************************************************************
+ * cm_canned_cycle_callback() - queue the moves of a canned cycle
+ *
+ *  Called from the controller main loop. Queues one planner buffer per call, skipping
+ *  steps that have nothing to do, and returns EAGAIN until the last one is queued.
+ */
+
+stat_t cm_canned_cycle_callback()
+{
+    if (cd.state == CANNED_INACTIVE) {
+        return (STAT_NOOP);
+    }
+    while (cd.state != CANNED_INACTIVE) {
+        if (mp_planner_is_full(mp)) {
+            return (STAT_EAGAIN);
+        }
+        if (_canned_step()) {
+            return ((cd.state == CANNED_INACTIVE) ? STAT_OK : STAT_EAGAIN);
+        }
+    }
+    return (STAT_OK);
+}
+
+/*
+ * _canned_move()           - queue a rapid or feed of one axis or the two plane axes
+ * _exec_spindle_stop()     - spindle exec for G86 at the bottom of the hole
+ * _exec_spindle_reverse()  - spindle exec for G84 at the bottom of the hole
+ * _exec_spindle_restore()  - undo either of them
+ * _canned_step()           - run one step of the cycle - returns true if a buffer was queued
+ *
+ *  The spindle execs run in the planner queue, so they see the spindle as the preceding
+ *  M3/M4/M5 left it, not as it is when the block is parsed.
+ */
+
+static bool _canned_move(const cmMotionMode motion_mode, const uint8_t axis, const float position)
+{
+    if (fp_EQ(cd.position[axis], position)) {
+        return (false);
+    }
+    copy_vector(cd.gm.target, cd.position);
+    cd.gm.target[axis] = position;
+    cd.gm.motion_mode = motion_mode;
+    cm_cycle_start();
+    mp_aline(&cd.gm);                                       // a too-short move is dropped, as for arc segments
+    copy_vector(cd.position, cd.gm.target);
+    return (true);
+}
+
+static bool _canned_move_to_hole()
+{
+    if (fp_EQ(cd.position[cd.plane_axis_0], cd.hole[0]) && fp_EQ(cd.position[cd.plane_axis_1], cd.hole[1])) {
+        return (false);
+    }
+    copy_vector(cd.gm.target, cd.position);
+    cd.gm.target[cd.plane_axis_0] = cd.hole[0];
+    cd.gm.target[cd.plane_axis_1] = cd.hole[1];
+    cd.gm.motion_mode = MOTION_MODE_STRAIGHT_TRAVERSE;
+    cm_cycle_start();
+    mp_aline(&cd.gm);
+    copy_vector(cd.position, cd.gm.target);
+    return (true);
+}
+
+static void _exec_spindle_stop(float *value, bool *flag)
+{
+    cd.spindle_state = spindle.state;
+    if ((spindle.state == SPINDLE_CW) || (spindle.state == SPINDLE_CCW)) {
+        spindle_control_immediate(SPINDLE_OFF);
+    }
+}
+
+static void _exec_spindle_reverse(float *value, bool *flag)
+{
+    cd.spindle_state = spindle.state;
+    if (spindle.state == SPINDLE_CW) {
+        spindle_control_immediate(SPINDLE_CCW);
+    } else if (spindle.state == SPINDLE_CCW) {
+        spindle_control_immediate(SPINDLE_CW);
+    }
+}
+
+static void _exec_spindle_restore(float *value, bool *flag)
+{
+    if ((cd.spindle_state == SPINDLE_CW) || (cd.spindle_state == SPINDLE_CCW)) {
+        spindle_control_immediate((spControl)cd.spindle_state);
+    }
+}
+
+static bool _canned_step()
+{
+    switch (cd.state) {
+        case CANNED_CLEAR: {
+            cd.state = CANNED_HOLE;
+            if (cd.position[cd.drill_axis] < cd.r_plane) {
+                return (_canned_move(MOTION_MODE_STRAIGHT_TRAVERSE, cd.drill_axis, cd.r_plane));
+            }
+            return (false);
+        }
+        case CANNED_HOLE: {
+            cd.state = CANNED_R_PLANE;
+            return (_canned_move_to_hole());
+        }
+        case CANNED_R_PLANE: {
+            cd.state = CANNED_FEED_IN;
+            cd.depth = cd.r_plane;
+            return (_canned_move(MOTION_MODE_STRAIGHT_TRAVERSE, cd.drill_axis, cd.r_plane));
+        }
+        case CANNED_FEED_IN: {
+            float depth = cd.bottom;
+            if (cd.peck > 0) {
+                depth = max(cd.depth - cd.peck, cd.bottom);
+            }
+            cd.depth = depth;
+            cd.state = (depth > cd.bottom) ? CANNED_PECK_OUT : CANNED_BOTTOM;
+            return (_canned_move(MOTION_MODE_STRAIGHT_FEED, cd.drill_axis, depth));
+        }
+        case CANNED_PECK_OUT: {
+            cd.state = CANNED_PECK_IN;
+            return (_canned_move(MOTION_MODE_STRAIGHT_TRAVERSE, cd.drill_axis, cd.r_plane));
+        }
+        case CANNED_PECK_IN: {
+            cd.state = CANNED_FEED_IN;
+            return (_canned_move(MOTION_MODE_STRAIGHT_TRAVERSE, cd.drill_axis, min(cd.depth + CANNED_PECK_CLEARANCE, cd.r_plane)));
+        }
+        case CANNED_BOTTOM: {
+            cd.state = CANNED_FEED_OUT;
+            if (cd.dwell > 0) {                                     // G82, G89
+                mp_dwell(cd.dwell);
+                return (true);
+            }
+            if (cd.cycle == MOTION_MODE_CANNED_CYCLE_84) {
+                mp_queue_command(_exec_spindle_reverse, nullptr, nullptr);   // the execs take no arguments
+                return (true);
+            }
+            if (cd.cycle == MOTION_MODE_CANNED_CYCLE_86) {
+                mp_queue_command(_exec_spindle_stop, nullptr, nullptr);
+                return (true);
+            }
+            return (false);
+        }
+        case CANNED_FEED_OUT: {
+            cd.state = CANNED_RAPID_OUT;
+            if ((cd.cycle == MOTION_MODE_CANNED_CYCLE_84) ||
+                (cd.cycle == MOTION_MODE_CANNED_CYCLE_85) ||
+                (cd.cycle == MOTION_MODE_CANNED_CYCLE_89)) {
+                return (_canned_move(MOTION_MODE_STRAIGHT_FEED, cd.drill_axis, cd.r_plane));
+            }
+            return (false);
+        }
+        case CANNED_RAPID_OUT: {
+            cd.state = CANNED_RESTORE;
+            return (_canned_move(MOTION_MODE_STRAIGHT_TRAVERSE, cd.drill_axis, cd.retract));
+        }
+        case CANNED_RESTORE: {
+            bool queued = false;
+            if ((cd.cycle == MOTION_MODE_CANNED_CYCLE_84) || (cd.cycle == MOTION_MODE_CANNED_CYCLE_86)) {
+                mp_queue_command(_exec_spindle_restore, nullptr, nullptr);
+                queued = true;
+            }
+            if (--cd.holes > 0) {
+                cd.hole[0] += cd.step[0];
+                cd.hole[1] += cd.step[1];
+                cd.state = CANNED_HOLE;
+            } else {
+                cd.state = CANNED_INACTIVE;
+            }
+            return (queued);
+        }
+        default: {
+            cd.state = CANNED_INACTIVE;
+            return (false);
+        }
+    }
+}
@@ -359,7 +359,7 @@ static void _start_cycle_restart()
         }
         switch (cm1.hold_exit) {
             case FEEDHOLD_EXIT_CYCLE:     { op.add_action(_run_restart_cycle); break; }
-            case FEEDHOLD_EXIT_FLUSH:     { op.add_action(_run_queue_flush); } // no break
+            case FEEDHOLD_EXIT_FLUSH:     { op.add_action(_run_queue_flush); } // fall through
             case FEEDHOLD_EXIT_STOP:      { op.add_action(_run_program_stop); break; }
             case FEEDHOLD_EXIT_END:       { op.add_action(_run_program_end); break; }
             case FEEDHOLD_EXIT_ALARM:     { op.add_action(_run_alarm); break; }
@@ -410,6 +410,8 @@ static void _start_queue_flush()
 static stat_t _run_queue_flush()            // typically runs from cm1 planner
 {
     cm_abort_arc(cm);                       // kill arcs so they don't just create more alines
+    cm_abort_canned_cycle();                // ...and canned cycles
+    cm_abort_raster();                      // ...and laser raster rows
     planner_reset((mpPlanner_t *)cm->mp);   // reset primary planner. also resets the mr under the planner
     cm_reset_position_to_absolute_position(cm);
     cm1.queue_flush_state = QUEUE_FLUSH_OFF;
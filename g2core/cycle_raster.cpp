@@ -0,0 +1,337 @@
+/*
+ * cycle_raster.cpp - laser raster rows
+ * This file is part of the g2core project
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, you may use this file as part of a software library without
+ * restriction. Specifically, if other files instantiate templates or use macros or
+ * inline functions from this file, or you compile this file and link it with  other
+ * files to produce an executable, this file does not by itself cause the resulting
+ * executable to be covered by the GNU General Public License. This exception does not
+ * however invalidate any other reasons why the executable file might be covered by the
+ * GNU General Public License.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/*
+ * LASER RASTER ROWS
+ *
+ *  A raster row is a single G1 that carries the laser power of every pixel along it, so
+ *  an engraving is one line per scan row rather than a G1 ... S line per pixel:
+ *
+ *      G1 X50 F6000 ({rast:"AAAQIDBAUGBwgJCgsMDQ4PD/"})
+ *
+ *  The pixels are base64 encoded bytes, 0 - 255 for no power up to S, spread evenly from
+ *  the current position to the target. Laser spindle mode ({spmo:3}) is required. M3/M4
+ *  and S apply as for any other G1 in laser mode - M4 still scales the power with the
+ *  velocity. The runtime fires each segment at the mean of the pixels under it, so a pixel
+ *  is only resolved if it is at least a segment long (velocity x NOM_SEGMENT_MS).
+ *
+ *  With an overscan set ({spov:}) the row is run with the laser off for that distance
+ *  before and after it, so the head is at speed at the first pixel and only slows past
+ *  the last one. Each row runs:
+ *      - rapid back along the row by the overscan
+ *      - lead in to the start of the row, laser off
+ *      - the row
+ *      - lead out past the end of the row, laser off
+ *
+ *  The head is left at the lead-out end. The model position is the end of the row, as
+ *  programmed, so the next move - normally the step over to the next row - starts from
+ *  the lead-out and takes up the way back. A separate return traverse would be undone
+ *  straight away by the next row's back-off whenever rows alternate direction.
+ *
+ *  Rows run in either direction, so scanning back and forth is just alternating the target
+ *  of each row. The moves are queued from cm_raster_callback() as the planner has room,
+ *  the same way canned cycles are.
+ *
+ *  Rows are held in a small pool from when their move is queued until the runtime starts
+ *  the move after it. A row waits in the callback for a free slot.
+ */
+
+#include "g2core.h"
+#include "config.h"
+#include "canonical_machine.h"
+#include "planner.h"
+#include "spindle.h"
+#include "util.h"
+#include "xio.h"                    // for char definitions
+
+#ifndef RASTER_ROWS
+#define RASTER_ROWS 4                   // rows in the planner and runtime at once
+#endif
+#ifndef RASTER_ROW_PIXELS
+#define RASTER_ROW_PIXELS 320           // most pixels in a row - 428 chars of base64
+#endif
+
+typedef enum {
+    RASTER_INACTIVE = 0,            // no row being queued
+    RASTER_BACK_OFF,                // rapid back by the overscan
+    RASTER_LEAD_IN,                 // feed to the start of the row, laser off
+    RASTER_ROW,                     // the row, once there is a free slot for it
+    RASTER_LEAD_OUT                 // feed on past the end of the row, laser off
+} rsRasterState;
+
+/**** Raster singleton structure ****/
+
+struct rsRasterSingleton {
+    // row pool - rows are loaded by the model and released by the runtime, in order
+    uint8_t row[RASTER_ROWS][RASTER_ROW_PIXELS];
+    uint16_t pixels[RASTER_ROWS];
+    float row_start[RASTER_ROWS][AXES];     // where each row starts...
+    float row_step[RASTER_ROWS][AXES];      // ...and the row's unit vector divided by the pixel length
+    volatile uint32_t loaded;       // rows queued
+    volatile uint32_t released;     // rows done with
+    volatile bool running;          // the runtime is in the move of the oldest row
+
+    // row being queued - all positions are machine coordinates in mm
+    rsRasterState state;
+    uint8_t staged[RASTER_ROW_PIXELS];  // the row as decoded, until it has a slot
+    uint16_t staged_pixels;
+    float spindle_speed;            // S for the row
+    float start[AXES];              // start of the row
+    float end[AXES];                // end of the row
+    float overscan[AXES];           // overscan along the row
+
+    GCodeState_t gm;                // Gcode state sent with each move
+};
+static struct rsRasterSingleton rs;
+
+/**** NOTE: global prototypes and other .h info is located in canonical_machine.h ****/
+
+static void _raster_step(void);
+
+/****************************************************************************************
+ * cm_abort_raster() - stop queueing a row and drop all rows. Only call with motion stopped
+ */
+
+void cm_abort_raster()
+{
+    rs.state = RASTER_INACTIVE;
+    rs.released = rs.loaded;
+    rs.running = false;
+}
+
+/****************************************************************************************
+ * cm_raster_feed() - canonical machine entry point for a G1 that may carry a raster row
+ *
+ *  Values are as programmed (units, distance mode and offsets not yet applied). If the
+ *  active comment has no row this is an ordinary G1.
+ */
+
+static char *_raster_data(char *active_comment)     // find and terminate the row's base64
+{
+    for (char *p = strstr(active_comment, "rast"); p != NULL; p = strstr(p+1, "rast")) {
+        char *key = (p[-1] == '"') ? p-1 : p;           // quoted or relaxed JSON key
+        if ((key == active_comment) || ((key[-1] != '{') && (key[-1] != ','))) {
+            continue;                                   // part of some other key or string
+        }
+        char *data = p + 4;
+        if (*key == '"') {
+            if (*data++ != '"') { continue; }
+        }
+        if ((*data++ != ':') || (*data++ != '"')) {
+            return (NULL);
+        }
+        char *end = strchr(data, '"');
+        if (end == NULL) {
+            return (NULL);
+        }
+        *end = NUL;
+        return (data);
+    }
+    return (NULL);
+}
+
+stat_t cm_raster_feed(const float target[], const bool flags[], char *active_comment)
+{
+    char *data = _raster_data(active_comment);
+    if (data == NULL) {
+        return (cm_straight_feed(target, flags, PROFILE_NORMAL));
+    }
+
+    // trap specification errors
+    if (spindle.mode != SPINDLE_LASER) {
+        return (STAT_RASTER_REQUIRES_LASER_MODE);
+    }
+    if (cm->gm.feed_rate_mode == INVERSE_TIME_MODE) {
+        return (STAT_INVERSE_TIME_MODE_CANNOT_BE_USED);
+    }
+    if (fp_ZERO(cm->gm.feed_rate)) {
+        return (STAT_FEEDRATE_NOT_SPECIFIED);
+    }
+    int16_t pixels = base64_decode(rs.staged, data, RASTER_ROW_PIXELS);
+    if (pixels <= 0) {
+        return (STAT_RASTER_ROW_INVALID);
+    }
+    cm->gm.motion_mode = MOTION_MODE_STRAIGHT_FEED;
+
+    if (!(flags[AXIS_X] | flags[AXIS_Y] | flags[AXIS_Z] |
+          flags[AXIS_U] | flags[AXIS_V] | flags[AXIS_W] |
+          flags[AXIS_A] | flags[AXIS_B] | flags[AXIS_C])) {
+        return(STAT_OK);
+    }
+    cm_set_model_target(target, flags);
+    copy_vector(rs.start, cm->gmx.position);
+    copy_vector(rs.end, cm->gm.target);
+    float length = get_axis_vector_length(rs.start, rs.end);
+    if (length < EPSILON) {
+        return (STAT_OK);                                   // nothing to engrave
+    }
+
+    // soft limit test the row including its overscan - the row can't fail once it starts queueing
+    float test[AXES];
+    for (uint8_t a = 0; a < AXES; a++) {
+        rs.overscan[a] = (rs.end[a] - rs.start[a]) / length * spindle.laser_overscan;
+        test[a] = rs.start[a] - rs.overscan[a];
+    }
+    ritorno(cm_test_soft_limits(test));
+    for (uint8_t a = 0; a < AXES; a++) {
+        test[a] = rs.end[a] + rs.overscan[a];
+    }
+    ritorno(cm_test_soft_limits(test));
+
+    cm_set_display_offsets(&cm->gm);                        // capture the fully resolved offsets to gm
+    memcpy(&rs.gm, &cm->gm, sizeof(GCodeState_t));          // copy Gcode context for the moves
+    rs.gm.path_control = PATH_CONTINUOUS;                   // never stop between the overscan and the row
+    rs.spindle_speed = cm->gm.spindle_speed;
+    rs.staged_pixels = pixels;
+    rs.state = fp_ZERO(spindle.laser_overscan) ? RASTER_ROW : RASTER_BACK_OFF;
+
+    cm_cycle_start();                                       // if not already started
+    cm_update_model_position();
+    return (STAT_OK);
+}
+
+/****************************************************************************************
+ * cm_raster_callback() - queue the moves of a raster row
+ *
+ *  Called from the controller main loop. Queues one planner buffer per call and returns
+ *  EAGAIN until the last one is queued.
+ */
+
+stat_t cm_raster_callback()
+{
+    if (rs.state == RASTER_INACTIVE) {
+        return (STAT_NOOP);
+    }
+    if (mp_planner_is_full(mp)) {
+        return (STAT_EAGAIN);
+    }
+    if ((rs.state == RASTER_ROW) && ((rs.loaded - rs.released) >= RASTER_ROWS)) {
+        return (STAT_EAGAIN);                               // wait for the runtime to free a row
+    }
+    _raster_step();
+    return ((rs.state == RASTER_INACTIVE) ? STAT_OK : STAT_EAGAIN);
+}
+
+/*
+ * _raster_move() - queue a move to a point on the row, offset by a multiple of the overscan
+ * _raster_step() - run one step of the row
+ */
+
+static void _raster_move(const cmMotionMode motion_mode, const float base[], const float overscan,
+                         const bool laser, const uint8_t row)
+{
+    for (uint8_t a = 0; a < AXES; a++) {
+        rs.gm.target[a] = base[a] + (rs.overscan[a] * overscan);
+    }
+    rs.gm.motion_mode = motion_mode;
+    rs.gm.spindle_speed = laser ? rs.spindle_speed : 0;
+    rs.gm.raster_row = row;
+    cm_cycle_start();
+    mp_aline(&rs.gm);                                       // a too-short move is dropped, as for arc segments
+}
+
+static void _raster_step()
+{
+    switch (rs.state) {
+        case RASTER_BACK_OFF: {
+            rs.state = RASTER_LEAD_IN;
+            _raster_move(MOTION_MODE_STRAIGHT_TRAVERSE, rs.start, -1, false, 0);
+            break;
+        }
+        case RASTER_LEAD_IN: {
+            rs.state = RASTER_ROW;
+            _raster_move(MOTION_MODE_STRAIGHT_FEED, rs.start, 0, false, 0);
+            break;
+        }
+        case RASTER_ROW: {
+            uint8_t slot = rs.loaded % RASTER_ROWS;
+            memcpy(rs.row[slot], rs.staged, rs.staged_pixels);
+            rs.pixels[slot] = rs.staged_pixels;
+            float length = get_axis_vector_length(rs.start, rs.end);
+            for (uint8_t a = 0; a < AXES; a++) {
+                rs.row_start[slot][a] = rs.start[a];
+                rs.row_step[slot][a] = (rs.end[a] - rs.start[a]) / length * (rs.staged_pixels / length);
+            }
+            rs.loaded++;
+            rs.state = fp_ZERO(spindle.laser_overscan) ? RASTER_INACTIVE : RASTER_LEAD_OUT;
+            _raster_move(MOTION_MODE_STRAIGHT_FEED, rs.end, 0, true, slot+1);
+            break;
+        }
+        case RASTER_LEAD_OUT: {
+            rs.state = RASTER_INACTIVE;
+            _raster_move(MOTION_MODE_STRAIGHT_FEED, rs.end, 1, false, 0);
+            break;
+        }
+        default: {
+            rs.state = RASTER_INACTIVE;
+        }
+    }
+}
+
+/****************************************************************************************
+ * cm_raster_start_block() - runtime: an aline is starting - release the rows it follows
+ * cm_raster_power()       - runtime: mean pixel power [0..1] over a segment of a row's move
+ *
+ *  row is the gm.raster_row of the block - the slot + 1, or 0 if it has no row. from and
+ *  to are the segment's start and end positions. Pixels are found by position rather than
+ *  time so a row resumed from a feedhold picks up where it stopped.
+ */
+
+void cm_raster_start_block(const uint8_t row)
+{
+    if (row != 0) {
+        while ((rs.released != rs.loaded) && ((rs.released % RASTER_ROWS) != (uint32_t)(row-1))) {
+            rs.released++;                                  // rows whose moves were too short to run
+        }
+        rs.running = true;
+    } else if (rs.running) {
+        rs.released++;
+        rs.running = false;
+    }
+}
+
+static float _raster_pixel(const uint8_t slot, const float position[])
+{
+    float pixel = 0;
+    for (uint8_t a = 0; a < AXES; a++) {
+        pixel += (position[a] - rs.row_start[slot][a]) * rs.row_step[slot][a];
+    }
+    return (pixel);
+}
+
+float cm_raster_power(const uint8_t row, const float from[], const float to[])
+{
+    uint8_t slot = row-1;
+    int32_t pixels = rs.pixels[slot];
+    int32_t first = min(max((int32_t)floorf(_raster_pixel(slot, from) + EPSILON3), (int32_t)0), pixels-1);
+    int32_t last = min((int32_t)ceilf(_raster_pixel(slot, to) - EPSILON3), pixels);
+    if (last <= first) {
+        last = first+1;
+    }
+    uint32_t sum = 0;
+    for (int32_t i = first; i < last; i++) {
+        sum += rs.row[slot][i];
+    }
+    return ((float)sum / (float)((last - first) * 255));
+}
@@ -0,0 +1,227 @@
+/*
+ * host_socket/host_socket.h - a serial-like xio device on a Unix-domain socket, for host builds
+ * This file is part of the G2 project
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, you may use this file as part of a software library without
+ * restriction. Specifically, if other files instantiate templates or use macros or
+ * inline functions from this file, or you compile this file and link it with  other
+ * files to produce an executable, this file does not by itself cause the resulting
+ * executable to be covered by the GNU General Public License. This exception does not
+ * however invalidate any other reasons why the executable file might be covered by the
+ * GNU General Public License.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef HOST_SOCKET_H_ONCE
+#define HOST_SOCKET_H_ONCE
+
+#include <functional>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+/* HostSocketSerial
+ *
+ *  Presents the same transfer interface as the Motate serial devices, so it drops into
+ *  xioDeviceWrapper<> the way SerialUSB does. One client is accepted at a time:
+ *  a client connecting is treated as DTR asserted, and the client closing (or any socket
+ *  error) as DTR dropped - both are reported through the connection callback, which the
+ *  wrapper forwards to controller_set_connected().
+ *
+ *  There are no interrupts on the host, so transfers only progress when periodic() is called.
+ *  An RX transfer completes as soon as any data arrives (like a short USB packet), a TX
+ *  transfer completes once every byte of it has been accepted by the socket.
+ */
+
+struct HostSocketSerial {
+    const char *_path;
+    int _listen_fd = -1;
+    int _client_fd = -1;
+
+    std::function<void(bool)> _connection_callback;
+    std::function<void()> _rx_done_callback;
+    std::function<void()> _tx_done_callback;
+
+    char *_rx_position = nullptr;           // next byte an RX transfer will write
+    char *_rx_end = nullptr;
+    bool _rx_active = false;
+
+    char *_tx_position = nullptr;           // next byte a TX transfer will send
+    char *_tx_end = nullptr;
+    bool _tx_active = false;
+
+    HostSocketSerial(const char *path) : _path{path} {};
+
+    // begin() - create the listening socket. Returns false if it could not be created.
+    bool begin() {
+        struct sockaddr_un addr;
+        if (strlen(_path) >= sizeof(addr.sun_path)) {
+            return false;
+        }
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        strcpy(addr.sun_path, _path);
+
+        unlink(_path);                      // remove a stale socket left by a previous run
+        _listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (_listen_fd < 0) {
+            return false;
+        }
+        if ((bind(_listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) || (listen(_listen_fd, 1) != 0)) {
+            close(_listen_fd);
+            _listen_fd = -1;
+            return false;
+        }
+        _setNonBlocking(_listen_fd);
+        return true;
+    };
+
+    bool isConnected() { return (_client_fd >= 0); };
+
+    void setConnectionCallback(std::function<void(bool)> &&callback) { _connection_callback = std::move(callback); };
+    void setRXTransferDoneCallback(std::function<void()> &&callback) { _rx_done_callback = std::move(callback); };
+    void setTXTransferDoneCallback(std::function<void()> &&callback) { _tx_done_callback = std::move(callback); };
+
+    const char *getRXTransferPosition() { return _rx_position; };
+    const char *getTXTransferPosition() { return _tx_position; };
+
+    bool startRXTransfer(char *&buffer, uint16_t length) {
+        if (_rx_active || (length == 0)) {
+            return false;
+        }
+        _rx_position = buffer;
+        _rx_end = buffer + length;
+        _rx_active = true;
+        return true;
+    };
+
+    bool startTXTransfer(char *&buffer, uint16_t length) {
+        if (_tx_active || !isConnected() || (length == 0)) {
+            return false;
+        }
+        _tx_position = buffer;
+        _tx_end = buffer + length;
+        _tx_active = true;
+        return true;
+    };
+
+    // flush() - abandon the TX transfer in progress
+    void flush() {
+        if (_tx_active) {
+            _tx_position = _tx_end;
+            _finishTX();
+        }
+    };
+
+    // flushRead() - discard whatever the client has sent that hasn't been read yet
+    void flushRead() {
+        char scratch[256];
+        if (isConnected()) {
+            while (recv(_client_fd, scratch, sizeof(scratch), MSG_DONTWAIT) > 0);
+        }
+    };
+
+    // periodic() - accept a client, and move data for the transfers in progress. Call from the main loop.
+    void periodic() {
+        if (!isConnected()) {
+            _accept();
+            return;
+        }
+        while (_rx_active && _receive());   // the done callback normally starts the next transfer
+        while (_tx_active && _send());
+        if (isConnected() && !_rx_active) {
+            _checkHangup();                 // nothing is being read, so look for the client closing
+        }
+    };
+
+    /**** internals ****/
+
+    void _setNonBlocking(int fd) { fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK); };
+
+    void _accept() {
+        if (_listen_fd < 0) {
+            return;
+        }
+        int fd = accept(_listen_fd, nullptr, nullptr);
+        if (fd < 0) {
+            return;
+        }
+        _setNonBlocking(fd);
+        _client_fd = fd;
+        if (_connection_callback) {
+            _connection_callback(true);
+        }
+    };
+
+    void _hangup() {
+        close(_client_fd);
+        _client_fd = -1;
+        flush();                            // nobody left to send to - let the TXBuffer move on
+        if (_connection_callback) {
+            _connection_callback(false);
+        }
+    };
+
+    void _finishTX() {
+        _tx_active = false;
+        if (_tx_done_callback) {
+            _tx_done_callback();
+        }
+    };
+
+    // returns true if the transfer completed and another pass may make progress
+    bool _receive() {
+        ssize_t length = recv(_client_fd, _rx_position, _rx_end - _rx_position, 0);
+        if (length > 0) {
+            _rx_position += length;
+            _rx_active = false;
+            if (_rx_done_callback) {
+                _rx_done_callback();
+            }
+            return true;
+        }
+        if ((length == 0) || ((errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR))) {
+            _hangup();
+        }
+        return false;
+    };
+
+    bool _send() {
+        ssize_t length = send(_client_fd, _tx_position, _tx_end - _tx_position, MSG_NOSIGNAL);
+        if (length > 0) {
+            _tx_position += length;
+            if (_tx_position == _tx_end) {
+                _finishTX();
+                return true;
+            }
+            return false;                   // socket is full - try again next time
+        }
+        if ((length < 0) && (errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR)) {
+            _hangup();
+        }
+        return false;
+    };
+
+    void _checkHangup() {
+        char c;
+        ssize_t length = recv(_client_fd, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+        if ((length == 0) || ((length < 0) && (errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR))) {
+            _hangup();
+        }
+    };
+};
+
+#endif  // HOST_SOCKET_H_ONCE
@@ -107,7 +107,7 @@ char *get_status_message(stat_t status);
 #define STAT_FAILED_GET_PLANNER_BUFFER 36
 
 #define STAT_ERROR_37 37
-#define STAT_ERROR_38 38
+#define STAT_CONFIG_SNAPSHOT_MISMATCH 38    // config snapshot is from another firmware build or out of order
 #define STAT_ERROR_39 39
 
 #define STAT_ERROR_40 40
@@ -278,20 +278,28 @@ char *get_status_message(stat_t status);
 #define STAT_T_WORD_IS_MISSING 180
 #define STAT_T_WORD_IS_INVALID 181
 
+/* Gcode expression, parameter and O word errors */
+
+#define STAT_EXPRESSION_SYNTAX_ERROR 182
+#define STAT_EXPRESSION_DOMAIN_ERROR 183
+#define STAT_PARAMETER_INVALID 184
+#define STAT_PARAMETER_TABLE_FULL 185
+#define STAT_O_WORD_INVALID 186
+#define STAT_O_WORD_STORE_FULL 187
+#define STAT_O_WORD_NESTING_TOO_DEEP 188
+#define STAT_O_WORD_SUBROUTINE_UNDEFINED 189
+
+/* laser raster errors */
+
+#define STAT_RASTER_ROW_INVALID 190
+#define STAT_RASTER_REQUIRES_LASER_MODE 191
+
+/* heater autotune errors */
+
+#define STAT_TEMPERATURE_AUTOTUNE_FAILED 192
+
 /* reserved for Gcode or other program errors */
 
-#define STAT_ERROR_182 182
-#define STAT_ERROR_183 183
-#define STAT_ERROR_184 184
-#define STAT_ERROR_185 185
-#define STAT_ERROR_186 186
-#define STAT_ERROR_187 187
-#define STAT_ERROR_188 188
-#define STAT_ERROR_189 189
-
-#define STAT_ERROR_190 190
-#define STAT_ERROR_191 191
-#define STAT_ERROR_192 192
 #define STAT_ERROR_193 193
 #define STAT_ERROR_194 194
 #define STAT_ERROR_195 195
@@ -417,7 +425,7 @@ static const char stat_35[] = "Bad status report setting";
 static const char stat_36[] = "Failed to get planner buffer";
 
 static const char stat_37[] = "Backplan hit running buffer";
-static const char stat_38[] = "38";
+static const char stat_38[] = "Config snapshot does not match";
 static const char stat_39[] = "39";
 
 static const char stat_40[] = "40";
@@ -573,18 +581,18 @@ static const char stat_179[] = "S word invalid";
 
 static const char stat_180[] = "T word missing";
 static const char stat_181[] = "T word invalid";
-static const char stat_182[] = "182";
-static const char stat_183[] = "183";
-static const char stat_184[] = "184";
-static const char stat_185[] = "185";
-static const char stat_186[] = "186";
-static const char stat_187[] = "187";
-static const char stat_188[] = "188";
-static const char stat_189[] = "189";
-
-static const char stat_190[] = "190";
-static const char stat_191[] = "191";
-static const char stat_192[] = "192";
+static const char stat_182[] = "Expression syntax error";
+static const char stat_183[] = "Expression domain error";
+static const char stat_184[] = "Parameter undefined or invalid";
+static const char stat_185[] = "Named parameter table full";
+static const char stat_186[] = "O word invalid or out of place";
+static const char stat_187[] = "O word program store full";
+static const char stat_188[] = "O word nesting too deep";
+static const char stat_189[] = "O word subroutine undefined";
+static const char stat_190[] = "Raster row invalid or too long";
+static const char stat_191[] = "Raster requires laser spindle mode";
+
+static const char stat_192[] = "Heater autotune failed";
 static const char stat_193[] = "193";
 static const char stat_194[] = "194";
 static const char stat_195[] = "195";
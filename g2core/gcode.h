@@ -78,6 +78,11 @@ typedef enum {              // G Modal Group 13
     PATH_CONTINUOUS         // G64 and typically the default mode
 } cmPathControl;
 
+typedef enum {                      // canned cycle return mode
+    RETRACT_TO_INITIAL_LEVEL = 0,   // G98 - retract to the level the cycle started from
+    RETRACT_TO_R_PLANE              // G99 - retract to the R plane
+} cmRetractMode;
+
 typedef enum {
     ABSOLUTE_DISTANCE_MODE = 0, // G90 / G90.1
     INCREMENTAL_DISTANCE_MODE   // G91 / G91.1
@@ -169,6 +174,7 @@ typedef struct GCodeState {             // Gcode model state - used by model, pl
 
     float feed_rate;                    // F - normalized to millimeters/minute or in inverse time mode
     float P_word;                       // P - parameter used for dwell time in seconds, G10 coord select...
+    float spindle_speed;                // S - applied per segment in laser mode, otherwise last S sent to the spindle
 
     cmFeedRateMode feed_rate_mode;      // See cmFeedRateMode for settings
     cmCanonicalPlane select_plane;      // G17,G18,G19 - values to set plane to
@@ -180,6 +186,8 @@ typedef struct GCodeState {             // Gcode model state - used by model, pl
     cmCoordSystem coord_system;         // G54-G59 - select coordinate system 1-9
     uint8_t tool;               // G    // M6 tool change - moves "tool_select" to "tool"
     uint8_t tool_select;        // G    // T value - T sets this value
+    uint8_t spindle_control;            // M3,M4,M5 as spControl - laser mode only, as above
+    uint8_t raster_row;                 // laser raster row played out along the move + 1, 0 for none
 
     void reset() {
         linenum = 0;
@@ -192,6 +200,7 @@ typedef struct GCodeState {             // Gcode model state - used by model, pl
 
         feed_rate = 0.0;
         P_word = 0.0;
+        spindle_speed = 0.0;
 
         feed_rate_mode = INVERSE_TIME_MODE;
         select_plane = CANON_PLANE_XY;
@@ -203,7 +212,8 @@ typedef struct GCodeState {             // Gcode model state - used by model, pl
         coord_system = ABSOLUTE_COORDS;
         tool = 0;
         tool_select = 0;
-
+        spindle_control = 0;            // SPINDLE_OFF
+        raster_row = 0;
     };
 } GCodeState_t;
 
@@ -236,6 +246,11 @@ typedef struct GCodeStateExtended {     // Gcode dynamic state extensions - used
  */
 void gcode_parser_init(void);
 stat_t gcode_parser(char* block);
+bool gcode_lookahead_is_full(void);
+bool gcode_lookahead_add(char* line);
+char* gcode_lookahead_line(void);
+stat_t gcode_lookahead_run(void);
+void gcode_lookahead_flush(void);
 stat_t gc_get_gc(nvObj_t* nv);
 stat_t gc_run_gc(nvObj_t* nv);
 
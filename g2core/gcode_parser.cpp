@@ -22,9 +22,11 @@
 #include "controller.h"
 #include "gcode.h"
 #include "canonical_machine.h"
+#include "gcode_program.h"
 #include "settings.h"
 #include "spindle.h"
 #include "coolant.h"
+#include "gpio.h"
 #include "util.h"
 #include "xio.h"                    // for char definitions
 
@@ -41,7 +43,7 @@ static stat_t _execute_gcode_block_marlin(void);
 
 typedef enum {                          // Used for detecting gcode errors. See NIST section 3.4
     MODAL_GROUP_G0 = 0,                 // {G10,G28,G28.1,G92}  non-modal axis commands (note 1)
-    MODAL_GROUP_G1,                     // {G0,G1,G2,G3,G80}    motion
+    MODAL_GROUP_G1,                     // {G0,G1,G2,G3,G80-G89} motion
     MODAL_GROUP_G2,                     // {G17,G18,G19}        plane selection
     MODAL_GROUP_G3,                     // {G90,G91}            distance mode
     MODAL_GROUP_G5,                     // {G93,G94}            feed rate mode
@@ -106,6 +108,7 @@ typedef enum {                                  // these are in order to optimiz
     NEXT_ACTION_MARLIN_REPORT_VERSION,          // M115
     NEXT_ACTION_MARLIN_DISPLAY_ON_SCREEN,       // M117
     NEXT_ACTION_MARLIN_SET_BED_TEMP,            // M140, M190
+    NEXT_ACTION_MARLIN_AUTOTUNE_HEATER,         // M303
 #endif
 
 } gpNextAction;
@@ -121,12 +124,13 @@ typedef struct GCodeInputValue {    // Gcode inputs - meaning depends on context
 
     float target[AXES];             // XYZABC where the move should go
     float arc_offset[3];            // IJK - used by arc commands
-    float arc_radius;               // R word - radius value in arc radius mode
+    float arc_radius;               // R word - radius value in arc radius mode, R plane in canned cycles
     float F_word;                   // F word - feedrate as present in the F word (will be normalized later)
     float P_word;                   // P word - parameter used for dwell time in seconds, G10 commands
+    float Q_word;                   // Q word - peck depth in canned cycles, M62/M63 distance into the move
     float S_word;                   // S word - usually in RPM
     uint8_t H_word;                 // H word - used by G43s
-    uint8_t L_word;                 // L word - used by G10s
+    uint8_t L_word;                 // L word - used by G10s, repeats in canned cycles
 
     uint8_t feed_rate_mode;         // See cmFeedRateMode for settings
     uint8_t select_plane;           // G17,G18,G19 - values to set plane to
@@ -135,6 +139,7 @@ typedef struct GCodeInputValue {    // Gcode inputs - meaning depends on context
     uint8_t path_control;           // G61... EXACT_PATH, EXACT_STOP, CONTINUOUS
     uint8_t distance_mode;          // G91   0=use absolute coords(G90), 1=incremental movement
     uint8_t arc_distance_mode;      // G90.1=use absolute IJK offsets, G91.1=incremental IJK offsets
+    uint8_t retract_mode;           // G98=retract to initial level, G99=retract to R plane
     uint8_t origin_offset_mode;     // G92...TRUE=in origin offset mode
     uint8_t absolute_override;      // G53 TRUE = move using machine coordinates - this block only (G53)
     
@@ -145,6 +150,7 @@ typedef struct GCodeInputValue {    // Gcode inputs - meaning depends on context
     uint8_t coolant_flood;          // TRUE = flood on (M8)
     uint8_t coolant_off;            // TRUE = turn off all coolants (M9)
     uint8_t spindle_control;        // 0=OFF (M5), 1=CW (M3), 2=CCW (M4)
+    uint8_t output_control;         // M62, M63, M64, M65 as ioOutputControl
 
     bool m48_enable;                // M48/M49 input (enables for feed and spindle)
     bool fro_control;               // M50 feedrate override control
@@ -171,6 +177,7 @@ typedef struct GCodeFlags {         // Gcode input flags
 
     bool F_word;
     bool P_word;
+    bool Q_word;
     bool S_word;
     bool H_word;
     bool L_word;
@@ -182,6 +189,7 @@ typedef struct GCodeFlags {         // Gcode input flags
     bool path_control;
     bool distance_mode;
     bool arc_distance_mode;
+    bool retract_mode;
     bool origin_offset_mode;
     bool absolute_override;
 
@@ -192,6 +200,7 @@ typedef struct GCodeFlags {         // Gcode input flags
     bool coolant_flood;
     bool coolant_off;
     bool spindle_control;
+    bool output_control;
 
     bool m48_enable;
     bool fro_control;
@@ -208,8 +217,30 @@ typedef struct GCodeFlags {         // Gcode input flags
 
 } GCodeFlag_t;
 
+#ifndef GCODE_MAX_WORDS
+#define GCODE_MAX_WORDS 40              // words in one block
+#endif
+
+#ifndef GCODE_LOOKAHEAD_BLOCKS
+#define GCODE_LOOKAHEAD_BLOCKS 4        // blocks scanned ahead while the planner is full
+#endif
+#define GCODE_LOOKAHEAD_LINE_LEN 96     // longer lines are not scanned ahead
+#define GCODE_LOOKAHEAD_WORDS 12        // blocks with more words are not scanned ahead
+
+typedef struct GCodeWord {              // one word of a block, as scanned
+    char letter;
+    uint16_t next;                      // offset in the normalized block of the character after the word
+    int32_t value_int;                  // integer part of the value - exact for line numbers over 2^24
+    float value;
+} GCodeWord_t;
+
 typedef struct GCodeParser {
     bool modals[MODAL_GROUP_COUNT];
+
+    bool checksum;                      // the block had a (valid) checksum
+    uint8_t words;                      // words in word[]
+    stat_t word_status;                 // STAT_COMPLETE, or the error that ended the word list
+    GCodeWord_t word[GCODE_MAX_WORDS];
 } GCodeParser_t;
 
 GCodeParser_t gp;   // main parser struct
@@ -217,10 +248,10 @@ GCodeValue_t gv;    // gcode input values
 GCodeFlag_t gf;     // gcode input flags
 
 // local helper functions and macros
-static void _normalize_gcode_block(char *str, char **active_comment, uint8_t *block_delete_flag);
-static stat_t _get_next_gcode_word(char **pstr, char *letter, float *value, int32_t *value_int);
+static stat_t _scan_gcode_block(char *str, char **active_comment, uint8_t *block_delete_flag);
+static stat_t _run_gcode_block(char *str, char *active_comment, uint8_t block_delete_flag);
+static char *_scan_active_comments(char *ac_rd, char *ac_wr);
 static stat_t _point(float value);
-static stat_t _verify_checksum(char *str);
 static stat_t _validate_gcode_block(char *active_comment);
 static stat_t _parse_gcode_block(char *line, char *active_comment); // Parse the block into the GN/GF structs
 static stat_t _execute_gcode_block(char *active_comment);           // Execute the gcode block
@@ -237,6 +268,8 @@ void gcode_parser_init()
 {
     memset(&gv, 0, sizeof(GCodeValue_t));
     memset(&gf, 0, sizeof(GCodeFlag_t));
+    gcode_lookahead_flush();
+    gcode_program_init();
 }
 
 /*
@@ -251,14 +284,22 @@ stat_t gcode_parser(char *block)
     char none = NUL;
     char *active_comment = &none;           // gcode comment or NUL string
     uint8_t block_delete_flag;
+    bool execute;
 
-    stat_t check_ret = _verify_checksum(str);
-    if (check_ret != STAT_OK) {
-        return check_ret;
+    ritorno(gcode_program_filter(block, &execute));     // O words and branches not taken
+    if (!execute) {
+        return (STAT_OK);
     }
+    ritorno(_scan_gcode_block(str, &active_comment, &block_delete_flag));
+    return (_run_gcode_block(str, active_comment, block_delete_flag));
+}
 
-    _normalize_gcode_block(str, &active_comment, &block_delete_flag);
+/*
+ * _run_gcode_block() - parse and execute a scanned block
+ */
 
+static stat_t _run_gcode_block(char *str, char *active_comment, uint8_t block_delete_flag)
+{
     // TODO, now MSG is put in the active comment, handle that.
 
     if (str[0] == NUL) {                    // normalization returned null string
@@ -275,56 +316,136 @@ stat_t gcode_parser(char *block)
     if (block_delete_flag == true) {
         return (STAT_NOOP);
     }
-    return(_parse_gcode_block(block, active_comment));
+    return(_parse_gcode_block(str, active_comment));
 }
 
-/*
- * _verify_checksum() - ensure that, if there is a checksum, that it's valid
+/****************************************************************************************
+ * G-CODE LOOKAHEAD
+ *
+ *  While the planner is full the controller keeps reading Gcode lines and scans them into
+ *  this queue: checksum, normalization and number conversion are done ahead. When a planner
+ *  buffer frees the oldest block only has to be parsed into gv/gf and executed. Parsing and
+ *  executing stay in line order because they depend on the model state left by the block
+ *  before (motion mode, feed rate mode, Marlin M-codes that act during parsing).
  *
- * Returns STAT_OK is it's valid.
- * Returns STAT_CHECKSUM_MATCH_FAILED if the checksum doesn't match.
+ *  gcode_lookahead_add()  - scan a line into the queue. Returns false (and leaves the line as
+ *                           it was) if the queue is full, or the line or its block is too
+ *                           long for a queue entry. The caller must then run it in order.
+ *                           Lines using parameters or O words, and any line while O words
+ *                           are being run, are never scanned ahead (see gcode_program.h).
+ *  gcode_lookahead_line() - the line of the oldest block as it was received, or nullptr
+ *  gcode_lookahead_run()  - parse and execute the oldest block and drop it. Scan errors
+ *                           (checksum) are returned here, in line order.
+ *  gcode_lookahead_flush() - drop all blocks (queue flush, job kill)
  */
-static stat_t _verify_checksum(char *str)
+
+typedef struct GCodeLookaheadBlock {
+    stat_t status;                      // _scan_gcode_block() status
+    uint8_t block_delete;
+    bool checksum;
+    uint8_t words;
+    stat_t word_status;
+    uint8_t active_comment;             // offset of the active comment in block[]
+    GCodeWord_t word[GCODE_LOOKAHEAD_WORDS];
+    char line[GCODE_LOOKAHEAD_LINE_LEN];    // the line as received - for the response
+    char block[GCODE_LOOKAHEAD_LINE_LEN];   // normalized block and active comment
+} GCodeLookaheadBlock_t;
+
+typedef struct GCodeLookahead {
+    uint8_t head;                       // oldest block
+    uint8_t count;                      // blocks in the queue
+    GCodeLookaheadBlock_t block[GCODE_LOOKAHEAD_BLOCKS];
+} GCodeLookahead_t;
+
+static GCodeLookahead_t gl;
+
+bool gcode_lookahead_is_full()
 {
-    bool has_line_number = false; // -1 means we don't have one
-    if (*str == 'N') {
-        has_line_number = true;
+    return (gl.count == GCODE_LOOKAHEAD_BLOCKS);
+}
+
+bool gcode_lookahead_add(char *line)
+{
+    uint16_t length = strlen(line);
+    if ((gl.count == GCODE_LOOKAHEAD_BLOCKS) || (length >= GCODE_LOOKAHEAD_LINE_LEN)) {
+        return (false);
+    }
+    if (!gcode_program_is_idle() || gcode_program_has_words(line)) {
+        return (false);                 // depends on the lines before it having run
     }
+    GCodeLookaheadBlock_t *b = &gl.block[(gl.head + gl.count) % GCODE_LOOKAHEAD_BLOCKS];
+    memcpy(b->line, line, length+1);
 
-    char checksum = 0;
-    char c = *str++;
-    while (c && (c != '*') && (c != '\n') && (c != '\r')) {
-        checksum ^= c;
-        c = *str++;
+    char none = NUL;
+    char *active_comment = &none;
+    b->status = _scan_gcode_block(line, &active_comment, &b->block_delete);
+    if (b->status == STAT_OK) {
+        uint16_t block_length = (active_comment - line) + strlen(active_comment) + 1;
+        if ((block_length > GCODE_LOOKAHEAD_LINE_LEN) || (gp.words > GCODE_LOOKAHEAD_WORDS)) {
+            strcpy(line, b->line);      // doesn't fit - give the line back as received
+            return (false);
+        }
+        memcpy(b->block, line, block_length);
+        b->active_comment = active_comment - line;
+        b->checksum = gp.checksum;
+        b->words = gp.words;
+        b->word_status = gp.word_status;
+        memcpy(b->word, gp.word, gp.words * sizeof(GCodeWord_t));
     }
+    gl.count++;
+    return (true);
+}
 
-    // c might be 0 here, in which case we didn't get a checksum and we return STAT_OK
+char *gcode_lookahead_line()
+{
+    return ((gl.count == 0) ? nullptr : gl.block[gl.head].line);
+}
 
-    if (c == '*') {
-        *(str-1) = 0; // null terminate, the parser won't like this * here!
-        gf.checksum = true;
-        if (strtol(str, NULL, 10) != checksum) {
-            debug_trap("checksum failure");
-            return STAT_CHECKSUM_MATCH_FAILED;
-        }
-        if (!has_line_number) {
-            debug_trap("line number missing with checksum");
-            return STAT_MISSING_LINE_NUMBER_WITH_CHECKSUM;
-        }
+stat_t gcode_lookahead_run()
+{
+    if (gl.count == 0) {
+        return (STAT_NOOP);
     }
-    return STAT_OK;
+    GCodeLookaheadBlock_t *b = &gl.block[gl.head];
+    stat_t status = b->status;
+    if (status == STAT_OK) {
+        gp.checksum = b->checksum;
+        gp.words = b->words;
+        gp.word_status = b->word_status;
+        memcpy(gp.word, b->word, b->words * sizeof(GCodeWord_t));
+        status = _run_gcode_block(b->block, b->block + b->active_comment, b->block_delete);
+    }
+    gl.head = (gl.head + 1) % GCODE_LOOKAHEAD_BLOCKS;
+    gl.count--;
+    return (status);
+}
+
+void gcode_lookahead_flush()
+{
+    gl.count = 0;
 }
 
 /****************************************************************************************
- * _normalize_gcode_block() - normalize a block (line) of gcode in place
+ * _scan_gcode_block() - normalize, checksum and tokenize a block (line) of gcode in place
  *
- *  Baseline normalization functions:
+ *  One walk over the line does all of the following:
+ *   - Compute the checksum. If there is one ('*' outside of a comment) check it and end
+ *     the block there. A checksum requires a line number (N) as the first character.
  *   - Isolate comments. See below.
  *   The rest of this applies just to the GCODE string itself (not the comments):
  *   - Remove white space, control and other invalid characters
  *   - Convert all letters to upper case
- *   - Remove (erroneous) leading zeros that might be taken to mean Octal
+ *   - Remove (erroneous) leading zeros so the normalized block doesn't look like Octal
  *   - Signal if a block-delete character (/) was encountered in the first space
+ *   - Split the block into words and convert each value once, into both the float value
+ *     and the exact integer part (line numbers over 2^24 don't fit in a float). The integer
+ *     part saturates at +/-INT32_MAX rather than wrapping. The words
+ *     are left in gp.word[]. A malformed word ends the list; its error is left in
+ *     gp.word_status and reported when the block is parsed, as it always was.
+ *   - Evaluate parameters and [expressions] as word values, and hold #n=value settings until
+ *     the whole line has been read (see gcode_program.cpp). Errors in these are returned.
+ *   - M23 (Marlin only) is followed by a file name. The rest of the line is copied as it is,
+ *     so gp.word[].next of the M word points at the name with its case and spaces intact.
  *   - NOTE: Assumes no leading whitespace as this was removed at the controller dispatch level
  *
  *  So this: "g1 x100 Y100 f400" becomes this: "G1X100Y100F400"
@@ -341,9 +462,12 @@ static stat_t _verify_checksum(char *str)
  *     - Only ONE MSG comment will be accepted
  *   - Other "plain" comments are discarded
  *
+ *  Active comments are only noted during the walk. If there are any, _scan_active_comments()
+ *  gathers them from the first one on.
+ *
  *  Returns:
+ *   - STAT_OK, or the checksum error
  *   - com points to comment string or to NUL if no comment
- *   - msg points to message string or to NUL if no comment
  *   - block_delete_flag is set true if block delete encountered, false otherwise
  */
 /* Active comment notes:
@@ -360,250 +484,413 @@ static stat_t _verify_checksum(char *str)
 
 char _normalize_scratch[RX_BUFFER_SIZE];
 
-void _normalize_gcode_block(char *str, char **active_comment, uint8_t *block_delete_flag)
+typedef enum {                          // _scan_gcode_block() states
+    SCAN_GCODE = 0,                     // gcode words
+    SCAN_COMMENT,                       // plain (comment)
+    SCAN_ACTIVE_COMMENT,                // ({json}) active comment
+    SCAN_MSG_COMMENT,                   // (msg...) comment
+    SCAN_STRING_ARG,                    // M23 file name - copied as it is
+    SCAN_END_OF_LINE                    // past a ';' or '%' comment
+} gcScanState;
+
+typedef struct GCodeNumber {            // value of the word being scanned
+    uint32_t mantissa;                  // significant digits
+    uint32_t integer;                   // integer part, saturated at INT32_MAX
+    int8_t exponent;                    // power of 10 to apply to mantissa
+    uint8_t digits;                     // significant digits in mantissa
+    bool negative;
+    bool point;                         // decimal point seen
+    bool present;                       // any sign, digit or point seen
+} GCodeNumber_t;
+
+static const float _pow10[] = { 1, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10 };
+
+static float _number_value(const GCodeNumber_t *n)
 {
-    _normalize_scratch[0] = 0;
-
-    char *gc_rd = str;                  // read pointer
-    char *gc_wr = _normalize_scratch;   // write pointer
-    char *ac_rd = str;                  // Active Comment read pointer
-    char *ac_wr = _normalize_scratch;   // Active Comment write pointer
-    bool last_char_was_digit = false;   // used for octal stripping
-
-    // Move the ac_wr point forward one for every non-AC character we KEEP (plus one for a NULL in between)
-    ac_wr++;                            // account for the in-between NULL
+    float value = (float)n->mantissa;
+    int8_t exponent = n->exponent;
+    for (; exponent > 10; exponent -= 10) { value *= 1e10; }    // absurd inputs only
+    for (; exponent < -10; exponent += 10) { value /= 1e10; }
+    value = (exponent < 0) ? (value / _pow10[-exponent]) : (value * _pow10[exponent]);
+    return (n->negative ? -value : value);
+}
 
-    // mark block deletes
-    if (*gc_rd == '/') {
-        *block_delete_flag = true;
-        gc_rd++;
+// add one normalized character to the value - returns false if it can't be part of a number
+static bool _scan_number(GCodeNumber_t *n, char c)
+{
+    if (c == '-') {
+        if (n->present) { return (false); }
+        n->negative = true;
+    } else if (c == '.') {
+        if (n->point) { return (false); }
+        n->point = true;
     } else {
-        *block_delete_flag = false;
+        uint8_t digit = c - '0';
+        if (!n->point) {                                        // value_int is an int32 - don't let it wrap
+            n->integer = (n->integer > (uint32_t)(INT32_MAX - digit) / 10) ? INT32_MAX : n->integer * 10 + digit;
+        }
+        if (n->digits < 9) {                                    // 9 digits always fit in 32 bits
+            if ((n->mantissa != 0) || (digit != 0)) {           // leading zeros aren't significant
+                n->digits++;
+            }
+            n->mantissa = n->mantissa * 10 + digit;
+            if (n->point) { n->exponent--; }
+        } else if (!n->point) {                                 // drop digits past the 9th
+            n->exponent++;
+        }
     }
+    n->present = true;
+    return (true);
+}
 
-    while (*gc_rd != 0) {
-        if ((*gc_rd == ';') || (*gc_rd == '%')) {   // check for ';' or '%' comments that end the line
-            *gc_rd = 0;                             // go ahead and snap the string off cleanly here
-            break;
+// finish the word being scanned - returns false if it has no value
+static bool _end_word(GCodeWord_t *word, const GCodeNumber_t *n)
+{
+    if (!n->present) {
+#if MARLIN_COMPAT_ENABLED == true
+        if (!mst.marlin_flavor) {
+            return (false);
         }
+#else
+        return (false);
+#endif
+    }
+    word->value = _number_value(n);
+    word->value_int = n->negative ? -(int32_t)n->integer : (int32_t)n->integer;
+    return (true);
+}
 
-        // check for comment '('
-        else if (*gc_rd == '(') {
-            // We only care if it's a "({" in order to handle string-skipping properly
-            gc_rd++;
-            if ((*gc_rd == '{') || (((* gc_rd    == 'm') || (* gc_rd    == 'M')) &&
-                                    ((*(gc_rd+1) == 's') || (*(gc_rd+1) == 'S')) &&
-                                    ((*(gc_rd+2) == 'g') || (*(gc_rd+2) == 'G'))
-                )) {
-                if (ac_rd == nullptr) {
-                    ac_rd = gc_rd;      // note the start of the first AC
-                }
+static stat_t _scan_gcode_block(char *str, char **active_comment, uint8_t *block_delete_flag)
+{
+    char *rd = str;                     // read pointer
+    char *wr = _normalize_scratch;      // write pointer
+    char *ac_rd = nullptr;              // start of the first active comment, if any
+    char *eol = nullptr;                // ';' or '%' that ended the line, if any
+    bool last_char_was_digit = false;   // used for octal stripping
+    bool has_line_number = (*str == 'N');
+    bool in_checksum = true;            // still accumulating the checksum
+    uint8_t checksum = 0;
+    uint8_t state = SCAN_GCODE;
+    bool in_string = false;             // active comment string handling
+    bool escaped = false;
+    char *string_arg = nullptr;         // start of an M23 file name, if any
+
+    GCodeWord_t *word = nullptr;        // word being scanned
+    GCodeNumber_t number;
+
+    gp.words = 0;
+    gp.word_status = STAT_COMPLETE;
+    gp.checksum = false;
+    gcode_parameter_clear_pending();
 
-                // skip the comment, handling strings carefully
-                bool in_string = false;
-                while (*(++gc_rd) != 0) {
-                    if (*gc_rd=='"') {
-                        in_string = true;
-                    } else if (in_string) {
-                        if ((*gc_rd == '\\') && (*(gc_rd+1) != 0)) {
-                            gc_rd++; // Skip it, it's escaped.
-                        }
-                    } else if ((*gc_rd == ')')) {
-                        break;
-                    }
+    // mark block deletes
+    *block_delete_flag = (*rd == '/');
+
+    for (char c; (c = *rd) != NUL; rd++) {
+        if (in_checksum) {
+            if ((c == '*') && ((state == SCAN_GCODE) || (state == SCAN_STRING_ARG) || (state == SCAN_END_OF_LINE))) {
+                *rd = NUL;              // null terminate, the parser won't like this * here!
+                gp.checksum = true;
+                if (strtol(rd+1, NULL, 10) != checksum) {
+                    debug_trap("checksum failure");
+                    return (STAT_CHECKSUM_MATCH_FAILED);
                 }
-                if (*gc_rd == 0) {      // We don't want the rd++ later to skip the NULL if we're at one
-                    break;
+                if (!has_line_number) {
+                    debug_trap("line number missing with checksum");
+                    return (STAT_MISSING_LINE_NUMBER_WITH_CHECKSUM);
                 }
+                break;
+            }
+            if ((c == '\n') || (c == '\r')) {
+                in_checksum = false;
             } else {
-                *(gc_rd-1) = ' ';       // Change the '(' to a space to simplify the comment copy later
-                while ((*gc_rd != 0) && (*gc_rd != ')')) {  // skip ahead until we find a ')' (or NULL)
-                    gc_rd++;
-                }
+                checksum ^= c;
             }
-        } else if (!isspace(*gc_rd)) {
-            bool do_copy = false;
+        }
 
-            // Perform Octal stripping - remove invalid leading zeros in number strings
-            // Otherwise number conversions can fail, as Gcode does not support octal but C libs do
-            // Change 0123.004 to 123.004, or -0234.003 to -234.003
-            if (isdigit(*gc_rd) || (*gc_rd == '.')) { // treat '.' as a digit so we don't strip after one
-                if (last_char_was_digit || (*gc_rd != '0') || !isdigit(*(gc_rd+1))) {
-                    do_copy = true;
-                }
-                last_char_was_digit = true;
+        switch (state) {
+            case SCAN_END_OF_LINE: {
+                continue;
             }
-            else if ((isalnum((char)*gc_rd)) || (strchr("-.", *gc_rd))) { // all valid characters
-                last_char_was_digit = false;
-                do_copy = true;
+            case SCAN_COMMENT:
+            case SCAN_MSG_COMMENT: {
+                if (c == ')') { state = SCAN_GCODE; }
+                continue;
             }
-            if (do_copy) {
-                *(gc_wr++) = toupper(*gc_rd);
-                ac_wr++; // move the ac start position
+            case SCAN_STRING_ARG: {             // keep case and inner spaces, drop leading blanks
+                if (c == ';') {
+                    eol = rd;
+                    state = SCAN_END_OF_LINE;
+                } else if ((c > ' ') || ((c == ' ') && (wr != string_arg))) {
+                    *(wr++) = c;
+                }
+                continue;
             }
+            case SCAN_ACTIVE_COMMENT: {         // skip the comment, handling strings carefully
+                if (escaped) {
+                    escaped = false;
+                } else if (c == '"') {
+                    in_string = !in_string;
+                } else if (in_string) {
+                    escaped = (c == '\\');
+                } else if (c == ')') {
+                    state = SCAN_GCODE;
+                }
+                continue;
+            }
+            default: break;
         }
-        gc_rd++;
-    }
-
-    // Enforce null termination
-    *gc_wr = 0;
-    char *comment_start = ac_wr;    // note the beginning of the comments
-    if (ac_rd != nullptr) {
 
-        // Now we'll copy the comments to the scratch
-        while (*ac_rd != 0) {
-            // check for comment '('
-            // Remember: we're only "counting characters" at this point, no more.
-            if (*ac_rd == '(') {
-                // We only care if it's a "({" in order to handle string-skipping properly
-                ac_rd++;
-
-                bool do_copy = false;
-                bool in_msg = false;
-                if (((* ac_rd    == 'm') || (* ac_rd    == 'M')) &&
-                    ((*(ac_rd+1) == 's') || (*(ac_rd+1) == 'S')) &&
-                    ((*(ac_rd+2) == 'g') || (*(ac_rd+2) == 'G'))
-                    ) {
-
-                    ac_rd += 3;
-                    if (*ac_rd == ' ') {
-                        ac_rd++; // skip the first space.
-                    }
+        if ((c == ';') || (c == '%')) {         // ';' or '%' comments end the line
+            eol = rd;
+            state = SCAN_END_OF_LINE;
+            continue;
+        }
+        if (c == '(') {
+            // We only care if it's a "({" or "(msg" in order to handle string-skipping properly
+            if (rd[1] == '{') {
+                state = SCAN_ACTIVE_COMMENT;
+                in_string = false;
+                escaped = false;
+            } else if ((toupper(rd[1]) == 'M') && (toupper(rd[2]) == 'S') && (toupper(rd[3]) == 'G')) {
+                state = SCAN_MSG_COMMENT;
+            } else {
+                *rd = ' ';                      // plain comment: keep it out of _scan_active_comments()
+                state = SCAN_COMMENT;
+                continue;
+            }
+            if (ac_rd == nullptr) {
+                ac_rd = rd;                     // note the start of the first AC
+            }
+            continue;
+        }
 
-                    if (*(ac_wr-1) == '}') {
-                        *(ac_wr-1) = ',';
-                    } else {
-                        *(ac_wr++) = '{';
-                    }
-                    *(ac_wr++) = 'm';
-                    *(ac_wr++) = 's';
-                    *(ac_wr++) = 'g';
-                    *(ac_wr++) = ':';
-                    *(ac_wr++) = '"';
-
-                    // TODO - FIX BUFFER OVERFLOW POTENTIAL
-                    // "(msg)" is four characters. "{msg:" is five. If the write buffer is full, we'll overflow.
-                    // Also " is MSG will be quoted, making one character into two.
-
-                    in_msg = true;
-                    do_copy = true;
+        // Parameters and expressions are evaluated from the text as it is. '#' or '[' in place
+        // of a word's number is its value, '#' anywhere else starts a parameter setting.
+        if ((c == '#') || (c == '[')) {
+            const char *end = rd;
+            stat_t status;
+            if ((word != nullptr) && ((wr[-1] == word->letter) || (wr[-1] == '-'))) {
+                float value;
+                if ((status = gcode_expression_value(&end, &value)) == STAT_OK) {
+                    word->value = number.negative ? -value : value;
+                    word->value_int = (fabs(word->value) < (float)INT32_MAX) ? (int32_t)word->value :
+                                      (word->value < 0) ? -INT32_MAX : INT32_MAX;
+                    word->next = wr - _normalize_scratch;
+                    word = nullptr;             // digits after the value are malformed
                 }
-
-                else if (*ac_rd == '{') {
-                    // merge json comments
-                    if (*(ac_wr-1) == '}') {
-                        *(ac_wr-1) = ',';
-
-                        // don't copy the '{'
-                        ac_rd++;
-                    }
-
-                    do_copy = true;
+            } else if (c == '#') {
+                if ((word != nullptr) && !_end_word(word, &number)) {
+                    gp.word_status = STAT_BAD_NUMBER_FORMAT;
+                    gp.words--;
                 }
+                word = nullptr;
+                status = gcode_parameter_assignment(&end);
+            } else {
+                status = STAT_EXPRESSION_SYNTAX_ERROR;
+            }
+            if (status != STAT_OK) {
+                return (status);
+            }
+            for (rd++; rd < end; rd++) {        // the characters used still count in the checksum
+                if (in_checksum) { checksum ^= *rd; }
+            }
+            rd--;
+            last_char_was_digit = false;
+            continue;
+        }
 
-                if (do_copy) {
-                    // skip the comment, handling strings carefully
-                    bool in_string = false;
-                    bool escaped = false;
-                    while (*ac_rd != 0) {
-                        if (in_string && (*ac_rd == '\\')) {
-                            escaped = true;
-                        } else if (!escaped && (*ac_rd == '"')) {
-                            // In msg comments, we have to escape "
-                            if (in_msg) {
-                                *(ac_wr++) = '\\';
-                            } else {
-                                in_string = !in_string;
-                            }
-                        } else if (!in_string && (*ac_rd == ')')) {
-                            ac_rd++;
-                            if (in_msg) {
-                                *(ac_wr++) = '"';
-                                *(ac_wr++) = '}';
-                            }
-                            break;
-                        } else {
-                            escaped = false;
-                        }
-
-                        // Skip spaces if we're not in a string or msg (implicit string)
-                        if (in_string || in_msg || (*ac_rd != ' ')) {
-                            *ac_wr = *ac_rd;
-                            ac_wr++;
-                        }
+#if MARLIN_COMPAT_ENABLED == true
+        // M23 is followed by a file name, not words. Marlin takes the rest of the line.
+        if (((c == ' ') || (c == '\t')) && (word != nullptr) && (word->letter == 'M') && (number.integer == 23) &&
+            number.present && !number.point && !number.negative) {
+            string_arg = wr;
+            state = SCAN_STRING_ARG;
+            continue;
+        }
+#endif
 
-                        ac_rd++;
-                    }
-                }
+        // Perform Octal stripping - remove invalid leading zeros in number strings
+        // Change 0123.004 to 123.004, or -0234.003 to -234.003
+        if (((c >= '0') && (c <= '9')) || (c == '.')) { // treat '.' as a digit so we don't strip after one
+            bool keep = last_char_was_digit || (c != '0') || (rd[1] < '0') || (rd[1] > '9');
+            last_char_was_digit = true;
+            if (!keep) {
+                continue;
+            }
+        } else if ((c >= 'a') && (c <= 'z')) {
+            last_char_was_digit = false;
+            c -= 'a' - 'A';
+        } else if (((c >= 'A') && (c <= 'Z')) || (c == '-')) {
+            last_char_was_digit = false;
+        } else {
+            continue;                           // white space and invalid characters are dropped
+        }
+        *(wr++) = c;
 
-                // We don't want the rd++ later to skip the NULL if we're at one
-                if (*ac_rd == 0) {
-                    break;
-                }
+        // tokenize the normalized character
+        if (gp.word_status != STAT_COMPLETE) {
+            continue;                           // the word list already ended in an error
+        }
+        if (c >= 'A') {                         // a letter starts a new word
+            if ((word != nullptr) && !_end_word(word, &number)) {
+                gp.word_status = STAT_BAD_NUMBER_FORMAT;
+                gp.words--;
+                word = nullptr;
+                continue;
             }
-            ac_rd++;
+            if (gp.words == GCODE_MAX_WORDS) {
+                gp.word_status = STAT_INPUT_EXCEEDS_MAX_LENGTH;
+                word = nullptr;
+                continue;
+            }
+            word = &gp.word[gp.words++];
+            word->letter = c;
+            number = {};
+        } else if ((word == nullptr) || !_scan_number(&number, c)) {
+            gp.word_status = STAT_INVALID_OR_MALFORMED_COMMAND;
+            if (word != nullptr) {
+                _end_word(word, &number);       // the word itself was good up to here
+            }
+            word = nullptr;
+            continue;
         }
+        word->next = wr - _normalize_scratch;
+    }
+    if ((word != nullptr) && !_end_word(word, &number)) {
+        gp.word_status = STAT_BAD_NUMBER_FORMAT;
+        gp.words--;
+    }
+    if (string_arg != nullptr) {
+        while ((wr > string_arg) && (wr[-1] == ' ')) {
+            wr--;                               // trailing blanks aren't part of the name
+        }
+    }
+    if (eol != nullptr) {
+        *eol = NUL;                             // snap the string off cleanly at the comment
+    }
+    if ((gp.word_status == STAT_COMPLETE) && !*block_delete_flag) {
+        gcode_parameter_apply_pending();
     }
 
     // Enforce null termination
-    *ac_wr = 0;
+    *(wr++) = NUL;
+    char *comment_start = wr;                   // note the beginning of the comments
+    if (ac_rd != nullptr) {
+        wr = _scan_active_comments(ac_rd, wr);
+    }
+    *wr = NUL;
 
     // Now copy it all back
-    memcpy(str, _normalize_scratch, (ac_wr-_normalize_scratch)+1);
+    memcpy(str, _normalize_scratch, (wr-_normalize_scratch)+1);
 
     *active_comment = str + (comment_start - _normalize_scratch);
+    return (STAT_OK);
 }
 
 /****************************************************************************************
- * _get_next_gcode_word() - get gcode word consisting of a letter and a value
+ * _scan_active_comments() - gather the active comments of a block behind the gcode
  *
- *  This function requires the Gcode string to be normalized.
- *  Normalization must remove any leading zeros or they will be converted to Octal
- *  G0X... is not interpreted as hexadecimal. This is trapped.
+ *  ac_rd points at the '(' of the first active comment, ac_wr where the merged comments go.
+ *  Returns the new write position.
  */
 
-static stat_t _get_next_gcode_word(char **pstr, char *letter, float *value, int32_t *value_int)
+static char *_scan_active_comments(char *ac_rd, char *ac_wr)
 {
-    if (**pstr == NUL) { return (STAT_COMPLETE); }    // no more words
+    // Now we'll copy the comments to the scratch
+    while (*ac_rd != 0) {
+        // check for comment '('
+        // Remember: we're only "counting characters" at this point, no more.
+        if (*ac_rd == '(') {
+            // We only care if it's a "({" in order to handle string-skipping properly
+            ac_rd++;
 
-    // get letter part
-    if(isupper(**pstr) == false) {
-        return (STAT_INVALID_OR_MALFORMED_COMMAND);
-    }
-    *letter = **pstr;
-    (*pstr)++;
-
-// Removed support for hex numbers
-//    // X-axis-becomes-a-hexadecimal-number get-value case, e.g. G0X100 --> G255
-//    if ((**pstr == '0') && (*(*pstr+1) == 'X')) {
-//        *value = 0;
-//        (*pstr)++;
-//        return (STAT_OK);                           // pointer points to X
-//    }
-//
-//    // get-value general case
-//    char *end;
-//    *value_int = atol(*pstr);                       // needed to get an accurate line number for N > 8,388,608
-//    *value = strtof(*pstr, &end);
-
-    // get-value general case
-    char *end = *pstr;
-    *value = c_atof(end);
-    *value_int = atol(*pstr);                       // needed to get an accurate line number for N > 8,388,608
-
-    if (end == *pstr) {
-#if MARLIN_COMPAT_ENABLED == true
-        if (mst.marlin_flavor) {
-            *value = 0;
-        } else {
-            return(STAT_BAD_NUMBER_FORMAT);
+            bool do_copy = false;
+            bool in_msg = false;
+            if (((* ac_rd    == 'm') || (* ac_rd    == 'M')) &&
+                ((*(ac_rd+1) == 's') || (*(ac_rd+1) == 'S')) &&
+                ((*(ac_rd+2) == 'g') || (*(ac_rd+2) == 'G'))
+                ) {
+
+                ac_rd += 3;
+                if (*ac_rd == ' ') {
+                    ac_rd++; // skip the first space.
+                }
+
+                if (*(ac_wr-1) == '}') {
+                    *(ac_wr-1) = ',';
+                } else {
+                    *(ac_wr++) = '{';
+                }
+                *(ac_wr++) = 'm';
+                *(ac_wr++) = 's';
+                *(ac_wr++) = 'g';
+                *(ac_wr++) = ':';
+                *(ac_wr++) = '"';
+
+                // TODO - FIX BUFFER OVERFLOW POTENTIAL
+                // "(msg)" is four characters. "{msg:" is five. If the write buffer is full, we'll overflow.
+                // Also " is MSG will be quoted, making one character into two.
+
+                in_msg = true;
+                do_copy = true;
+            }
+
+            else if (*ac_rd == '{') {
+                // merge json comments
+                if (*(ac_wr-1) == '}') {
+                    *(ac_wr-1) = ',';
+
+                    // don't copy the '{'
+                    ac_rd++;
+                }
+
+                do_copy = true;
+            }
+
+            if (do_copy) {
+                // skip the comment, handling strings carefully
+                bool in_string = false;
+                bool escaped = false;
+                while (*ac_rd != 0) {
+                    if (in_string && (*ac_rd == '\\')) {
+                        escaped = true;
+                    } else if (!escaped && (*ac_rd == '"')) {
+                        // In msg comments, we have to escape "
+                        if (in_msg) {
+                            *(ac_wr++) = '\\';
+                        } else {
+                            in_string = !in_string;
+                        }
+                    } else if (!in_string && (*ac_rd == ')')) {
+                        ac_rd++;
+                        if (in_msg) {
+                            *(ac_wr++) = '"';
+                            *(ac_wr++) = '}';
+                        }
+                        break;
+                    } else {
+                        escaped = false;
+                    }
+
+                    // Skip spaces if we're not in a string or msg (implicit string)
+                    if (in_string || in_msg || (*ac_rd != ' ')) {
+                        *ac_wr = *ac_rd;
+                        ac_wr++;
+                    }
+
+                    ac_rd++;
+                }
+            }
+
+            // We don't want the rd++ later to skip the NULL if we're at one
+            if (*ac_rd == 0) {
+                break;
+            }
         }
-#else
-        return(STAT_BAD_NUMBER_FORMAT);
-#endif
-    }    // more robust test then checking for value=0;
-    *pstr = end;
-    return (STAT_OK);                               // pointer points to next character after the word
+        ac_rd++;
+    }
+    return (ac_wr);
 }
 
 /*
@@ -644,13 +931,12 @@ static stat_t _validate_gcode_block(char *active_comment)
  * _parse_gcode_block() - parses one line of NULL terminated G-Code.
  *
  *  All the parser does is load the state values in gn (next model state) and set flags
- *  in gf (model state flags). The execute routine applies them. The buffer is assumed to
- *  contain only uppercase characters and signed floats (no whitespace).
+ *  in gf (model state flags). The execute routine applies them. The words come from
+ *  gp.word[] as left by _scan_gcode_block(); buf is the normalized block.
  */
 
 static stat_t _parse_gcode_block(char *buf, char *active_comment)
 {
-    char *pstr = (char *)buf;                   // persistent pointer into gcode block for parsing words
     char letter;                                // parsed letter, eg.g. G or X or Y
     float value = 0;                            // value parsed from letter (e.g. 2 for G2)
     int32_t value_int = 0;                      // integer value parsed from letter - needed for line numbers
@@ -659,6 +945,8 @@ static stat_t _parse_gcode_block(char *buf, char *active_comment)
     // set initial state for new move
     memset(&gv, 0, sizeof(GCodeValue_t));       // clear all next-state values
     memset(&gf, 0, sizeof(GCodeFlag_t));        // clear all next-state flags
+    memset(gp.modals, 0, sizeof(gp.modals));    // clear the modal groups seen in the block
+    gf.checksum = gp.checksum;
     gv.motion_mode = cm_get_motion_mode(MODEL); // get motion mode from previous block
 
     // Causes a later exception if
@@ -670,7 +958,10 @@ static stat_t _parse_gcode_block(char *buf, char *active_comment)
     }
 
     // extract commands and parameters
-    while((status = _get_next_gcode_word(&pstr, &letter, &value, &value_int)) == STAT_OK) {
+    for (uint8_t i = 0; i < gp.words; i++) {
+        letter = gp.word[i].letter;
+        value = gp.word[i].value;
+        value_int = gp.word[i].value_int;
         switch(letter) {
             case 'G':
             switch((uint8_t)value) {
@@ -744,6 +1035,13 @@ static stat_t _parse_gcode_block(char *buf, char *active_comment)
                 }
                 case 64: SET_MODAL (MODAL_GROUP_G13,path_control, PATH_CONTINUOUS);
                 case 80: SET_MODAL (MODAL_GROUP_G1, motion_mode,  MOTION_MODE_CANCEL_MOTION_MODE);
+                case 81: SET_MODAL (MODAL_GROUP_G1, motion_mode,  MOTION_MODE_CANNED_CYCLE_81);
+                case 82: SET_MODAL (MODAL_GROUP_G1, motion_mode,  MOTION_MODE_CANNED_CYCLE_82);
+                case 83: SET_MODAL (MODAL_GROUP_G1, motion_mode,  MOTION_MODE_CANNED_CYCLE_83);
+                case 84: SET_MODAL (MODAL_GROUP_G1, motion_mode,  MOTION_MODE_CANNED_CYCLE_84);
+                case 85: SET_MODAL (MODAL_GROUP_G1, motion_mode,  MOTION_MODE_CANNED_CYCLE_85);
+                case 86: SET_MODAL (MODAL_GROUP_G1, motion_mode,  MOTION_MODE_CANNED_CYCLE_86);
+                case 89: SET_MODAL (MODAL_GROUP_G1, motion_mode,  MOTION_MODE_CANNED_CYCLE_89);
                 case 90: {
                     switch (_point(value)) {
                         case 0: SET_MODAL (MODAL_GROUP_G3, distance_mode, ABSOLUTE_DISTANCE_MODE);
@@ -773,6 +1071,8 @@ static stat_t _parse_gcode_block(char *buf, char *active_comment)
                 case 93: SET_MODAL (MODAL_GROUP_G5, feed_rate_mode, INVERSE_TIME_MODE);
                 case 94: SET_MODAL (MODAL_GROUP_G5, feed_rate_mode, UNITS_PER_MINUTE_MODE);
 //              case 95: SET_MODAL (MODAL_GROUP_G5, feed_rate_mode, UNITS_PER_REVOLUTION_MODE);
+                case 98: SET_MODAL (MODAL_GROUP_G9, retract_mode, RETRACT_TO_INITIAL_LEVEL);
+                case 99: SET_MODAL (MODAL_GROUP_G9, retract_mode, RETRACT_TO_R_PLANE);
 
                 default: status = STAT_GCODE_COMMAND_UNSUPPORTED;
             }
@@ -801,6 +1101,10 @@ static stat_t _parse_gcode_block(char *buf, char *active_comment)
                     }
                     break;
                 case 51: SET_MODAL (MODAL_GROUP_M9, spo_control, true);
+                case 62: SET_NON_MODAL (output_control, OUTPUT_SYNC_ON);
+                case 63: SET_NON_MODAL (output_control, OUTPUT_SYNC_OFF);
+                case 64: SET_NON_MODAL (output_control, OUTPUT_IMMEDIATE_ON);
+                case 65: SET_NON_MODAL (output_control, OUTPUT_IMMEDIATE_OFF);
                 case 100:
                     switch (_point(value)) {
                         case 0: SET_NON_MODAL (next_action, NEXT_ACTION_JSON_COMMAND_SYNC);
@@ -812,9 +1116,12 @@ static stat_t _parse_gcode_block(char *buf, char *active_comment)
 
 #if MARLIN_COMPAT_ENABLED == true   // Note: case ordering and presence/absence of break;s is very important
                 case 20:marlin_list_sd_response();        status = STAT_COMPLETE; break;    // List SD card
-                case 21:                                                                    // Initialize SD card
+                case 21:marlin_init_sd_response();        status = STAT_COMPLETE; break;    // Initialize SD card
                 case 22:                                  status = STAT_COMPLETE; break;    // Release SD card
-                case 23: marlin_select_sd_response(pstr); status = STAT_COMPLETE; break;    // Select SD file
+                case 23: marlin_select_sd_response(buf + gp.word[i].next); status = STAT_COMPLETE; break; // Select SD file
+                case 24: marlin_start_sd_print();         status = STAT_COMPLETE; break;    // Start/resume SD print
+                case 25: marlin_pause_sd_print();         status = STAT_COMPLETE; break;    // Pause SD print
+                case 27: marlin_report_sd_status();       status = STAT_COMPLETE; break;    // Report SD print status
 
                 case 82: SET_NON_MODAL (marlin_relative_extruder_mode, false);              // set relative extruder mode off
                 case 83: SET_NON_MODAL (marlin_relative_extruder_mode, true);               // set relative extruder mode on
@@ -835,6 +1142,8 @@ static stat_t _parse_gcode_block(char *buf, char *active_comment)
                 case 190:                gf.marlin_wait_for_temp = true; // NO break!       // set wait for temp and execute M140
                 case 140: SET_NON_MODAL (next_action, NEXT_ACTION_MARLIN_SET_BED_TEMP);     // set heated bed temperature
 
+                case 303: SET_NON_MODAL (next_action, NEXT_ACTION_MARLIN_AUTOTUNE_HEATER);  // autotune heater PID
+
                 case 110: SET_NON_MODAL (next_action, NEXT_ACTION_MARLIN_RESET_LINE_NUMBERS);// reset line numbers
                 case 111: status = STAT_COMPLETE; break; // ignore M111 Marlin debug statements. Don't process contents of the line further
 
@@ -849,6 +1158,7 @@ static stat_t _parse_gcode_block(char *buf, char *active_comment)
             case 'T': SET_NON_MODAL (tool_select, (uint8_t)trunc(value));
             case 'F': SET_NON_MODAL (F_word, value);
             case 'P': SET_NON_MODAL (P_word, value);                // used for dwell time, G10 coord select
+            case 'Q': SET_NON_MODAL (Q_word, value);                // peck depth in canned cycles
             case 'S': SET_NON_MODAL (S_word, value);
             case 'X': SET_NON_MODAL (target[AXIS_X], value);
             case 'Y': SET_NON_MODAL (target[AXIS_Y], value);
@@ -874,6 +1184,9 @@ static stat_t _parse_gcode_block(char *buf, char *active_comment)
         }
         if(status != STAT_OK) break;
     }
+    if (status == STAT_OK) {
+        status = gp.word_status;                // STAT_COMPLETE, or the word that couldn't be scanned
+    }
     if ((status != STAT_OK) && (status != STAT_COMPLETE)) return (status);
     ritorno(_validate_gcode_block(active_comment));
     return (_execute_gcode_block(active_comment));        // if successful execute the block
@@ -966,6 +1279,9 @@ stat_t _execute_gcode_block(char *active_comment)
     if (gf.coolant_off) {
         ritorno(coolant_control_sync((coControl)gv.coolant_off, COOLANT_BOTH));     // M9
     }
+    if (gf.output_control) {                                // M62, M63, M64, M65
+        ritorno(gpio_output_control((ioOutputControl)gv.output_control, gv.P_word, gf.P_word, gv.Q_word, gf.Q_word));
+    }
     if (gv.next_action == NEXT_ACTION_DWELL) {              // G4 - dwell
         ritorno(cm_dwell(gv.P_word));                       // return if error, otherwise complete the block
     }
@@ -997,7 +1313,7 @@ stat_t _execute_gcode_block(char *active_comment)
 
     EXEC_FUNC(cm_set_distance_mode, distance_mode);         // G90, G91
     EXEC_FUNC(cm_set_arc_distance_mode, arc_distance_mode); // G90.1, G91.1
-    //--> set retract mode goes here
+    EXEC_FUNC(cm_set_retract_mode, retract_mode);           // G98, G99
 
     switch (gv.next_action) {
         case NEXT_ACTION_SET_G28_POSITION:  { status = cm_set_g28_position(); break;}                               // G28.1
@@ -1032,7 +1348,7 @@ stat_t _execute_gcode_block(char *active_comment)
             switch (gv.motion_mode) {
                 case MOTION_MODE_CANCEL_MOTION_MODE: { cm->gm.motion_mode = gv.motion_mode; break;}                 // G80
                 case MOTION_MODE_STRAIGHT_TRAVERSE:  { status = cm_straight_traverse(gv.target, gf.target, PROFILE_NORMAL); break;} // G0
-                case MOTION_MODE_STRAIGHT_FEED:      { status = cm_straight_feed(gv.target, gf.target, PROFILE_NORMAL); break;}     // G1
+                case MOTION_MODE_STRAIGHT_FEED:      { status = cm_raster_feed(gv.target, gf.target, active_comment); break;}        // G1, and laser raster rows
                 case MOTION_MODE_CW_ARC:                                                                            // G2
                 case MOTION_MODE_CCW_ARC: { status = cm_arc_feed(gv.target,     gf.target,                          // G3
                                                                  gv.arc_offset, gf.arc_offset,
@@ -1042,6 +1358,21 @@ stat_t _execute_gcode_block(char *active_comment)
                                                                  gv.motion_mode);
                                             break;
                                           }
+                case MOTION_MODE_CANNED_CYCLE_81:                                                                   // G81
+                case MOTION_MODE_CANNED_CYCLE_82:                                                                   // G82
+                case MOTION_MODE_CANNED_CYCLE_83:                                                                   // G83
+                case MOTION_MODE_CANNED_CYCLE_84:                                                                   // G84
+                case MOTION_MODE_CANNED_CYCLE_85:                                                                   // G85
+                case MOTION_MODE_CANNED_CYCLE_86:                                                                   // G86
+                case MOTION_MODE_CANNED_CYCLE_89: { status = cm_canned_cycle_feed(gv.target,    gf.target,         // G89
+                                                                          gv.arc_radius, gf.arc_radius,
+                                                                          gv.Q_word,     gf.Q_word,
+                                                                          gv.P_word,     gf.P_word,
+                                                                          gv.L_word,     gf.L_word,
+                                                                          gp.modals[MODAL_GROUP_G1],
+                                                                          gv.motion_mode);
+                                                    break;
+                                                  }
                 default: break;
             }
             cm_set_absolute_override(MODEL, ABSOLUTE_OVERRIDE_OFF);  // un-set absolute override once the move is planned
@@ -1101,7 +1432,7 @@ static stat_t _execute_gcode_block_marlin()
     if (gf.marlin_relative_extruder_mode) {                 // M82, M83
         marlin_set_extruder_mode(gv.marlin_relative_extruder_mode);
     }    
-    if (gf.E_word) {
+    if (gf.E_word && (gv.next_action != NEXT_ACTION_MARLIN_AUTOTUNE_HEATER)) { // M303 E selects the heater
         // Ennn T0 -> Annn
         if (cm->gm.tool_select == 1) {
             gf.target[AXIS_A] = true;
@@ -1148,6 +1479,20 @@ static stat_t _execute_gcode_block_marlin()
             gf.S_word = false;
             break;
         }
+        case NEXT_ACTION_MARLIN_AUTOTUNE_HEATER:    {       // M303 [E] S [C]
+            mst.marlin_flavor = true;                       // these gcodes are ONLY in marlin flavor
+            uint8_t tool = cm->gm.tool_select;
+            if (gf.E_word) {                                // E-1 is the bed, E0 and E1 the extruders
+                tool = (gv.E_word < 0) ? 3 : ((gv.E_word < 2) ? (uint8_t)gv.E_word + 1 : 0);
+            }
+            uint8_t cycles = gf.target[AXIS_C] ? (uint8_t)gv.target[AXIS_C] : 0;   // C is the cycle count
+            ritorno(marlin_autotune_heater(tool, gf.S_word ? gv.S_word : 0, cycles));
+
+            gf.E_word = false;
+            gf.S_word = false;
+            gf.target[AXIS_C] = false;
+            break;
+        }
         case NEXT_ACTION_MARLIN_CANCEL_WAIT_TEMP:   {       // M108
             js.json_mode = MARLIN_COMM_MODE;                // we use M105 to know when to switch
             cm_request_feedhold(FEEDHOLD_TYPE_HOLD, FEEDHOLD_EXIT_STOP);
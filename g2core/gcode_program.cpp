@@ -0,0 +1,1063 @@
+/*
+ * gcode_program.cpp - Gcode parameters, expressions and O word control flow
+ * This file is part of the g2core project
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, you may use this file as part of a software library without
+ * restriction. Specifically, if other files instantiate templates or use macros or
+ * inline functions from this file, or you compile this file and link it with  other
+ * files to produce an executable, this file does not by itself cause the resulting
+ * executable to be covered by the GNU General Public License. This exception does not
+ * however invalidate any other reasons why the executable file might be covered by the
+ * GNU General Public License.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/*  See gcode_program.h for what is supported.
+ *
+ *  Every Gcode line passes gcode_program_filter() before it is scanned. The filter runs
+ *  the O word lines, drops the lines of branches not taken and records the lines that
+ *  may have to be run again. Line sources are the host (or job file) stream and the store:
+ *  while gcode_program_next_line() returns lines the controller runs them instead of
+ *  reading new ones.
+ *
+ *  The store is a run of NUL terminated lines. Subroutines are defined at the bottom, one
+ *  after the other. A loop streamed in is recorded above them from its opening line on,
+ *  and the recording is cut off again when the loop is left. The control stack holds the
+ *  open if / while / do / repeat blocks with the store offset a loop goes back to.
+ */
+
+#include "g2core.h"
+#include "config.h"
+#include "canonical_machine.h"
+#include "gcode_program.h"
+#include "report.h"
+#include "util.h"
+#include "xio.h"                    // for char definitions
+
+/**** Parameters ****/
+
+typedef struct gpNamedParameter {
+    char name[GCODE_PARAMETER_NAME_LEN];
+    float value;
+} gpNamedParameter_t;
+
+typedef struct gpReference {                // a parameter as it was written
+    uint16_t number;                        // #n, or 0 for a named parameter
+    char name[GCODE_PARAMETER_NAME_LEN];    // #<name>
+} gpReference_t;
+
+typedef struct gpAssignment {
+    gpReference_t ref;
+    float value;
+} gpAssignment_t;
+
+/**** O words ****/
+
+typedef enum {
+    O_NONE = 0,
+    O_SUB,
+    O_ENDSUB,
+    O_RETURN,
+    O_CALL,
+    O_IF,
+    O_ELSEIF,
+    O_ELSE,
+    O_ENDIF,
+    O_WHILE,
+    O_ENDWHILE,
+    O_DO,
+    O_REPEAT,
+    O_ENDREPEAT,
+    O_BREAK,
+    O_CONTINUE
+} gpKeyword;
+
+static const char *const _keyword[] = {     // gpKeyword order - "ELSEIF" must come before "ELSE"
+    "", "SUB", "ENDSUB", "RETURN", "CALL", "IF", "ELSEIF", "ELSE", "ENDIF",
+    "WHILE", "ENDWHILE", "DO", "REPEAT", "ENDREPEAT", "BREAK", "CONTINUE"
+};
+
+#define _K(k) (1 << (k))                    // keyword set for a skip
+
+typedef struct gpBlock {                    // open if / while / do / repeat
+    uint16_t number;                        // O number
+    uint8_t keyword;                        // O_IF, O_WHILE, O_DO or O_REPEAT
+    bool taken;                             // O_IF: a branch has been run
+    uint16_t start;                         // loops: store offset to go back to
+    int32_t count;                          // O_REPEAT: passes left
+} gpBlock_t;
+
+typedef struct gpSubroutine {
+    uint16_t number;                        // 0 if unused
+    uint16_t start;                         // store offset of the first body line
+    uint16_t length;                        // bytes, up to and including the endsub line
+} gpSubroutine_t;
+
+typedef struct gpCall {
+    uint16_t number;                        // O number of the subroutine
+    uint8_t depth;                          // control stack depth at the call
+    bool from_store;                        // return to the store, or to the stream
+    uint16_t pc;                            // store offset to return to
+    float saved[GCODE_CALL_ARGUMENTS];      // #1 - #30 of the caller
+} gpCall_t;
+
+/**** Gcode program singleton structure ****/
+
+struct gpProgramSingleton {
+    float parameter[GCODE_PARAMETERS];
+    gpNamedParameter_t named[GCODE_NAMED_PARAMETERS];
+    uint8_t named_count;
+    gpAssignment_t pending[GCODE_PENDING_ASSIGNMENTS];
+    uint8_t pending_count;
+
+    // store
+    char store[GCODE_PROGRAM_STORE_SIZE];
+    uint16_t tail;                          // end of the store contents
+    gpSubroutine_t sub[GCODE_SUBROUTINES];
+
+    // line source
+    bool replaying;                         // lines come from the store, not the stream
+    uint16_t pc;                            // store offset of the next line to replay
+    bool from_store;                        // the line being filtered was replayed...
+    uint16_t line_offset;                   // ...from this offset
+    char line[GCODE_PROGRAM_LINE_LEN];      // replayed line, for the parser to work on
+
+    // control flow
+    gpBlock_t block[GCODE_O_WORD_DEPTH];
+    uint8_t depth;
+    gpCall_t call[GCODE_CALL_DEPTH];
+    uint8_t calls;
+    bool skipping;                          // dropping lines up to...
+    uint16_t skip_number;                   // ...this O number with...
+    uint16_t skip_until;                    // ...one of these keywords (_K() set)
+    bool skip_execute;                      // then run that line (or drop it too)
+    gpSubroutine_t *defining;               // subroutine being stored, or nullptr
+    bool recording;                         // stream lines are being recorded...
+    uint16_t record_base;                   // ...from here...
+    uint8_t record_depth;                   // ...until the control stack drops to this depth
+};
+static struct gpProgramSingleton pg;
+
+static stat_t _expression(const char **p, uint8_t depth, uint8_t level, float *value);
+static stat_t _operand(const char **p, uint8_t depth, float *value);
+
+/****************************************************************************************
+ * gcode_program_init()  - clear parameters, subroutines and control flow
+ * gcode_program_reset() - end the loops, branches and calls in progress (queue flush, job
+ *                         kill, error in a replayed line). Parameters and subroutines stay,
+ *                         with #1 - #30 as they were before the first call.
+ * gcode_program_is_idle() - true if lines are streamed and run one by one as sent
+ */
+
+void gcode_program_init()
+{
+    memset(&pg, 0, sizeof(pg));
+}
+
+void gcode_program_reset()
+{
+    if (pg.defining != nullptr) {           // drop a half stored subroutine
+        pg.tail = pg.defining->start;
+        pg.defining->number = 0;
+        pg.defining = nullptr;
+    }
+    if (pg.recording) {
+        pg.tail = pg.record_base;
+        pg.recording = false;
+    }
+    if (pg.calls != 0) {                    // give the outermost caller its #1 - #30 back
+        memcpy(&pg.parameter[1], pg.call[0].saved, sizeof(pg.call[0].saved));
+        pg.calls = 0;
+    }
+    pg.replaying = false;
+    pg.from_store = false;
+    pg.depth = 0;
+    pg.skipping = false;
+    pg.pending_count = 0;
+}
+
+bool gcode_program_is_idle()
+{
+    return (!pg.replaying && (pg.depth == 0) && (pg.calls == 0) && !pg.skipping && !pg.recording &&
+            (pg.defining == nullptr));
+}
+
+/****************************************************************************************
+ * PARAMETERS
+ */
+
+static void _skip_spaces(const char **p)
+{
+    while ((**p == SPC) || (**p == TAB)) {
+        (*p)++;
+    }
+}
+
+// match a keyword (upper case) at *p regardless of case, and skip it
+static bool _match(const char **p, const char *keyword)
+{
+    const char *s = *p;
+    for (; *keyword != NUL; keyword++, s++) {
+        if (toupper(*s) != *keyword) {
+            return (false);
+        }
+    }
+    *p = s;
+    return (true);
+}
+
+static float *_named_parameter(const char *name)
+{
+    for (uint8_t i = 0; i < pg.named_count; i++) {
+        if (strcmp(pg.named[i].name, name) == 0) {
+            return (&pg.named[i].value);
+        }
+    }
+    return (nullptr);
+}
+
+// parse a parameter reference after its '#': #n, #<name>, ##n or #[expression]
+static stat_t _reference(const char **p, uint8_t depth, gpReference_t *ref)
+{
+    _skip_spaces(p);
+    if (**p == '<') {
+        uint8_t len = 0;
+        for ((*p)++; **p != '>'; (*p)++) {
+            char c = **p;
+            if (c == NUL) {
+                return (STAT_EXPRESSION_SYNTAX_ERROR);
+            }
+            if ((c == SPC) || (c == TAB)) {
+                continue;                   // NGC ignores spaces in names
+            }
+            if (len == GCODE_PARAMETER_NAME_LEN-1) {
+                return (STAT_PARAMETER_INVALID);
+            }
+            ref->name[len++] = tolower(c);
+        }
+        (*p)++;
+        if (len == 0) {
+            return (STAT_EXPRESSION_SYNTAX_ERROR);
+        }
+        ref->name[len] = NUL;
+        ref->number = 0;
+        return (STAT_OK);
+    }
+    float number;
+    ritorno(_operand(p, depth, &number));
+    if ((number < 1) || (number > 65535) || (fabs(number - lroundf(number)) > EPSILON4)) {
+        return (STAT_PARAMETER_INVALID);
+    }
+    ref->number = (uint16_t)lroundf(number);
+    return (STAT_OK);
+}
+
+// NGC axis order XYZABCUVW
+static const uint8_t _ngc_axis[] = { AXIS_X, AXIS_Y, AXIS_Z, AXIS_A, AXIS_B, AXIS_C, AXIS_U, AXIS_V, AXIS_W };
+
+static float _in_units(uint8_t axis, float value)
+{
+    if ((axis <= AXIS_W) && (cm_get_units_mode(MODEL) == INCHES)) {
+        return (value / MM_PER_INCH);
+    }
+    return (value);
+}
+
+// read only system parameters - returns false if there is no such parameter
+static bool _system_parameter(uint16_t n, float *value)
+{
+    if ((n >= 5061) && (n <= 5069)) {
+        uint8_t axis = _ngc_axis[n - 5061];
+        *value = _in_units(axis, cm->probe_results[0][axis] - cm_get_combined_offset(axis));
+    } else if (n == 5070) {
+        *value = (cm->probe_state[0] == PROBE_SUCCEEDED) ? 1 : 0;
+    } else if ((n >= 5161) && (n <= 5169)) {
+        uint8_t axis = _ngc_axis[n - 5161];
+        *value = _in_units(axis, cm->gmx.g28_position[axis]);
+    } else if ((n >= 5181) && (n <= 5189)) {
+        uint8_t axis = _ngc_axis[n - 5181];
+        *value = _in_units(axis, cm->gmx.g30_position[axis]);
+    } else if (n == 5210) {
+        *value = cm->gmx.g92_offset_enable ? 1 : 0;
+    } else if ((n >= 5211) && (n <= 5219)) {
+        uint8_t axis = _ngc_axis[n - 5211];
+        *value = _in_units(axis, cm->gmx.g92_offset[axis]);
+    } else if (n == 5220) {
+        *value = cm->gm.coord_system;
+    } else if ((n >= 5221) && (n < 5221 + 20*COORDS) && (((n - 5221) % 20) < AXES)) {
+        uint8_t axis = _ngc_axis[(n - 5221) % 20];
+        *value = _in_units(axis, cm->coord_offset[G54 + (n - 5221) / 20][axis]);
+    } else if (n == 5400) {
+        *value = cm->gm.tool;
+    } else if ((n >= 5420) && (n <= 5428)) {
+        *value = cm_get_display_position(MODEL, _ngc_axis[n - 5420]);
+    } else {
+        return (false);
+    }
+    return (true);
+}
+
+static stat_t _read_parameter(const gpReference_t *ref, float *value)
+{
+    if (ref->number == 0) {
+        float *named = _named_parameter(ref->name);
+        if (named == nullptr) {
+            return (STAT_PARAMETER_INVALID);
+        }
+        *value = *named;
+    } else if (ref->number < GCODE_PARAMETERS) {
+        *value = pg.parameter[ref->number];
+    } else if (!_system_parameter(ref->number, value)) {
+        return (STAT_PARAMETER_INVALID);
+    }
+    return (STAT_OK);
+}
+
+static stat_t _write_parameter(const gpReference_t *ref, float value)
+{
+    if (ref->number == 0) {
+        float *named = _named_parameter(ref->name);
+        if (named == nullptr) {
+            if (pg.named_count == GCODE_NAMED_PARAMETERS) {
+                return (STAT_PARAMETER_TABLE_FULL);
+            }
+            strcpy(pg.named[pg.named_count].name, ref->name);
+            named = &pg.named[pg.named_count++].value;
+        }
+        *named = value;
+    } else if (ref->number < GCODE_PARAMETERS) {
+        pg.parameter[ref->number] = value;
+    } else {
+        float unused;
+        return (_system_parameter(ref->number, &unused) ? STAT_PARAMETER_IS_READ_ONLY : STAT_PARAMETER_INVALID);
+    }
+    return (STAT_OK);
+}
+
+/*
+ * gcode_parameter_assignment()    - scan "#ref=value" at *p (at the '#') and hold the setting
+ * gcode_parameter_clear_pending() - drop the settings held (a new line is being scanned)
+ * gcode_parameter_apply_pending() - make the settings held (the line was read without error)
+ *
+ *  On return *p is past the last character used.
+ */
+
+stat_t gcode_parameter_assignment(const char **p)
+{
+    if (pg.pending_count == GCODE_PENDING_ASSIGNMENTS) {
+        return (STAT_INPUT_EXCEEDS_MAX_LENGTH);
+    }
+    gpAssignment_t *a = &pg.pending[pg.pending_count];
+    (*p)++;                                 // the '#'
+    ritorno(_reference(p, 0, &a->ref));
+    _skip_spaces(p);
+    if (**p != '=') {
+        return (STAT_EXPRESSION_SYNTAX_ERROR);
+    }
+    (*p)++;
+    ritorno(_operand(p, 0, &a->value));
+    if (a->ref.number >= GCODE_PARAMETERS) {
+        ritorno(_write_parameter(&a->ref, 0));  // report a read only or unknown parameter now
+    }
+    pg.pending_count++;
+    return (STAT_OK);
+}
+
+void gcode_parameter_clear_pending()
+{
+    pg.pending_count = 0;
+}
+
+void gcode_parameter_apply_pending()
+{
+    for (uint8_t i = 0; i < pg.pending_count; i++) {
+        stat_t status = _write_parameter(&pg.pending[i].ref, pg.pending[i].value);
+        if (status != STAT_OK) {
+            rpt_exception(status, pg.pending[i].ref.name);  // named parameter table full
+        }
+    }
+    pg.pending_count = 0;
+}
+
+/****************************************************************************************
+ * EXPRESSIONS
+ *
+ * gcode_expression_value() - evaluate the operand at *p: a number, a #parameter, a
+ *      bracketed [expression] or a function, with optional signs. *p is left past it.
+ *
+ *  The evaluator is recursive descent over the NGC precedence levels. Brackets, signs and
+ *  #-indirections are limited to GCODE_EXPRESSION_DEPTH, so the C stack used is bounded.
+ */
+
+typedef enum {
+    OP_NONE = 0,
+    OP_POWER,                               // level 1
+    OP_TIMES, OP_DIVIDE, OP_MOD,            // level 2
+    OP_PLUS, OP_MINUS,                      // level 3
+    OP_EQ, OP_NE, OP_GT, OP_GE, OP_LT, OP_LE,   // level 4
+    OP_AND, OP_OR, OP_XOR                   // level 5
+} gpOperator;
+#define EXPRESSION_LEVELS 5
+
+typedef struct gpOperatorName {
+    const char *name;
+    uint8_t level;
+    uint8_t op;
+} gpOperatorName_t;
+
+static const gpOperatorName_t _operators[] = {
+    { "**", 1, OP_POWER },
+    { "*", 2, OP_TIMES }, { "/", 2, OP_DIVIDE }, { "MOD", 2, OP_MOD },
+    { "+", 3, OP_PLUS }, { "-", 3, OP_MINUS },
+    { "EQ", 4, OP_EQ }, { "NE", 4, OP_NE }, { "GT", 4, OP_GT }, { "GE", 4, OP_GE },
+    { "LT", 4, OP_LT }, { "LE", 4, OP_LE },
+    { "AND", 5, OP_AND }, { "OR", 5, OP_OR }, { "XOR", 5, OP_XOR }
+};
+
+typedef enum {
+    FN_ABS = 0, FN_ACOS, FN_ASIN, FN_COS, FN_EXP, FN_FIX, FN_FUP, FN_ROUND,
+    FN_LN, FN_SIN, FN_SQRT, FN_TAN, FN_ATAN, FN_EXISTS
+} gpFunction;
+
+static const char *const _functions[] = {   // gpFunction order
+    "ABS", "ACOS", "ASIN", "COS", "EXP", "FIX", "FUP", "ROUND",
+    "LN", "SIN", "SQRT", "TAN", "ATAN", "EXISTS"
+};
+
+stat_t gcode_expression_value(const char **p, float *value)
+{
+    return (_operand(p, 0, value));
+}
+
+static stat_t _bracket(const char **p, uint8_t depth, float *value)
+{
+    _skip_spaces(p);
+    if (**p != '[') {
+        return (STAT_EXPRESSION_SYNTAX_ERROR);
+    }
+    if (depth == GCODE_EXPRESSION_DEPTH) {
+        return (STAT_MAX_DEPTH_EXCEEDED);
+    }
+    (*p)++;
+    ritorno(_expression(p, depth+1, EXPRESSION_LEVELS, value));
+    _skip_spaces(p);
+    if (**p != ']') {
+        return (STAT_EXPRESSION_SYNTAX_ERROR);
+    }
+    (*p)++;
+    return (STAT_OK);
+}
+
+static stat_t _function(const char **p, uint8_t depth, uint8_t fn, float *value)
+{
+    if (fn == FN_EXISTS) {                  // EXISTS[#<name>]
+        gpReference_t ref;
+        _skip_spaces(p);
+        if (**p != '[') { return (STAT_EXPRESSION_SYNTAX_ERROR); }
+        (*p)++;
+        _skip_spaces(p);
+        if (**p != '#') { return (STAT_EXPRESSION_SYNTAX_ERROR); }
+        (*p)++;
+        ritorno(_reference(p, depth+1, &ref));
+        _skip_spaces(p);
+        if (**p != ']') { return (STAT_EXPRESSION_SYNTAX_ERROR); }
+        (*p)++;
+        float unused;
+        *value = (_read_parameter(&ref, &unused) == STAT_OK) ? 1 : 0;
+        return (STAT_OK);
+    }
+    float x;
+    ritorno(_bracket(p, depth, &x));
+    switch (fn) {
+        case FN_ABS:   { *value = fabs(x); break; }
+        case FN_ACOS:  { if (fabs(x) > 1) { return (STAT_EXPRESSION_DOMAIN_ERROR); }
+                         *value = acos(x) * RADIAN; break; }
+        case FN_ASIN:  { if (fabs(x) > 1) { return (STAT_EXPRESSION_DOMAIN_ERROR); }
+                         *value = asin(x) * RADIAN; break; }
+        case FN_COS:   { *value = cos(x / RADIAN); break; }
+        case FN_EXP:   { *value = exp(x); break; }
+        case FN_FIX:   { *value = floor(x); break; }
+        case FN_FUP:   { *value = ceil(x); break; }
+        case FN_ROUND: { *value = round(x); break; }
+        case FN_LN:    { if (x <= 0) { return (STAT_EXPRESSION_DOMAIN_ERROR); }
+                         *value = log(x); break; }
+        case FN_SIN:   { *value = sin(x / RADIAN); break; }
+        case FN_SQRT:  { if (x < 0) { return (STAT_EXPRESSION_DOMAIN_ERROR); }
+                         *value = sqrt(x); break; }
+        case FN_TAN:   { *value = tan(x / RADIAN); break; }
+        case FN_ATAN:  {                    // ATAN[y]/[x]
+            float x2;
+            _skip_spaces(p);
+            if (**p != '/') { return (STAT_EXPRESSION_SYNTAX_ERROR); }
+            (*p)++;
+            ritorno(_bracket(p, depth, &x2));
+            *value = atan2(x, x2) * RADIAN;
+            break;
+        }
+    }
+    return (STAT_OK);
+}
+
+static stat_t _operand(const char **p, uint8_t depth, float *value)
+{
+    _skip_spaces(p);
+    char c = **p;
+
+    if ((c == '-') || (c == '+')) {         // unary minus and plus
+        if (depth == GCODE_EXPRESSION_DEPTH) {
+            return (STAT_MAX_DEPTH_EXCEEDED);
+        }
+        (*p)++;
+        ritorno(_operand(p, depth+1, value));
+        if (c == '-') {
+            *value = -*value;
+        }
+        return (STAT_OK);
+    }
+    if (c == '[') {
+        return (_bracket(p, depth, value));
+    }
+    if (c == '#') {
+        if (depth == GCODE_EXPRESSION_DEPTH) {
+            return (STAT_MAX_DEPTH_EXCEEDED);
+        }
+        gpReference_t ref;
+        (*p)++;
+        ritorno(_reference(p, depth+1, &ref));
+        return (_read_parameter(&ref, value));
+    }
+    if (isdigit(c) || (c == '.')) {         // no exponents in Gcode numbers
+        float number = 0;
+        float scale = 0;
+        for (; isdigit(**p) || ((**p == '.') && (scale == 0)); (*p)++) {
+            if (**p == '.') {
+                scale = 1;
+            } else {
+                number = number * 10 + (**p - '0');
+                if (scale != 0) { scale *= 10; }
+            }
+        }
+        *value = (scale > 1) ? (number / scale) : number;
+        return (STAT_OK);
+    }
+    for (uint8_t fn = 0; fn < (sizeof(_functions) / sizeof(_functions[0])); fn++) {
+        if (_match(p, _functions[fn])) {
+            return (_function(p, depth, fn, value));
+        }
+    }
+    return (STAT_EXPRESSION_SYNTAX_ERROR);
+}
+
+static uint8_t _operator(const char **p, uint8_t level)
+{
+    _skip_spaces(p);
+    for (uint8_t i = 0; i < (sizeof(_operators) / sizeof(_operators[0])); i++) {
+        if (_operators[i].level != level) {
+            continue;
+        }
+        const char *s = *p;
+        if ((level == 2) && (s[0] == '*') && (s[1] == '*')) {
+            return (OP_NONE);               // a power binds tighter - not ours
+        }
+        if (_match(&s, _operators[i].name)) {
+            *p = s;
+            return (_operators[i].op);
+        }
+    }
+    return (OP_NONE);
+}
+
+static stat_t _expression(const char **p, uint8_t depth, uint8_t level, float *value)
+{
+    if (level == 0) {
+        return (_operand(p, depth, value));
+    }
+    ritorno(_expression(p, depth, level-1, value));
+    for (uint8_t op; (op = _operator(p, level)) != OP_NONE; ) {
+        float rhs;
+        ritorno(_expression(p, depth, level-1, &rhs));
+        float lhs = *value;
+        switch (op) {
+            case OP_POWER:  { *value = pow(lhs, rhs); break; }
+            case OP_TIMES:  { *value = lhs * rhs; break; }
+            case OP_DIVIDE: { if (rhs == 0) { return (STAT_EXPRESSION_DOMAIN_ERROR); }
+                              *value = lhs / rhs; break; }
+            case OP_MOD:    { if (rhs == 0) { return (STAT_EXPRESSION_DOMAIN_ERROR); }
+                              *value = fmod(lhs, rhs);
+                              if (*value < 0) { *value += fabs(rhs); }
+                              break; }
+            case OP_PLUS:   { *value = lhs + rhs; break; }
+            case OP_MINUS:  { *value = lhs - rhs; break; }
+            case OP_EQ:     { *value = fp_EQ(lhs, rhs) ? 1 : 0; break; }
+            case OP_NE:     { *value = fp_NE(lhs, rhs) ? 1 : 0; break; }
+            case OP_GT:     { *value = (lhs > rhs) ? 1 : 0; break; }
+            case OP_GE:     { *value = (lhs >= rhs) ? 1 : 0; break; }
+            case OP_LT:     { *value = (lhs < rhs) ? 1 : 0; break; }
+            case OP_LE:     { *value = (lhs <= rhs) ? 1 : 0; break; }
+            case OP_AND:    { *value = (fp_NE(lhs, 0) && fp_NE(rhs, 0)) ? 1 : 0; break; }
+            case OP_OR:     { *value = (fp_NE(lhs, 0) || fp_NE(rhs, 0)) ? 1 : 0; break; }
+            case OP_XOR:    { *value = (fp_NE(lhs, 0) != fp_NE(rhs, 0)) ? 1 : 0; break; }
+        }
+        if (isnan(*value) || isinf(*value)) {
+            return (STAT_EXPRESSION_DOMAIN_ERROR);
+        }
+    }
+    return (STAT_OK);
+}
+
+/****************************************************************************************
+ * O WORDS
+ *
+ * gcode_program_has_words() - true if the line uses parameters, expressions or O words.
+ *      Such lines depend on the lines before them having run and are not scanned ahead.
+ */
+
+// parse "[Nnnn] Onnn keyword" - returns the keyword or O_NONE, and *p past the keyword
+static uint8_t _o_word(const char **p, uint16_t *number)
+{
+    _skip_spaces(p);
+    if ((**p == 'N') || (**p == 'n')) {
+        for ((*p)++; isdigit(**p); (*p)++);
+        _skip_spaces(p);
+    }
+    if ((**p != 'O') && (**p != 'o')) {
+        return (O_NONE);
+    }
+    (*p)++;
+    uint32_t n = 0;
+    for (; isdigit(**p); (*p)++) {
+        n = n * 10 + (**p - '0');
+        if (n > 65535) { return (O_NONE); }
+    }
+    _skip_spaces(p);
+    *number = n;
+    for (uint8_t k = O_SUB; k <= O_CONTINUE; k++) {
+        const char *s = *p;
+        if (_match(&s, _keyword[k]) && !isalpha(*s)) {
+            *p = s;
+            return (k);
+        }
+    }
+    return (O_NONE);
+}
+
+static bool _is_o_line(const char *line)
+{
+    _skip_spaces(&line);
+    if ((*line == 'N') || (*line == 'n')) {
+        for (line++; isdigit(*line); line++);
+        _skip_spaces(&line);
+    }
+    return ((*line == 'O') || (*line == 'o'));
+}
+
+bool gcode_program_has_words(const char *line)
+{
+    return ((strpbrk(line, "#[") != nullptr) || _is_o_line(line));
+}
+
+static stat_t _condition(const char **p, bool *result)
+{
+    float value;
+    ritorno(_bracket(p, 0, &value));
+    *result = fp_NE(value, 0);     // any non-zero value is true
+    return (STAT_OK);
+}
+
+// append a line to the store - returns its offset in *offset
+static stat_t _store_line(const char *line, uint16_t *offset)
+{
+    uint16_t length = strlen(line) + 1;
+    if (length > GCODE_PROGRAM_LINE_LEN) {
+        return (STAT_INPUT_EXCEEDS_MAX_LENGTH);
+    }
+    if (pg.tail + length > GCODE_PROGRAM_STORE_SIZE) {
+        return (STAT_O_WORD_STORE_FULL);
+    }
+    *offset = pg.tail;
+    memcpy(&pg.store[pg.tail], line, length);
+    pg.tail += length;
+    return (STAT_OK);
+}
+
+static void _skip(uint16_t number, uint16_t until, bool execute)
+{
+    pg.skipping = true;
+    pg.skip_number = number;
+    pg.skip_until = until;
+    pg.skip_execute = execute;
+}
+
+static void _jump(uint16_t pc)
+{
+    pg.pc = pc;
+    pg.replaying = true;
+}
+
+// the innermost open loop with this O number, or -1
+static int8_t _find_loop(uint16_t number)
+{
+    for (int8_t i = pg.depth-1; i >= 0; i--) {
+        if ((pg.block[i].number == number) && (pg.block[i].keyword != O_IF)) {
+            return (i);
+        }
+    }
+    return (-1);
+}
+
+static uint16_t _loop_end(uint8_t keyword)
+{
+    return ((keyword == O_WHILE) ? _K(O_ENDWHILE) : (keyword == O_DO) ? _K(O_WHILE) : _K(O_ENDREPEAT));
+}
+
+static stat_t _push(uint16_t number, uint8_t keyword, uint16_t start)
+{
+    if (pg.depth == GCODE_O_WORD_DEPTH) {
+        return (STAT_O_WORD_NESTING_TOO_DEEP);
+    }
+    gpBlock_t *b = &pg.block[pg.depth++];
+    b->number = number;
+    b->keyword = keyword;
+    b->taken = false;
+    b->start = start;
+    b->count = 0;
+    return (STAT_OK);
+}
+
+static gpBlock_t *_top(uint16_t number, uint8_t keyword)
+{
+    if ((pg.depth == 0) || (pg.block[pg.depth-1].number != number) || (pg.block[pg.depth-1].keyword != keyword)) {
+        return (nullptr);
+    }
+    return (&pg.block[pg.depth-1]);
+}
+
+// a loop opened from the stream is recorded from its opening line on
+static stat_t _record_loop(const char *line, uint16_t *offset, uint16_t *next)
+{
+    if (pg.from_store) {
+        return (STAT_OK);                   // offsets are already set
+    }
+    if (!pg.recording) {
+        pg.recording = true;
+        pg.record_base = pg.tail;
+        pg.record_depth = pg.depth;
+        ritorno(_store_line(line, offset));
+    }
+    *next = pg.tail;
+    return (STAT_OK);
+}
+
+static stat_t _call(uint16_t number, const char *args)
+{
+    gpSubroutine_t *sub = nullptr;
+    for (uint8_t i = 0; i < GCODE_SUBROUTINES; i++) {
+        if (pg.sub[i].number == number) {
+            sub = &pg.sub[i];
+        }
+    }
+    if ((number == 0) || (sub == nullptr)) {
+        return (STAT_O_WORD_SUBROUTINE_UNDEFINED);
+    }
+    if (pg.calls == GCODE_CALL_DEPTH) {
+        return (STAT_O_WORD_NESTING_TOO_DEEP);
+    }
+    float arg[GCODE_CALL_ARGUMENTS];
+    uint8_t args_count = 0;
+    for (_skip_spaces(&args); *args == '['; _skip_spaces(&args)) {
+        if (args_count == GCODE_CALL_ARGUMENTS) {
+            return (STAT_INPUT_EXCEEDS_MAX_LENGTH);
+        }
+        ritorno(_bracket(&args, 0, &arg[args_count++]));
+    }
+    gpCall_t *call = &pg.call[pg.calls++];
+    call->number = number;
+    call->depth = pg.depth;
+    call->from_store = pg.from_store;
+    call->pc = pg.pc;
+    memcpy(call->saved, &pg.parameter[1], sizeof(call->saved));
+    memset(&pg.parameter[1], 0, sizeof(call->saved));
+    memcpy(&pg.parameter[1], arg, args_count * sizeof(float));
+    _jump(sub->start);
+    return (STAT_OK);
+}
+
+static stat_t _return(uint16_t number)
+{
+    if ((pg.calls == 0) || (pg.call[pg.calls-1].number != number)) {
+        return (STAT_O_WORD_INVALID);
+    }
+    gpCall_t *call = &pg.call[--pg.calls];
+    memcpy(&pg.parameter[1], call->saved, sizeof(call->saved));
+    pg.depth = call->depth;                 // drop blocks left open by a return
+    pg.skipping = false;
+    pg.replaying = call->from_store;
+    pg.pc = call->pc;
+    return (STAT_OK);
+}
+
+static stat_t _define(uint16_t number)
+{
+    if (pg.from_store || (pg.depth != 0) || (pg.calls != 0) || (number == 0)) {
+        return (STAT_O_WORD_INVALID);       // subroutines are defined at the top level only
+    }
+    gpSubroutine_t *sub = nullptr;
+    for (uint8_t i = 0; i < GCODE_SUBROUTINES; i++) {
+        if (pg.sub[i].number == number) {   // redefinition
+            sub = &pg.sub[i];
+            if (sub->start + sub->length == pg.tail) {
+                pg.tail = sub->start;       // it was the last one stored - reuse its room
+            }
+            break;
+        }
+        if ((sub == nullptr) && (pg.sub[i].number == 0)) {
+            sub = &pg.sub[i];
+        }
+    }
+    if (sub == nullptr) {
+        return (STAT_O_WORD_STORE_FULL);
+    }
+    sub->number = number;
+    sub->start = pg.tail;
+    sub->length = 0;
+    pg.defining = sub;
+    return (STAT_OK);
+}
+
+// run an O word line. offset is where the line is in the store, next where the line after it is
+static stat_t _run_o_word(const char *line, uint8_t keyword, uint16_t number, const char *rest,
+                          uint16_t offset, uint16_t next)
+{
+    gpBlock_t *b;
+    bool result;
+
+    switch (keyword) {
+        case O_SUB: { return (_define(number)); }
+        case O_ENDSUB:
+        case O_RETURN: { return (_return(number)); }
+        case O_CALL: { return (_call(number, rest)); }
+
+        case O_IF: {
+            ritorno(_condition(&rest, &result));
+            ritorno(_push(number, O_IF, 0));
+            if (result) {
+                pg.block[pg.depth-1].taken = true;
+            } else {
+                _skip(number, _K(O_ELSEIF) | _K(O_ELSE) | _K(O_ENDIF), true);
+            }
+            return (STAT_OK);
+        }
+        case O_ELSEIF:
+        case O_ELSE: {
+            if ((b = _top(number, O_IF)) == nullptr) {
+                return (STAT_O_WORD_INVALID);
+            }
+            if (b->taken) {
+                _skip(number, _K(O_ENDIF), true);
+                return (STAT_OK);
+            }
+            result = true;
+            if (keyword == O_ELSEIF) {
+                ritorno(_condition(&rest, &result));
+            }
+            if (result) {
+                b->taken = true;
+            } else {
+                _skip(number, _K(O_ELSEIF) | _K(O_ELSE) | _K(O_ENDIF), true);
+            }
+            return (STAT_OK);
+        }
+        case O_ENDIF: {
+            if (_top(number, O_IF) == nullptr) {
+                return (STAT_O_WORD_INVALID);
+            }
+            pg.depth--;
+            return (STAT_OK);
+        }
+
+        case O_WHILE: {
+            if ((b = _top(number, O_DO)) != nullptr) {         // closes a do loop
+                ritorno(_condition(&rest, &result));
+                if (result) {
+                    _jump(b->start);
+                } else {
+                    pg.depth--;
+                }
+                return (STAT_OK);
+            }
+            ritorno(_condition(&rest, &result));
+            b = _top(number, O_WHILE);
+            bool again = (b != nullptr) && pg.from_store && (b->start == offset);
+            if (!result) {
+                if (again) {
+                    pg.depth--;
+                }
+                _skip(number, _K(O_ENDWHILE), false);
+                return (STAT_OK);
+            }
+            if (!again) {
+                ritorno(_record_loop(line, &offset, &next));
+                ritorno(_push(number, O_WHILE, offset));
+            }
+            return (STAT_OK);
+        }
+        case O_ENDWHILE: {
+            if ((b = _top(number, O_WHILE)) == nullptr) {
+                return (STAT_O_WORD_INVALID);
+            }
+            _jump(b->start);                                   // back to the while line
+            return (STAT_OK);
+        }
+        case O_DO: {
+            ritorno(_record_loop(line, &offset, &next));
+            return (_push(number, O_DO, next));
+        }
+        case O_REPEAT: {
+            float count;
+            ritorno(_bracket(&rest, 0, &count));
+            if (count < 1) {
+                _skip(number, _K(O_ENDREPEAT), false);
+                return (STAT_OK);
+            }
+            ritorno(_record_loop(line, &offset, &next));
+            ritorno(_push(number, O_REPEAT, next));
+            pg.block[pg.depth-1].count = (int32_t)count;
+            return (STAT_OK);
+        }
+        case O_ENDREPEAT: {
+            if ((b = _top(number, O_REPEAT)) == nullptr) {
+                return (STAT_O_WORD_INVALID);
+            }
+            if (--b->count > 0) {
+                _jump(b->start);
+            } else {
+                pg.depth--;
+            }
+            return (STAT_OK);
+        }
+        case O_BREAK:
+        case O_CONTINUE: {
+            int8_t i = _find_loop(number);
+            if (i < 0) {
+                return (STAT_O_WORD_INVALID);
+            }
+            uint16_t until = _loop_end(pg.block[i].keyword);
+            if (keyword == O_BREAK) {
+                pg.depth = i;                                   // leave the loop...
+                _skip(number, until, false);                    // ...and drop the rest of it
+            } else {
+                pg.depth = i+1;
+                _skip(number, until, true);                     // run the loop end
+            }
+            return (STAT_OK);
+        }
+    }
+    return (STAT_O_WORD_INVALID);
+}
+
+// stop recording once the loop that started it has been left and lines come from the stream
+static void _end_recording()
+{
+    if (pg.recording && !pg.replaying && (pg.depth <= pg.record_depth)) {
+        pg.tail = pg.record_base;
+        pg.recording = false;
+    }
+}
+
+/*
+ * gcode_program_filter() - run O words and sort out the lines to run
+ *
+ *  Called with each Gcode line before it is scanned. Sets execute if the line is to be run
+ *  by the parser - false for O word lines, lines stored into a subroutine and the lines of
+ *  branches not taken. An error ends the loops and calls in progress.
+ */
+
+stat_t gcode_program_filter(const char *line, bool *execute)
+{
+    stat_t status = STAT_OK;
+    uint16_t number = 0;
+    const char *rest = line;
+    uint8_t keyword = _o_word(&rest, &number);
+    uint16_t offset = pg.line_offset;
+    uint16_t next = pg.pc;
+    *execute = false;
+
+    if (pg.defining != nullptr) {           // storing a subroutine body
+        uint16_t unused;
+        if ((status = _store_line(line, &unused)) != STAT_OK) {
+            gcode_program_reset();
+            return (status);
+        }
+        if ((keyword == O_ENDSUB) && (number == pg.defining->number)) {
+            pg.defining->length = pg.tail - pg.defining->start;
+            pg.defining = nullptr;
+        }
+        return (STAT_OK);
+    }
+    if (!pg.from_store && pg.recording) {   // streamed line inside a loop
+        if ((status = _store_line(line, &offset)) != STAT_OK) {
+            gcode_program_reset();
+            return (status);
+        }
+        next = pg.tail;
+    }
+    if (pg.skipping) {
+        if ((keyword == O_NONE) || (number != pg.skip_number) || !(pg.skip_until & _K(keyword))) {
+            _end_recording();
+            pg.from_store = false;
+            return (STAT_OK);
+        }
+        pg.skipping = false;
+        if (!pg.skip_execute) {
+            _end_recording();
+            pg.from_store = false;
+            return (STAT_OK);
+        }
+    }
+    if (keyword != O_NONE) {
+        status = _run_o_word(line, keyword, number, rest, offset, next);
+    } else if (_is_o_line(line)) {
+        status = STAT_O_WORD_INVALID;
+    } else {
+        *execute = true;
+    }
+    pg.from_store = false;
+    if (status != STAT_OK) {
+        gcode_program_reset();
+        return (status);
+    }
+    _end_recording();
+    return (STAT_OK);
+}
+
+/*
+ * gcode_program_next_line() - the next line to replay from the store, or nullptr to read
+ *      the stream. The line may be changed by the caller.
+ */
+
+char *gcode_program_next_line()
+{
+    if (!pg.replaying) {
+        return (nullptr);
+    }
+    if (pg.pc >= pg.tail) {                 // ran off the end of a loop recording
+        pg.replaying = false;
+        _end_recording();
+        return (nullptr);
+    }
+    pg.line_offset = pg.pc;
+    strcpy(pg.line, &pg.store[pg.pc]);
+    pg.pc += strlen(pg.line) + 1;
+    pg.from_store = true;
+    return (pg.line);
+}
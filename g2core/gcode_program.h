@@ -0,0 +1,118 @@
+/*
+ * gcode_program.h - Gcode parameters, expressions and O word control flow
+ * This file is part of the g2core project
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, you may use this file as part of a software library without
+ * restriction. Specifically, if other files instantiate templates or use macros or
+ * inline functions from this file, or you compile this file and link it with  other
+ * files to produce an executable, this file does not by itself cause the resulting
+ * executable to be covered by the GNU General Public License. This exception does not
+ * however invalidate any other reasons why the executable file might be covered by the
+ * GNU General Public License.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/*
+ * GCODE PROGRAMS
+ *
+ *  RS274/NGC parameters, expressions and O word control flow, run on the controller so a
+ *  host can stream parametric programs as they are written. Everything is held in fixed
+ *  tables - the sizes below bound the RAM used.
+ *
+ *  Parameters and expressions
+ *      #1 - #99        numbered parameters, RAM only (#1 - #30 are the arguments of a call)
+ *      #<name>         named parameters - all global
+ *      #5061 - #5069   last probe position XYZABCUVW, in work coordinates  (read only)
+ *      #5070           1 if the last probe succeeded                       (read only)
+ *      #5161, #5181    G28 and G30 positions XYZABCUVW                     (read only)
+ *      #5210 - #5219   G92 enable, G92 offsets                             (read only)
+ *      #5220           active coordinate system, 1 = G54                   (read only)
+ *      #5221 - #5329   G54 - G59 offsets, 20 per system                    (read only)
+ *      #5400           active tool                                         (read only)
+ *      #5420 - #5428   current work position                               (read only)
+ *
+ *  Linear values are in the units in effect. An expression is an operand or a bracketed
+ *  [expression] using ** * / MOD + - EQ NE GT GE LT LE AND OR XOR (in NGC precedence),
+ *  unary minus, ABS ACOS ASIN COS EXP FIX FUP ROUND LN SIN SQRT TAN (degrees), ATAN[y]/[x]
+ *  and EXISTS[#<name>]. Any word value can be an expression ("G1 X[#1*2] F#<feed>") and
+ *  "#n=value" sets a parameter. All settings on a line take effect after the whole line
+ *  has been read, as in NGC.
+ *
+ *  O words
+ *      O100 sub ... O100 endsub / O100 return      define a subroutine
+ *      O100 call [a] [b] ...                       call it with a, b... in #1, #2...
+ *      O101 while [cond] ... O101 endwhile
+ *      O102 do ... O102 while [cond]
+ *      O103 repeat [n] ... O103 endrepeat
+ *      O104 if [cond] ... O104 elseif [cond] ... O104 else ... O104 endif
+ *      O105 break, O105 continue                   (with the number of the loop)
+ *
+ *  Subroutine bodies and the lines of loops are kept in a RAM store so they can be run
+ *  again. A loop streamed by the host (or read from a job file) is run as it arrives and
+ *  recorded; further passes are replayed from the store and the recording is dropped when
+ *  the loop is left. Replayed lines get no response - an error in one is reported as an
+ *  exception and ends the loops and calls in progress. While any of this is going on
+ *  Gcode is not read ahead of the planner, so lines stay in program order.
+ */
+
+#ifndef GCODE_PROGRAM_H_ONCE
+#define GCODE_PROGRAM_H_ONCE
+
+/**** Configs and Constants ****/
+
+#ifndef GCODE_PARAMETERS
+#define GCODE_PARAMETERS 100                // numbered parameters #1 - #99
+#endif
+#ifndef GCODE_NAMED_PARAMETERS
+#define GCODE_NAMED_PARAMETERS 16           // #<name> parameters
+#endif
+#define GCODE_PARAMETER_NAME_LEN 12         // longest #<name>, including the NUL
+#ifndef GCODE_PENDING_ASSIGNMENTS
+#define GCODE_PENDING_ASSIGNMENTS 8         // #n= settings on one line
+#endif
+#ifndef GCODE_EXPRESSION_DEPTH
+#define GCODE_EXPRESSION_DEPTH 8            // nested brackets, signs and #-indirections
+#endif
+
+#ifndef GCODE_PROGRAM_STORE_SIZE
+#define GCODE_PROGRAM_STORE_SIZE 2048       // bytes for subroutine bodies and loop recordings
+#endif
+#ifndef GCODE_PROGRAM_LINE_LEN
+#define GCODE_PROGRAM_LINE_LEN 128          // longest line that can be stored
+#endif
+#ifndef GCODE_SUBROUTINES
+#define GCODE_SUBROUTINES 8
+#endif
+#ifndef GCODE_O_WORD_DEPTH
+#define GCODE_O_WORD_DEPTH 8                // nested if, while, do and repeat blocks
+#endif
+#ifndef GCODE_CALL_DEPTH
+#define GCODE_CALL_DEPTH 4                  // nested subroutine calls
+#endif
+#define GCODE_CALL_ARGUMENTS 30             // #1 - #30 are saved and restored by a call
+
+/**** Function Prototypes ****/
+
+void gcode_program_init(void);
+void gcode_program_reset(void);
+bool gcode_program_is_idle(void);
+bool gcode_program_has_words(const char *line);
+stat_t gcode_program_filter(const char *line, bool *execute);
+char *gcode_program_next_line(void);
+
+stat_t gcode_expression_value(const char **p, float *value);
+stat_t gcode_parameter_assignment(const char **p);
+void gcode_parameter_clear_pending(void);
+void gcode_parameter_apply_pending(void);
+
+#endif  // End of include guard: GCODE_PROGRAM_H_ONCE
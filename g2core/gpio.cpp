@@ -47,6 +47,7 @@
 #include "encoder.h"
 #include "hardware.h"
 #include "canonical_machine.h"
+#include "planner.h"
 
 #include "text_parser.h"
 #include "controller.h"
@@ -510,6 +511,52 @@ stat_t gpio_set_output(uint8_t output_num, float value) {
   return STAT_OK;
 }
 
+/*
+ * gpio_set_outputs() - turn a set of outputs on and off (bit 0 = output 1)
+ *
+ *  Called from the stepper loader to change M62/M63 outputs with the motion.
+ */
+void gpio_set_outputs(const uint16_t on, const uint16_t off)
+{
+    for (uint8_t i = 0; i < D_OUT_CHANNELS; i++) {
+        if (on & (1 << i)) {
+            gpio_set_output(i, 1.0);
+        } else if (off & (1 << i)) {
+            gpio_set_output(i, 0.0);
+        }
+    }
+}
+
+/*
+ * gpio_output_control() - M62, M63, M64, M65 digital output control
+ *
+ *  P is the output number (1 = out1). M64/M65 set the output now. M62/M63 set it with
+ *  the next move, optionally Q distance into it, without stopping the planner. Outputs set
+ *  for the same move must share one Q. See mp_sync_output().
+ */
+stat_t gpio_output_control(const ioOutputControl control, const float P_word, const bool P_flag,
+                                                           const float Q_word, const bool Q_flag)
+{
+    if (!P_flag) {
+        return (STAT_P_WORD_IS_MISSING);
+    }
+    if ((P_word < 1) || (P_word > D_OUT_CHANNELS) || (fp_NE(P_word, (uint8_t)P_word))) {
+        return (STAT_P_WORD_IS_INVALID);
+    }
+    if (Q_flag && (Q_word < 0)) {
+        return (STAT_Q_WORD_IS_INVALID);
+    }
+    uint8_t output_num = (uint8_t)P_word - 1;
+    switch (control) {
+        case OUTPUT_SYNC_ON:       { return (mp_sync_output(output_num, true,  Q_flag ? _to_millimeters(Q_word) : 0)); }
+        case OUTPUT_SYNC_OFF:      { return (mp_sync_output(output_num, false, Q_flag ? _to_millimeters(Q_word) : 0)); }
+        case OUTPUT_IMMEDIATE_ON:  { return (gpio_set_output(output_num, 1.0)); }
+        case OUTPUT_IMMEDIATE_OFF: { return (gpio_set_output(output_num, 0.0)); }
+        default: {}
+    }
+    return (STAT_OK);
+}
+
 
 /***********************************************************************************
  * CONFIGURATION AND INTERFACE FUNCTIONS
@@ -616,6 +663,43 @@ stat_t io_set_domode(nvObj_t *nv)           // output function
     return (STAT_OK);
 }
 
+/*
+ *  gpio_get_output() - return the logical value (0.0 - 1.0) of an output, 0 if it's disabled
+ *
+ *  output_num is zero-based, the same as gpio_set_output().
+ */
+float gpio_get_output(const uint8_t output_num)
+{
+    if (output_num >= D_OUT_CHANNELS) {
+        return (0.0);
+    }
+    ioMode outMode = d_out[output_num].mode;
+    if (outMode == IO_MODE_DISABLED) {
+        return (0.0);
+    }
+    float value;
+    switch (output_num+1) {                     // add 1 to get logical pin numbers
+        case 1:  { value = (float)output_1_pin; } break;
+        case 2:  { value = (float)output_2_pin; } break;
+        case 3:  { value = (float)output_3_pin; } break;
+        case 4:  { value = (float)output_4_pin; } break;
+        case 5:  { value = (float)output_5_pin; } break;
+        case 6:  { value = (float)output_6_pin; } break;
+        case 7:  { value = (float)output_7_pin; } break;
+        case 8:  { value = (float)output_8_pin; } break;
+        case 9:  { value = (float)output_9_pin; } break;
+        case 10: { value = (float)output_10_pin; } break;
+        case 11: { value = (float)output_11_pin; } break;
+        case 12: { value = (float)output_12_pin; } break;
+        case 13: { value = (float)output_13_pin; } break;
+        default: { return (0.0); }
+    }
+    if (outMode == IO_ACTIVE_LOW) {
+        value = 1.0 - value;                    // invert output sense
+    }
+    return (value);
+}
+
 /*
  *  io_get_output() - return output state given an nv object
  */
@@ -623,32 +707,12 @@ stat_t io_get_output(nvObj_t *nv)
 {
     uint8_t output_num = _io(nv->index);
 
-    ioMode outMode = d_out[output_num].mode;
-    if (outMode == IO_MODE_DISABLED) {
+    if (d_out[output_num].mode == IO_MODE_DISABLED) {
         nv->valuetype = TYPE_NULL;   // reports back as NULL
     } else {
         nv->valuetype = TYPE_FLOAT;
         nv->precision = 2;
-        
-        switch (output_num+1) {                 // add 1 to get logical pin numbers
-            case 1:  { nv->value_flt = (float)output_1_pin; } break;
-            case 2:  { nv->value_flt = (float)output_2_pin; } break;
-            case 3:  { nv->value_flt = (float)output_3_pin; } break;
-            case 4:  { nv->value_flt = (float)output_4_pin; } break;
-            case 5:  { nv->value_flt = (float)output_5_pin; } break;
-            case 6:  { nv->value_flt = (float)output_6_pin; } break;
-            case 7:  { nv->value_flt = (float)output_7_pin; } break;
-            case 8:  { nv->value_flt = (float)output_8_pin; } break;
-            case 9:  { nv->value_flt = (float)output_9_pin; } break;
-            case 10: { nv->value_flt = (float)output_10_pin; } break;
-            case 11: { nv->value_flt = (float)output_11_pin; } break;
-            case 12: { nv->value_flt = (float)output_12_pin; } break;
-            case 13: { nv->value_flt = (float)output_13_pin; } break;
-            default: { nv->valuetype = TYPE_NULL;  }    // reports back as NULL
-        }
-        if (outMode == IO_ACTIVE_LOW) {
-            nv->value_flt = 1.0 - nv->value_flt;        // invert output sense
-        }
+        nv->value_flt = gpio_get_output(output_num);
     }
     return (STAT_OK);
 }
@@ -104,6 +104,14 @@ typedef enum {
     INPUT_EDGE_TRAILING                 // flag is set when trailing edge is detected
 } inputEdgeFlag;
 
+typedef enum {                          // M62-M65 digital output control
+    OUTPUT_CONTROL_NONE = 0,
+    OUTPUT_SYNC_ON,                     // M62 - turn output on with the next move
+    OUTPUT_SYNC_OFF,                    // M63 - turn output off with the next move
+    OUTPUT_IMMEDIATE_ON,                // M64 - turn output on now
+    OUTPUT_IMMEDIATE_OFF                // M65 - turn output off now
+} ioOutputControl;
+
 /*
  * GPIO structures
  */
@@ -151,6 +159,10 @@ void gpio_set_probing_mode(const uint8_t input_num, const bool is_probing);
 int8_t gpio_get_probing_input(void);
 bool gpio_read_input(const uint8_t input_num);
 stat_t gpio_set_output(uint8_t output_num, float value);
+float gpio_get_output(const uint8_t output_num);
+void gpio_set_outputs(const uint16_t on, const uint16_t off);
+stat_t gpio_output_control(const ioOutputControl control, const float P_word, const bool P_flag,
+                                                           const float Q_word, const bool Q_flag);
 
 stat_t io_get_mo(nvObj_t *nv);
 stat_t io_set_mo(nvObj_t *nv);
@@ -44,17 +44,13 @@ jsSingleton_t js;
 
 static stat_t _json_parser_kernal(nvObj_t *nv, char *str);
 static stat_t _json_parser_execute(nvObj_t *nv);
-static stat_t _normalize_json_string(char *str, uint16_t size);
-static stat_t _get_nv_pair(nvObj_t *nv, char **pstr, int8_t *depth);
 
 /****************************************************************************
  * json_parser() - exposed part of JSON parser
  * _json_parser_kernal()
- * _normalize_json_string()
- * _get_nv_pair_strict()
  *
- *  This is a dumbed down JSON parser to fit in limited memory with no malloc
- *  or practical way to do recursion ("depth" tracks parent/child levels).
+ *  This is a small recursive descent JSON parser to fit in limited memory with
+ *  no malloc. Recursion is bounded by JSON_MAX_DEPTH ("depth" tracks parent/child levels).
  *
  *  This function will parse the following forms up to the JSON_MAX limits:
  *    {"name":"value"}
@@ -63,6 +59,7 @@ static stat_t _get_nv_pair(nvObj_t *nv, char **pstr, int8_t *depth);
  *    {"parent_name":""}
  *    {"parent_name":{"name":"value"}}
  *    {"parent_name":{"name1":"value1", "n2":"v2", ... "nN":"vN"}}
+ *    {"parent_name":{"child":{"name":"value"}}, "p2":{"name":"value"}}
  *
  *    "value" can be a string, number, true, false, or null (2 types)
  *
@@ -80,8 +77,7 @@ static stat_t _get_nv_pair(nvObj_t *nv, char **pstr, int8_t *depth);
  *
  *  Separation of concerns
  *    json_parser() is the only exposed part. It does parsing, display, and status reports.
- *    _get_nv_pair() only does parsing and syntax; no semantic validation or group handling
- *    _json_parser_kernal() does index validation and group handling
+ *    _json_parser_kernal() does parsing and syntax, index validation and group handling
  *    _json_parser_execute() executes sets and gets in an application agnostic way. It should work for other apps than g2core
  */
 
@@ -91,7 +87,10 @@ stat_t json_parser(char *str, bool suppress_response) // suppress_response defau
     stat_t status = _json_parser_kernal(nv, str);
     if (status == STAT_OK) {                        // execute the command
         nv = nv_body;
+        bool streaming = nv_stream_enable(false);
+        nv_stream_enable(streaming && !suppress_response);  // a suppressed response isn't streamed either
         status = _json_parser_execute(nv);
+        nv_stream_enable(streaming);
     }
     if (suppress_response || (status == STAT_COMPLETE)) {  // skip the print if returning from something that already did it.
         return status;
@@ -108,7 +107,9 @@ void json_parse_for_exec(char *str, bool execute)
     stat_t status = _json_parser_kernal(nv, str);
     if ((status == STAT_OK) && (execute)) {
         nv = nv_exec;
+        bool streaming = nv_stream_enable(false);   // runs at exec level - never write to xio from here
         status = _json_parser_execute(nv);          // execute the command
+        nv_stream_enable(streaming);
     }
 }
 
@@ -117,7 +118,9 @@ static stat_t _json_parser_execute(nvObj_t *nv) {
     do {
         if (nv->valuetype == TYPE_PARENT) {         // added as partial fix for Issue #298:
                                                     // Reading values with nested JSON changes values in inches mode
-            if (strcmp(nv->token, "sr") == 0) {     // Hack to execute Set Status Report (SR parent) See end note (*)
+            if ((strcmp(nv->token, "sr") == 0) ||   // Hack to execute Set Status Report (SR parent) - the sr set reads the children that follow
+                (strcmp(nv->token, "srd") == 0) ||  // ...same for status report deadbands
+                (strcmp(nv->token, "srm") == 0)) {  // ...and minimum intervals
                 return (nv_set(nv));
             }
 
@@ -140,235 +143,289 @@ static stat_t _json_parser_execute(nvObj_t *nv) {
     return (STAT_OK);                               // only successful commands exit through this point
 }
 
-// (*) Note: The JSON / token system is essentially flat, as it was derived from a command-line flat-ASCII approach
-//     If the JSON objects had proper recursive descent handlers that just passed the remaining string (at that level) 
-//     off for further processing, we would not need to do this hack. A fix is in the works. For now, this is OK.
+/*
+ * _json_parser_kernal() - parse a JSON string into the nv list
+ *
+ *  A single pass over the string. Names are resolved to cfgArray indexes as they are
+ *  read, and string values are compacted and NUL terminated in place - nv->stringp
+ *  points into the input string, so the input must outlive the nv list (it does for
+ *  both callers: the RX line and the planner's JSON command buffer).
+ *
+ *  Objects nest to JSON_MAX_DEPTH. A child takes its group from the nearest enclosing
+ *  object that is a prefixed group, so {"x":{"vm":1},"y":{"vm":2}} sets xvm and yvm.
+ */
+
+typedef struct jsonParser {
+    char *rd;                                       // read position
+    nvObj_t *nv;                                    // next nv to populate
+    nvObj_t *last;                                  // last nv populated - marked if parsing fails
+    int8_t top_depth;                               // depth of the outermost pairs
+    uint8_t pairs;                                  // pairs parsed so far
+} jsonParser_t;
+
+static stat_t _json_parse_object(jsonParser_t *jp, const char *group, int8_t depth);
 
 static stat_t _json_parser_kernal(nvObj_t *nv, char *str)
 {
-    stat_t status;
-    int8_t depth;
-    char group[GROUP_LEN+1] = {""};                 // group identifier - starts as NUL
-    int8_t i = NV_BODY_LEN;
+    int8_t depth = nv_reset_nv(nv)->depth;          // top level sits wherever the list starts it
+    if (strnlen(str, JSON_INPUT_STRING_MAX+1) > JSON_INPUT_STRING_MAX) {
+        return (STAT_INPUT_EXCEEDS_MAX_LENGTH);     // before anything is compacted or linked
+    }
+    jsonParser_t jp = { str, nv, nv, depth, 0 };
 
-    status = _normalize_json_string(str, JSON_INPUT_STRING_MAX);
+    stat_t status = _json_parse_object(&jp, "", depth);
     if (status != STAT_OK) {
-        nv->valuetype = TYPE_NULL;
+        jp.last->valuetype = TYPE_NULL;             // the object that failed, for the error display
         return (status);
     }
-
-    // parse the JSON command into the nv body
-    do {
-        if (--i == 0) {
-            return (STAT_JSON_TOO_MANY_PAIRS);      // length error
-        }
-        // Use relaxed parser. Will read either strict or relaxed mode. To use strict-only parser refer
-        // to build earlier than 407.03. Substitute _get_nv_pair_strict() for _get_nv_pair()
-        if ((status = _get_nv_pair(nv, &str, &depth)) > STAT_EAGAIN) { // erred out
-            nv->valuetype = TYPE_NULL;
-            return (status);
-        }
-        // propagate the group from previous NV pair (if relevant)
-        if (group[0] != NUL) {
-            strncpy(nv->group, group, GROUP_LEN);   // copy the parent's group to this child
-        }
-        // validate the token and get the index
-        if ((nv->index = nv_get_index(nv->group, nv->token)) == NO_MATCH) {
-            nv->valuetype = TYPE_NULL;
-            return (STAT_UNRECOGNIZED_NAME);
-        }
-        if ((nv_index_is_group(nv->index)) && (nv_group_is_prefixed(nv->token))) {
-            strncpy(group, nv->token, GROUP_LEN);   // record the group ID
-        }
-        nv_coerce_types(nv);                        // adjust types based on type fields in configApp table
-        if ((nv = nv->nx) == NULL) {
-            return (STAT_JSON_TOO_MANY_PAIRS);      // Not supposed to encounter a NULL
-        }
-    } while (status != STAT_OK);                    // breaks when parsing is complete
-
-    return (STAT_OK);                               // only successful commands exit through this point
+    if (jp.pairs == 0) {
+        return (STAT_JSON_SYNTAX_ERROR);            // {} - nothing to do
+    }
+    return (STAT_OK);
 }
 
 /*
- * _normalize_json_string - normalize a JSON string in place
- *
- *  Validate string size limits, remove all whitespace and convert
- *  to lower case, with the exception of gcode comments
+ * _json_skip_ws() - skip whitespace, control characters and DEL. Returns the next character.
+ * _json_parse_name() - read an optionally quoted name into nv->token, lower case
+ * _json_parse_string() - compact the string value in place and link it to the nv
+ * _json_parse_value() - parse the value of the current nv
+ * _json_parse_object() - parse an object; the opening curly has been found but not consumed
+ *
+ *  Relaxed rules, as before: quotes are optional on names and required on string values.
+ *  Names and string values are lower cased and stripped of whitespace, except inside Gcode
+ *  comments and for table entries flagged F_VERBATIM (file names). null, true and false
+ *  may be abbreviated n, t and f. Input arrays are still not supported.
  */
 
-static stat_t _normalize_json_string(char *str, uint16_t size)
+static char _json_skip_ws(jsonParser_t *jp)
 {
-    char *wr;                                       // write pointer
-    uint8_t in_comment = false;
-
-    if (strlen(str) > size) {
-        return (STAT_INPUT_EXCEEDS_MAX_LENGTH);
-    }
-    for (wr = str; *str != NUL; str++) {
-        if (!in_comment) {                          // normal processing
-            if (*str == '(') in_comment = true;
-            if ((*str <= ' ') || (*str == DEL)) continue; // toss ctrls, WS & DEL
-            *wr++ = tolower(*str);
-        } else {                                    // Gcode comment processing
-            if (*str == ')') in_comment = false;
-            *wr++ = *str;
-        }
+    while ((*jp->rd != NUL) && ((*jp->rd <= ' ') || (*jp->rd == DEL))) {
+        jp->rd++;
     }
-    *wr = NUL;
-    return (STAT_OK);
+    return (*jp->rd);
 }
 
-/*
- * _get_nv_pair() - get the next name-value pair w/relaxed JSON rules. Also parses strict JSON.
- *
- *  Parse the next statement and populate the command object (nvObj).
- *
- *  Leaves string pointer (str) on the first character following the object.
- *  Which is the character just past the ',' separator if it's a multi-valued
- *  object or the terminating NUL if single object or the last in a multi.
- *
- *  Keeps track of tree depth and closing braces as much as it has to.
- *  If this were to be extended to track multiple parents or more than two
- *  levels deep it would have to track closing curlies - which it does not.
- *
- *  ASSUMES INPUT STRING HAS FIRST BEEN NORMALIZED BY _normalize_json_string()
- *
- *  If a group prefix is passed in it will be pre-pended to any name parsed
- *  to form a token string. For example, if "x" is provided as a group and
- *  "fr" is found in the name string the parser will search for "xfr" in the
- *  cfgArray.
- */
-/*  RELAXED RULES
- *
- *  Quotes are accepted but not needed on names
- *  Quotes are required for string values
- *
- *  See build 406.xx or earlier for strict JSON parser - deleted in 407.03
- */
-
-static stat_t _get_nv_pair(nvObj_t *nv, char **pstr, int8_t *depth)
+static stat_t _json_parse_name(jsonParser_t *jp, nvObj_t *nv)
 {
-    uint8_t i;
-    char *tmp;
-    char leaders[] = {"{,\""};      // open curly, quote and leading comma
-    char separators[] = {":\""};    // colon and quote
-    char terminators[] = {"},\""};  // close curly, comma and quote
-    char value[] = {"{\".-+"};      // open curly, quote, period, minus and plus
-
-    nv_reset_nv(nv);                // wipes the object and sets the depth
-
-    // --- Process name part ---
-    // Find, terminate and set pointers for the name. Allow for leading and trailing name quotes.
-    char * name = *pstr;
-    for (i=0; true; i++, (*pstr)++) {
-        if (strchr(leaders, (int)**pstr) == NULL) {     // find leading character of name
-            name = (*pstr)++;
+    bool quoted = (_json_skip_ws(jp) == '\"');
+    if (quoted) {
+        jp->rd++;
+    }
+    uint8_t length = 0;
+    while (true) {
+        char c = *jp->rd;
+        if ((c == ':') || (c == '\"') || (c == NUL)) {
             break;
         }
-        if (i == MAX_PAD_CHARS) {
-            return (STAT_JSON_SYNTAX_ERROR);
+        jp->rd++;
+        if ((c <= ' ') || (c == DEL)) {
+            continue;
+        }
+        if (length == TOKEN_LEN) {
+            return (STAT_INPUT_EXCEEDS_MAX_LENGTH);
         }
+        nv->token[length++] = tolower(c);
     }
+    nv->token[length] = NUL;
 
-    // Find the end of name, NUL terminate and copy token
-    for (i=0; true; i++, (*pstr)++) {
-        if (strchr(separators, (int)**pstr) != NULL) {
-            *(*pstr)++ = NUL;
-            strncpy(nv->token, name, TOKEN_LEN+1);      // copy the string to the token
-            break;
-        }
-        if (i == TOKEN_LEN) {
-            return (STAT_INPUT_EXCEEDS_MAX_LENGTH);
+    if (quoted) {
+        if (*jp->rd != '\"') {
+            return (STAT_JSON_SYNTAX_ERROR);
         }
+        jp->rd++;
+    }
+    if ((length == 0) || (_json_skip_ws(jp) != ':')) {
+        return (STAT_JSON_SYNTAX_ERROR);
     }
+    jp->rd++;
+    return (STAT_OK);
+}
 
-    // --- Process value part ---  (organized from most to least frequently encountered)
+static stat_t _json_parse_string(jsonParser_t *jp, nvObj_t *nv)
+{
+    char *start = ++jp->rd;                         // skip the opening quote
+    char *wr = start;                               // write pointer trails the read pointer
+    bool in_comment = false;
+    bool verbatim = (nv->index != NO_MATCH) && (cfgArray[nv->index].flags & F_VERBATIM);
 
-    // Find the start of the value part
-    for (i=0; true; i++, (*pstr)++) {
-        if (isalnum((int)**pstr)) break;
-        if (strchr(value, (int)**pstr) != NULL) break;
-        if (i == MAX_PAD_CHARS) {
-            return (STAT_JSON_SYNTAX_ERROR);
+    while (true) {
+        char c = *jp->rd++;
+        if (c == NUL) {
+            return (STAT_JSON_SYNTAX_ERROR);        // unterminated string
+        }
+        if (c == '\"') {
+            break;
+        }
+        if (c == '\\') {
+            if ((*jp->rd != '\"') && (*jp->rd != '\\') && (*jp->rd != '/')) {
+                return (STAT_JSON_SYNTAX_ERROR);    // only the escapes that can appear in a command
+            }
+            *wr++ = *jp->rd++;
+            continue;
+        }
+        if (verbatim) {                             // e.g. file names - case and spaces matter
+            *wr++ = c;
+            continue;
+        }
+        if (in_comment) {                           // Gcode comments keep their case and spacing
+            if (c == ')') {
+                in_comment = false;
+            }
+            *wr++ = c;
+            continue;
+        }
+        if (c == '(') {
+            in_comment = true;
+        }
+        if ((c <= ' ') || (c == DEL)) {
+            continue;
         }
+        *wr++ = tolower(c);
     }
+    *wr = NUL;
 
-    // nulls (gets)
-    if ((**pstr == 'n') || ((**pstr == '\"') && (*(*pstr+1) == '\"'))) { // process null value
+    if (*start == NUL) {                            // "" is the same as null - a GET
         nv->valuetype = TYPE_NULL;
         nv->value_int = TYPE_NULL;
+    } else if ((start[0] == '0') && (start[1] == 'x') && (start[2] != NUL)) { // 0x... might be data
+        uint32_t *v = (uint32_t*)&nv->value_flt;
+        *v = strtoul(start, 0L, 0);
+        nv->valuetype = TYPE_DATA;
+    } else {
+        nv->valuetype = TYPE_STRING;
+        nv->stringp = (char (*)[])start;
+    }
+    return (STAT_OK);
+}
 
-    // numbers
-    } else if (isdigit(**pstr) || (**pstr == '-')) {    // value is a number
-        nv->value_int = atol(*pstr);                    // get the number as an integer
-        nv->value_flt = (float)strtod(*pstr, &tmp);     // get the number as a float - tmp is the end pointer
+static stat_t _json_parse_value(jsonParser_t *jp, nvObj_t *nv, int8_t depth)
+{
+    char c = _json_skip_ws(jp);
 
-        if ((tmp == *pstr) ||                           // if start pointer equals end the conversion failed
-            (strchr(terminators, *tmp) == NULL)) {      // terminators are the only legal chars at the end of a number
-            nv->valuetype = TYPE_NULL;                  // report back an error
+    // numbers
+    if (isdigit(c) || (c == '-')) {
+        char *tmp;
+        nv->value_int = atol(jp->rd);               // get the number as an integer
+        nv->value_flt = (float)strtod(jp->rd, &tmp);// get the number as a float - tmp is the end pointer
+        if (tmp == jp->rd) {                        // if start pointer equals end the conversion failed
+            return (STAT_BAD_NUMBER_FORMAT);
+        }
+        jp->rd = tmp;
+        c = _json_skip_ws(jp);
+        if ((c != ',') && (c != '}')) {             // terminators are the only legal chars after a number
             return (STAT_BAD_NUMBER_FORMAT);
         }
         nv->valuetype = TYPE_FLOAT;
-
-    // object parent
-    } else if (**pstr == '{') {
-        nv->valuetype = TYPE_PARENT;
-//        *depth += 1;                                  // nv_reset_nv() sets the next object's level so this is redundant
-        (*pstr)++;
-        return(STAT_EAGAIN);                            // signal that there is more to parse
+        return (STAT_OK);
+    }
 
     // strings
-    } else if (**pstr == '\"') {                        // value is a string
-        (*pstr)++;
-        nv->valuetype = TYPE_STRING;
-        if ((tmp = strchr(*pstr, '\"')) == NULL) {
-            return (STAT_JSON_SYNTAX_ERROR);            // find the end of the string
-        }
-        *tmp = NUL;
-
-        // if string begins with 0x it might be data, needs to be at least 3 chars long
-        if( strlen(*pstr)>=3 && (*pstr)[0]=='0' && (*pstr)[1]=='x')
-        {
-            uint32_t *v = (uint32_t*)&nv->value_flt;
-            *v = strtoul((const char *)*pstr, 0L, 0);
-            nv->valuetype = TYPE_DATA;
-        } else {
-            ritorno(nv_copy_string(nv, *pstr));
-        }
-        *pstr = ++tmp;
+    if (c == '\"') {
+        return (_json_parse_string(jp, nv));
+    }
 
-    // boolean true/false
-    } else if (**pstr == 't') {
-        nv->valuetype = TYPE_BOOLEAN;
-        nv->value_int = true;
-    } else if (**pstr == 'f') {
-        nv->valuetype = TYPE_BOOLEAN;
-        nv->value_int = false;
+    // object parent - the children follow this nv in the list
+    if (c == '{') {
+        nv->valuetype = TYPE_PARENT;
+        const char *group = nv->group;
+        if ((nv_index_is_group(nv->index)) && (nv_group_is_prefixed(nv->token))) {
+            group = nv->token;                      // children are looked up in this group
+        }
+        return (_json_parse_object(jp, group, depth+1));
+    }
 
     // arrays
-    } else if (**pstr == '[') {
+    if (c == '[') {
         nv->valuetype = TYPE_ARRAY;
-        ritorno(nv_copy_string(nv, *pstr));     // copy array into string for error displays
-        return (STAT_VALUE_TYPE_ERROR);         // return error as the parser doesn't do input arrays yet
+        return (STAT_VALUE_TYPE_ERROR);             // return error as the parser doesn't do input arrays yet
+    }
 
-    // general error condition
-    } else {
-        return (STAT_JSON_SYNTAX_ERROR);        // ill-formed JSON
+    // null, true, false
+    char *word = jp->rd;
+    while (isalpha(*jp->rd)) {
+        jp->rd++;
     }
+    switch (tolower(*word)) {
+        case 'n': { nv->valuetype = TYPE_NULL; nv->value_int = TYPE_NULL; return (STAT_OK); }
+        case 't': { nv->valuetype = TYPE_BOOLEAN; nv->value_int = true; return (STAT_OK); }
+        case 'f': { nv->valuetype = TYPE_BOOLEAN; nv->value_int = false; return (STAT_OK); }
+    }
+    return (STAT_JSON_SYNTAX_ERROR);                // ill-formed JSON
+}
 
-    // process comma separators and end curlies
-    if ((*pstr = strpbrk(*pstr, terminators)) == NULL) { // advance to terminator or err out
+static stat_t _json_parse_object(jsonParser_t *jp, const char *group, int8_t depth)
+{
+    if (_json_skip_ws(jp) != '{') {
         return (STAT_JSON_SYNTAX_ERROR);
     }
-    if (**pstr == '}') {
-        *depth -= 1;                            // pop up a nesting level
-        (*pstr)++;                              // advance to comma or whatever follows
+    if ((depth - jp->top_depth) >= JSON_MAX_DEPTH) {
+        return (STAT_MAX_DEPTH_EXCEEDED);
+    }
+    jp->rd++;
+    if (_json_skip_ws(jp) == '}') {                 // empty object
+        jp->rd++;
+        return (STAT_OK);
+    }
+
+    while (true) {
+        nvObj_t *nv = jp->nv;
+        if ((nv->nx == NULL) || (++jp->pairs == NV_BODY_LEN)) {
+            return (STAT_JSON_TOO_MANY_PAIRS);      // the last nv in the list must stay empty
+        }
+        nv_reset_nv(nv);
+        nv->depth = depth;
+        jp->last = nv;
+        ritorno(_json_parse_name(jp, nv));
+        strncpy(nv->group, group, GROUP_LEN);
+        nv->group[GROUP_LEN] = NUL;
+        if ((nv->index = nv_get_index(nv->group, nv->token)) == NO_MATCH) {
+            return (STAT_UNRECOGNIZED_NAME);        // validate the token and get the index
+        }
+        jp->nv = nv->nx;                            // claim the nv before any children do
+        ritorno(_json_parse_value(jp, nv, depth));
+        nv_coerce_types(nv);                        // adjust types based on type fields in configApp table
+
+        char c = _json_skip_ws(jp);
+        jp->rd++;
+        if (c == '}') {
+            return (STAT_OK);
+        }
+        if (c != ',') {
+            return (STAT_JSON_SYNTAX_ERROR);
+        }
     }
-    if (**pstr == ',') {
-        return (STAT_EAGAIN);                   // signal that there is more to parse
+}
+
+/*
+ * _json_serialize_scalar() - write a null, number, boolean or data value. Returns the length.
+ */
+static uint8_t _json_serialize_scalar(nvObj_t *nv, char *str)
+{
+    switch (nv->valuetype)  {
+        case (TYPE_NULL):   {   strcpy(str, "null");
+                                return (4);
+                            }
+        case (TYPE_FLOAT):  {   convert_outgoing_float(nv);
+                                return (floattoa(str, nv->value_flt, nv->precision));
+                            }
+        case (TYPE_INTEGER):{   return (inttoa(str, (int)nv->value_int));
+                            }
+        case (TYPE_BOOLEAN):{   if (nv->value_int) {
+                                    strcpy(str, "true");
+                                    return (4);
+                                }
+                                strcpy(str, "false");
+                                return (5);
+                            }
+        case (TYPE_DATA):   {   uint32_t *v = (uint32_t*)&nv->value_flt;
+                                strcpy(str, "\"0x");
+                                uint8_t length = 3 + hextoa(str+3, *v);
+                                strcpy(str+length, "\"");
+                                return (length+1);
+                            }
+        default:            {   return (0);
+                            }
     }
-    (*pstr)++;
-    return (STAT_OK);                           // signal that parsing is complete
 }
 
 /****************************************************************************
@@ -403,7 +460,7 @@ static stat_t _get_nv_pair(nvObj_t *nv, char **pstr, int8_t *depth)
  *    - If a JSON object is empty omit the object altogether (no curlies)
  */
 
-uint16_t json_serialize(nvObj_t *nv, char *out_buf, uint16_t size)
+int16_t json_serialize(nvObj_t *nv, char *out_buf, uint16_t size)
 {
     char *str = out_buf;
     char *str_max = out_buf + size;
@@ -423,51 +480,25 @@ uint16_t json_serialize(nvObj_t *nv, char *out_buf, uint16_t size)
 
             switch (nv->valuetype)  {
                 case (TYPE_EMPTY):  {   break; }
-                case (TYPE_NULL):   {   strcpy(str, "null");
-                                        str += 4;
-                                        break;
-                                    }
                 case (TYPE_PARENT): {   *str++ = '{';
                                         need_a_comma = false;
                                         break;
                                     }
-                case (TYPE_FLOAT):  {   convert_outgoing_float(nv);
-                                        str += floattoa(str, nv->value_flt, nv->precision);
-                                        break;
-                                    }
-//                case (TYPE_INT):    {   // str += inttoa(str, (int)nv->value); // doesn't handle negative numbers
-//                                        str += sprintf(str, "%d", (int)nv->value);
-//                                        break;
-//                                    }
-                case (TYPE_INTEGER):{   str += sprintf(str, "%d", (int)nv->value_int);
-                                        break;
-                                    }
                 case (TYPE_STRING): {   *str++ = '"';
                                         strcpy(str, *nv->stringp);
                                         str += strlen(*nv->stringp);
                                         *str++ = '"';
                                         break;
                                     }
-                case (TYPE_BOOLEAN):{   if (nv->value_int) {
-                                            strcpy(str, "false");
-                                            str += 5;
-                                        } else {
-                                            strcpy(str, "true");
-                                            str += 4;
-                                        }
-                                        break;
-                                    }
-                case (TYPE_DATA):   {   uint32_t *v = (uint32_t*)&nv->value_flt;
-                                        str += sprintf(str, "\"0x%lx\"", *v);
-                                        break;
-                                    }
                 case (TYPE_ARRAY):  {   strcpy(str++, "[");
                                         strcpy(str, *nv->stringp);
                                         str += strlen(*nv->stringp);
                                         strcpy(str++, "]");
                                         break;
                                     }
-                default: {}
+                default:            {   str += _json_serialize_scalar(nv, str);
+                                        break;
+                                    }
             }
         }
         if (str >= str_max) { return (-1);}     // signal buffer overrun
@@ -504,6 +535,20 @@ void json_print_object(nvObj_t *nv)
     xio_writeline(cs.out_buf);
 }
 
+/*
+ * json_print_status_report() - serialize and print the nvObj array as a status report
+ *
+ *  Same as json_print_object(), but the output goes to the status report slot of each
+ *  device. A report that has not been sent yet is replaced by the newer one, so a slow
+ *  host sees fresh data instead of a backlog. See xio_write_status_report().
+ */
+void json_print_status_report(nvObj_t *nv)
+{
+    if (json_serialize(nv, cs.out_buf, sizeof(cs.out_buf)) >= 0) {
+        xio_write_status_report(cs.out_buf);
+    }
+}
+
 /*
  * json_print_list() - command to select and produce a JSON formatted output
  */
@@ -513,6 +558,7 @@ void json_print_list(stat_t status, uint8_t flags)
     switch (flags) {
         case JSON_NO_PRINT: break;
         case JSON_OBJECT_FORMAT: { json_print_object(nv_body); break; }
+        case JSON_STATUS_REPORT_FORMAT: { json_print_status_report(nv_body); break; }
         case JSON_RESPONSE_FORMAT:
         case JSON_RESPONSE_TO_MUTED_FORMAT:
             { json_print_response(status, flags == JSON_RESPONSE_TO_MUTED_FORMAT); break; }
@@ -538,18 +584,40 @@ void json_print_list(stat_t status, uint8_t flags)
  *  on all the (non-silent) responses.
  */
 
-void json_print_response(uint8_t status, const bool only_to_muted /*= false*/)
+static bool _json_response_enabled(stat_t status)
 {
     if ((js.json_verbosity == JV_SILENT) || (cs.responses_suppressed)) {                   // silent means no responses
-        return;
+        return (false);
     }
     if (js.json_verbosity == JV_EXCEPTIONS)    {            // cutout for JV_EXCEPTIONS mode
         if (status == STAT_OK) {
             if (cm->machine_state != MACHINE_INITIALIZING) { // always do full echo during startup
-                return;
+                return (false);
             }
         }
     }
+    return (true);
+}
+
+// COMMENT APPLIES TO ARM ONLY - for now
+// in xio.cpp:xio.readline the CR || LF read from the host is not appended to the string.
+// to ensure that the correct number of bytes are reported back to the host we add a +1 to
+// cs.linelen so that the number of bytes received matches the number of bytes reported
+
+static void _json_footer_string(char *str, stat_t status)
+{
+    strcpy(str, "1,"); str += 2;                            // '1' is the footer revision hard coded
+    str += inttoa(str, status);                             // nb: inttoa() works differently than itoa(). See util.cpp
+    strcpy(str++, ",");
+    str += inttoa(str, cs.linelen+1);
+    cs.linelen = 0;                                         // reset linelen so it's only reported once
+}
+
+void json_print_response(uint8_t status, const bool only_to_muted /*= false*/)
+{
+    if (!_json_response_enabled(status)) {
+        return;
+    }
 
     // Body processing
     nvObj_t *nv = nv_body;
@@ -596,20 +664,8 @@ void json_print_response(uint8_t status, const bool only_to_muted /*= false*/)
         }
     }
 
-    // COMMENT APPLIES TO ARM ONLY - for now
-    // in xio.cpp:xio.readline the CR || LF read from the host is not appended to the string.
-    // to ensure that the correct number of bytes are reported back to the host we add a +1 to
-    // cs.linelen so that the number of bytes received matches the number of bytes reported
-
     char footer_string[NV_FOOTER_LEN];
-    char *str = footer_string;
-
-    strcpy(str, "1,"); str += 2;                            // '1' is the footer revision hard coded
-    str += inttoa(str, status);                             // nb: inttoa() works differently than itoa(). See util.cpp
-    strcpy(str++, ",");
-    str += inttoa(str, cs.linelen+1);
-    cs.linelen = 0;                                            // reset linelen so it's only reported once
-
+    _json_footer_string(footer_string, status);
     nv_copy_string(nv, footer_string);                      // link string to nv object
     nv->depth = 0;                                          // footer 'f' is a peer to response 'r' (hard wired to 0)
     nv->valuetype = TYPE_ARRAY;                             // declare it as an array
@@ -622,6 +678,118 @@ void json_print_response(uint8_t status, const bool only_to_muted /*= false*/)
     }
 }
 
+/*
+ * json_stream_begin()  - start a response for a parent whose children will be streamed
+ * json_stream_object() - serialize one child of the parent and queue it for output
+ * json_stream_end()    - close the parent, add the footer and send what is left
+ *
+ *  Used for group and status report GETs. Children are serialized one at a time into a
+ *  JSON_STREAM_CHUNK_LEN buffer that is written to xio whenever it fills, so RAM use is
+ *  bounded and a parent can have any number of children - there is no NV_BODY_LEN limit.
+ *  The output is the same response json_print_response() makes from a materialized list:
+ *
+ *    {"r":{"x":{"am":1,"vm":16000, ... }},"f":[1,0,8]}
+ *
+ *  Verbosity is observed as for any other response with STAT_OK.
+ */
+
+static struct jsonStream {
+    bool enabled;                                   // false if verbosity settings suppress the response
+    bool need_a_comma;
+    uint16_t length;                                // characters waiting in buf
+    char buf[JSON_STREAM_CHUNK_LEN];
+} jstream;
+
+static void _json_stream_flush()
+{
+    if (jstream.length > 0) {
+        xio_write(jstream.buf, jstream.length);
+        jstream.length = 0;
+    }
+}
+
+static void _json_stream_put(const char *str, uint16_t length)
+{
+    while (length > 0) {
+        if (jstream.length == JSON_STREAM_CHUNK_LEN) {
+            _json_stream_flush();
+        }
+        uint16_t room = JSON_STREAM_CHUNK_LEN - jstream.length;
+        uint16_t count = (length < room) ? length : room;
+        memcpy(&jstream.buf[jstream.length], str, count);
+        jstream.length += count;
+        str += count;
+        length -= count;
+    }
+}
+
+static void _json_stream_key(const char *token)
+{
+    if (jstream.need_a_comma) {
+        _json_stream_put(",", 1);
+    }
+    jstream.need_a_comma = true;
+    _json_stream_put("\"", 1);
+    _json_stream_put(token, strlen(token));
+    _json_stream_put("\":", 2);
+}
+
+void json_stream_begin(nvObj_t *parent)
+{
+    jstream.enabled = _json_response_enabled(STAT_OK);
+    if (!jstream.enabled) {
+        return;
+    }
+    jstream.length = 0;
+    jstream.need_a_comma = false;
+    _json_stream_put("{\"r\":", 5);
+    _json_stream_put("{", 1);
+    _json_stream_key(parent->token);
+    _json_stream_put("{", 1);
+    jstream.need_a_comma = false;
+}
+
+void json_stream_object(nvObj_t *nv)
+{
+    if ((!jstream.enabled) || (nv->valuetype == TYPE_EMPTY) || (nv->valuetype == TYPE_SKIP)) {
+        return;
+    }
+    _json_stream_key(nv->token);
+    switch (nv->valuetype) {
+        case (TYPE_STRING): {   _json_stream_put("\"", 1);
+                                _json_stream_put(*nv->stringp, strlen(*nv->stringp));
+                                _json_stream_put("\"", 1);
+                                break;
+                            }
+        case (TYPE_ARRAY):  {   _json_stream_put("[", 1);
+                                _json_stream_put(*nv->stringp, strlen(*nv->stringp));
+                                _json_stream_put("]", 1);
+                                break;
+                            }
+        case (TYPE_PARENT): {   _json_stream_put("{}", 2);    // groups don't have groups
+                                break;
+                            }
+        default:            {   char value[24];
+                                _json_stream_put(value, _json_serialize_scalar(nv, value));
+                                break;
+                            }
+    }
+}
+
+void json_stream_end(stat_t status)
+{
+    if (!jstream.enabled) {
+        return;
+    }
+    char footer_string[NV_FOOTER_LEN];
+    _json_footer_string(footer_string, status);
+    _json_stream_put("}},\"f\":[", 8);
+    _json_stream_put(footer_string, strlen(footer_string));
+    _json_stream_put("]}\n", 3);
+    _json_stream_flush();
+    jstream.enabled = false;
+}
+
 /***********************************************************************************
  * CONFIGURATION AND INTERFACE FUNCTIONS
  * Functions to get and set variables from the cfgArray table
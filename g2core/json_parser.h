@@ -40,6 +40,8 @@
 #define JSON_INPUT_STRING_MAX 512   // set an arbitrary max
 #define JSON_OUTPUT_STRING_MAX (OUTPUT_BUFFER_LEN)
 #define MAX_PAD_CHARS 8             // JSON whitespace padding allowable
+#define JSON_MAX_DEPTH 8            // maximum nesting of JSON input objects
+#define JSON_STREAM_CHUNK_LEN 128   // output is written in pieces of this size by json_stream_object()
 
 typedef enum {
     JV_SILENT = 0,                  // [0] no response is provided for any command
@@ -58,7 +60,8 @@ typedef enum {                      // json output print modes
     JSON_NO_PRINT = 0,              // don't print anything if you find yourself in JSON mode
     JSON_OBJECT_FORMAT,             // print just the body as a json object
     JSON_RESPONSE_FORMAT,           // print the header/body/footer as a response object
-    JSON_RESPONSE_TO_MUTED_FORMAT   // print the header/body/footer as a response object, only to muted channels
+    JSON_RESPONSE_TO_MUTED_FORMAT,  // print the header/body/footer as a response object, only to muted channels
+    JSON_STATUS_REPORT_FORMAT       // print just the body as a json object that supersedes any pending status report
 } jsonFormats;
 
 typedef struct jsSingleton {
@@ -84,10 +87,14 @@ extern jsSingleton_t js;
 
 stat_t json_parser(char *str, bool suppress_response = false);
 void json_parse_for_exec(char *str, bool execute);
-uint16_t json_serialize(nvObj_t *nv, char *out_buf, uint16_t size);
+int16_t json_serialize(nvObj_t *nv, char *out_buf, uint16_t size);
 void json_print_object(nvObj_t *nv);
+void json_print_status_report(nvObj_t *nv);
 void json_print_response(uint8_t status, const bool only_to_muted = false);
 void json_print_list(stat_t status, uint8_t flags);
+void json_stream_begin(nvObj_t *parent);
+void json_stream_object(nvObj_t *nv);
+void json_stream_end(stat_t status);
 
 stat_t js_get_ej(nvObj_t *nv);
 stat_t js_set_ej(nvObj_t *nv);
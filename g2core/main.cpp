@@ -37,6 +37,8 @@
 #include "gpio.h"
 #include "pwm.h"
 #include "xio.h"
+#include "telemetry.h"
+#include "scope.h"
 
 #include "util.h"
 #include "MotateUniqueID.h"
@@ -108,6 +110,8 @@ void application_init_machine(void)
 
     stepper_init();                     // stepper subsystem
     encoder_init();                     // virtual encoders
+    telemetry_init();                   // motion telemetry ring (config values come later)
+    scope_init();                       // motion capture buffer
     gpio_init();                        // inputs and outputs
     pwm_init();                         // pulse width modulation drivers
     canonical_machine_inits();          // combined inits for CMs and planner    
@@ -39,6 +39,7 @@
 #include "xio.h"                // for char definitions
 #include "temperature.h"        // for temperature controls
 #include "json_parser.h"
+#include "report.h"
 #include "planner.h"
 #include "stepper.h"            // for MOTOR_TIMEOUT_SECONDS_MIN/MOTOR_TIMEOUT_SECONDS_MAX
 #include "MotateTimers.h"       // for char definitions
@@ -173,33 +174,75 @@ stat_t marlin_start_tramming_bed() {
 
 /***********************************************************************************
  * marlin_list_sd_response()    - M20 called from gcode parser
+ * marlin_init_sd_response()    - M21 called from gcode parser
  * marlin_select_sd_response()  - M23 called from gcode parser
+ * marlin_start_sd_print()      - M24 called from gcode parser
+ * marlin_pause_sd_print()      - M25 called from gcode parser
+ * marlin_report_sd_status()    - M27 called from gcode parser
+ *
+ *  The "SD card" is whatever xio_storage the board registered. With no storage the
+ *  list is empty, every select fails and M21 says so.
  */
 
-stat_t marlin_list_sd_response()
+static void _list_sd_file(const char *name, int32_t size)
 {
-    char buffer[128];
-    char *str = buffer;
-
-    str_concat(str, "Begin file list\nEnd file list\n");
-    *str = 0;
+    char buffer[XIO_FILE_NAME_LEN + 16];
+    sprintf(buffer, "%s %ld\n", name, (long)size);
     xio_writeline(buffer);
+}
 
+stat_t marlin_list_sd_response()
+{
+    xio_writeline("Begin file list\n");
+    xio_list_job_files(_list_sd_file);
+    xio_writeline("End file list\n");
+    return (STAT_OK);
+}
+
+stat_t marlin_init_sd_response()
+{
+    xio_writeline(xio_has_storage() ? "SD card ok\n" : "SD init fail\n");
     return (STAT_OK);
 }
 
 stat_t marlin_select_sd_response(const char *file)
 {
     char buffer[128];
-    char *str = buffer;
+    int32_t position, size;
 
-    str_concat(str, "open failed, File: ");
-    strncpy(str, file, Motate::strlen(file));
-    str += Motate::strlen(file);
-    str_concat(str, "\n");
-    *str = 0;
+    if (xio_select_job_file(file)) {
+        xio_job_file_progress(position, size);
+        sprintf(buffer, "File opened: %.*s Size: %ld\nFile selected\n", XIO_FILE_NAME_LEN, file, (long)size);
+    } else {
+        sprintf(buffer, "open failed, File: %.*s\n", XIO_FILE_NAME_LEN, file);
+    }
     xio_writeline(buffer);
+    return (STAT_OK);
+}
 
+stat_t marlin_start_sd_print()
+{
+    xio_start_job_file();               // does nothing if no file was selected
+    return (STAT_OK);
+}
+
+stat_t marlin_pause_sd_print()
+{
+    xio_pause_job_file();
+    return (STAT_OK);
+}
+
+stat_t marlin_report_sd_status()
+{
+    char buffer[64];
+    int32_t position, size;
+
+    if (xio_job_file_progress(position, size)) {
+        sprintf(buffer, "SD printing byte %ld/%ld\n", (long)position, (long)size);
+    } else {
+        sprintf(buffer, "Not SD printing\n");
+    }
+    xio_writeline(buffer);
     return (STAT_OK);
 }
 
@@ -388,6 +431,32 @@ stat_t marlin_set_fan_speed(const uint8_t fan, float speed)
     return (STAT_OK);
 }
 
+/***********************************************************************************
+ * marlin_autotune_heater() - M303 called from gcode parser
+ * _marlin_start_autotune()
+ *
+ *  The autotune is started in sync with the moves around it. The results are reported
+ *  and written to the heater's P, I and D settings when it finishes.
+ */
+
+void _marlin_start_autotune(float* vect, bool* flag) {
+    stat_t status = cm_start_heater_autotune(vect[0], vect[1], vect[2]);
+    if (status != STAT_OK) {
+        rpt_exception(status, "M303 autotune could not be started");
+    }
+}
+
+stat_t marlin_autotune_heater(uint8_t tool, float temperature, uint8_t cycles)
+{
+    if ((tool < 1) || (tool > 3)) {
+        return STAT_INPUT_VALUE_RANGE_ERROR;
+    }
+    float value[AXES] = { (float)tool, temperature, (float)cycles };
+    bool flag[AXES] = { true, true, true };
+    mp_queue_command(_marlin_start_autotune, value, flag);
+    return (STAT_OK);
+}
+
 /***********************************************************************************
  * marlin_request_position_report() - M114 called from gcode parser
  */
@@ -46,7 +46,11 @@ extern MarlinStateExtended_t mst;       // Marlin state object
 stat_t marlin_start_tramming_bed();                             // G29
 
 stat_t marlin_list_sd_response();                               // M20
+stat_t marlin_init_sd_response();                               // M21
 stat_t marlin_select_sd_response(const char *file);             // M23
+stat_t marlin_start_sd_print();                                 // M24
+stat_t marlin_pause_sd_print();                                 // M25
+stat_t marlin_report_sd_status();                               // M27
 stat_t marlin_set_extruder_mode(const uint8_t mode);            // M82, M82
 stat_t marlin_disable_motors();                                 // M84
 stat_t marlin_set_motor_timeout(float s);                       // M84 Sxxx, M85 Sxxx, M18 Sxxx
@@ -54,6 +58,7 @@ stat_t marlin_set_motor_timeout(float s);                       // M84 Sxxx, M85
 stat_t marlin_set_temperature(uint8_t tool, float temperature, bool wait); // M104, M109, M140, M190
 stat_t marlin_request_temperature_report();                     // M105
 stat_t marlin_set_fan_speed(const uint8_t fan, float speed);    // M106, M107
+stat_t marlin_autotune_heater(uint8_t tool, float temperature, uint8_t cycles); // M303
 
 stat_t marlin_request_position_report();                        // M114
 stat_t marlin_report_version();                                 // M115
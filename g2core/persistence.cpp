@@ -27,8 +27,18 @@
 #include "g2core.h"
 #include "persistence.h"
 #include "canonical_machine.h"
+#include "controller.h"
+#include "planner.h"
 #include "report.h"
-//#include "util.h"
+#include "text_parser.h"
+#include "util.h"
+#include "xio.h"
+
+#include <stddef.h>     // for offsetof()
+
+#ifdef NVM_FILE
+#include <stdio.h>
+#endif
 
 /***********************************************************************************
  **** STRUCTURE ALLOCATIONS ********************************************************
@@ -40,39 +50,623 @@ nvmSingleton_t nvm;
  **** GENERIC STATIC FUNCTIONS AND VARIABLES ***************************************
  ***********************************************************************************/
 
+static uint32_t _record_address(uint8_t sector, uint16_t record)
+{
+    return ((uint32_t)sector * NVM_SECTOR_SIZE + sizeof(nvmHeader_t) + (uint32_t)record * sizeof(nvmRecord_t));
+}
+
+static uint16_t _record_crc(const nvmRecord_t *r)
+{
+    uint16_t crc = crc16(0xFFFF, &r->index, sizeof(r->index));
+    return (crc16(crc, &r->value, sizeof(r->value)));
+}
+
+static uint16_t _header_crc(const nvmHeader_t *h)
+{
+    return (crc16(0xFFFF, h, offsetof(nvmHeader_t, crc)));
+}
+
+static bool _is_float(index_t index)           // same test as _set_defa() uses for defaults
+{
+    return (!(cfgArray[index].flags & (TYPE_INTEGER | TYPE_BOOLEAN)));
+}
+
+/*
+ * _table_signature() - CRC of every cfgArray token and its flags
+ *
+ *  Records are keyed by index and hold raw bits, so adding, removing or re-typing a
+ *  table entry changes the meaning of the log. This catches all three.
+ */
+
+static uint16_t _table_signature()
+{
+    uint16_t crc = 0xFFFF;
+    for (index_t i=0; i<nv_index_max(); i++) {
+        crc = crc16(crc, cfgArray[i].token, strlen(cfgArray[i].token));
+        crc = crc16(crc, &cfgArray[i].flags, sizeof(cfgArray[i].flags));
+    }
+    return (crc);
+}
+
+/*
+ * _can_write() - NVM may only be programmed while no motion is running
+ */
+
+static bool _can_write()
+{
+    return ((cm->cycle_type == CYCLE_NONE) && !mp_get_runtime_busy());
+}
+
+/*
+ * _scan_sector() - rebuild nvm_slot[] and the write position from the active sector
+ */
+
+static void _scan_sector()
+{
+    nvmRecord_t r;
+
+    memset(nvm_slot, 0, nv_index_max() * sizeof(nvm_slot[0]));
+    for (nvm.next = 0; nvm.next < NVM_RECORDS; nvm.next++) {
+        nvm_device_read(_record_address(nvm.sector, nvm.next), &r, sizeof(r));
+        if ((r.index == NVM_ERASED_INDEX) && (r.crc == 0xFFFF) && (r.value == 0xFFFFFFFF)) {
+            break;                                  // end of the log
+        }
+        if ((r.crc == _record_crc(&r)) && (r.index < nv_index_max())) {
+            nvm_slot[r.index] = nvm.next + 1;       // later records supersede earlier ones
+        }                                           // a bad record is skipped, but takes up its space
+    }
+}
+
+/*
+ * _start_sector() - erase the next sector and write the records of the live indexes to it
+ *
+ *  With copy false the new sector starts empty (a reset). Values waiting in the queue are
+ *  not copied - they are written right after. The header is written last, so the new
+ *  sector only becomes the active one once it is complete.
+ */
+
+static bool _is_queued(index_t index)
+{
+    for (uint8_t i=0; i<nvm.pending; i++) {
+        if (nvm.queue[i].index == index) {
+            return (true);
+        }
+    }
+    return (false);
+}
+
+static stat_t _copy_live_records(uint8_t sector, bool copy, uint16_t *next)
+{
+    for (index_t i=0; i<nv_index_max(); i++) {
+        if ((nvm_slot[i] == 0) || !copy || _is_queued(i)) {
+            nvm_slot[i] = 0;
+            continue;
+        }
+        if (*next == NVM_RECORDS) {                 // the settings don't fit in a sector
+            return (STAT_PERSISTENCE_ERROR);
+        }
+        nvmRecord_t r;
+        nvm_device_read(_record_address(nvm.sector, nvm_slot[i] - 1), &r, sizeof(r));
+        ritorno(nvm_device_program(_record_address(sector, *next), &r, sizeof(r)));
+        nvm_slot[i] = ++(*next);
+    }
+    return (STAT_OK);
+}
+
+static stat_t _start_sector(bool copy)
+{
+    uint8_t sector = (nvm.sector + 1) % NVM_SECTORS;
+    uint16_t next = 0;
+
+    nvmHeader_t h;
+    h.magic = NVM_MAGIC;
+    h.sequence = nvm.sequence + 1;
+    h.signature = nvm.signature;
+    h.crc = _header_crc(&h);
+    h.reserved = 0xFFFFFFFF;
+
+    stat_t status = nvm_device_erase(sector);
+    if (status == STAT_OK) {
+        status = _copy_live_records(sector, copy, &next);
+    }
+    if (status == STAT_OK) {
+        status = nvm_device_program((uint32_t)sector * NVM_SECTOR_SIZE, &h, sizeof(h));
+    }
+    if (status != STAT_OK) {
+        if (nvm.loaded) {
+            _scan_sector();                         // the old sector is still intact
+        }
+        return (status);
+    }
+
+    nvm.sector = sector;
+    nvm.sequence = h.sequence;
+    nvm.next = next;
+    nvm.loaded = true;
+    if (copy) {
+        nvm.compactions++;
+    }
+    return (STAT_OK);
+}
+
+/*
+ * _flush() - append the queued writes to the log, compacting first if they don't fit
+ */
+
+static stat_t _flush()
+{
+    if (nvm.pending == 0) {
+        return (STAT_OK);
+    }
+    if (!nvm.loaded) {                              // no log yet - start one
+        ritorno(_start_sector(false));
+    }
+    if ((nvm.next + nvm.pending) > NVM_RECORDS) {
+        ritorno(_start_sector(true));
+        if ((nvm.next + nvm.pending) > NVM_RECORDS) {
+            return (STAT_PERSISTENCE_ERROR);
+        }
+    }
+    for (uint8_t i=0; i<nvm.pending; i++) {
+        nvmRecord_t *r = &nvm.queue[i];
+        r->crc = _record_crc(r);
+        ritorno(nvm_device_program(_record_address(nvm.sector, nvm.next), r, sizeof(nvmRecord_t)));
+        nvm_slot[r->index] = ++nvm.next;
+    }
+    nvm.pending = 0;
+    return (STAT_OK);
+}
+
+/*
+ * _stored_value() - latest value of index, from the queue or the log. False if none.
+ */
+
+static bool _stored_value(index_t index, uint32_t *value)
+{
+    for (uint8_t i=0; i<nvm.pending; i++) {
+        if (nvm.queue[i].index == index) {
+            *value = nvm.queue[i].value;
+            return (true);
+        }
+    }
+    if (nvm_slot[index] == 0) {
+        return (false);
+    }
+    nvmRecord_t r;
+    nvm_device_read(_record_address(nvm.sector, nvm_slot[index] - 1), &r, sizeof(r));
+    *value = r.value;
+    return (true);
+}
 
 /***********************************************************************************
  **** CODE *************************************************************************
  ***********************************************************************************/
 
+/*
+ * persistence_init() - open the NVM device and find the active sector of the log
+ */
+
 void persistence_init()
 {
-    return;
+    memset(&nvm, 0, sizeof(nvm));
+    nvm.signature = _table_signature();
+    if (nvm_device_open() != STAT_OK) {
+        return;                                     // no NVM - settings come from defaults
+    }
+    nvm.ready = true;
+    nvm.sector = NVM_SECTORS - 1;                   // so the first log starts in sector 0
+
+    nvmHeader_t h;
+    bool found = false;
+    for (uint8_t sector=0; sector<NVM_SECTORS; sector++) {
+        nvm_device_read((uint32_t)sector * NVM_SECTOR_SIZE, &h, sizeof(h));
+        if ((h.magic != NVM_MAGIC) || (h.crc != _header_crc(&h))) {
+            continue;
+        }
+        if (!found || (h.sequence > nvm.sequence)) {
+            found = true;
+            nvm.sector = sector;                    // a log from another table isn't loaded, but
+            nvm.sequence = h.sequence;              // the next log still starts after it
+            nvm.loaded = (h.signature == nvm.signature);
+        }
+    }
+    if (nvm.loaded) {
+        _scan_sector();
+    }
+}
+
+/*
+ * persistence_is_loaded() - true if there are persisted values to load at boot
+ */
+
+bool persistence_is_loaded()
+{
+    return (nvm.ready && nvm.loaded);
 }
 
 /*
- * read_persistent_value()	- return value (as float) by index
+ * persistence_reset() - start a new, empty log. Used when all settings are reset to defaults.
+ */
+
+stat_t persistence_reset()
+{
+    if (!nvm.ready) {
+        return (STAT_OK);
+    }
+    nvm.pending = 0;
+    memset(nvm_slot, 0, nv_index_max() * sizeof(nvm_slot[0]));
+    if (!_can_write()) {
+        nvm.loaded = false;                         // the next flush starts the new log
+        return (STAT_OK);
+    }
+    return (_start_sector(false));
+}
+
+/*
+ * persistence_callback() - write queued values once the machine is out of its cycle
+ */
+
+stat_t persistence_callback()
+{
+    if ((nvm.pending == 0) || !_can_write()) {
+        return (STAT_OK);
+    }
+    stat_t status = _flush();
+    if (status != STAT_OK) {
+        nvm.pending = 0;                            // don't retry a write the log can't take
+        rpt_exception(status, "persistence_callback() could not write settings");
+    }
+    return (STAT_OK);
+}
+
+/*
+ * read_persistent_value()	- load nv->value_int or value_flt with the latest persisted value
  *
- *	It's the responsibility of the caller to make sure the index does not exceed range
+ *	It's the responsibility of the caller to make sure the index does not exceed range.
+ *  Returns STAT_NOOP if there is no persisted value for the index.
  */
 
 stat_t read_persistent_value(nvObj_t *nv)
 {
-    nv->value_flt = 0;
+    uint32_t value;
+    if (!nvm.ready || !_stored_value(nv->index, &value)) {
+        return (STAT_NOOP);
+    }
+    if (_is_float(nv->index)) {
+        memcpy(&nv->value_flt, &value, sizeof(value));
+    } else {
+        nv->value_int = (int32_t)value;
+    }
     return (STAT_OK);
 }
 
 /*
- * write_persistent_value() - write to NVM by index, but only if the value has changed
+ * write_persistent_value() - queue a write to NVM by index, but only if the value has changed
  *
  *	It's the responsibility of the caller to make sure the index does not exceed range
  *	Note: Removed NAN and INF checks on floats - not needed
+ *
+ *  A full queue is flushed now if no motion is running. Otherwise the write is refused -
+ *  it takes more than NVM_WRITE_QUEUE_LEN changed settings in a single cycle to get there.
  */
 
 stat_t write_persistent_value(nvObj_t *nv)
 {
-//    if (cm->cycle_state != CYCLE_OFF) { // can't write when machine is moving
-//        return(rpt_exception(STAT_FILE_NOT_OPEN, "write_persistent_value() can't write when machine is in cycle"));
-//    }
+    if (!nvm.ready) {
+        return (STAT_OK);
+    }
+    uint32_t value;
+    if (_is_float(nv->index)) {
+        memcpy(&value, &nv->value_flt, sizeof(value));
+    } else {
+        value = (uint32_t)nv->value_int;
+    }
+    uint32_t stored;
+    if (_stored_value(nv->index, &stored) && (stored == value)) {
+        return (STAT_OK);
+    }
+    for (uint8_t i=0; i<nvm.pending; i++) {         // a queued value is replaced
+        if (nvm.queue[i].index == nv->index) {
+            nvm.queue[i].value = value;
+            return (STAT_OK);
+        }
+    }
+    if (nvm.pending == NVM_WRITE_QUEUE_LEN) {
+        if (!_can_write()) {
+            return(rpt_exception(STAT_PERSISTENCE_ERROR, "write_persistent_value() can't write when machine is in cycle"));
+        }
+        ritorno(_flush());
+    }
+    nvm.queue[nvm.pending].index = nv->index;
+    nvm.queue[nvm.pending].value = value;
+    nvm.pending++;
     return (STAT_OK);
 }
+
+/***********************************************************************************
+ * CONFIG SNAPSHOTS
+ ***********************************************************************************/
+
+// read-only values are flagged F_PERSIST in places (pid1p...), but could never be restored
+static bool _is_persisted(index_t index)
+{
+    return (nv_index_is_single(index) && (cfgArray[index].flags & F_PERSIST) && (cfgArray[index].set != set_ro));
+}
+
+static uint16_t _persisted_count()
+{
+    uint16_t count = 0;
+    for (index_t i=0; nv_index_is_single(i); i++) {
+        if (_is_persisted(i)) {
+            count++;
+        }
+    }
+    return (count);
+}
+
+typedef struct nvmSnapshotChunk {           // a chunk as sent, less the unused values
+    nvmSnapshotHeader_t h;
+    uint32_t values[NVM_SNAPSHOT_CHUNK];
+} nvmSnapshotChunk_t;
+
+static uint16_t _chunk_length(const nvmSnapshotChunk_t *c)
+{
+    return (sizeof(nvmSnapshotHeader_t) + c->h.count * sizeof(uint32_t));
+}
+
+static uint16_t _snapshot_crc(const nvmSnapshotChunk_t *c)
+{
+    uint16_t crc = crc16(0xFFFF, &c->h, offsetof(nvmSnapshotHeader_t, crc));
+    return (crc16(crc, c->values, c->h.count * sizeof(uint32_t)));
+}
+
+/*
+ * _snapshot_chunk() - fill a chunk with the persisted values from ordinal on
+ *
+ *  index is where the table scan for the ordinal'th persisted value starts. Returns where
+ *  the scan for the next chunk starts.
+ */
+
+static index_t _snapshot_chunk(nvmSnapshotChunk_t *chunk, uint16_t ordinal, uint16_t total, index_t index)
+{
+    nvmSnapshotHeader_t *h = &chunk->h;
+    h->version = NVM_SNAPSHOT_VERSION;
+    h->count = min((uint16_t)(total - ordinal), (uint16_t)NVM_SNAPSHOT_CHUNK);
+    h->signature = nvm.signature;
+    h->ordinal = ordinal;
+    for (uint8_t k=0; k < h->count; index++) {
+        if (!_is_persisted(index)) {
+            continue;
+        }
+        nvObj_t v;
+        v.index = index;
+        strcpy(v.token, cfgArray[index].token);     // token field is always terminated
+        v.group[0] = NUL;                           // the token is the whole name, as cfgArray has it
+        v.value_int = 0;
+        v.value_flt = 0;
+        cfgArray[index].get(&v);
+        if (_is_float(index)) {
+            memcpy(&chunk->values[k++], &v.value_flt, sizeof(uint32_t));
+        } else {
+            chunk->values[k++] = (uint32_t)v.value_int;
+        }
+    }
+    h->crc = _snapshot_crc(chunk);
+    return (index);
+}
+
+/*
+ * nvm_get_cfgs() - stream all persisted values as a snapshot - see persistence.h
+ *
+ *  The values are read with the get functions, so a snapshot can be taken with or
+ *  without NVM. The response is printed here, so this returns STAT_COMPLETE.
+ */
+
+stat_t nvm_get_cfgs(nvObj_t *nv)
+{
+    nvmSnapshotChunk_t chunk;
+    char encoded[8 * ((sizeof(chunk) + 4) / 5) + 1];
+    nvmSnapshotHeader_t *h = &chunk.h;
+    index_t index = nv->index;
+    uint16_t total = _persisted_count();
+    uint16_t string_wp = nvStr.wp;
+
+    nv->valuetype = TYPE_PARENT;
+    nv_stream_begin(nv);
+    nvObj_t *child = nv->nx;
+    nv_reset_nv(child);
+    child->index = index;                           // children print with nvm_print_cfgs()
+    strcpy(child->token, "n");
+    child->valuetype = TYPE_INTEGER;
+    child->value_int = total;
+    nv_stream_object(child);
+
+    index_t i = 0;
+    for (uint16_t ordinal=0, n=0; ordinal < total; ordinal += h->count, n++) {
+        i = _snapshot_chunk(&chunk, ordinal, total, i);
+        base32_encode(encoded, &chunk, _chunk_length(&chunk));
+
+        child->token[0] = 'c';
+        inttoa(&child->token[1], n);
+        child->valuetype = TYPE_STRING;
+        nv_copy_string(child, encoded);
+        nv_stream_object(child);
+        nvStr.wp = string_wp;                       // the chunk has been sent
+    }
+    nv_stream_end(STAT_OK);
+    return (STAT_COMPLETE);
+}
+
+/*
+ * nvm_set_cfgs() - apply and persist one snapshot chunk - see persistence.h
+ *
+ *  A value a set function refuses is skipped, and the rest of the chunk is still applied.
+ *  The first such error is returned, so the host knows the machine isn't exactly as
+ *  snapshotted. Values are set in mm mode, as in config_init().
+ */
+
+stat_t nvm_set_cfgs(nvObj_t *nv)
+{
+    nvmSnapshotChunk_t chunk;
+    nvmSnapshotHeader_t *h = &chunk.h;
+
+    if (nv->valuetype != TYPE_STRING) {
+        return (STAT_UNSUPPORTED_TYPE);
+    }
+    if (cm->cycle_type != CYCLE_NONE) {
+        return (STAT_COMMAND_NOT_ACCEPTED);
+    }
+    int16_t length = base32_decode((uint8_t *)&chunk, *nv->stringp, sizeof(chunk));
+    if (length < (int16_t)sizeof(nvmSnapshotHeader_t)) {
+        return (STAT_CONFIG_SNAPSHOT_MISMATCH);
+    }
+    if ((h->version != NVM_SNAPSHOT_VERSION) || (h->signature != nvm.signature) ||
+        (h->count > NVM_SNAPSHOT_CHUNK)) {
+        return (STAT_CONFIG_SNAPSHOT_MISMATCH);
+    }
+    if ((length != (int16_t)_chunk_length(&chunk)) || (h->crc != _snapshot_crc(&chunk))) {
+        return (STAT_CHECKSUM_MATCH_FAILED);
+    }
+    if (h->ordinal == 0) {                          // the first chunk starts a new restore
+        nvm.import_ordinal = 0;
+        nvm.import_index = 0;
+    }
+    if (h->ordinal != nvm.import_ordinal) {
+        return (STAT_CONFIG_SNAPSHOT_MISMATCH);
+    }
+
+    stat_t status = STAT_OK;
+    uint8_t units = cm_get_units_mode(MODEL);
+    cm_set_units_mode(MILLIMETERS);
+    for (uint8_t k=0; k < h->count; nvm.import_index++) {
+        if (!nv_index_is_single(nvm.import_index)) {
+            status = STAT_CONFIG_SNAPSHOT_MISMATCH; // more values than the table has
+            break;
+        }
+        if (!_is_persisted(nvm.import_index)) {
+            continue;
+        }
+        nvObj_t v;
+        v.index = nvm.import_index;
+        strcpy(v.token, cfgArray[v.index].token);
+        v.group[0] = NUL;
+        if (_is_float(v.index)) {
+            memcpy(&v.value_flt, &chunk.values[k++], sizeof(uint32_t));
+            v.valuetype = TYPE_FLOAT;
+        } else {
+            v.value_int = (int32_t)chunk.values[k++];
+            v.valuetype = TYPE_INTEGER;
+        }
+        stat_t set_status = cfgArray[v.index].set(&v);
+        if (set_status == STAT_OK) {
+            nv_persist(&v);
+        } else if (status == STAT_OK) {
+            status = set_status;
+        }
+    }
+    cm_set_units_mode(units);
+    nvm.import_ordinal += h->count;
+
+    nv->valuetype = TYPE_INTEGER;                   // respond with the number of values applied
+    nv->value_int = nvm.import_ordinal;
+    return (status);
+}
+
+/*********************
+ * TEXT MODE SUPPORT *
+ *********************/
+#ifdef __TEXT_MODE
+
+void nvm_print_cfgs(nvObj_t *nv)
+{
+    if (nv->valuetype == TYPE_STRING) {
+        sprintf(cs.out_buf, "[%s] %s\n", nv->token, *nv->stringp);
+    } else {
+        sprintf(cs.out_buf, "[%s] %ld\n", nv->token, (long)nv->value_int);
+    }
+    xio_writeline(cs.out_buf);
+}
+
+#endif // __TEXT_MODE
+
+/***********************************************************************************
+ **** NVM DEVICES ******************************************************************
+ ***********************************************************************************/
+
+#if defined(NVM_FILE)
+
+/*
+ * File backed NVM for host builds - erase fills a sector with 0xFF, program can only
+ * clear bits, as in flash.
+ */
+
+static FILE *nvm_file;
+
+stat_t nvm_device_open()
+{
+    if ((nvm_file = fopen(NVM_FILE, "r+b")) != NULL) {
+        return (STAT_OK);
+    }
+    if ((nvm_file = fopen(NVM_FILE, "w+b")) == NULL) {
+        return (STAT_FILE_NOT_OPEN);
+    }
+    for (uint8_t sector=0; sector<NVM_SECTORS; sector++) {
+        ritorno(nvm_device_erase(sector));
+    }
+    return (STAT_OK);
+}
+
+stat_t nvm_device_read(uint32_t address, void *data, uint16_t length)
+{
+    if ((fseek(nvm_file, address, SEEK_SET) != 0) || (fread(data, 1, length, nvm_file) != length)) {
+        memset(data, 0xFF, length);
+        return (STAT_PERSISTENCE_ERROR);
+    }
+    return (STAT_OK);
+}
+
+stat_t nvm_device_program(uint32_t address, const void *data, uint16_t length)
+{
+    uint8_t buf[sizeof(nvmHeader_t)];               // programs are one header or one record
+    if (length > sizeof(buf)) {
+        return (STAT_PERSISTENCE_ERROR);
+    }
+    nvm_device_read(address, buf, length);
+    for (uint16_t i=0; i<length; i++) {
+        buf[i] &= ((const uint8_t *)data)[i];
+    }
+    if ((fseek(nvm_file, address, SEEK_SET) != 0) || (fwrite(buf, 1, length, nvm_file) != length)) {
+        return (STAT_PERSISTENCE_ERROR);
+    }
+    fflush(nvm_file);
+    return (STAT_OK);
+}
+
+stat_t nvm_device_erase(uint8_t sector)
+{
+    uint8_t buf[256];
+    memset(buf, 0xFF, sizeof(buf));
+    if (fseek(nvm_file, (uint32_t)sector * NVM_SECTOR_SIZE, SEEK_SET) != 0) {
+        return (STAT_PERSISTENCE_ERROR);
+    }
+    for (uint16_t i=0; i<(NVM_SECTOR_SIZE / sizeof(buf)); i++) {
+        if (fwrite(buf, 1, sizeof(buf), nvm_file) != sizeof(buf)) {
+            return (STAT_PERSISTENCE_ERROR);
+        }
+    }
+    fflush(nvm_file);
+    return (STAT_OK);
+}
+
+#elif !defined(HAS_NVM_DEVICE)
+
+/*
+ * No NVM - nothing is persisted
+ */
+
+stat_t nvm_device_open() { return (STAT_PERSISTENCE_ERROR); }
+stat_t nvm_device_read(uint32_t address, void *data, uint16_t length) { return (STAT_PERSISTENCE_ERROR); }
+stat_t nvm_device_program(uint32_t address, const void *data, uint16_t length) { return (STAT_PERSISTENCE_ERROR); }
+stat_t nvm_device_erase(uint8_t sector) { return (STAT_PERSISTENCE_ERROR); }
+
+#endif // NVM devices
@@ -25,28 +25,143 @@
  * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
 
+/*
+ * PERSISTENCE
+ *
+ *  Persisted settings are kept in an append-only log of fixed size records keyed by
+ *  cfgArray index. Writing a value appends a record - nothing is ever rewritten in place,
+ *  so each location in NVM is programmed once per erase. The log lives in NVM_SECTORS
+ *  erase sectors used in rotation. When the active sector fills up, the latest value of
+ *  every index is copied into the next sector (compaction) and that sector becomes the
+ *  active one. Its header is written last, so a power loss during compaction leaves the
+ *  old sector in charge.
+ *
+ *  Every record carries a CRC. A record that fails its CRC (e.g. torn by a power loss)
+ *  is ignored and the previous value for that index stands. Each sector header carries
+ *  a signature of the cfgArray tokens and types. A firmware build with a different table
+ *  would read the indexes wrongly, so it ignores the log and loads settings defaults.
+ *
+ *  Writes are queued and written in batches by persistence_callback() when the machine
+ *  is not in a cycle. Programming flash stalls code running from flash, which would
+ *  starve the step timers. persistence_init() scans the active sector once and keeps
+ *  the record number of the latest value of each index in nvm_slot[], so the boot load
+ *  (config_init()) reads each value directly.
+ *
+ *  NVM device
+ *
+ *  The log is written through four device functions, so it can sit on any NVM that is
+ *  erased in sectors and programmed from the erased (0xFF) state:
+ *
+ *      nvm_device_open(), nvm_device_read(), nvm_device_program(), nvm_device_erase()
+ *
+ *  Host builds define NVM_FILE as a file name. The device is then a file that behaves
+ *  like flash (program can only clear bits), so the log can be tested without hardware.
+ *  A board with on-chip or external NVM defines HAS_NVM_DEVICE in its hardware.h and
+ *  provides the functions in its hardware.cpp - G2v9 keeps the log in the top 16K of
+ *  its on-chip flash. With neither there is no NVM, and settings load from defaults
+ *  at every reset as before.
+ *
+ *  CONFIG SNAPSHOTS
+ *
+ *  {"cfgs":null} exports every settable persisted value as a binary snapshot in base32
+ *  chunks:
+ *
+ *      {"r":{"cfgs":{"n":704,"c0":"AEU...","c1":"AEU...",...}},"f":[...]}
+ *
+ *  Base32 because the JSON parser lower cases string values - the chunks decode the
+ *  same in either case. To restore, send the chunks back in order, one per line:
+ *  {"cfgs":"AEU..."}. The values in each chunk are applied and persisted as it arrives,
+ *  and the response is the number of values applied so far. Each chunk is checked on
+ *  its own. It has a version, the cfgArray signature, the ordinal of its first value
+ *  and a CRC. So a snapshot from another build, a corrupt chunk or one out of order is
+ *  refused before anything is set. Values are raw internal-unit bits in cfgArray order,
+ *  so there is no parsing, unit conversion or token lookup.
+ */
+
 #ifndef PERSISTENCE_H_ONCE
 #define PERSISTENCE_H_ONCE
 
 #include "config.h"  // needed for nvObj_t definition
 
-#define NVM_VALUE_LEN 4       // NVM value length (float, fixed length)
-#define NVM_BASE_ADDR 0x0000  // base address of usable NVM
+/**** Configs and Constants ****/
+
+#ifndef NVM_SECTOR_SIZE
+#define NVM_SECTOR_SIZE     8192            // bytes per erase sector
+#endif
+#ifndef NVM_SECTORS
+#define NVM_SECTORS         2               // sectors the log rotates through - at least 2
+#endif
+
+#define NVM_WRITE_QUEUE_LEN 32              // writes batched between flushes
+#define NVM_SNAPSHOT_VERSION 1
+#define NVM_SNAPSHOT_CHUNK  40              // values per snapshot chunk - a chunk is one JSON line
+#define NVM_MAGIC           0x47324E56      // "G2NV"
+#define NVM_ERASED_INDEX    0xFFFF
+
+//**** persistence structures ****
+
+typedef struct nvmHeader {                  // start of each sector - written last
+    uint32_t magic;
+    uint32_t sequence;                      // the sector with the highest sequence is active
+    uint16_t signature;                     // CRC of the cfgArray tokens and flags
+    uint16_t crc;                           // CRC of the fields above
+    uint32_t reserved;                      // keeps the records 8 byte aligned
+} nvmHeader_t;
 
-//**** persistence singleton ****
+typedef struct nvmRecord {
+    uint16_t index;                         // cfgArray index, NVM_ERASED_INDEX if unwritten
+    uint16_t crc;                           // CRC of index and value
+    uint32_t value;                         // value_int, or the bits of value_flt
+} nvmRecord_t;
+
+typedef struct nvmSnapshotHeader {           // start of each snapshot chunk
+    uint8_t version;                        // NVM_SNAPSHOT_VERSION
+    uint8_t count;                          // values in the chunk
+    uint16_t signature;                     // CRC of the cfgArray tokens and flags
+    uint16_t ordinal;                       // position of the first value among the persisted values
+    uint16_t crc;                           // CRC of the header fields above and the values
+} nvmSnapshotHeader_t;
+
+#define NVM_RECORDS ((NVM_SECTOR_SIZE - sizeof(nvmHeader_t)) / sizeof(nvmRecord_t))
 
 typedef struct nvmSingleton {
-    uint16_t base_addr;     // NVM base address
-    uint16_t profile_base;  // NVM base address of current profile]
-    uint16_t address;
-    float    tmp_value;
-    int8_t   byte_array[NVM_VALUE_LEN];
+    bool ready;                             // an NVM device is present
+    bool loaded;                            // a log written with this cfgArray was found at boot
+    uint8_t sector;                         // active sector
+    uint32_t sequence;                      // sequence number of the active sector
+    uint16_t signature;                     // of the running cfgArray
+    uint16_t next;                          // next free record in the active sector
+    uint8_t pending;                        // records in the write queue
+    uint32_t compactions;
+    uint16_t import_ordinal;                // next snapshot value expected
+    index_t import_index;                   // cfgArray index to look for it from
+    nvmRecord_t queue[NVM_WRITE_QUEUE_LEN];
 } nvmSingleton_t;
 
+extern nvmSingleton_t nvm;
+extern uint16_t nvm_slot[];                 // latest record number + 1 by index, 0 = none (see config_app.c)
+
 //**** persistence function prototypes ****
 
 void persistence_init(void);
+stat_t persistence_callback(void);
+stat_t persistence_reset(void);
+bool persistence_is_loaded(void);
 stat_t read_persistent_value(nvObj_t* nv);
 stat_t write_persistent_value(nvObj_t* nv);
 
+stat_t nvm_get_cfgs(nvObj_t *nv);
+stat_t nvm_set_cfgs(nvObj_t *nv);
+
+#ifdef __TEXT_MODE
+    void nvm_print_cfgs(nvObj_t *nv);
+#else
+    #define nvm_print_cfgs tx_print_stub
+#endif
+
+stat_t nvm_device_open(void);
+stat_t nvm_device_read(uint32_t address, void *data, uint16_t length);
+stat_t nvm_device_program(uint32_t address, const void *data, uint16_t length);
+stat_t nvm_device_erase(uint8_t sector);
+
 #endif  // End of include guard: PERSISTENCE_H_ONCE
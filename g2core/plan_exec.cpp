@@ -37,6 +37,8 @@
 #include "util.h"
 #include "spindle.h"
 #include "xio.h"    // DIAGNOSTIC
+#include "telemetry.h"
+#include "scope.h"
 
 // execute routines (NB: These are all called from the LO interrupt)
 static stat_t _exec_aline_head(mpBuf_t *bf); // passing bf because body might need it, and it might call body
@@ -261,6 +263,7 @@ stat_t mp_exec_move()
 
     // Getting a NULL buffer means nothing's running in the queue - this is OK
     if ((bf = mp_get_run_buffer()) == NULL) {
+        mp_runtime_deferred_commands(NULL);             // run any deferred commands left with nothing to wait for
         st_prep_null();
         return (STAT_NOOP);
     }
@@ -309,6 +312,7 @@ stat_t mp_exec_move()
     if (bf->bf_func == NULL) {
         return(cm_panic(STAT_INTERNAL_ERROR, "mp_exec_move()")); // never supposed to get here
     }
+    mp_runtime_deferred_commands(bf);                   // run commands deferred to the start of this buffer
     return (bf->bf_func(bf));                               // run the move callback in the planner buffer
 }
 
@@ -438,6 +442,7 @@ stat_t mp_exec_aline(mpBuf_t *bf)
 
         // Start a new move by setting up the runtime singleton (mr)
         memcpy(&mr->gm, &(bf->gm), sizeof(GCodeState_t));   // copy in the gcode model state
+        cm_raster_start_block(mr->gm.raster_row);           // release laser raster rows that have run
         bf->block_state = BLOCK_ACTIVE;                     // note that this buffer is running
         mr->block_state = BLOCK_INITIAL_ACTION;             // note the planner doesn't look at block_state
 
@@ -456,7 +461,7 @@ stat_t mp_exec_aline(mpBuf_t *bf)
         copy_vector(mr->target, bf->gm.target);
         copy_vector(mr->axis_flags, bf->axis_flags);
 
-        mr->run_bf = bf;                                // DIAGNOSTIC: points to running bf
+        mr->run_bf = bf;                                // points to running bf (used for laser power)
         mr->plan_bf = bf->nx;                           // DIAGNOSTIC: points to next bf to forward plan
 
         // characterize the move for starting section - head/body/tail 
@@ -949,9 +954,19 @@ static stat_t _exec_aline_segment()
         mp->run_time_remaining = 0.0;
     }
 
-    // Call the stepper prep function
+    // Call the stepper prep functions - laser power first so it loads with the segment
+    float power = (mr->gm.raster_row == 0) ? 1.0 : cm_raster_power(mr->gm.raster_row, mr->position, mr->gm.target);
+    st_prep_laser(spindle_laser_duty(&mr->gm, mr->segment_velocity, mr->run_bf->cruise_vmax, power));
+    if ((mr->run_bf->output_on | mr->run_bf->output_off) &&     // M62/M63 outputs change with the segment they fall in
+        (get_axis_vector_length(mr->target, mr->gm.target) <= mr->run_bf->output_remaining + EPSILON)) {
+        st_prep_outputs(mr->run_bf->output_on, mr->run_bf->output_off);
+        mr->run_bf->output_on = 0;
+        mr->run_bf->output_off = 0;
+    }
     ritorno(st_prep_line(travel_steps, mr->following_error, mr->segment_time));
     copy_vector(mr->position, mr->gm.target);               // update position from target
+    tm_sample(mr->position, mr->segment_velocity, mr->following_error, mr->gm.linenum, mr->section, mr->segment_time);
+    scope_sample(travel_steps);
     if (mr->segment_count == 0) {
         return (STAT_OK);                                   // this section has run all its segments
     }
@@ -70,6 +70,7 @@ static void _set_bf_diagnostics(mpBuf_t* bf) {}
  *
  * mp_zero_segment_velocity()         - correct velocity in last segment for reporting purposes
  * mp_get_runtime_velocity()          - returns current velocity (aggregate)
+ * mp_get_runtime_axis_velocity()     - returns current velocity of one axis (signed)
  * mp_get_runtime_machine_position()  - returns current axis position in machine coordinates
  * mp_set_runtime_display_offset()    - set combined display offsets in the MR struct
  * mp_get_runtime_display_position()  - returns current axis position in work display coordinates
@@ -78,6 +79,7 @@ static void _set_bf_diagnostics(mpBuf_t* bf) {}
 
 void  mp_zero_segment_velocity() { mr->segment_velocity = 0; }
 float mp_get_runtime_velocity(void) { return (mr->segment_velocity); }
+float mp_get_runtime_axis_velocity(const uint8_t axis) { return (mr->segment_velocity * mr->unit[axis]); }
 float mp_get_runtime_absolute_position(mpPlannerRuntime_t *_mr, uint8_t axis) { return (_mr->position[axis]); }
 void mp_set_runtime_display_offset(float offset[]) { copy_vector(mr->gm.display_offset, offset); }
 
@@ -229,6 +231,14 @@ stat_t mp_aline(GCodeState_t* _gm)
             bf->unit[axis] = axis_length[axis] / length;// nb: bf-> unit was cleared by mp_get_write_buffer()
         }
     }
+    if (mp->output_on | mp->output_off) {              // attach pending M62/M63 outputs to the move
+        bf->output_on = mp->output_on;
+        bf->output_off = mp->output_off;
+        bf->output_remaining = max(length - mp->output_distance, (float)0.0);
+        mp->output_on = 0;
+        mp->output_off = 0;
+        mp->output_distance = 0;
+    }
     _calculate_jerk(bf);                                // compute bf->jerk values
     _calculate_vmaxes(bf, axis_length, axis_square);    // compute cruise_vmax and absolute_vmax
     _set_bf_diagnostics(bf);                            // DIAGNOSTIC
@@ -239,6 +249,37 @@ stat_t mp_aline(GCodeState_t* _gm)
     return (STAT_OK);
 }
 
+/****************************************************************************************
+ * mp_sync_output() - change a digital output with the next move
+ *
+ *  The change rides on the next aline queued, and is made by the runtime when the segment
+ *  that reaches distance (mm) into that move is loaded. Unlike mp_queue_command() this takes
+ *  no buffer and the planner doesn't stop for it. A distance longer than the move changes
+ *  the output at the end of the move. Later changes to the same output replace earlier ones.
+ *
+ *  All the changes waiting for a move share one distance, so a change to another output at
+ *  a different distance is rejected rather than moving the ones already waiting.
+ *
+ *  output is zero-based (output 1 is 0)
+ */
+
+stat_t mp_sync_output(const uint8_t output, const bool value, const float distance)
+{
+    uint16_t bit = (1 << output);
+    if (((mp->output_on | mp->output_off) & ~bit) && fp_NE(distance, mp->output_distance)) {
+        return (STAT_Q_WORD_IS_INVALID);                // another output is waiting at another distance
+    }
+    if (value) {
+        mp->output_on |= bit;
+        mp->output_off &= ~bit;
+    } else {
+        mp->output_off |= bit;
+        mp->output_on &= ~bit;
+    }
+    mp->output_distance = distance;
+    return (STAT_OK);
+}
+
 /****************************************************************************************
  * mp_plan_block_list() - plan all the blocks in the list
  *
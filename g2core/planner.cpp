@@ -181,7 +181,7 @@ void _init_planner_queue(mpPlanner_t *_mp, mpBuf_t *queue, uint8_t size)
 void planner_init(mpPlanner_t *_mp, mpPlannerRuntime_t *_mr, mpBuf_t *queue, uint8_t queue_size)
 {
     // init planner master structure
-    memset(_mp, 0, sizeof(mpPlanner_t));    // clear all values, pointers and status    
+    memset((void *)_mp, 0, sizeof(mpPlanner_t));    // clear all values, pointers and status    
     _mp->magic_start = MAGICNUM;            // set boundary condition assertions
     _mp->magic_end = MAGICNUM;
     _mp->mfo_factor = 1.00;
@@ -313,9 +313,9 @@ void mp_queue_command(void(*cm_exec)(float *, bool *), float *value, bool *flag)
     bf->bf_func = _exec_command;      // callback to planner queue exec function
     bf->cm_func = cm_exec;            // callback to canonical machine exec function
 
-    for (uint8_t axis = AXIS_X; axis < AXES; axis++) {
-        bf->unit[axis] = value[axis];               // use the unit vector to store command values
-        bf->axis_flags[axis] = flag[axis];
+    for (uint8_t axis = AXIS_X; axis < AXES; axis++) {  // either vector may be nullptr if unused
+        bf->unit[axis] = (value != nullptr) ? value[axis] : 0;  // use the unit vector to store command values
+        bf->axis_flags[axis] = (flag != nullptr) ? flag[axis] : false;
     }
     mp_commit_write_buffer(BLOCK_TYPE_COMMAND);     // must be final operation before exit
 }
@@ -335,6 +335,50 @@ stat_t mp_runtime_command(mpBuf_t *bf)
     return (STAT_OK);
 }
 
+/****************************************************************************************
+ * mp_defer_command()             - queue a command to run as the next planner buffer starts
+ * mp_runtime_deferred_commands() - run the deferred commands due before a buffer
+ *
+ *  For commands that don't need motion to stop - coolant, spindle speed changes, tool
+ *  select, JSON commands. A queued command takes a planner buffer, and the planner plans
+ *  to a stop at every command buffer. A deferred command takes neither. It is held in a
+ *  small ring on the side, and each buffer records the ring count when it is committed.
+ *  The exec runs the commands up to that count when it starts the buffer, so they run in
+ *  the same order relative to the moves as queued commands would.
+ *
+ *  Commands left over when the queue runs empty are run right away - there is nothing
+ *  left for them to wait for. If the ring is full the command is queued as usual, which
+ *  also runs the deferred commands ahead of it first.
+ */
+
+void mp_defer_command(void(*cm_exec)(float *, bool *), float *value, bool *flag)
+{
+    if ((uint8_t)(mp->deferred_wr - mp->deferred_rd) >= PLANNER_DEFERRED_COMMANDS) {
+        mp_queue_command(cm_exec, value, flag);
+        return;
+    }
+    mpDeferredCommand_t *dc = &mp->deferred[mp->deferred_wr & (PLANNER_DEFERRED_COMMANDS-1)];
+    dc->cm_func = cm_exec;
+    for (uint8_t axis = AXIS_X; axis < AXES; axis++) {
+        dc->value[axis] = (value == nullptr) ? 0 : value[axis];
+        dc->flag[axis] = (flag == nullptr) ? false : flag[axis];
+    }
+    mp->deferred_wr++;                              // must follow writing the command
+    if (cm->hold_state == FEEDHOLD_OFF) {
+        st_request_exec_move();                     // runs it now if the queue is empty
+    }
+}
+
+void mp_runtime_deferred_commands(const mpBuf_t *bf)
+{
+    uint8_t end = (bf == NULL) ? mp->deferred_wr : bf->deferred_end;
+    while (mp->deferred_rd != end) {
+        mpDeferredCommand_t *dc = &mp->deferred[mp->deferred_rd & (PLANNER_DEFERRED_COMMANDS-1)];
+        dc->cm_func(dc->value, dc->flag);
+        mp->deferred_rd++;
+    }
+}
+
 /****************************************************************************************
  * _exec_json_command() - execute json string (from exec system)
  * mp_json_command()    - queue a json command
@@ -352,7 +396,7 @@ stat_t mp_json_command(char *json_string)
 {
     // Never supposed to fail, since we stopped parsing when we were full
     jc.write_buffer(json_string);
-    mp_queue_command(_exec_json_command, nullptr, nullptr);
+    mp_defer_command(_exec_json_command, nullptr, nullptr);
     return (STAT_OK);
 }
 
@@ -792,6 +836,7 @@ void mp_commit_write_buffer(const blockType block_type)
 
     q->w->block_type = block_type;
     q->w->block_state = BLOCK_INITIAL_ACTION;
+    q->w->deferred_end = mp->deferred_wr;   // deferred commands run before this buffer
 
     if (block_type != BLOCK_TYPE_ALINE) {
         if ((mp->planner_state > PLANNER_STARTUP) && (cm->hold_state == FEEDHOLD_OFF)) {
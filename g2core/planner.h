@@ -79,6 +79,8 @@
  *  - mp_aline()         - plan and queue a move with acceleration management
  *  - mp_dwell()         - plan and queue a pause (dwell) to the planner queue
  *  - mp_queue_command() - queue a canned command
+ *  - mp_defer_command() - run a command as the next buffer starts, without using a buffer
+ *  - mp_sync_output()   - change a digital output with the next move (no buffer is queued)
  *  - mp_json_command()  - queue a JSON command for run-time interpretation and execution (M100)  
  *  - mp_json_wait()     - queue a JSON wait for run-time interpretation and execution (M101)
  *  - 
@@ -229,6 +231,7 @@ typedef enum {                      // code blocks for planning and trapezoid ge
 #define PLANNER_QUEUE_SIZE          ((uint8_t)48)       // Suggest 12 min. Limit is 255
 #define SECONDARY_QUEUE_SIZE        ((uint8_t)12)       // Secondary planner queue for feedhold operations
 #define PLANNER_BUFFER_HEADROOM     ((uint8_t)4)        // Buffers to reserve in planner before processing new input line
+#define PLANNER_DEFERRED_COMMANDS   ((uint8_t)16)       // Commands run as the next buffer starts. Must be a power of 2
 #define JERK_MULTIPLIER             ((float)1000000)    // DO NOT CHANGE - must always be 1 million
 
 #define JUNCTION_INTEGRATION_MIN    (0.05)              // JT minimum allowable setting
@@ -311,6 +314,12 @@ typedef enum {                      // code blocks for planning and trapezoid ge
 
 //**** Planner Queue Structures ****
 
+typedef struct mpDeferredCommand {      // a command run as the next buffer starts - takes no buffer itself
+    cm_exec_t cm_func;                  // callback to canonical machine execution function
+    float value[AXES];                  // ...and its arguments
+    bool flag[AXES];
+} mpDeferredCommand_t;
+
 typedef struct mpBuffer {
 
     // *** CAUTION *** These two pointers are not reset by _clear_buffer()
@@ -367,6 +376,12 @@ typedef struct mpBuffer {
     float sqrt_j;                       // sqrt(jM) used for planning (computed and cached)
     float q_recip_2_sqrt_j;             // (q/(2 sqrt(jM))) where q = (sqrt(10)/(3^(1/4))), used in length computations (computed and cached)
 
+    uint16_t output_on;                 // M62 digital outputs to turn on in this move (bit 0 = output 1)
+    uint16_t output_off;                // M63 digital outputs to turn off in this move
+    float output_remaining;             // ...when this much of the move remains (mm)
+
+    uint8_t deferred_end;               // deferred commands up to this count run as the buffer starts
+
     GCodeState_t gm;                    // Gcode model state - passed from model, used by planner and runtime
 
     // clears the above structure
@@ -407,6 +422,10 @@ typedef struct mpBuffer {
         recip_jerk = 0.0;
         sqrt_j = 0.0;
         q_recip_2_sqrt_j = 0.0;
+        output_on = 0;
+        output_off = 0;
+        output_remaining = 0.0;
+        deferred_end = 0;
         gm.reset();
     }
 } mpBuf_t;
@@ -465,7 +484,7 @@ typedef struct mpPlannerRuntime {       // persistent runtime variables
     mpBlockRuntimeBuf_t block[2];       // buffer holding the two blocks
 
     mpBuf_t *plan_bf;                   // DIAGNOSTIC - pointer to next buffer to plan
-    mpBuf_t *run_bf;                    // DIAGNOSTIC - pointer to currently running buffer
+    mpBuf_t *run_bf;                    // pointer to currently running buffer
 
     float entry_velocity;               // entry values for the currently running block
 
@@ -525,6 +544,16 @@ typedef struct mpPlanner {              // common variables for a planner contex
     float ramp_target;
     float ramp_dvdt;
 
+    // M62/M63 digital output changes waiting for the next move
+    uint16_t output_on;
+    uint16_t output_off;
+    float output_distance;              // distance into the move to change them (mm)
+
+    // deferred commands - written by the model, run by the exec. Counts are free-running
+    mpDeferredCommand_t deferred[PLANNER_DEFERRED_COMMANDS];
+    volatile uint8_t deferred_wr;       // commands deferred
+    volatile uint8_t deferred_rd;       // commands run
+
     // objects
     Timeout block_timeout;              // Timeout object for block planning
 
@@ -547,6 +576,11 @@ typedef struct mpPlanner {              // common variables for a planner contex
         mfo_active = false;
         ramp_active = false;
         entry_changed = false;
+        output_on = 0;
+        output_off = 0;
+        output_distance = 0;
+        deferred_wr = 0;
+        deferred_rd = 0;
         block_timeout.clear();
     }
 } mpPlanner_t;
@@ -582,6 +616,8 @@ void mp_set_steps_to_runtime_position(void);
 
 void mp_queue_command(void(*cm_exec)(float *, bool *), float *value, bool *flag);
 stat_t mp_runtime_command(mpBuf_t *bf);
+void mp_defer_command(void(*cm_exec)(float *, bool *), float *value, bool *flag);
+void mp_runtime_deferred_commands(const mpBuf_t *bf);
 
 stat_t mp_json_command(char *json_string);
 stat_t mp_json_command_immediate(char *json_string);
@@ -625,6 +661,7 @@ bool mp_free_run_buffer(void);
 //**** plan_line.c functions
 void mp_zero_segment_velocity(void);                    // getters and setters...
 float mp_get_runtime_velocity(void);
+float mp_get_runtime_axis_velocity(const uint8_t axis);
 float mp_get_runtime_absolute_position(mpPlannerRuntime_t *_mr, uint8_t axis);
 float mp_get_runtime_display_position(uint8_t axis);
 void mp_set_runtime_display_offset(float offset[]);
@@ -632,6 +669,7 @@ bool mp_get_runtime_busy(void);
 bool mp_runtime_is_idle(void);
 
 stat_t mp_aline(GCodeState_t *_gm);                   // line planning...
+stat_t mp_sync_output(const uint8_t output, const bool value, const float distance);
 void mp_plan_block_list(void);
 void mp_plan_block_forward(mpBuf_t *bf);
 
@@ -166,7 +166,9 @@ void rpt_print_system_ready_message(void)
  *    - Automatic status reports in text mode return CSV format according to si setting
  */
 static stat_t _populate_unfiltered_status_report(void);
-static uint8_t _populate_filtered_status_report(void);
+static stat_t _stream_unfiltered_status_report(void);
+static uint8_t _populate_filtered_status_report(bool &held_back);
+static void _compile_status_report_plan(void);
 
 uint8_t _is_stat(nvObj_t *nv)
 {
@@ -182,9 +184,10 @@ uint8_t _is_stat(nvObj_t *nv)
  *
  *  Call this function to completely re-initialize the status report
  *  Sets SR list to hard-coded defaults and re-initializes SR values in NVM
+ *  With reset_list false the list loaded from NVM is kept.
  */
 
-void sr_init_status_report()
+void sr_init_status_report(bool reset_list)
 {
     nvObj_t *nv = nv_reset_nv_list();    // used for status report persistence locations
     sr.status_report_request = SR_OFF;
@@ -193,11 +196,13 @@ void sr_init_status_report()
 
     // record the index of the "stat" variable so we can use it during reporting
     sr.stat_index = nv_get_index((const char *)"", (const char *)"stat");
+    if (!reset_list) {
+        return;
+    }
 
     // setup the status report array 
     for (uint8_t i=0; i < NV_STATUS_REPORT_LEN ; i++) {
         if (sr_defaults[i][0] == NUL) break;                    // quit on first blank array entry
-        sr.status_report_value[i] = -1234567;                   // pre-load values with an unlikely number
         nv->value_int = nv_get_index((const char *)"", sr_defaults[i]);// load the index for the SR element
         if (nv->value_int == NO_MATCH) {
             rpt_exception(STAT_BAD_STATUS_REPORT_SETTING, "sr_init_status_report() encountered bad SR setting"); // trap mis-configured profile settings
@@ -242,8 +247,15 @@ stat_t sr_set_status_report(nvObj_t *nv)
     if (elements == 0) {
         return (STAT_INPUT_LESS_THAN_MIN_VALUE);
     }
+    nvObj_t unused;                                         // clear the rest of the persisted list
+    unused.value_int = 0;
+    for (uint8_t i=elements; i<NV_STATUS_REPORT_LEN; i++) {
+        unused.index = sr_start + i;
+        nv_persist(&unused);
+    }
     memcpy(sr.status_report_list, status_report_list, sizeof(status_report_list));
-    return(_populate_unfiltered_status_report());            // return current values
+    sr.plan_valid = false;
+    return(_stream_unfiltered_status_report());              // return current values
 }
 
 /*
@@ -305,16 +317,22 @@ stat_t sr_status_report_callback()         // called by controller dispatcher
         sr.throttle_counter = 0;
     }
 
+    bool held_back = false;
     sr.status_report_request = SR_OFF;
     if ((sr.status_report_request == SR_VERBOSE) ||
         (sr.status_report_verbosity == SR_VERBOSE)) {
         _populate_unfiltered_status_report();
     } else {
-        if (_populate_filtered_status_report() == false) {  // no new data
+        bool has_data = _populate_filtered_status_report(held_back);
+        if (held_back) {                                // come back for elements held by their interval
+            sr_request_status_report(SR_REQUEST_TIMED);
+        }
+        if (!has_data) {                                // no new data
             return (STAT_OK);
         }
     }
-    nv_print_list(STAT_OK, TEXT_MULTILINE_FORMATTED, JSON_OBJECT_FORMAT);
+    nv_print_list(STAT_OK, TEXT_MULTILINE_FORMATTED, JSON_STATUS_REPORT_FORMAT);
+    sr.reports_sent++;
     return (STAT_OK);
 }
 
@@ -323,34 +341,124 @@ stat_t sr_status_report_callback()         // called by controller dispatcher
  */
 stat_t sr_run_text_status_report()
 {
-    _populate_unfiltered_status_report();
-    nv_print_list(STAT_OK, TEXT_MULTILINE_FORMATTED, JSON_RESPONSE_FORMAT);
+    _stream_unfiltered_status_report();
     return (STAT_OK);
 }
 
+/*
+ * _compile_status_report_plan() - compile the SR list into sr.plan
+ *
+ *  Runs on the first report after the list changes (sr_set_status_report(), or a set
+ *  of any seXX). Deadbands, intervals and last values of elements that were already in
+ *  the plan are carried over, as long as the old and new lists fit in the plan together.
+ *  New elements start from the precision based deadband. Works in place - no scratch plan.
+ */
+static void _compile_status_report_plan()
+{
+    // Thresholds to detect value changes based on precision for the value.
+    // Allow for floating point roundoffs, i.e. precision = 2 is 0.01 becomes --> 0.009
+    const float precision[8] = { 0.9, 0.09, 0.009, 0.0009, 0.00009, 0.000009, 0.0000009, 0.00000009 };
+    uint8_t old_end = sr.plan_len;          // old entries not yet matched are kept in [i, old_end)
+    uint8_t i;
+
+    for (i=0; i<NV_STATUS_REPORT_LEN; i++) {
+        index_t index = sr.status_report_list[i];
+        if ((index == 0) || (index >= nv_index_max())) {
+            break;
+        }
+        uint8_t j = i;
+        while ((j < old_end) && (sr.plan[j].index != index)) { j++; }
+
+        if (j < old_end) {                  // already in the plan - move it into place
+            srPlanEntry_t tmp = sr.plan[i];
+            sr.plan[i] = sr.plan[j];
+            sr.plan[j] = tmp;
+            continue;
+        }
+        if (i < old_end) {                  // keep the old entry for a later match if there's room
+            if (old_end < NV_STATUS_REPORT_LEN) {
+                sr.plan[old_end++] = sr.plan[i];
+            }
+        } else {
+            old_end = i+1;
+        }
+        srPlanEntry_t *e = &sr.plan[i];
+        e->index = index;
+        e->get = cfgArray[index].get;
+        strcpy(e->token, cfgArray[index].token);    // group + stripped token is the table token
+        e->deadband = precision[cfgArray[index].precision & 0x07];
+        e->min_interval = 0;
+        e->last_report_ms = 0;
+        e->last_value = -1234567;                   // pre-load values with an unlikely number
+    }
+    sr.plan_len = i;
+    sr.plan_valid = true;
+}
+
+static srPlanEntry_t *_status_report_plan_entry(index_t index)
+{
+    if (!sr.plan_valid) { _compile_status_report_plan(); }
+    for (uint8_t i=0; i<sr.plan_len; i++) {
+        if (sr.plan[i].index == index) { return (&sr.plan[i]); }
+    }
+    return (NULL);
+}
+
 /*
  * _populate_unfiltered_status_report() - populate nvObj body with status values
+ * _stream_unfiltered_status_report()   - print the same report as each value is read
+ * _get_status_report_element()         - read one plan element into nv, with its flattened token
  *
- *  Designed to be run as a response; i.e. have a "r" header and a footer.
+ *  The populated report is for the status report callback, which needs the whole report
+ *  in one piece so it can supersede a report that hasn't been sent yet. Reports that are
+ *  returned as a response (? and {"sr":...}) are streamed - see nv_stream_begin().
  */
-static stat_t _populate_unfiltered_status_report()
+static void _get_status_report_element(nvObj_t *nv, srPlanEntry_t *e)
+{
+    nv_reset_nv(nv);
+    nv->index = e->index;
+    strcpy(nv->token, e->token);            // getters accept the flattened token with no group
+    e->get(nv);
+    sr.elements_read++;
+}
+
+static nvObj_t *_status_report_parent()
 {
     const char sr_str[] = "sr";
-    char tmp[TOKEN_LEN+1];
     nvObj_t *nv = nv_reset_nv_list();       // sets *nv to the start of the body
 
     nv->valuetype = TYPE_PARENT;            // setup the parent object (no length checking required)
     strcpy(nv->token, sr_str);
     nv->index = nv_get_index((const char *)"", sr_str);// set the index - may be needed by calling function
-    nv = nv->nx;                            // no need to check for NULL as list has just been reset
+    return (nv);
+}
 
-    for (uint8_t i=0; i<NV_STATUS_REPORT_LEN; i++) {
-        if ((nv->index = sr.status_report_list[i]) == 0) { break;}
-        nv_get_nvObj(nv);
+static stat_t _stream_unfiltered_status_report()
+{
+    if (!sr.plan_valid) { _compile_status_report_plan(); }
+    nvObj_t *nv = _status_report_parent();
+    nv_stream_begin(nv);
+    nv = nv->nx;                            // every element is read into the same nvObj
+
+    for (uint8_t i=0; i<sr.plan_len; i++) {
+        _get_status_report_element(nv, &sr.plan[i]);
+        nv_stream_object(nv);
+        nvStr.wp = 0;                       // the element's strings have been sent
+    }
+    nv_stream_end(STAT_OK);
+    sr.reports_sent++;
+    sr.elements_sent += sr.plan_len;
+    return (STAT_COMPLETE);                 // the response has already been printed
+}
 
-        strcpy(tmp, nv->group);             // flatten out groups - WARNING - you cannot use strncpy here...
-        strcat(tmp, nv->token);
-        strcpy(nv->token, tmp);             //...or here.
+static stat_t _populate_unfiltered_status_report()
+{
+    if (!sr.plan_valid) { _compile_status_report_plan(); }
+    nvObj_t *nv = _status_report_parent()->nx; // no need to check for NULL as list has just been reset
+
+    for (uint8_t i=0; i<sr.plan_len; i++) {
+        _get_status_report_element(nv, &sr.plan[i]);
+        sr.elements_sent++;
 
         if ((nv = nv->nx) == NULL) {
             return (cm_panic(STAT_BUFFER_FULL_FATAL, "_populate_unfiltered_status_report() sr link NULL"));    // should never be NULL unless SR length exceeds available buffer array
@@ -365,56 +473,59 @@ static stat_t _populate_unfiltered_status_report()
  *  Designed to be displayed as a JSON object; i.e. no footer or header
  *  Returns 'true' if the report has new data, 'false' if there is nothing to report.
  *
+ *  An element is reported when it moves out of its deadband, but no more often than its
+ *  minimum interval. held_back is set if an element changed and is waiting on its interval.
+ *
  *  NOTE: Unlike sr_populate_unfiltered_status_report(), this function does NOT set
  *  the SR index, which is a relatively expensive operation. In current use this
  *  doesn't matter, but if the caller assumes its set it may lead to a side-effect (bug)
- *
- *  NOTE: Room for improvement - look up the SR index initially and cache it, use the
- *        cached value for all remaining reports.
  */
-static uint8_t _populate_filtered_status_report()
+static uint8_t _populate_filtered_status_report(bool &held_back)
 {
     const char sr_str[] = "sr";
     bool has_data = false;
-    char tmp[TOKEN_LEN+1];
     float current_value;
+    uint32_t now = SysTickTimer_getValue();
     nvObj_t *nv = nv_reset_nv_list();           // sets nv to the start of the body
-    
-    // Set thresholds to detect value changes based on precision for the value. 
-    // Allow for floating point roundoffs, i.e. precision = 2 is 0.01 becomes --> 0.009
-    float precision[8] = { 0.9, 0.09, 0.009, 0.0009, 0.00009, 0.000009, 0.0000009, 0.00000009 };
+
+    if (!sr.plan_valid) { _compile_status_report_plan(); }
+    held_back = false;
 
     nv->valuetype = TYPE_PARENT;                // setup the parent object (no need to length check the copy)
     strcpy(nv->token, sr_str);
 //    nv->index = nv_get_index((const char *)"", sr_str);// OMITTED - set the index - may be needed by calling function
     nv = nv->nx;                                // no need to check for NULL as list has just been reset
 
-    for (uint8_t i=0; i<NV_STATUS_REPORT_LEN; i++) {
-        if ((nv->index = sr.status_report_list[i]) == 0) {  // end of list
-            break;
-        }
-        nv_get_nvObj(nv);
+    for (uint8_t i=0; i<sr.plan_len; i++) {
+        srPlanEntry_t *e = &sr.plan[i];
+        _get_status_report_element(nv, e);
 
-        // extract the value and cast into a float, regardless of value type 
-        if ((valueType)(cfgArray[nv->index].flags & F_TYPE_MASK) == TYPE_FLOAT) {
+        // extract the value and cast into a float, regardless of value type
+        if (nv->valuetype == TYPE_FLOAT) {
             current_value = nv->value_flt;
         } else {
             current_value = (float)nv->value_int;
         }
 
-        // report values that have changed by more than the indicated precision, but always stops and ends
-        if ((fabs(current_value - sr.status_report_value[i]) > precision[cfgArray[nv->index].precision]) ||
-//            ((nv->index == sr.stat_index) && fp_EQ(nv->value_int, COMBINED_PROGRAM_STOP)) ||
-//            ((nv->index == sr.stat_index) && fp_EQ(nv->value_int, COMBINED_PROGRAM_END))) {
-            ((nv->index == sr.stat_index) && (nv->value_int == COMBINED_PROGRAM_STOP)) ||
-            ((nv->index == sr.stat_index) && (nv->value_int == COMBINED_PROGRAM_END))) {
-
-            strcpy(tmp, nv->group);            // flatten out groups - WARNING - you cannot use strncpy here...
-            strcat(tmp, nv->token);
-            strcpy(nv->token, tmp);            //...or here.
-            sr.status_report_value[i] = current_value;
+        // always report stops and ends
+        bool report = (nv->index == sr.stat_index) &&
+                      ((nv->value_int == COMBINED_PROGRAM_STOP) || (nv->value_int == COMBINED_PROGRAM_END));
+
+        // otherwise report values that have moved out of the deadband, unless reported too recently
+        if (!report && (fabs(current_value - e->last_value) > e->deadband)) {
+            if ((e->min_interval == 0) || ((now - e->last_report_ms) >= e->min_interval)) {
+                report = true;
+            } else {
+                held_back = true;               // changed, but has to wait for a later report
+            }
+        }
+
+        if (report) {
+            e->last_value = current_value;
+            e->last_report_ms = now;
+            sr.elements_sent++;
             if ((nv = nv->nx) == NULL) {        // should never be NULL unless SR length exceeds available buffer array
-                return (false); 
+                return (false);
             }
             has_data = true;
         } else {
@@ -424,7 +535,6 @@ static uint8_t _populate_filtered_status_report()
     return (has_data);
 }
 
-
 /****************************
  * END OF REPORT FUNCTIONS *
  ****************************/
@@ -443,15 +553,81 @@ static uint8_t _populate_filtered_status_report()
  * sr_set_sv() - set status report verbosity
  * sr_get_si() - get status report interval
  * sr_set_si() - set status report interval
+ * sr_set_se() - set a status report list element (seXX) - recompiles the plan
+ * sr_get_srd() - get the deadbands of the status report elements
+ * sr_set_srd() - set deadbands, e.g. {"srd":{"posx":0.01,"vel":5}}
+ * sr_get_srm() - get the minimum report intervals of the status report elements
+ * sr_set_srm() - set minimum report intervals in ms, e.g. {"srm":{"vel":250}}
+ *
+ *  srd and srm set elements that are already in the status report list (see sr), and
+ *  return the settings for the whole list.
  */
 
-stat_t sr_get(nvObj_t *nv) { return (_populate_unfiltered_status_report()); }
+stat_t sr_get(nvObj_t *nv) { return (_stream_unfiltered_status_report()); }
 stat_t sr_set(nvObj_t *nv) { return (sr_set_status_report(nv)); }
 
 stat_t sr_get_sv(nvObj_t *nv) { return(get_integer(nv, (uint8_t &)sr.status_report_verbosity)); }
 stat_t sr_set_sv(nvObj_t *nv) { return(set_integer(nv, (uint8_t &)sr.status_report_verbosity, SR_OFF, SR_VERBOSE)); }
 stat_t sr_get_si(nvObj_t *nv) { return(get_integer(nv, sr.status_report_interval)); }
 stat_t sr_set_si(nvObj_t *nv) { return(set_int32(nv, sr.status_report_interval, STATUS_REPORT_MIN_MS, STATUS_REPORT_MAX_MS)); }
+stat_t sr_set_se(nvObj_t *nv) { sr.plan_valid = false; return(set_int32(nv)); }
+
+static stat_t _stream_status_report_plan(index_t index, bool deadbands)
+{
+    if (!sr.plan_valid) { _compile_status_report_plan(); }
+    nvObj_t *nv = nv_reset_nv_list();
+    nv->valuetype = TYPE_PARENT;
+    strcpy(nv->token, cfgArray[index].token);
+    nv->index = index;
+    nv_stream_begin(nv);
+    nv = nv->nx;
+
+    for (uint8_t i=0; i<sr.plan_len; i++) {
+        nv_reset_nv(nv);
+        nv->index = index;                  // print and serialize as an srd or srm value
+        strcpy(nv->token, sr.plan[i].token);
+        if (deadbands) {
+            nv->value_flt = sr.plan[i].deadband;
+            nv->valuetype = TYPE_FLOAT;
+        } else {
+            nv->value_int = sr.plan[i].min_interval;
+            nv->valuetype = TYPE_INTEGER;
+        }
+        nv_stream_object(nv);
+    }
+    nv_stream_end(STAT_OK);
+    return (STAT_COMPLETE);
+}
+
+static stat_t _set_status_report_plan(nvObj_t *nv, bool deadbands)
+{
+    index_t index = nv->index;
+
+    for (uint8_t i=0; i<NV_STATUS_REPORT_LEN; i++) {
+        if (((nv = nv->nx) == NULL) || (nv->valuetype == TYPE_EMPTY)) {
+            break;
+        }
+        srPlanEntry_t *e = _status_report_plan_entry(nv->index);
+        if (e == NULL) {
+            return (STAT_BAD_STATUS_REPORT_SETTING);    // not in the status report
+        }
+        float value = (nv->valuetype == TYPE_FLOAT) ? nv->value_flt : (float)nv->value_int;
+        if (value < 0) {
+            return (STAT_INPUT_LESS_THAN_MIN_VALUE);
+        }
+        if (deadbands) {
+            e->deadband = value;
+        } else {
+            e->min_interval = (uint32_t)value;
+        }
+    }
+    return (_stream_status_report_plan(index, deadbands));
+}
+
+stat_t sr_get_srd(nvObj_t *nv) { return (_stream_status_report_plan(nv->index, true)); }
+stat_t sr_set_srd(nvObj_t *nv) { return (_set_status_report_plan(nv, true)); }
+stat_t sr_get_srm(nvObj_t *nv) { return (_stream_status_report_plan(nv->index, false)); }
+stat_t sr_set_srm(nvObj_t *nv) { return (_set_status_report_plan(nv, false)); }
 
 /*********************
  * TEXT MODE SUPPORT *
@@ -460,10 +636,14 @@ stat_t sr_set_si(nvObj_t *nv) { return(set_int32(nv, sr.status_report_interval,
 
 static const char fmt_sv[] = "[sv]  status report verbosity%6d [0=off,1=filtered,2=verbose]\n";
 static const char fmt_si[] = "[si]  status interval%14d ms\n";
+static const char fmt_srd[] = "[%s] status report deadband%14.4f\n";
+static const char fmt_srm[] = "[%s] status report interval%14d ms\n";
 
 void sr_print_sr(nvObj_t *nv) { _populate_unfiltered_status_report();}
 void sr_print_sv(nvObj_t *nv) { text_print(nv, fmt_sv);}
 void sr_print_si(nvObj_t *nv) { text_print(nv, fmt_si);}
+void sr_print_srd(nvObj_t *nv) { sprintf(cs.out_buf, fmt_srd, nv->token, (double)nv->value_flt); xio_writeline(cs.out_buf);}
+void sr_print_srm(nvObj_t *nv) { sprintf(cs.out_buf, fmt_srm, nv->token, (int)nv->value_int); xio_writeline(cs.out_buf);}
 
 #endif // __TEXT_MODE
 
@@ -547,7 +727,7 @@ stat_t qr_queue_report_callback()         // called by controller dispatcher
 
     qr.queue_report_requested = false;
 
-    char report[32];    // we know these reports can't be longer than 30 bytes
+    char report[40];    // 36 bytes at most: three 5 digit counts in the JSON form
 
     if (cs.comm_mode == TEXT_MODE) {
         if (qr.queue_report_verbosity == QR_SINGLE) {
@@ -678,7 +858,8 @@ uint8_t job_report_callback()
         // no-op, job_ids are client app state
         return (STAT_OK);
     }
-    sprintf(cs.out_buf, "{\"job\":[%lu,%lu,%lu,%lu]}\n", cfg.job_id[0], cfg.job_id[1], cfg.job_id[2], cfg.job_id[3] );
+    sprintf(cs.out_buf, "{\"job\":[%lu,%lu,%lu,%lu]}\n", (unsigned long)cfg.job_id[0], (unsigned long)cfg.job_id[1],
+                                                         (unsigned long)cfg.job_id[2], (unsigned long)cfg.job_id[3]);
     xio_writeline(cs.out_buf);
     return (STAT_OK);
 }
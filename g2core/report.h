@@ -57,6 +57,25 @@ typedef enum {                      // planner queue enable and verbosity
     QR_TRIPLE                       // queue depth reported for buffers, buffers added, buffered removed
 } qrVerbosity;
 
+/* Status report plan
+ *
+ *  The SR list (se00 - seXX) is compiled once into a plan, so generating a report doesn't
+ *  have to look anything up in cfgArray or rebuild the flattened tokens. Each element has
+ *  its own deadband and minimum interval for filtered reports. The deadband defaults to
+ *  the display precision of the element, the interval to 0 (report on every change).
+ *  Both are in the element's internal units and survive recompiling the plan, but are not
+ *  persisted. Set them with {"srd":{"posx":0.01}} and {"srm":{"vel":250}}.
+ */
+typedef struct srPlanEntry {
+    index_t index;                      // cfgArray index of the element
+    fptrCmd get;                        // cached getter from cfgArray
+    char token[TOKEN_LEN+1];            // flattened token, e.g. "posx"
+    float deadband;                     // filtered reports skip changes smaller than this
+    uint32_t min_interval;              // ...and report the element no more often than this (ms)
+    uint32_t last_report_ms;            // SysTick of the last filtered report of this element
+    float last_value;                   // value in the last filtered report
+} srPlanEntry_t;
+
 typedef struct srSingleton {
 
     /*** config values (PUBLIC) ***/
@@ -69,7 +88,15 @@ typedef struct srSingleton {
     index_t stat_index;                                 // table index value for stat - determined during initialization
     uint8_t throttle_counter;                           // slow down SRs when in a constrained time (not phat_city)
     index_t status_report_list[NV_STATUS_REPORT_LEN];   // status report elements to report
-    float status_report_value[NV_STATUS_REPORT_LEN];    // previous values for filtered reporting
+
+    bool plan_valid;                                    // false if the list changed since the plan was compiled
+    uint8_t plan_len;                                   // elements in the plan
+    srPlanEntry_t plan[NV_STATUS_REPORT_LEN];           // compiled status report list
+
+    // cost of report generation - read only as srn, srr, srf
+    uint32_t reports_sent;                              // reports generated, filtered or not
+    uint32_t elements_read;                             // getter calls made for reports
+    uint32_t elements_sent;                             // elements that made it into a report
 
 } srSingleton_t;
 
@@ -104,7 +131,7 @@ void rpt_print_loading_configs_message(void);
 void rpt_print_initializing_message(void);
 void rpt_print_system_ready_message(void);
 
-void sr_init_status_report(void);
+void sr_init_status_report(bool reset_list);
 stat_t sr_set_status_report(nvObj_t *nv);
 stat_t sr_request_status_report(cmStatusReportRequest request_type);
 stat_t sr_status_report_callback(void);
@@ -117,6 +144,11 @@ stat_t sr_get_sv(nvObj_t *nv);
 stat_t sr_set_sv(nvObj_t *nv);
 stat_t sr_get_si(nvObj_t *nv);
 stat_t sr_set_si(nvObj_t *nv);
+stat_t sr_set_se(nvObj_t *nv);
+stat_t sr_get_srd(nvObj_t *nv);
+stat_t sr_set_srd(nvObj_t *nv);
+stat_t sr_get_srm(nvObj_t *nv);
+stat_t sr_set_srm(nvObj_t *nv);
 
 void qr_init_queue_report(void);
 void qr_request_queue_report(int8_t buffers);
@@ -137,6 +169,8 @@ stat_t qr_set_qv(nvObj_t *nv);
     void sr_print_sr(nvObj_t *nv);
     void sr_print_si(nvObj_t *nv);
     void sr_print_sv(nvObj_t *nv);
+    void sr_print_srd(nvObj_t *nv);
+    void sr_print_srm(nvObj_t *nv);
     void qr_print_qv(nvObj_t *nv);
     void qr_print_qr(nvObj_t *nv);
     void qr_print_qi(nvObj_t *nv);
@@ -147,6 +181,8 @@ stat_t qr_set_qv(nvObj_t *nv);
     #define sr_print_sr tx_print_stub
     #define sr_print_si tx_print_stub
     #define sr_print_sv tx_print_stub
+    #define sr_print_srd tx_print_stub
+    #define sr_print_srm tx_print_stub
     #define qr_print_qv tx_print_stub
     #define qr_print_qr tx_print_stub
     #define qr_print_qi tx_print_stub
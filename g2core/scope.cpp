@@ -0,0 +1,379 @@
+/*
+ * scope.cpp - triggered motion capture buffer ("scope mode")
+ * This file is part of the g2core project
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, you may use this file as part of a software library without
+ * restriction. Specifically, if other files instantiate templates or use macros or
+ * inline functions from this file, or you compile this file and link it with  other
+ * files to produce an executable, this file does not by itself cause the resulting
+ * executable to be covered by the GNU General Public License. This exception does not
+ * however invalidate any other reasons why the executable file might be covered by the
+ * GNU General Public License.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "g2core.h"
+#include "config.h"
+#include "scope.h"
+#include "canonical_machine.h"
+#include "controller.h"
+#include "planner.h"
+#include "stepper.h"
+#include "text_parser.h"
+#include "util.h"
+#include "xio.h"
+
+/**** Allocate Structures ****/
+
+scScope_t sc;
+
+/************************************************************************************
+ **** CODE **************************************************************************
+ ************************************************************************************/
+
+/*
+ * scope_init() - clear the capture. Config values are loaded by config_init().
+ */
+
+void scope_init()
+{
+    memset(&sc, 0, sizeof(sc));
+}
+
+static void _arm()
+{
+    sc.state = SCOPE_IDLE;                  // keep the executor out while the capture is cleared
+    sc.pending = false;
+    sc.write = 0;
+    sc.recorded = 0;
+    sc.before = 0;
+    sc.after = 0;
+    sc.state = SCOPE_ARMED;
+}
+
+/*
+ * _fire() - mark the sample at index as the trigger
+ */
+
+static void _fire(uint8_t index, uint8_t cause)
+{
+    sc.cause = cause;
+    sc.trigger = index;
+    sc.before = min((uint8_t)(sc.recorded - 1), sc.pre);
+    sc.after = 1;                           // the trigger sample is the first post-trigger sample
+    sc.pending = false;
+    sc.state = (sc.after >= sc.post) ? SCOPE_DONE : SCOPE_TRIGGERED;
+}
+
+static bool _triggered(uint8_t *cause)
+{
+    if (sc.pending) {
+        *cause = sc.pending_cause;
+        return (true);
+    }
+    *cause = sc.mode;
+    switch (sc.mode) {
+        case SCOPE_TRIGGER_LINE:     { return (mr->gm.linenum == sc.line); }
+        case SCOPE_TRIGGER_FEEDHOLD: { return (cm->hold_state != FEEDHOLD_OFF); }
+        case SCOPE_TRIGGER_FOLLOWING_ERROR: {
+            for (uint8_t m=0; m<MOTORS; m++) {
+                if (fabs(mr->following_error[m]) > sc.following_error) {
+                    return (true);
+                }
+            }
+            return (false);
+        }
+        default: { return (false); }        // alarm and manual triggers arrive as pending
+    }
+}
+
+/*
+ * scope_sample() - record the segment just prepared - called from the segment executor
+ *
+ *  Runs at exec interrupt level. travel_steps is the segment's travel as passed to
+ *  st_prep_line(); everything else is read from mr.
+ */
+
+void scope_sample(const float travel_steps[])
+{
+    if ((sc.state != SCOPE_ARMED) && (sc.state != SCOPE_TRIGGERED)) {
+        return;
+    }
+    uint8_t index = sc.write;
+    scSample_t *s = &sc.buf[index];
+
+    s->line = mr->gm.linenum;
+    s->section = mr->section;
+    s->hold_state = cm->hold_state;
+    s->prep_slack = min(st_get_dda_ticks_remaining(), (uint32_t)UINT16_MAX);
+    s->segment_velocity = mr->segment_velocity;
+    s->forward_diff[0] = mr->forward_diff_1;
+    s->forward_diff[1] = mr->forward_diff_2;
+    s->forward_diff[2] = mr->forward_diff_3;
+    s->forward_diff[3] = mr->forward_diff_4;
+    s->forward_diff[4] = mr->forward_diff_5;
+    for (uint8_t m=0; m<MOTORS; m++) {
+        s->travel_steps[m] = travel_steps[m];
+        s->following_error[m] = mr->following_error[m];
+    }
+    sc.write = (index + 1) % SCOPE_BUFFER_LEN;
+    if (sc.recorded < SCOPE_BUFFER_LEN) {
+        sc.recorded++;
+    }
+
+    if (sc.state == SCOPE_TRIGGERED) {      // pre + post <= SCOPE_BUFFER_LEN, so the
+        if (++sc.after >= sc.post) {        // pre-trigger samples are never overwritten
+            sc.state = SCOPE_DONE;
+        }
+        return;
+    }
+    uint8_t cause;
+    if (_triggered(&cause)) {
+        _fire(index, cause);
+    }
+}
+
+/*
+ * scope_alarm() - tell an armed alarm-triggered capture that an alarm or shutdown occurred
+ */
+
+void scope_alarm()
+{
+    if ((sc.state == SCOPE_ARMED) && (sc.mode == SCOPE_TRIGGER_ALARM)) {
+        sc.pending_cause = SCOPE_TRIGGER_ALARM;
+        sc.pending = true;
+    }
+}
+
+/*
+ * scope_callback() - main loop callback to finish captures once motion has stopped
+ *
+ *  A pending trigger with no motion running fires on the last sample recorded, and a
+ *  capture still waiting for post-trigger samples is frozen with what it has. The
+ *  executor can't run while the runtime is idle, but a new move could start between
+ *  the test and the update, so the update is done with interrupts off.
+ */
+
+stat_t scope_callback()
+{
+    if ((sc.state != SCOPE_TRIGGERED) && !((sc.state == SCOPE_ARMED) && sc.pending)) {
+        return (STAT_OK);
+    }
+    if (mp_get_runtime_busy()) {
+        return (STAT_OK);
+    }
+    __disable_irq();
+    if (sc.state == SCOPE_TRIGGERED) {
+        sc.state = SCOPE_DONE;
+    } else if (sc.state == SCOPE_ARMED) {
+        if (sc.recorded == 0) {
+            sc.cause = sc.pending_cause;
+            sc.pending = false;
+            sc.state = SCOPE_DONE;          // an empty capture
+        } else {
+            _fire((sc.write + SCOPE_BUFFER_LEN - 1) % SCOPE_BUFFER_LEN, sc.pending_cause);
+            sc.state = SCOPE_DONE;
+        }
+    }
+    __enable_irq();
+    return (STAT_OK);
+}
+
+/***********************************************************************************
+ * CONFIGURATION AND INTERFACE FUNCTIONS
+ * Functions to get and set variables from the cfgArray table
+ ***********************************************************************************/
+
+/*
+ * sc_get_scs() - get capture state - see scState
+ * sc_set_scs() - 0 = disarm, 1 = arm (clears the capture), 2 = trigger now
+ * sc_get_scm() - get trigger mode
+ * sc_set_scm() - set trigger mode - see scTrigger
+ * sc_get_scl() - get trigger line number
+ * sc_set_scl() - set trigger line number
+ * sc_get_scf() - get following error trigger threshold
+ * sc_set_scf() - set following error trigger threshold in steps
+ * sc_get_scp() - get number of pre-trigger samples
+ * sc_set_scp() - set number of pre-trigger samples
+ * sc_get_sca() - get number of post-trigger samples, including the trigger sample
+ * sc_set_sca() - set number of post-trigger samples
+ *
+ *  Changing the capture setup while armed would leave a capture that doesn't match its
+ *  settings, so it disarms the scope. pre + post may not exceed SCOPE_BUFFER_LEN.
+ */
+
+stat_t sc_get_scs(nvObj_t *nv) { return (get_integer(nv, sc.state)); }
+stat_t sc_set_scs(nvObj_t *nv)
+{
+    switch (nv->value_int) {
+        case 0: { sc.state = SCOPE_IDLE; break; }
+        case 1: { _arm(); break; }
+        case 2: {
+            if (sc.state != SCOPE_ARMED) {
+                return (STAT_COMMAND_NOT_ACCEPTED);
+            }
+            sc.pending_cause = SCOPE_TRIGGER_MANUAL;
+            sc.pending = true;
+            break;
+        }
+        default: { return (STAT_INPUT_VALUE_RANGE_ERROR); }
+    }
+    return (get_integer(nv, sc.state));
+}
+
+stat_t sc_get_scm(nvObj_t *nv) { return (get_integer(nv, sc.mode)); }
+stat_t sc_set_scm(nvObj_t *nv)
+{
+    ritorno(set_integer(nv, sc.mode, SCOPE_TRIGGER_MANUAL, SCOPE_TRIGGER_FOLLOWING_ERROR));
+    sc.state = SCOPE_IDLE;
+    return (STAT_OK);
+}
+
+stat_t sc_get_scl(nvObj_t *nv) { return (get_integer(nv, sc.line)); }
+stat_t sc_set_scl(nvObj_t *nv) { return (set_int32(nv, sc.line, 0, INT32_MAX)); }
+stat_t sc_get_scf(nvObj_t *nv) { return (get_float(nv, sc.following_error)); }
+stat_t sc_set_scf(nvObj_t *nv) { return (set_float_range(nv, sc.following_error, 0, 1000000)); }
+
+stat_t sc_get_scp(nvObj_t *nv) { return (get_integer(nv, sc.pre)); }
+stat_t sc_set_scp(nvObj_t *nv)
+{
+    ritorno(set_integer(nv, sc.pre, 0, SCOPE_BUFFER_LEN - sc.post));
+    sc.state = SCOPE_IDLE;
+    return (STAT_OK);
+}
+
+stat_t sc_get_sca(nvObj_t *nv) { return (get_integer(nv, sc.post)); }
+stat_t sc_set_sca(nvObj_t *nv)
+{
+    ritorno(set_integer(nv, sc.post, 1, SCOPE_BUFFER_LEN - sc.pre));
+    sc.state = SCOPE_IDLE;
+    return (STAT_OK);
+}
+
+/*
+ * sc_get_scd() - stream the capture as {"scd":{"cause":..,"trg":..,"n":..,"s0":[..],..}}
+ *
+ *  Only a finished capture (scs = 3) can be read, and only as the response to a command
+ *  line (not from the exec). Samples are sent oldest first, one array per sample in the
+ *  order given in scope.h. The response is printed here, so this returns STAT_COMPLETE
+ *  to keep the caller from printing it again.
+ */
+
+static void _stream_integer(nvObj_t *nv, const char *token, int32_t value)
+{
+    strcpy(nv->token, token);
+    nv->valuetype = TYPE_INTEGER;
+    nv->value_int = value;
+    nv_stream_object(nv);
+}
+
+// an int32 is at most 11 chars and a float from floattoa() at most 21, each plus a comma
+#define SCOPE_INT_FIELD_LEN 12
+#define SCOPE_FLOAT_FIELD_LEN 22
+
+static char *_put_float(char *p, const char *end, float value, uint8_t precision)
+{
+    p += floattoa(p, value, precision, (end - p) - 2);  // leave room for the comma and the NUL
+    *p++ = ',';
+    return (p);
+}
+
+static void _stream_sample(nvObj_t *nv, uint8_t n, const scSample_t *s)
+{
+    char buf[(4 * SCOPE_INT_FIELD_LEN) + ((6 + 2*MOTORS) * SCOPE_FLOAT_FIELD_LEN) + 1];
+    const char *end = buf + sizeof(buf);
+    char *p = buf;
+
+    p += inttoa(p, s->line);        *p++ = ',';
+    p += inttoa(p, s->section);     *p++ = ',';
+    p += inttoa(p, s->hold_state);  *p++ = ',';
+    p += inttoa(p, (int32_t)((s->prep_slack * 1000000.0) / FREQUENCY_DDA)); *p++ = ',';
+    p = _put_float(p, end, s->segment_velocity, 3);
+    for (uint8_t i=0; i<5; i++) {
+        p = _put_float(p, end, s->forward_diff[i], 6);
+    }
+    for (uint8_t m=0; m<MOTORS; m++) {
+        p = _put_float(p, end, s->travel_steps[m], 3);
+    }
+    for (uint8_t m=0; m<MOTORS; m++) {
+        p = _put_float(p, end, s->following_error[m], 3);
+    }
+    *(p-1) = NUL;                           // overwrite the trailing comma
+
+    uint16_t string_wp = nvStr.wp;
+    nv->token[0] = 's';
+    inttoa(&nv->token[1], n);
+    nv->valuetype = TYPE_ARRAY;
+    nv->value_int = 6 + 4 + 2*MOTORS;       // array element count
+    nv_copy_string(nv, buf);
+    nv_stream_object(nv);
+    nvStr.wp = string_wp;                   // the sample's string has been sent
+}
+
+stat_t sc_get_scd(nvObj_t *nv)
+{
+    if (sc.state != SCOPE_DONE) {
+        return (STAT_COMMAND_NOT_ACCEPTED);
+    }
+    uint8_t count = sc.before + sc.after;
+    uint8_t first = (sc.trigger + SCOPE_BUFFER_LEN - sc.before) % SCOPE_BUFFER_LEN;
+    index_t index = nv->index;
+
+    nv->valuetype = TYPE_PARENT;
+    if (!nv_stream_begin(nv)) {
+        return (STAT_COMMAND_NOT_ACCEPTED); // a capture is too big for the nv list
+    }
+    nvObj_t *child = nv->nx;
+    nv_reset_nv(child);
+    child->index = index;                   // children print with sc_print_scd()
+    _stream_integer(child, "cause", sc.cause);
+    _stream_integer(child, "trg", (count == 0) ? -1 : sc.before);
+    _stream_integer(child, "n", count);
+    for (uint8_t i=0; i<count; i++) {
+        _stream_sample(child, i, &sc.buf[(first + i) % SCOPE_BUFFER_LEN]);
+    }
+    nv_stream_end(STAT_OK);
+    return (STAT_COMPLETE);
+}
+
+/*********************
+ * TEXT MODE SUPPORT *
+ *********************/
+#ifdef __TEXT_MODE
+
+static const char fmt_scs[] = "[scs] scope state%20d [0=idle,1=armed,2=triggered,3=done]\n";
+static const char fmt_scm[] = "[scm] scope trigger mode%13d [0=manual,1=line,2=alarm,3=feedhold,4=following error]\n";
+static const char fmt_scl[] = "[scl] scope trigger line%13d\n";
+static const char fmt_scf[] = "[scf] scope following error%10.3f steps\n";
+static const char fmt_scp[] = "[scp] scope pre-trigger samples%6d\n";
+static const char fmt_sca[] = "[sca] scope post-trigger samples%5d\n";
+
+void sc_print_scs(nvObj_t *nv) { text_print(nv, fmt_scs);}
+void sc_print_scm(nvObj_t *nv) { text_print(nv, fmt_scm);}
+void sc_print_scl(nvObj_t *nv) { text_print(nv, fmt_scl);}
+void sc_print_scf(nvObj_t *nv) { text_print(nv, fmt_scf);}
+void sc_print_scp(nvObj_t *nv) { text_print(nv, fmt_scp);}
+void sc_print_sca(nvObj_t *nv) { text_print(nv, fmt_sca);}
+
+void sc_print_scd(nvObj_t *nv)
+{
+    if (nv->valuetype == TYPE_ARRAY) {
+        sprintf(cs.out_buf, "[%s] %s\n", nv->token, *nv->stringp);
+    } else {
+        sprintf(cs.out_buf, "[%s] %ld\n", nv->token, (long)nv->value_int);
+    }
+    xio_writeline(cs.out_buf);
+}
+
+#endif // __TEXT_MODE
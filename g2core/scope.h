@@ -0,0 +1,160 @@
+/*
+ * scope.h - triggered motion capture buffer ("scope mode")
+ * This file is part of the g2core project
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, you may use this file as part of a software library without
+ * restriction. Specifically, if other files instantiate templates or use macros or
+ * inline functions from this file, or you compile this file and link it with  other
+ * files to produce an executable, this file does not by itself cause the resulting
+ * executable to be covered by the GNU General Public License. This exception does not
+ * however invalidate any other reasons why the executable file might be covered by the
+ * GNU General Public License.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/*
+ * SCOPE MODE
+ *
+ *  A capture buffer for post-mortem analysis of the segment executor - for when a stall
+ *  or lost steps can't be reproduced under a debugger. Once armed the executor records
+ *  every segment into a circular buffer. When the trigger fires the buffer keeps the
+ *  last scp samples before the trigger and records sca samples from the trigger on,
+ *  then freezes until it is read and re-armed. If motion stops before sca samples are
+ *  taken the capture freezes with what it has.
+ *
+ *      {"scm":4, "scf":2.5, "scp":8, "sca":24}     trigger on 2.5 steps of following error
+ *      {"scs":1}                                   arm (clears the previous capture)
+ *      {"scs":null}                                0=idle, 1=armed, 2=triggered, 3=done
+ *      {"scs":0}                                   disarm
+ *      {"scd":null}                                download the capture
+ *
+ *  Trigger modes (scm): 0=manual, 1=line number reached (scl), 2=alarm or shutdown,
+ *  3=feedhold, 4=following error of any motor over scf steps. In any mode {"scs":2}
+ *  triggers the capture by hand.
+ *
+ *  The download is {"scd":{"cause":m, "trg":i, "n":n, "s0":[...], ... "sN":[...]}} with the
+ *  samples oldest first and the trigger at sample trg. Each sample array holds:
+ *
+ *      line, section, hold_state, prep_slack_us, segment_velocity,
+ *      forward_diff_1 ... forward_diff_5, travel_steps[MOTORS], following_error[MOTORS]
+ *
+ *  prep_slack_us is how much of the running segment was left when this segment had been
+ *  prepared - 0 means the loader had run dry (an underrun).
+ */
+
+#ifndef SCOPE_H_ONCE
+#define SCOPE_H_ONCE
+
+#include "hardware.h"  // for MOTORS
+
+/**** Configs and Constants ****/
+
+#ifndef SCOPE_BUFFER_LEN
+#define SCOPE_BUFFER_LEN    32              // samples - each is 40 + 8*MOTORS bytes
+#endif
+
+typedef enum {
+    SCOPE_IDLE = 0,                         // not recording
+    SCOPE_ARMED,                            // recording, waiting for the trigger
+    SCOPE_TRIGGERED,                        // recording post-trigger samples
+    SCOPE_DONE                              // capture is frozen
+} scState;
+
+typedef enum {
+    SCOPE_TRIGGER_MANUAL = 0,
+    SCOPE_TRIGGER_LINE,
+    SCOPE_TRIGGER_ALARM,
+    SCOPE_TRIGGER_FEEDHOLD,
+    SCOPE_TRIGGER_FOLLOWING_ERROR
+} scTrigger;
+
+/**** Structures ****/
+
+typedef struct scSample {
+    int32_t line;
+    uint8_t section;
+    uint8_t hold_state;
+    uint16_t prep_slack;                    // DDA ticks
+    float segment_velocity;
+    float forward_diff[5];
+    float travel_steps[MOTORS];
+    float following_error[MOTORS];
+} scSample_t;
+
+typedef struct scScope {
+    // config values
+    uint8_t mode;                           // scTrigger to fire on
+    int32_t line;                           // line number for SCOPE_TRIGGER_LINE
+    float following_error;                  // steps for SCOPE_TRIGGER_FOLLOWING_ERROR
+    uint8_t pre;                            // samples kept before the trigger
+    uint8_t post;                           // samples recorded from the trigger on
+
+    // capture state
+    volatile uint8_t state;                 // scState
+    volatile bool pending;                  // trigger requested outside the executor (alarm, manual)
+    volatile uint8_t pending_cause;         // scTrigger of the pending request
+    uint8_t cause;                          // scTrigger that fired
+    uint8_t write;                          // next sample to write
+    uint8_t recorded;                       // samples in the buffer, up to SCOPE_BUFFER_LEN
+    uint8_t trigger;                        // buffer index of the trigger sample
+    uint8_t before;                         // samples kept before the trigger (<= pre)
+    uint8_t after;                          // samples recorded from the trigger on
+    scSample_t buf[SCOPE_BUFFER_LEN];
+} scScope_t;
+
+extern scScope_t sc;
+
+/**** Function Prototypes ****/
+
+void scope_init(void);
+stat_t scope_callback(void);
+void scope_sample(const float travel_steps[]);
+void scope_alarm(void);
+
+stat_t sc_get_scs(nvObj_t *nv);
+stat_t sc_set_scs(nvObj_t *nv);
+stat_t sc_get_scm(nvObj_t *nv);
+stat_t sc_set_scm(nvObj_t *nv);
+stat_t sc_get_scl(nvObj_t *nv);
+stat_t sc_set_scl(nvObj_t *nv);
+stat_t sc_get_scf(nvObj_t *nv);
+stat_t sc_set_scf(nvObj_t *nv);
+stat_t sc_get_scp(nvObj_t *nv);
+stat_t sc_set_scp(nvObj_t *nv);
+stat_t sc_get_sca(nvObj_t *nv);
+stat_t sc_set_sca(nvObj_t *nv);
+stat_t sc_get_scd(nvObj_t *nv);
+
+#ifdef __TEXT_MODE
+
+    void sc_print_scs(nvObj_t *nv);
+    void sc_print_scm(nvObj_t *nv);
+    void sc_print_scl(nvObj_t *nv);
+    void sc_print_scf(nvObj_t *nv);
+    void sc_print_scp(nvObj_t *nv);
+    void sc_print_sca(nvObj_t *nv);
+    void sc_print_scd(nvObj_t *nv);
+
+#else
+
+    #define sc_print_scs tx_print_stub
+    #define sc_print_scm tx_print_stub
+    #define sc_print_scl tx_print_stub
+    #define sc_print_scf tx_print_stub
+    #define sc_print_scp tx_print_stub
+    #define sc_print_sca tx_print_stub
+    #define sc_print_scd tx_print_stub
+
+#endif // __TEXT_MODE
+
+#endif  // End of include guard: SCOPE_H_ONCE
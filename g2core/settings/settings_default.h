@@ -82,7 +82,7 @@
 #endif
 
 #ifndef SPINDLE_MODE
-#define SPINDLE_MODE                1       // {spmo; 0=diabled, 1=plan to stop, 2=continuous
+#define SPINDLE_MODE                1       // {spmo; 0=diabled, 1=plan to stop, 2=continuous, 3=laser
 #endif
 
 #ifndef SPINDLE_ENABLE_POLARITY
@@ -113,6 +113,14 @@
 #define SPINDLE_SPEED_MAX     1000000.0     // {spsm:
 #endif
 
+#ifndef SPINDLE_LASER_POWER_MIN
+#define SPINDLE_LASER_POWER_MIN     0.0     // {splm: M4 laser power floor as a fraction of S
+#endif
+
+#ifndef SPINDLE_LASER_OVERSCAN
+#define SPINDLE_LASER_OVERSCAN      0.0     // {spov: raster lead-in and lead-out in mm, 0 for none
+#endif
+
 #ifndef COOLANT_MIST_POLARITY
 #define COOLANT_MIST_POLARITY       1       // {comp: 0=active low, 1=active high
 #endif
@@ -189,6 +197,38 @@
 //#define STATUS_REPORT_DEFAULTS "line","vel","mpox","mpoy","mpoz","mpoa","coor","ofsa","ofsx","ofsy","ofsz","dist","unit","stat","homz","homy","homx","momo"
 #endif
 
+#ifndef TELEMETRY_RATE
+#define TELEMETRY_RATE              0                       // {tmr: samples per second of motion - 0 disables telemetry
+#endif
+
+#ifndef TELEMETRY_FIELDS
+#define TELEMETRY_FIELDS            TM_FIELDS_ALL           // {tmf: bitmask - see tmField in telemetry.h
+#endif
+
+#ifndef TELEMETRY_CHANNEL                                   // {tmc: xio channel for telemetry frames (ioN numbering)
+#if USB_SERIAL_PORTS_EXPOSED == 2
+#define TELEMETRY_CHANNEL           3                       // the second USB port, leaving the first for control
+#else
+#define TELEMETRY_CHANNEL           2                       // the USB port
+#endif
+#endif
+
+#ifndef SCOPE_TRIGGER_MODE
+#define SCOPE_TRIGGER_MODE          SCOPE_TRIGGER_MANUAL    // {scm: see scTrigger in scope.h
+#endif
+
+#ifndef SCOPE_FOLLOWING_ERROR
+#define SCOPE_FOLLOWING_ERROR       2.0                     // {scf: following error trigger threshold in steps
+#endif
+
+#ifndef SCOPE_PRE_TRIGGER_SAMPLES
+#define SCOPE_PRE_TRIGGER_SAMPLES   8                       // {scp: segments kept before the trigger
+#endif
+
+#ifndef SCOPE_POST_TRIGGER_SAMPLES
+#define SCOPE_POST_TRIGGER_SAMPLES  24                      // {sca: segments recorded from the trigger on - scp + sca <= SCOPE_BUFFER_LEN
+#endif
+
 #ifndef MARLIN_COMPAT_ENABLED
 #define MARLIN_COMPAT_ENABLED       false                   // boolean, either true or false
 #endif
@@ -1100,6 +1140,27 @@
 #ifndef H1_DEFAULT_D
 #define H1_DEFAULT_D                400.0
 #endif
+#ifndef H1_DEFAULT_MODEL_ENABLE
+#define H1_DEFAULT_MODEL_ENABLE     false
+#endif
+#ifndef H1_DEFAULT_MODEL_POWER
+#define H1_DEFAULT_MODEL_POWER      40.0     // heater power (W)
+#endif
+#ifndef H1_DEFAULT_MODEL_CAPACITY
+#define H1_DEFAULT_MODEL_CAPACITY   16.7     // heat capacity of the heater block (J/K)
+#endif
+#ifndef H1_DEFAULT_MODEL_LOSS
+#define H1_DEFAULT_MODEL_LOSS       0.068    // loss to ambient (W/K)
+#endif
+#ifndef H1_DEFAULT_MODEL_FAN_LOSS
+#define H1_DEFAULT_MODEL_FAN_LOSS   0.029    // extra loss with the part fan full on (W/K)
+#endif
+#ifndef H1_DEFAULT_MODEL_FILAMENT
+#define H1_DEFAULT_MODEL_FILAMENT   0.0056   // heat capacity of 1mm of 1.75mm filament (J/K)
+#endif
+#ifndef H1_DEFAULT_MODEL_SENSOR
+#define H1_DEFAULT_MODEL_SENSOR     0.22     // rate the sensor follows the block (1/s)
+#endif
 
 #ifndef H2_DEFAULT_ENABLE
 #define H2_DEFAULT_ENABLE           false
@@ -1113,6 +1174,27 @@
 #ifndef H2_DEFAULT_D
 #define H2_DEFAULT_D                400.0
 #endif
+#ifndef H2_DEFAULT_MODEL_ENABLE
+#define H2_DEFAULT_MODEL_ENABLE     false
+#endif
+#ifndef H2_DEFAULT_MODEL_POWER
+#define H2_DEFAULT_MODEL_POWER      40.0     // heater power (W)
+#endif
+#ifndef H2_DEFAULT_MODEL_CAPACITY
+#define H2_DEFAULT_MODEL_CAPACITY   16.7     // heat capacity of the heater block (J/K)
+#endif
+#ifndef H2_DEFAULT_MODEL_LOSS
+#define H2_DEFAULT_MODEL_LOSS       0.068    // loss to ambient (W/K)
+#endif
+#ifndef H2_DEFAULT_MODEL_FAN_LOSS
+#define H2_DEFAULT_MODEL_FAN_LOSS   0.029    // extra loss with the part fan full on (W/K)
+#endif
+#ifndef H2_DEFAULT_MODEL_FILAMENT
+#define H2_DEFAULT_MODEL_FILAMENT   0.0056   // heat capacity of 1mm of 1.75mm filament (J/K)
+#endif
+#ifndef H2_DEFAULT_MODEL_SENSOR
+#define H2_DEFAULT_MODEL_SENSOR     0.22     // rate the sensor follows the block (1/s)
+#endif
 
 #ifndef H3_DEFAULT_ENABLE
 #define H3_DEFAULT_ENABLE           false
@@ -1126,6 +1208,27 @@
 #ifndef H3_DEFAULT_D
 #define H3_DEFAULT_D                400.0
 #endif
+#ifndef H3_DEFAULT_MODEL_ENABLE
+#define H3_DEFAULT_MODEL_ENABLE     false
+#endif
+#ifndef H3_DEFAULT_MODEL_POWER
+#define H3_DEFAULT_MODEL_POWER      200.0    // heater power (W)
+#endif
+#ifndef H3_DEFAULT_MODEL_CAPACITY
+#define H3_DEFAULT_MODEL_CAPACITY   400.0    // heat capacity of the bed (J/K)
+#endif
+#ifndef H3_DEFAULT_MODEL_LOSS
+#define H3_DEFAULT_MODEL_LOSS       1.5      // loss to ambient (W/K)
+#endif
+#ifndef H3_DEFAULT_MODEL_FAN_LOSS
+#define H3_DEFAULT_MODEL_FAN_LOSS   0.0      // the part fan is not modeled for the bed
+#endif
+#ifndef H3_DEFAULT_MODEL_FILAMENT
+#define H3_DEFAULT_MODEL_FILAMENT   0.0      // no filament through the bed
+#endif
+#ifndef H3_DEFAULT_MODEL_SENSOR
+#define H3_DEFAULT_MODEL_SENSOR     0.1      // rate the sensor follows the bed (1/s)
+#endif
 
 // *** DEFAULT COORDINATE SYSTEM OFFSETS ***
 
@@ -41,6 +41,9 @@
 #define HARD_LIMIT_ENABLE           0       // 0=off, 1=on
 #define SAFETY_INTERLOCK_ENABLE     1       // 0=off, 1=on
 
+#define SPINDLE_MODE                3       // laser - power set per segment from S, M3 and M4
+#define SPINDLE_LASER_POWER_MIN     0.10    // M4 power floor as a fraction of S
+#define SPINDLE_LASER_OVERSCAN      2.0     // raster lead-in and lead-out in mm
 #define SPINDLE_ENABLE_POLARITY     1       // 0=active low, 1=active high
 #define SPINDLE_DIR_POLARITY        0       // 0=clockwise is low, 1=clockwise is high
 #define SPINDLE_PAUSE_ON_HOLD       true
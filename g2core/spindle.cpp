@@ -44,6 +44,7 @@ spSpindle_t spindle;
 /**** Static functions ****/
 
 static float _get_spindle_pwm (spSpindle_t &_spindle, pwmControl_t &_pwm);
+static float _get_laser_pwm (float speed);
 
 #define SPINDLE_DIRECTION_ASSERT \
     if ((spindle.direction < SPINDLE_CW) || (spindle.direction > SPINDLE_CCW)) { \
@@ -238,7 +239,17 @@ stat_t spindle_control_sync(spControl control)  // uses spControl arg: OFF, CW,
     if ((control == SPINDLE_PAUSE) && (!spindle.pause_enable)) {
         return (STAT_OK);
     }
-    
+
+    // In laser mode M3, M4 and M5 ride along with the moves in the Gcode model and are
+    // applied per segment. PAUSE and RESUME are not needed as the laser goes off whenever
+    // motion stops and comes back on with the next segment.
+    if (spindle.mode == SPINDLE_LASER) {
+        if (control <= SPINDLE_CCW) {
+            cm->gm.spindle_control = control;
+        }
+        return (STAT_OK);
+    }
+
     // queue the spindle control
     float value[] = { (float)control };
     mp_queue_command(_exec_spindle_control, value, nullptr);
@@ -248,7 +259,7 @@ stat_t spindle_control_sync(spControl control)  // uses spControl arg: OFF, CW,
 /****************************************************************************************
  * _exec_spindle_speed()     - actually execute the spindle speed command
  * spindle_speed_immediate() - execute spindle speed change immediately
- * spindle_speed_sync()      - queue a spindle speed change to the planner buffer
+ * spindle_speed_sync()      - queue or defer a spindle speed change to the planner
  *
  *  Setting S0 is considered as turning spindle off. Setting S to non-zero from S0
  *  will enable a spinup delay if spinups are npn-zero.
@@ -278,19 +289,91 @@ stat_t spindle_speed_immediate(float speed)
     ritorno(_casey_jones(speed));
     float value[] = { speed };
     _exec_spindle_speed(value, nullptr);
+    cm->gm.spindle_speed = speed;           // keep the model in step for spindle_speed_sync()
     return (STAT_OK);
 }
 
 stat_t spindle_speed_sync(float speed)
 {
     ritorno(_casey_jones(speed));
+    if (spindle.mode == SPINDLE_LASER) {    // set in the model so S changes don't stop the planner
+        cm->gm.spindle_speed = speed;
+        return (STAT_OK);
+    }
+    // A change of speed while the spindle is already turning is deferred to the next block
+    // so the planner doesn't stop for it. From or to S0 it's queued, as spinup needs a stop.
     float value[] = { speed };
-    mp_queue_command(_exec_spindle_speed, value, nullptr);
+    if (fp_NOT_ZERO(cm->gm.spindle_speed) && fp_NOT_ZERO(speed)) {
+        mp_defer_command(_exec_spindle_speed, value, nullptr);
+    } else {
+        mp_queue_command(_exec_spindle_speed, value, nullptr);
+    }
+    cm->gm.spindle_speed = speed;
     return (STAT_OK);
 }
 
+/****************************************************************************************
+ * spindle_laser_duty()  - return PWM phase for a segment, or SPINDLE_LASER_NONE if not a laser
+ * spindle_laser_output() - set the laser enable and PWM, return true if firing - stepper loader
+ * spindle_laser_off()    - turn off the laser - stepper loader
+ *
+ *  In laser mode S, M3, M4 and M5 are carried in the Gcode state of each move and the
+ *  power is set as each segment is loaded, so it changes exactly where the motion does.
+ *  The segment executor calls spindle_laser_duty() with the segment velocity and the
+ *  cruise velocity of the block:
+ *
+ *    - M5, S0, traverses and probes fire nothing
+ *    - M3 is constant power - S is output as programmed
+ *    - M4 is dynamic power - S is scaled by velocity / cruise velocity so the energy per
+ *      unit length stays the same through acceleration and deceleration. The scale is
+ *      floored at {splm:} so corners and very short moves still mark.
+ *
+ *  Power scales S further - it's the raster pixel value over the segment [0..1], or 1.
+ *  Speed maps to phase through the PWM 1 clockwise speed and phase ranges for both M3 and M4.
+ *  The laser only fires under a segment - the loader turns it off for dwells, queued commands
+ *  and whenever motion stops.
+ */
+
+float spindle_laser_duty(const GCodeState_t *gm, const float velocity, const float cruise_velocity, const float power)
+{
+    if (spindle.mode != SPINDLE_LASER) {
+        return (SPINDLE_LASER_NONE);
+    }
+    spindle.speed = gm->spindle_speed;              // for {sps:} reporting
+    if (((gm->spindle_control != SPINDLE_CW) && (gm->spindle_control != SPINDLE_CCW)) ||
+        ((gm->motion_mode != MOTION_MODE_STRAIGHT_FEED) &&
+         (gm->motion_mode != MOTION_MODE_CW_ARC) &&
+         (gm->motion_mode != MOTION_MODE_CCW_ARC)) ||
+        (fp_ZERO(gm->spindle_speed)) || (fp_ZERO(power))) {
+        return (pwm.c[PWM_1].phase_off);
+    }
+    float speed = gm->spindle_speed * power;
+    if ((gm->spindle_control == SPINDLE_CCW) && (cruise_velocity > EPSILON)) {
+        speed *= max(min(velocity / cruise_velocity, (float)1.0), spindle.laser_power_min);
+    }
+    return (_get_laser_pwm(speed));
+}
+
+bool spindle_laser_output(const float duty)
+{
+    bool enable_bit = fp_NE(duty, pwm.c[PWM_1].phase_off);
+    if (enable_bit ^ spindle.enable_polarity) {
+        spindle_enable_pin.clear();                 // drive pin LO
+    } else {
+        spindle_enable_pin.set();                   // drive pin HI
+    }
+    pwm_set_duty(PWM_1, duty);
+    return (enable_bit);
+}
+
+void spindle_laser_off()
+{
+    spindle_laser_output(pwm.c[PWM_1].phase_off);
+}
+
 /****************************************************************************************
  * _get_spindle_pwm() - return PWM phase (duty cycle) for dir and speed
+ * _get_laser_pwm()   - return PWM phase for a laser power, using the clockwise ranges
  */
 
 static float _get_spindle_pwm (spSpindle_t &_spindle, pwmControl_t &_pwm)
@@ -324,6 +407,14 @@ static float _get_spindle_pwm (spSpindle_t &_spindle, pwmControl_t &_pwm)
     }
 }
 
+static float _get_laser_pwm (float speed)
+{
+    pwmConfigChannel_t *c = &pwm.c[PWM_1];
+    speed = min(max(speed, c->cw_speed_lo), c->cw_speed_hi);
+    speed = (speed - c->cw_speed_lo) / (c->cw_speed_hi - c->cw_speed_lo);
+    return ((speed * (c->cw_phase_hi - c->cw_phase_lo)) + c->cw_phase_lo);
+}
+
 /****************************************************************************************
  * spindle_override_control()
  * spindle_start_override()
@@ -409,6 +500,11 @@ stat_t sp_set_spsn(nvObj_t *nv) { return(set_float_range(nv, spindle.speed_min,
 stat_t sp_get_spsm(nvObj_t *nv) { return(get_float(nv, spindle.speed_max)); }
 stat_t sp_set_spsm(nvObj_t *nv) { return(set_float_range(nv, spindle.speed_max, SPINDLE_SPEED_MIN, SPINDLE_SPEED_MAX)); }
 
+stat_t sp_get_splm(nvObj_t *nv) { return(get_float(nv, spindle.laser_power_min)); }
+stat_t sp_set_splm(nvObj_t *nv) { return(set_float_range(nv, spindle.laser_power_min, 0.0, 1.0)); }
+stat_t sp_get_spov(nvObj_t *nv) { return(get_float(nv, spindle.laser_overscan)); }
+stat_t sp_set_spov(nvObj_t *nv) { return(set_float_range(nv, spindle.laser_overscan, 0.0, SPINDLE_LASER_OVERSCAN_MAX)); }
+
 stat_t sp_get_spoe(nvObj_t *nv) { return(get_integer(nv, spindle.override_enable)); }
 stat_t sp_set_spoe(nvObj_t *nv) { return(set_integer(nv, (uint8_t &)spindle.override_enable, 0, 1)); }
 stat_t sp_get_spo(nvObj_t *nv) { return(get_float(nv, spindle.override_factor)); }
@@ -429,13 +525,15 @@ stat_t sp_set_sps(nvObj_t *nv) { return(spindle_speed_immediate(nv->value_flt));
 
 const char fmt_spc[]  = "[spc]  spindle control:%12d [0=OFF,1=CW,2=CCW]\n";
 const char fmt_sps[]  = "[sps]  spindle speed:%14.0f rpm\n";
-const char fmt_spmo[] = "[spmo] spindle mode%16d [0=disabled,1=plan-to-stop,2=continuous]\n";
+const char fmt_spmo[] = "[spmo] spindle mode%16d [0=disabled,1=plan-to-stop,2=continuous,3=laser]\n";
 const char fmt_spep[] = "[spep] spindle enable polarity%5d [0=active_low,1=active_high]\n";
 const char fmt_spdp[] = "[spdp] spindle direction polarity%2d [0=CW_low,1=CW_high]\n";
 const char fmt_spph[] = "[spph] spindle pause on hold%7d [0=no,1=pause_on_hold]\n";
 const char fmt_spde[] = "[spde] spindle spinup delay%10.1f seconds\n";
 const char fmt_spsn[] = "[spsn] spindle speed min%14.2f rpm\n";
 const char fmt_spsm[] = "[spsm] spindle speed max%14.2f rpm\n";
+const char fmt_splm[] = "[splm] spindle laser power min%7.3f [0..1 x S for M4]\n";
+const char fmt_spov[] = "[spov] spindle laser raster overscan%8.3f mm\n";
 const char fmt_spoe[] = "[spoe] spindle speed override ena%2d [0=disable,1=enable]\n";
 const char fmt_spo[]  = "[spo]  spindle speed override%10.3f [0.050 < spo < 2.000]\n";
 
@@ -448,6 +546,8 @@ void sp_print_spph(nvObj_t *nv) { text_print(nv, fmt_spph);}    // TYPE_INT
 void sp_print_spde(nvObj_t *nv) { text_print(nv, fmt_spde);}    // TYPE_FLOAT
 void sp_print_spsn(nvObj_t *nv) { text_print(nv, fmt_spsn);}    // TYPE_FLOAT
 void sp_print_spsm(nvObj_t *nv) { text_print(nv, fmt_spsm);}    // TYPE_FLOAT
+void sp_print_splm(nvObj_t *nv) { text_print(nv, fmt_splm);}    // TYPE_FLOAT
+void sp_print_spov(nvObj_t *nv) { text_print(nv, fmt_spov);}    // TYPE_FLOAT
 void sp_print_spoe(nvObj_t *nv) { text_print(nv, fmt_spoe);}    // TYPE INT
 void sp_print_spo(nvObj_t *nv)  { text_print(nv, fmt_spo);}     // TYPE FLOAT
 
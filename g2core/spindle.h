@@ -28,18 +28,24 @@
 #ifndef SPINDLE_H_ONCE
 #define SPINDLE_H_ONCE
 
+#include "canonical_machine.h"  // used for GCodeState_t
+
 #define SPINDLE_OVERRIDE_ENABLE false
 #define SPINDLE_OVERRIDE_FACTOR 1.00
 #define SPINDLE_OVERRIDE_MIN 0.05       // 5%
 #define SPINDLE_OVERRIDE_MAX 2.00       // 200%
 #define SPINDLE_OVERRIDE_RAMP_TIME 1    // change sped in seconds
 
+#define SPINDLE_LASER_NONE -1.0          // returned by spindle_laser_duty() if not in laser mode
+#define SPINDLE_LASER_OVERSCAN_MAX 100  // mm
+
 typedef enum {
     SPINDLE_DISABLED = 0,       // spindle will not operate
     SPINDLE_PLAN_TO_STOP,       // spindle operating, plans to stop
     SPINDLE_CONTINUOUS,         // spindle operating, does not plan to stop
+    SPINDLE_LASER,              // PWM 1 drives a laser - power is set per segment, does not plan to stop
 } spMode;
-#define SPINDLE_MODE_MAX SPINDLE_CONTINUOUS
+#define SPINDLE_MODE_MAX SPINDLE_LASER
 
 // spControl enum is used for multiple purposes:
 //  - request a spindle action (OFF, CW, CCW, PAUSE, RESUME)
@@ -94,6 +100,9 @@ typedef struct spSpindle {
     float       spinup_delay;       // {spde:} optional delay on spindle start (set to 0 to disable)
 //    float       spindown_delay;     // {spds:} optional delay on spindle stop (set to 0 to disable)
 
+    float       laser_power_min;    // {splm:} M4 power floor as a fraction of S [0..1]
+    float       laser_overscan;     // {spov:} raster lead-in and lead-out distance (see cycle_raster.cpp)
+
     bool        override_enable;    // {spoe:} TRUE = spindle speed override enabled (see also m48_enable in canonical machine)
     float       override_factor;    // {spo:}  1.0000 x S spindle speed. Go up or down from there
     
@@ -117,6 +126,10 @@ stat_t spindle_control_sync(spControl control);
 stat_t spindle_speed_immediate(float speed);    // S parameter
 stat_t spindle_speed_sync(float speed);         // S parameter
 
+float spindle_laser_duty(const GCodeState_t *gm, const float velocity, const float cruise_velocity, const float power);
+bool spindle_laser_output(const float duty);
+void spindle_laser_off(void);
+
 stat_t spindle_override_control(const float P_word, const bool P_flag); // M51
 void spindle_start_override(const float ramp_time, const float override_factor);
 void spindle_end_override(const float ramp_time);
@@ -140,6 +153,11 @@ stat_t sp_set_spsn(nvObj_t *nv);
 stat_t sp_get_spsm(nvObj_t *nv);
 stat_t sp_set_spsm(nvObj_t *nv);
 
+stat_t sp_get_splm(nvObj_t *nv);
+stat_t sp_set_splm(nvObj_t *nv);
+stat_t sp_get_spov(nvObj_t *nv);
+stat_t sp_set_spov(nvObj_t *nv);
+
 stat_t sp_get_spoe(nvObj_t* nv);
 stat_t sp_set_spoe(nvObj_t* nv);
 stat_t sp_get_spo(nvObj_t* nv);
@@ -162,6 +180,8 @@ stat_t sp_set_sps(nvObj_t* nv);
 //    void sp_print_spdn(nvObj_t* nv);
     void sp_print_spsn(nvObj_t* nv);
     void sp_print_spsm(nvObj_t* nv);
+    void sp_print_splm(nvObj_t* nv);
+    void sp_print_spov(nvObj_t* nv);
     void sp_print_spoe(nvObj_t* nv);
     void sp_print_spo(nvObj_t* nv);
     void sp_print_spc(nvObj_t* nv);
@@ -177,6 +197,8 @@ stat_t sp_set_sps(nvObj_t* nv);
 //    #define sp_print_spdn tx_print_stub
     #define sp_print_spsn tx_print_stub
     #define sp_print_spsm tx_print_stub
+    #define sp_print_splm tx_print_stub
+    #define sp_print_spov tx_print_stub
     #define sp_print_spoe tx_print_stub
     #define sp_print_spo tx_print_stub
     #define sp_print_spc tx_print_stub
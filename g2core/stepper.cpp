@@ -34,6 +34,8 @@
 #include "stepper.h"
 #include "encoder.h"
 #include "planner.h"
+#include "spindle.h"
+#include "gpio.h"
 #include "hardware.h"
 #include "text_parser.h"
 #include "util.h"
@@ -57,6 +59,7 @@ static stRunSingleton_t st_run;
 /**** Static functions ****/
 
 static void _load_move(void);
+static void _laser_off(void);
 
 /**** Setup motate ****/
 
@@ -162,6 +165,10 @@ void stepper_reset()
     st_run.dda_ticks_downcount = 0;                     // signal the runtime is not busy
     st_run.dwell_ticks_downcount = 0;
     st_pre.buffer_state = PREP_BUFFER_OWNED_BY_EXEC;    // set to EXEC or it won't restart
+    st_pre.laser_duty = SPINDLE_LASER_NONE;
+    st_pre.output_on = 0;                               // drop output changes for a segment that won't run
+    st_pre.output_off = 0;
+    _laser_off();                                       // stop the laser along with the motion
 
     for (uint8_t motor=0; motor<MOTORS; motor++) {
         st_pre.mot[motor].prev_direction = STEP_INITIAL_DIRECTION;
@@ -207,6 +214,18 @@ bool st_runtime_isbusy()
     return (st_run.dda_ticks_downcount || st_run.dwell_ticks_downcount);    // returns false if down count is zero
 }
 
+/*
+ * st_get_dda_ticks_remaining() - return DDA ticks left in the segment that is running
+ *
+ *  Read by the segment executor as it prepares the next segment, this is how long the
+ *  prep had before the loader would have found st_pre empty.
+ */
+
+uint32_t st_get_dda_ticks_remaining()
+{
+    return (st_run.dda_ticks_downcount);
+}
+
 /*
  * st_clc() - clear counters
  */
@@ -457,6 +476,7 @@ static void _load_move()
 #if (MOTORS > 5)
         motor_6.motionStopped();
 #endif
+        _laser_off();               // laser goes off when motion stops - including feedholds
         return;
     } // if (st_pre.buffer_state != PREP_BUFFER_OWNED_BY_LOADER)
 
@@ -599,17 +619,34 @@ static void _load_move()
         ACCUMULATE_ENCODER(MOTOR_6);
 #endif
 
+        //**** set laser power for the segment (laser mode only) ****
+
+        if (st_pre.laser_duty >= 0) {
+            st_run.laser_on = spindle_laser_output(st_pre.laser_duty);
+            st_pre.laser_duty = SPINDLE_LASER_NONE;
+        }
+
+        //**** change M62/M63 synchronized outputs with the segment ****
+
+        if (st_pre.output_on | st_pre.output_off) {
+            gpio_set_outputs(st_pre.output_on, st_pre.output_off);
+            st_pre.output_on = 0;
+            st_pre.output_off = 0;
+        }
+
         //**** do this last ****
 
         dda_timer.start();                              // start the DDA timer if not already running
 
-    // handle dwells and commands
+    // handle dwells and commands - the laser only fires under a segment, so it's off for both
     } else if (st_pre.block_type == BLOCK_TYPE_DWELL) {
+        _laser_off();
         st_run.dwell_ticks_downcount = st_pre.dwell_ticks;
         SysTickTimer.registerEvent(&dwell_systick_event); // We now use SysTick events to handle dwells
 
     // handle synchronous commands
     } else if (st_pre.block_type == BLOCK_TYPE_COMMAND) {
+        _laser_off();
         mp_runtime_command(st_pre.bf);
 
     } // else null - which is okay in many cases
@@ -620,6 +657,18 @@ static void _load_move()
     st_request_exec_move();                             // exec and prep next move
 }
 
+/*
+ * _laser_off() - turn the laser off if the last segment left it firing
+ */
+
+static void _laser_off()
+{
+    if (st_run.laser_on) {
+        st_run.laser_on = false;
+        spindle_laser_off();
+    }
+}
+
 /***********************************************************************************
  * st_prep_line() - Prepare the next move for the loader
  *
@@ -725,6 +774,28 @@ stat_t st_prep_line(float travel_steps[], float following_error[], float segment
     return (STAT_OK);
 }
 
+/*
+ * st_prep_laser() - Set the laser power for the next st_prep_line() segment
+ *
+ *  Duty is the PWM 1 phase to set when that segment is loaded, so power changes in step with
+ *  the motion. SPINDLE_LASER_NONE (negative) leaves the PWM alone when not in laser mode.
+ */
+
+void st_prep_laser(float duty)
+{
+    st_pre.laser_duty = duty;
+}
+
+/*
+ * st_prep_outputs() - Set digital outputs to change when the next st_prep_line() segment loads
+ */
+
+void st_prep_outputs(const uint16_t on, const uint16_t off)
+{
+    st_pre.output_on = on;
+    st_pre.output_off = off;
+}
+
 /*
  * st_prep_null() - Keeps the loader happy. Otherwise performs no action
  */
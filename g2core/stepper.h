@@ -385,6 +385,7 @@ typedef struct stRunSingleton {             // Stepper static values and axis pa
     uint32_t dda_ticks_downcount;           // dda tick down-counter (unscaled)
     uint32_t dwell_ticks_downcount;         // dwell tick down-counter (unscaled)
     uint32_t dda_ticks_X_substeps;          // ticks multiplied by scaling factor
+    bool laser_on;                          // laser mode: PWM 1 is firing
     stRunMotor_t mot[MOTORS];               // runtime motor structures
     magic_t magic_end;
 } stRunSingleton_t;
@@ -420,6 +421,9 @@ typedef struct stPrepSingleton {
     uint32_t dda_ticks;                     // DDA ticks for the move
     uint32_t dwell_ticks;                   // dwell ticks remaining
     uint32_t dda_ticks_X_substeps;          // DDA ticks scaled by substep factor
+    float laser_duty;                       // PWM 1 phase to set when the segment loads, or < 0 to leave it
+    uint16_t output_on;                     // digital outputs to turn on when the segment loads (bit 0 = output 1)
+    uint16_t output_off;                    // digital outputs to turn off when the segment loads
     stPrepMotor_t mot[MOTORS];              // prep time motor structs
     magic_t magic_end;
 } stPrepSingleton_t;
@@ -584,6 +588,7 @@ void stepper_init_assertions(void);
 stat_t stepper_test_assertions(void);
 
 bool st_runtime_isbusy(void);
+uint32_t st_get_dda_ticks_remaining(void);
 stat_t st_clc(nvObj_t *nv);
 void st_set_motor_power(const uint8_t motor);
 stat_t st_motor_power_callback(void);
@@ -595,6 +600,8 @@ void st_prep_null(void);
 void st_prep_command(void *bf);        // use a void pointer since we don't know about mpBuf_t yet)
 void st_prep_dwell(float microseconds);
 void st_prep_out_of_band_dwell(float microseconds);
+void st_prep_laser(float duty);
+void st_prep_outputs(const uint16_t on, const uint16_t off);
 stat_t st_prep_line(float travel_steps[], float following_error[], float segment_time);
 
 stat_t st_get_ma(nvObj_t *nv);
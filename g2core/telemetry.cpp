@@ -0,0 +1,188 @@
+/*
+ * telemetry.cpp - binary motion telemetry stream
+ * This file is part of the g2core project
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, you may use this file as part of a software library without
+ * restriction. Specifically, if other files instantiate templates or use macros or
+ * inline functions from this file, or you compile this file and link it with  other
+ * files to produce an executable, this file does not by itself cause the resulting
+ * executable to be covered by the GNU General Public License. This exception does not
+ * however invalidate any other reasons why the executable file might be covered by the
+ * GNU General Public License.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "g2core.h"
+#include "config.h"
+#include "telemetry.h"
+#include "text_parser.h"
+#include "util.h"
+#include "xio.h"
+
+/**** Allocate Structures ****/
+
+tmTelemetry_t tlm;
+
+/************************************************************************************
+ **** CODE **************************************************************************
+ ************************************************************************************/
+
+static void _set_interval()
+{
+    tlm.interval_us = (tlm.rate > 0) ? (1000000.0 / tlm.rate) : 0;
+}
+
+/*
+ * telemetry_init() - clear the ring and counters. Config values are loaded by config_init().
+ */
+
+void telemetry_init()
+{
+    memset(&tlm, 0, sizeof(tlm));
+}
+
+/*
+ * tm_sample() - take a sample at the end of a segment - called from the segment executor
+ *
+ *  Runs at exec interrupt level, so it only copies the values into the ring. segment_time
+ *  is in minutes, as in mr. The sample is dropped (and counted) if the ring is full.
+ */
+
+void tm_sample(const float position[], float velocity, const float following_error[],
+               int32_t line, uint8_t section, float segment_time)
+{
+    if (tlm.interval_us == 0) {
+        return;
+    }
+    float segment_us = segment_time * 60000000.0;
+    tlm.time_fraction_us += segment_us;         // keep time_us exact - a float runs out of bits in seconds
+    uint32_t whole_us = (uint32_t)tlm.time_fraction_us;
+    tlm.time_us += whole_us;
+    tlm.time_fraction_us -= whole_us;
+    tlm.elapsed_us += segment_us;
+    if (tlm.elapsed_us < tlm.interval_us) {
+        return;
+    }
+    tlm.elapsed_us = (tlm.elapsed_us < (2 * tlm.interval_us)) ? (tlm.elapsed_us - tlm.interval_us) : 0;
+    tlm.sequence++;
+
+    uint8_t head = tlm.head;
+    if (((head + 1) & (TM_RING_SIZE-1)) == tlm.tail) {
+        tlm.ring_drops++;
+        return;
+    }
+    tmSample_t *s = &tlm.ring[head];
+    s->sequence = tlm.sequence;
+    s->time = tlm.time_us;
+    copy_vector(s->position, position);
+    s->velocity = velocity;
+    for (uint8_t m=0; m<MOTORS; m++) {
+        s->following_error[m] = following_error[m];
+    }
+    s->line = line;
+    s->section = section;
+    tlm.head = (head + 1) & (TM_RING_SIZE-1);    // publish the sample only once it's complete
+}
+
+/*
+ * telemetry_callback() - main loop callback to write queued samples as frames
+ *
+ *  Never blocks. A frame the channel can't take right now is dropped (and counted),
+ *  so a slow or absent reader can't hold up the controller.
+ */
+
+static uint8_t *_put(uint8_t *p, const void *value, uint8_t size)
+{
+    memcpy(p, value, size);                 // ARM and x86 are little-endian already
+    return (p + size);
+}
+
+static uint16_t _encode_frame(const tmSample_t *s, uint8_t *frame)
+{
+    uint8_t *p = frame;
+
+    *p++ = TM_FRAME_SYNC;
+    *p++ = tlm.fields;
+    p = _put(p, &s->sequence, sizeof(s->sequence));
+    p = _put(p, &s->time, sizeof(s->time));
+    if (tlm.fields & TM_POSITION)        { p = _put(p, s->position, sizeof(s->position)); }
+    if (tlm.fields & TM_VELOCITY)        { p = _put(p, &s->velocity, sizeof(s->velocity)); }
+    if (tlm.fields & TM_FOLLOWING_ERROR) { p = _put(p, s->following_error, sizeof(s->following_error)); }
+    if (tlm.fields & TM_LINE)            { p = _put(p, &s->line, sizeof(s->line)); }
+    if (tlm.fields & TM_SECTION)         { *p++ = s->section; }
+
+    uint8_t checksum = 0;
+    for (uint8_t *c = frame; c < p; c++) {
+        checksum ^= *c;
+    }
+    *p++ = checksum;
+    return (p - frame);
+}
+
+stat_t telemetry_callback()
+{
+    uint8_t frame[TM_FRAME_MAX];
+
+    while (tlm.tail != tlm.head) {
+        uint16_t length = _encode_frame(&tlm.ring[tlm.tail], frame);
+        tlm.tail = (tlm.tail + 1) & (TM_RING_SIZE-1);
+        if (xio_write_frame(tlm.channel, (const char *)frame, length)) {
+            tlm.samples_sent++;
+        } else {
+            tlm.tx_drops++;
+        }
+    }
+    return (STAT_OK);
+}
+
+/***********************************************************************************
+ * CONFIGURATION AND INTERFACE FUNCTIONS
+ * Functions to get and set variables from the cfgArray table
+ ***********************************************************************************/
+
+/*
+ * tm_get_tmr() - get telemetry rate
+ * tm_set_tmr() - set telemetry rate in samples per second of motion (0 = off)
+ * tm_get_tmf() - get telemetry fields
+ * tm_set_tmf() - set telemetry fields - see tmField
+ * tm_get_tmc() - get telemetry channel
+ * tm_set_tmc() - set telemetry channel - the N of the ioN statistics group for the device
+ */
+
+stat_t tm_get_tmr(nvObj_t *nv) { return (get_float(nv, tlm.rate)); }
+stat_t tm_set_tmr(nvObj_t *nv)
+{
+    ritorno(set_float_range(nv, tlm.rate, 0, TM_RATE_MAX));
+    _set_interval();
+    return (STAT_OK);
+}
+stat_t tm_get_tmf(nvObj_t *nv) { return (get_integer(nv, tlm.fields)); }
+stat_t tm_set_tmf(nvObj_t *nv) { return (set_integer(nv, tlm.fields, 0, TM_FIELDS_ALL)); }
+stat_t tm_get_tmc(nvObj_t *nv) { return (get_integer(nv, tlm.channel)); }
+stat_t tm_set_tmc(nvObj_t *nv) { return (set_integer(nv, tlm.channel, 0, DEV_MAX-1)); }
+
+/*********************
+ * TEXT MODE SUPPORT *
+ *********************/
+#ifdef __TEXT_MODE
+
+static const char fmt_tmr[] = "[tmr] telemetry rate%17.0f samples/s [0=off]\n";
+static const char fmt_tmf[] = "[tmf] telemetry fields%15d [1=pos,2=vel,4=ferr,8=line,16=section]\n";
+static const char fmt_tmc[] = "[tmc] telemetry channel%14d [ioN]\n";
+
+void tm_print_tmr(nvObj_t *nv) { text_print(nv, fmt_tmr);}
+void tm_print_tmf(nvObj_t *nv) { text_print(nv, fmt_tmf);}
+void tm_print_tmc(nvObj_t *nv) { text_print(nv, fmt_tmc);}
+
+#endif // __TEXT_MODE
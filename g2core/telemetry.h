@@ -0,0 +1,144 @@
+/*
+ * telemetry.h - binary motion telemetry stream
+ * This file is part of the g2core project
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, you may use this file as part of a software library without
+ * restriction. Specifically, if other files instantiate templates or use macros or
+ * inline functions from this file, or you compile this file and link it with  other
+ * files to produce an executable, this file does not by itself cause the resulting
+ * executable to be covered by the GNU General Public License. This exception does not
+ * however invalidate any other reasons why the executable file might be covered by the
+ * GNU General Public License.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/*
+ * TELEMETRY
+ *
+ *  The segment executor samples the runtime (mr) as it finishes each segment and pushes
+ *  the sample into a single-producer / single-consumer ring. The main loop drains the
+ *  ring as binary frames on one xio channel (tmc). Channels are numbered in xio list order:
+ *  0 is the flash file and 1 the job file (neither can be written), then the USB ports
+ *  (2, and 3 if two are exposed), then the UART. Nothing is formatted as text, and
+ *  neither side ever waits on the other: a full ring drops the sample (tmd), a full
+ *  channel drops the frame (tmx).
+ *
+ *  Samples are taken in motion time, not wall time: tmr is samples per second of
+ *  executed motion, and each frame carries the motion time in microseconds. Nothing is
+ *  sent while the machine isn't moving. A sample is never taken more often than once
+ *  per segment, so rates above ~1300 Hz give one sample per segment.
+ *
+ *  Frame format - all values little-endian, no padding:
+ *
+ *      uint8_t  sync           TM_FRAME_SYNC (0xA5)
+ *      uint8_t  fields         tmField bits of the fields that follow, in bit order
+ *      uint16_t sequence       sample sequence number - gaps are ring drops
+ *      uint32_t time           motion time of the sample in microseconds (wraps)
+ *      float    position[AXES]             if TM_POSITION - mm
+ *      float    velocity                   if TM_VELOCITY - mm/min
+ *      float    following_error[MOTORS]    if TM_FOLLOWING_ERROR - steps
+ *      int32_t  line                       if TM_LINE - Gcode line number
+ *      uint8_t  section                    if TM_SECTION - 0=head, 1=body, 2=tail
+ *      uint8_t  checksum       XOR of all preceding bytes of the frame
+ */
+
+#ifndef TELEMETRY_H_ONCE
+#define TELEMETRY_H_ONCE
+
+#include "hardware.h"  // for MOTORS
+
+/**** Configs and Constants ****/
+
+#define TM_RING_SIZE        32              // samples buffered between exec and the main loop - must be a power of 2
+#define TM_FRAME_SYNC       0xA5
+#define TM_RATE_MAX         10000           // samples per second - faster just means every segment
+
+typedef enum {                              // telemetry field selection bits (tmf)
+    TM_POSITION = 0x01,
+    TM_VELOCITY = 0x02,
+    TM_FOLLOWING_ERROR = 0x04,
+    TM_LINE = 0x08,
+    TM_SECTION = 0x10
+} tmField;
+
+#define TM_FIELDS_ALL       (TM_POSITION | TM_VELOCITY | TM_FOLLOWING_ERROR | TM_LINE | TM_SECTION)
+
+#define TM_FRAME_MAX (8 + (AXES * 4) + 4 + (MOTORS * 4) + 4 + 1 + 1)
+
+/**** Structures ****/
+
+typedef struct tmSample {                   // one sample as taken by the executor
+    uint16_t sequence;
+    uint32_t time;                          // microseconds of motion
+    float position[AXES];
+    float velocity;
+    float following_error[MOTORS];
+    int32_t line;
+    uint8_t section;
+} tmSample_t;
+
+typedef struct tmTelemetry {
+    // config values
+    float rate;                             // samples per second of motion, 0 = off
+    uint8_t fields;                         // tmField bits
+    uint8_t channel;                        // xio channel (ioN) the frames are written to
+
+    // counters (read only)
+    uint32_t samples_sent;
+    uint32_t ring_drops;                    // samples lost because the ring was full
+    uint32_t tx_drops;                      // frames lost because the channel couldn't take them
+
+    // executor side - only written from the exec interrupt
+    float interval_us;                      // 1/rate, set from the main loop
+    float elapsed_us;                       // motion time since the last sample
+    float time_fraction_us;                 // part of a microsecond not yet added to time_us
+    uint32_t time_us;                       // motion time of the stream
+    uint16_t sequence;
+
+    volatile uint8_t head;                  // next slot the executor writes
+    volatile uint8_t tail;                  // next slot the main loop reads
+    tmSample_t ring[TM_RING_SIZE];
+} tmTelemetry_t;
+
+extern tmTelemetry_t tlm;
+
+/**** Function Prototypes ****/
+
+void telemetry_init(void);
+stat_t telemetry_callback(void);
+
+void tm_sample(const float position[], float velocity, const float following_error[],
+               int32_t line, uint8_t section, float segment_time);
+
+stat_t tm_get_tmr(nvObj_t *nv);
+stat_t tm_set_tmr(nvObj_t *nv);
+stat_t tm_get_tmf(nvObj_t *nv);
+stat_t tm_set_tmf(nvObj_t *nv);
+stat_t tm_get_tmc(nvObj_t *nv);
+stat_t tm_set_tmc(nvObj_t *nv);
+
+#ifdef __TEXT_MODE
+
+    void tm_print_tmr(nvObj_t *nv);
+    void tm_print_tmf(nvObj_t *nv);
+    void tm_print_tmc(nvObj_t *nv);
+
+#else
+
+    #define tm_print_tmr tx_print_stub
+    #define tm_print_tmf tx_print_stub
+    #define tm_print_tmc tx_print_stub
+
+#endif // __TEXT_MODE
+
+#endif  // End of include guard: TELEMETRY_H_ONCE
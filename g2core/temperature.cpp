@@ -30,13 +30,16 @@
 #include "config.h"             // #2
 #include "canonical_machine.h"  // #3
 #include "text_parser.h"        // #4
+#include "json_parser.h"
 
 #include "temperature.h"
 #include "planner.h"
+#include "gpio.h"
 #include "hardware.h"
 #include "pwm.h"
 #include "report.h"
 #include "util.h"
+#include "xio.h"
 #include "settings.h"
 
 
@@ -94,6 +97,65 @@
 #define TEMP_MIN_RISE_DEGREES_FROM_TARGET (float)10.0
 #endif
 
+// The PIDs are run every TEMP_PID_PERIOD_MS milliseconds. The I and D factors
+// are per-sample, so changing this changes what the configured values mean.
+#ifndef TEMP_PID_PERIOD_MS
+#define TEMP_PID_PERIOD_MS 100
+#endif
+
+// The thermistors are sampled every TEMP_ADC_SAMPLE_TICKS milliseconds (SysTick ticks), and
+// the TEMP_ADC_SAMPLES readings from each control period are reduced to one value. A quarter
+// of them at each end are dropped as noise spikes (see ADCSampler). 10 is the conversion rate
+// the old IIR filter ran at; 5 doubles the ADC interrupts for somewhat better spike rejection.
+#ifndef TEMP_ADC_SAMPLE_TICKS
+#define TEMP_ADC_SAMPLE_TICKS 10
+#endif
+#define TEMP_ADC_SAMPLES (TEMP_PID_PERIOD_MS / TEMP_ADC_SAMPLE_TICKS)
+
+// Relay autotune: the relay switches at set_point +- TEMP_AUTOTUNE_HYSTERESIS,
+// runs TEMP_AUTOTUNE_CYCLES full cycles (the first two are not measured), and
+// gives up if the temperature goes TEMP_AUTOTUNE_MAX_OVERSHOOT past the set
+// point or a half cycle takes longer than TEMP_AUTOTUNE_HALF_CYCLE_TIME seconds.
+// The warm-up is held to the same TEMP_MIN_RISE rules as a heater under the PID.
+#ifndef TEMP_AUTOTUNE_HYSTERESIS
+#define TEMP_AUTOTUNE_HYSTERESIS (float)0.5
+#endif
+#ifndef TEMP_AUTOTUNE_CYCLES
+#define TEMP_AUTOTUNE_CYCLES 5
+#endif
+#ifndef TEMP_AUTOTUNE_MAX_OVERSHOOT
+#define TEMP_AUTOTUNE_MAX_OVERSHOOT (float)20.0
+#endif
+#ifndef TEMP_AUTOTUNE_HALF_CYCLE_TIME
+#define TEMP_AUTOTUNE_HALF_CYCLE_TIME (float)(5.0 * 60.0) // five minutes
+#endif
+
+// Model-based control: the model plans to reach the set point over TEMP_MODEL_HORIZON
+// seconds, and is pulled toward the measured temperature with a time constant of
+// TEMP_MODEL_SMOOTHING seconds. While the heater is within TEMP_MODEL_ESTIMATE_BAND of its
+// set point the ambient loss is re-estimated with a time constant of TEMP_MODEL_ESTIMATE_TIME
+// seconds. This is also what takes out any steady offset left by a mismatched model.
+#ifndef TEMP_MODEL_AMBIENT
+#define TEMP_MODEL_AMBIENT (float)25.0
+#endif
+#ifndef TEMP_MODEL_HORIZON
+#define TEMP_MODEL_HORIZON (float)2.0
+#endif
+#ifndef TEMP_MODEL_SMOOTHING
+#define TEMP_MODEL_SMOOTHING (float)0.5
+#endif
+#ifndef TEMP_MODEL_ESTIMATE_BAND
+#define TEMP_MODEL_ESTIMATE_BAND (float)5.0
+#endif
+#ifndef TEMP_MODEL_ESTIMATE_TIME
+#define TEMP_MODEL_ESTIMATE_TIME (float)60.0
+#endif
+
+// The part cooling fan (the one M106 drives) adds to the extruders' losses
+#ifndef TEMP_MODEL_FAN_OUTPUT
+#define TEMP_MODEL_FAN_OUTPUT 4
+#endif
+
 
 /**** Allocate structures ****/
 
@@ -107,13 +169,69 @@ using namespace Motate;
 const float kSystemVoltage = 3.3;
 
 
+/*
+ * ADCSampler - keeps the latest raw ADC samples and reduces them once per control period
+ *
+ *  add() is all the conversion interrupt does. value() sorts the samples, drops the highest
+ *  and lowest quarter so a noise spike can't pull the reading, and averages the rest. The
+ *  oversampling resolves finer than one ADC count, so the result is a float.
+ *
+ *  value() may be interrupted by add(), in which case the window it reduces has one newer
+ *  sample in place of the oldest. That is harmless, so no locking is done.
+ */
+
+template<uint16_t sample_count>
+struct ADCSampler {
+    volatile uint16_t samples[sample_count];
+    volatile uint16_t write_index = 0;
+    volatile uint16_t filled = 0;   // until the ring has wrapped once only these are valid
+
+    void add(const uint16_t sample) {
+        samples[write_index] = sample;
+        if (++write_index == sample_count) {
+            write_index = 0;
+        }
+        if (filled < sample_count) {
+            filled++;
+        }
+    }
+
+    float value() {
+        uint16_t n = filled;
+        if (n == 0) {
+            return (0.0);
+        }
+        uint16_t sorted[sample_count];
+        for (uint16_t i=0; i<n; i++) {      // insertion sort - n is small
+            uint16_t sample = samples[i];
+            uint16_t j = i;
+            for (; (j > 0) && (sorted[j-1] > sample); j--) {
+                sorted[j] = sorted[j-1];
+            }
+            sorted[j] = sample;
+        }
+        uint16_t reject = n / 4;
+        uint32_t sum = 0;
+        for (uint16_t i=reject; i < n-reject; i++) {
+            sum += sorted[i];
+        }
+        return ((float)sum / (n - (2 * reject)));
+    }
+};
+
 template<pin_number adc_pin_num, uint16_t min_temp = 0, uint16_t max_temp = 300, uint32_t table_size=64>
 struct Thermistor {
     float c1, c2, c3, pullup_resistance, inline_resistance;
     // We'll pull adc top value from the adc_pin.getTop()
 
     ADCPin<adc_pin_num> adc_pin;
-    uint16_t raw_adc_value = 0;
+    ADCSampler<TEMP_ADC_SAMPLES> sampler;
+    float raw_adc_value = 0;        // reduced from the sampler once per control period
+
+    // ADC values at table_size evenly spaced temperatures from min_temp to max_temp.
+    // The ADC value falls as the temperature rises.
+    static constexpr float temp_step = (float)(max_temp - min_temp) / (table_size - 1);
+    float adc_table[table_size];
 
     typedef Thermistor<adc_pin_num, min_temp, max_temp, table_size> type;
 
@@ -150,37 +268,59 @@ struct Thermistor {
         c2 = (x-c3*v)/z;
         c1 = 1/temp_low_fixed-c3*pow(a1,3)-c2*a1;
 
-        //        int16_t temp = min_temp;
-        //        for (int i=0; temp < max_temp && i < table_size; i++) {
-        //            lookup_table[i][0] = adc_value(temp);
-        //            lookup_table[i][0] = temp;
-        //
-        //            temp += (min_temp-max_temp)/(table_size-1);
-        //        }
+        for (uint32_t i=0; i < table_size; i++) {
+            adc_table[i] = adc_value(min_temp + (i * temp_step));
+        }
     };
 
-//    uint16_t adc_value_(int16_t temp) {
-//        float y = (c1 - (1/(temp+273.15))) / (2*c3);
-//        float x = sqrt(pow(c2 / (3*c3),3) + pow(y,2));
-//        float r = exp((x-y) - (x+y)); // resistance of thermistor
-//        return (r / (pullup_resistance + r)) * (adc_pin.getTop());
-//    };
+    // The ADC value the thermistor reads at temp. Only used to build the table. Steinhart-Hart
+    // is inverted by bisection on ln(r) as the closed form fails when c3 comes out negative.
+    float adc_value(const float temp) {
+        float Tinv = 1/(temp+273.15);
+        float lo = 0;
+        float hi = log(TEMP_MIN_DISCONNECTED_RESISTANCE);
+        for (uint8_t i=0; i < 32; i++) {
+            float lnr = (lo + hi) / 2;
+            if ((c1 + (c2*lnr) + (c3*lnr*lnr*lnr)) > Tinv) {    // colder than temp - less resistance
+                hi = lnr;
+            } else {
+                lo = lnr;
+            }
+        }
+        float r = exp((lo + hi) / 2) + inline_resistance;      // resistance seen by the divider
+        return (r / (pullup_resistance + r)) * (adc_pin.getTop());
+    };
 
-    float temperature_exact() {
-        // Sanity check:
-        if (raw_adc_value < 1) {
-            return -1; // invalid temperature from a thermistor
+    // Temperature from the table by linear interpolation. Readings outside the table
+    // (below min_temp, above max_temp, or a failed sensor) fall back to the exact formula.
+    float temperature() {
+        float adc = raw_adc_value;
+        if ((adc < 1) || (adc > adc_table[0]) || (adc < adc_table[table_size-1])) {
+            return temperature_exact();
+        }
+        uint32_t lo = 0;                            // find adc_table[lo] >= adc > adc_table[hi]
+        uint32_t hi = table_size-1;
+        while (hi - lo > 1) {
+            uint32_t mid = (lo + hi) / 2;
+            if (adc_table[mid] >= adc) {
+                lo = mid;
+            } else {
+                hi = mid;
+            }
         }
+        float fraction = (adc_table[lo] - adc) / (adc_table[lo] - adc_table[hi]);
+        return min_temp + ((lo + fraction) * temp_step);
+    };
 
-        float v = (float)raw_adc_value * kSystemVoltage / (adc_pin.getTop()); // convert the 10 bit ADC value to a voltage
-        float r = ((pullup_resistance * v) / (kSystemVoltage - v)) - inline_resistance;   // resistance of thermistor
+    float temperature_exact() {
+        float r = get_resistance();                 // -1 for an invalid reading
 
         if ((r < 0) || (r > TEMP_MIN_DISCONNECTED_RESISTANCE)) {
             return -1;
         }
 
         float lnr = log(r);
-        float Tinv = c1 + (c2*lnr) + (c3*pow(lnr,3));
+        float Tinv = c1 + (c2*lnr) + (c3*lnr*lnr*lnr);
         return (1/Tinv) - 273.15; // final temperature
     };
 
@@ -189,13 +329,18 @@ struct Thermistor {
             return -1; // invalid temperature from a thermistor
         }
 
-        float v = (float)raw_adc_value * kSystemVoltage / (adc_pin.getTop()); // convert the 10 bit ADC value to a voltage
+        float v = raw_adc_value * kSystemVoltage / (adc_pin.getTop()); // convert the 10 bit ADC value to a voltage
         return ((pullup_resistance * v) / (kSystemVoltage - v)) - inline_resistance;   // resistance of thermistor
     }
 
     // Call back function from the ADC to tell it that the ADC has a new sample...
     void adc_has_new_value() {
-        raw_adc_value = (adc_pin.getRaw() + (9 * raw_adc_value))/10;
+        sampler.add(adc_pin.getRaw());
+    };
+
+    // Reduce the samples taken since the last control period to raw_adc_value
+    void update() {
+        raw_adc_value = sampler.value();
     };
 };
 
@@ -303,7 +448,7 @@ PWMOutputPin<-1> fet_pin3;// {kPWMPinInverted};
 #if TEMPERATURE_OUTPUT_ON == 1
 
 // We're going to register a SysTick event
-const int16_t fet_pin1_sample_freq = 10; // every fet_pin1_sample_freq interrupts, sample
+const int16_t fet_pin1_sample_freq = TEMP_ADC_SAMPLE_TICKS; // every fet_pin1_sample_freq interrupts, sample
 int16_t fet_pin1_sample_counter = fet_pin1_sample_freq;
 SysTickEvent adc_tick_event {[&] {
     if (!--fet_pin1_sample_counter) {
@@ -315,6 +460,236 @@ SysTickEvent adc_tick_event {[&] {
 #endif
 
 
+/*
+ * HeaterModel - first-order thermal model of a heater, used for model-based control
+ *
+ *  The heater block is a single heat capacity C, heated by the heater and losing heat to
+ *  ambient through a transfer coefficient that grows with the part fan and with the flow
+ *  of cold filament through the nozzle. The sensor lags the block. Each sample the model
+ *  is advanced with the output that was applied, then pulled toward the measurement.
+ *
+ *  The output is the power that would bring the modeled block (not the lagging sensor) to
+ *  the set point over TEMP_MODEL_HORIZON, plus the modeled losses. It heats at full power
+ *  until the block is nearly there, and it responds to a change in fan or flow when it
+ *  happens rather than after the temperature has moved.
+ *
+ *  The model runs whether or not it is in control, so the ambient loss is learned under PID
+ *  too and switching between them is bumpless.
+ */
+
+struct HeaterModel {
+    // These are all loaded from the he<n>m* config values
+    bool _enable = false;           // set true to control the heater from the model
+    float _power = 0.0;             // heater power at full output (W)
+    float _capacity = 0.0;          // heat capacity of the block (J/K)
+    float _loss = 0.0;              // transfer coefficient to ambient (W/K), estimated online
+    float _fan_loss = 0.0;          // extra transfer coefficient with the part fan at full (W/K)
+    float _filament = 0.0;          // heat capacity of a mm of filament (J/K per mm)
+    float _sensor_response = 0.0;   // rate the sensor follows the block (1/s)
+
+    bool _primed = false;
+    float _block_temp;              // modeled temperatures
+    float _sensor_temp;
+
+    // heat lost per degree over ambient with fan (0-1) and feed (mm/s of filament)
+    float lossCoefficient(float fan, float feed) {
+        return (_loss + (fan * _fan_loss) + (feed * _filament));
+    }
+
+    void update(float input, float output, float fan, float feed, float dt, bool holding) {
+        if ((_capacity <= 0.0) || (_power <= 0.0)) {    // not configured
+            return;
+        }
+        if (!_primed) {
+            _block_temp = input;
+            _sensor_temp = input;
+            _primed = true;
+            return;
+        }
+        float losses = lossCoefficient(fan, feed) * (_block_temp - TEMP_MODEL_AMBIENT);
+        _block_temp += ((_power * output) - losses) * dt / _capacity;
+        _sensor_temp += (_block_temp - _sensor_temp) * min(1.0f, _sensor_response * dt);
+
+        float correction = (input - _sensor_temp) * min(1.0f, dt / TEMP_MODEL_SMOOTHING);
+        _block_temp += correction;
+        _sensor_temp += correction;
+
+        // Holding temperature, the heater power matches the losses. The fan and flow terms
+        // are taken as known, so whatever is left over is the ambient loss.
+        if (holding && (output > 0.0) && (output < 1.0) && (input > TEMP_MODEL_AMBIENT + 10.0)) {
+            float loss = (_power * output / (input - TEMP_MODEL_AMBIENT)) - (fan * _fan_loss) - (feed * _filament);
+            _loss += (max(loss, 0.0f) - _loss) * dt / TEMP_MODEL_ESTIMATE_TIME;
+        }
+    }
+
+    float getNewOutput(float set_point, float fan, float feed) {
+        if (!_primed) {
+            return (0.0);
+        }
+        float power = (set_point - _block_temp) * _capacity / TEMP_MODEL_HORIZON;
+        power += lossCoefficient(fan, feed) * (set_point - TEMP_MODEL_AMBIENT);
+        return (min(max(power / _power, 0.0f), 1.0f));
+    }
+};
+
+/*
+ * PIDAutotune - relay feedback tuning of one heater
+ *
+ *  The heater is switched between bias+d and bias-d each time the temperature crosses the
+ *  set point, with a little hysteresis to keep sensor noise from chattering the relay. The
+ *  loop settles into a limit cycle of amplitude a and period Tu, which gives the ultimate
+ *  gain Ku = 4d / (pi * sqrt(a^2 - h^2)). The bias is re-centered each cycle so the heating
+ *  and cooling halves take the same time - heaters usually heat much faster than they cool.
+ *
+ *  While heating from well below the set point the PID's rise-time check applies, so a
+ *  loose sensor fails the autotune within TEMP_MIN_RISE_TIME. Closer in, each half cycle
+ *  must finish within TEMP_AUTOTUNE_HALF_CYCLE_TIME of the heater getting there.
+ *
+ *  Nothing in here touches hardware: call start(), then step() once per sample period
+ *  with the measured temperature and drive the heater with what it returns.
+ */
+
+struct PIDAutotune {
+    enum State : uint8_t { Idle = 0, Running, Done, Failed };
+
+    State state = Idle;
+    bool report_pending = false;    // set when Done or Failed, cleared once reported
+    const char *failure = nullptr;  // why it failed
+
+    float set_point;
+    float sample_period;            // seconds between calls to step()
+    float min_rise;                 // degrees it must rise in TEMP_MIN_RISE_TIME while far from the set point
+    uint8_t cycles;                 // cycles to run
+    uint8_t cycle;                  // cycles completed
+
+    float bias;                     // relay output is bias +- d
+    float d;
+    bool heating;
+    uint32_t samples;               // samples since start()
+    float last_switch;              // time of the last relay switch (seconds)
+    float half_start;               // time the half cycle came within reach of the set point
+    float rise_time;                // time the rise check was set, or -1 if it isn't
+    float rise_checkpoint;          // ...and the temperature it must reach by TEMP_MIN_RISE_TIME
+    float heat_time;                // length of the last heating half cycle
+    float max_temp;                 // extremes since the last switch to heating
+    float min_temp;
+
+    float ku = 0.0;                 // results: ultimate gain (output fraction per degree)
+    float tu = 0.0;                 //          ultimate period (seconds)
+
+    void start(const float set_point_, const float sample_period_, const uint8_t cycles_, const float min_rise_) {
+        state = Running;
+        report_pending = false;
+        failure = nullptr;
+        set_point = set_point_;
+        sample_period = sample_period_;
+        min_rise = min_rise_;
+        cycles = max(cycles_, (uint8_t)3);
+        cycle = 0;
+        bias = 0.5;
+        d = 0.5;
+        heating = true;
+        samples = 0;
+        last_switch = 0.0;
+        half_start = 0.0;
+        rise_time = -1.0;
+        heat_time = 0.0;
+        max_temp = 0.0;
+        min_temp = TEMP_MAX_SETPOINT;
+        ku = 0.0;
+        tu = 0.0;
+    }
+
+    void stop() {
+        state = Idle;
+        report_pending = false;
+    }
+
+    float fail(const char *why) {
+        state = Failed;
+        report_pending = true;
+        failure = why;
+        return 0.0;
+    }
+
+    float step(const float input) {
+        if (input < 0) {
+            return fail("sensor read failed");
+        }
+        if (input > min(set_point + TEMP_AUTOTUNE_MAX_OVERSHOOT, TEMP_MAX_SETPOINT)) {
+            return fail("temperature overshot");
+        }
+        float now = ++samples * sample_period;
+        if ((rise_time >= 0) && (now - rise_time >= TEMP_MIN_RISE_TIME / 1000.0)) {
+            if (input < rise_checkpoint) {
+                return fail("temperature failed to rise fast enough");
+            }
+            rise_time = -1.0;
+        }
+        if (heating && (rise_time < 0) && (set_point > input + TEMP_MIN_RISE_DEGREES_FROM_TARGET)) {
+            rise_time = now;
+            rise_checkpoint = min(input + min_rise, set_point + TEMP_AUTOTUNE_HYSTERESIS);
+        }
+        if (rise_time >= 0) {
+            half_start = now;       // the rise check is in charge until it's close
+        } else if (now - half_start > TEMP_AUTOTUNE_HALF_CYCLE_TIME) {
+            return fail("heater did not cross the set point");
+        }
+        max_temp = max(max_temp, input);
+        min_temp = min(min_temp, input);
+
+        if (heating && (input > set_point + TEMP_AUTOTUNE_HYSTERESIS)) {
+            heating = false;
+            heat_time = now - last_switch;
+            last_switch = now;
+            half_start = now;
+            rise_time = -1.0;
+
+        } else if (!heating && (input < set_point - TEMP_AUTOTUNE_HYSTERESIS)) {
+            heating = true;
+            float cool_time = now - last_switch;
+            last_switch = now;
+            half_start = now;
+
+            // The first cycle's heating half is the warm-up, so it tells us nothing, and
+            // the second still runs on the starting bias. Measure from the third on.
+            if (++cycle > 1) {
+                float a = (max_temp - min_temp) / 2;
+                float h = TEMP_AUTOTUNE_HYSTERESIS;
+                if ((cycle > 2) && (a > h)) {
+                    float n = cycle - 2;
+                    ku += ((4 * d / (M_PI * sqrt(a*a - h*h))) - ku) / n;    // running means
+                    tu += ((heat_time + cool_time) - tu) / n;
+                }
+                bias += d * (heat_time - cool_time) / (heat_time + cool_time);
+                bias = min(max(bias, 0.05f), 0.95f);
+                d = (bias > 0.5) ? (1.0 - bias) : bias;
+            }
+            max_temp = input;
+            min_temp = input;
+
+            if (cycle >= cycles) {
+                if ((ku <= 0.0) || (tu <= 0.0)) {
+                    return fail("no usable oscillation");
+                }
+                state = Done;
+                report_pending = true;
+                return 0.0;
+            }
+        }
+        return heating ? (bias + d) : (bias - d);
+    }
+
+    // Classic Ziegler-Nichols PID from Ku and Tu, in the PID's units (before the x100
+    // scaling of the config values): Kp = 0.6Ku, Ti = Tu/2, Td = Tu/8. The I term is
+    // accumulated and the D term is differenced once per sample, hence the sample period.
+    void gains(float &p, float &i, float &dd) {
+        p = 0.6 * ku;
+        i = p * sample_period / (0.5 * tu);
+        dd = p * (0.125 * tu) / sample_period;
+    }
+};
+
 struct PID {
     static constexpr float output_max = 1.0;
     static constexpr float derivative_contribution = 0.05;
@@ -339,9 +714,29 @@ struct PID {
 
     bool _enable;                   // set true to enable this heater
 
+    PIDAutotune _autotune;          // relay autotune, overrides the PID while running
+    HeaterModel _model;             // model-based control, used instead of the PID when enabled
+    float _output = 0.0;            // the last output, to advance the model
+
     PID(float P, float I, float D, float min_rise_over_time, float startSetPoint = 0.0) : _p_factor{P/100.0f}, _i_factor{I/100.0f}, _d_factor{D/100.0f}, _set_point{startSetPoint}, _at_set_point{false}, _min_rise_over_time(min_rise_over_time) {};
 
-    float getNewOutput(float input) {
+    // fan is the part fan (0-1) and feed is the filament feed into this heater (mm/s)
+    float getNewOutput(float input, float fan = 0.0, float feed = 0.0) {
+        bool holding = (_autotune.state != PIDAutotune::Running) && (_set_point >= TEMP_OFF_BELOW) &&
+                       (fabs(_set_point - input) < TEMP_MODEL_ESTIMATE_BAND);
+        if (input >= 0) {
+            _model.update(input, _output, fan, feed, TEMP_PID_PERIOD_MS / 1000.0, holding);
+        }
+        float output = _getOutput(input, fan, feed);
+        _output = max(output, 0.0f);
+        return output;
+    }
+
+    float _getOutput(float input, float fan, float feed) {
+        if (_autotune.state == PIDAutotune::Running) {
+            return _autotune.step(input);
+        }
+
         // If the input is < 0, the sensor failed
         if (input < 0) {
             if (_set_point > TEMP_OFF_BELOW) {
@@ -415,6 +810,10 @@ struct PID {
         if ((_set_point < TEMP_OFF_BELOW) || (input > TEMP_MAX_SETPOINT)) {
             return 0; // "off"
 
+        // The model plans its own approach to the set point, so it skips the full-on below
+        } else if (_model._enable) {
+            return _model.getNewOutput(_set_point, fan, feed);
+
         // If we are too far from the set point, turn the heater full on
         } else if (e > TEMP_FULL_ON_DIFFERENCE) {
             return 1; //"on"
@@ -481,6 +880,46 @@ HeaterFan<kOutput3_PinNumber> heater_fan1;
 
 /**** Static functions ****/
 
+/*
+ * _autotune_report() - write the gains from a finished autotune and report the result
+ *
+ *  The gains are written through the he<n>p/i/d config values, so they are range
+ *  checked, applied and persisted the same as if the host had sent them.
+ */
+static void _autotune_report(const uint8_t heater, PIDAutotune &tune)
+{
+    if (!tune.report_pending) {
+        return;
+    }
+    tune.report_pending = false;
+
+    if (tune.state == PIDAutotune::Failed) {
+        char buffer[64];
+        sprintf(buffer, "Heater %d autotune failed: %s", heater, tune.failure);
+        rpt_exception(STAT_TEMPERATURE_AUTOTUNE_FAILED, buffer);
+        return;
+    }
+
+    static const char *const suffix[] = { "p", "i", "d", "ku", "tu" };
+    float gain[3];
+    tune.gains(gain[0], gain[1], gain[2]);
+
+    nvObj_t *nv = nv_reset_nv_list();
+    for (uint8_t i=0; i<5; i++, nv = nv->nx) {
+        nv->group[0] = NUL;
+        sprintf(nv->token, "he%d%s", heater, suffix[i]);
+        nv->index = nv_get_index((const char *)"", nv->token);
+        if (i < 3) {
+            nv->value_flt = gain[i] * 100.0;    // NOTICE: the config values are scaled by 100
+            nv->valuetype = TYPE_FLOAT;
+            nv_set(nv);
+            nv_persist(nv);
+        }
+        nv_get(nv);
+    }
+    nv_print_list(STAT_OK, TEXT_MULTILINE_FORMATTED, JSON_OBJECT_FORMAT);
+}
+
 
 /*
  * temperature_init()
@@ -521,7 +960,11 @@ void temperature_reset()
     fet_pin3 = 0.0f;
     pid3._set_point = 0.0;
 
-    pid_timeout.set(100);
+    pid1._autotune.stop();
+    pid2._autotune.stop();
+    pid3._autotune.stop();
+
+    pid_timeout.set(TEMP_PID_PERIOD_MS);
 }
 
 // Minimum difference in temp before it'll trigger an SR
@@ -540,18 +983,36 @@ stat_t temperature_callback()
         pid2._set_point = 0.0;
         pid3._set_point = 0.0;
 
+        pid1._autotune.stop();
+        pid2._autotune.stop();
+        pid3._autotune.stop();
+
         return (STAT_OK);
     }
 
     if (pid_timeout.isPast()) {
-        pid_timeout.set(100);
+        pid_timeout.set(TEMP_PID_PERIOD_MS);
 
         float temp = 0.0;
         bool sr_requested = false;
 
+        thermistor1.update();
+        thermistor2.update();
+        thermistor3.update();
+
+        // Loads for the heater models: the part fan, and the filament being fed into each
+        // extruder (heater 1 feeds A, heater 2 feeds B). Retractions don't count.
+        float fan = gpio_get_output(TEMP_MODEL_FAN_OUTPUT-1);
+        float feed1 = 0.0;
+        float feed2 = 0.0;
+        if (cm_get_motion_state() != MOTION_STOP) {
+            feed1 = max(0.0f, mp_get_runtime_axis_velocity(AXIS_A)) / 60.0;    // mm/min to mm/s
+            feed2 = max(0.0f, mp_get_runtime_axis_velocity(AXIS_B)) / 60.0;
+        }
+
         if (pid1._enable) {
-            temp = thermistor1.temperature_exact();
-            fet_pin1 = pid1.getNewOutput(temp);
+            temp = thermistor1.temperature();
+            fet_pin1 = pid1.getNewOutput(temp, fan, feed1);
 
             if (fabs(temp - last_reported_temp1) > kTempDiffSRTrigger) {
                 last_reported_temp1 = temp;
@@ -562,8 +1023,8 @@ stat_t temperature_callback()
         heater_fan1.newTemp(temp);
 
         if (pid2._enable) {
-            temp = thermistor2.temperature_exact();
-            fet_pin2 = pid2.getNewOutput(temp);
+            temp = thermistor2.temperature();
+            fet_pin2 = pid2.getNewOutput(temp, fan, feed2);
 
             if (fabs(temp - last_reported_temp2) > kTempDiffSRTrigger) {
                 last_reported_temp2 = temp;
@@ -572,7 +1033,7 @@ stat_t temperature_callback()
         }
 
         if (pid3._enable) {
-            temp = thermistor3.temperature_exact();
+            temp = thermistor3.temperature();
             fet_pin3 = pid3.getNewOutput(temp);
 
             if (fabs(temp - last_reported_temp3) > kTempDiffSRTrigger) {
@@ -584,6 +1045,10 @@ stat_t temperature_callback()
         if (sr_requested) {
             sr_request_status_report(SR_REQUEST_TIMED);
         }
+
+        _autotune_report(1, pid1._autotune);
+        _autotune_report(2, pid2._autotune);
+        _autotune_report(3, pid3._autotune);
     }
     return (STAT_OK);
 }
@@ -726,6 +1191,164 @@ stat_t cm_set_heater_d(nvObj_t *nv)
     return (STAT_OK);
 }
 
+/****************************************************************************************
+ * cm_start_heater_autotune() - start a relay autotune of a heater at temperature
+ * cm_get_heater_autotune()   - get the autotune state (0=idle, 1=running, 2=done, 3=failed)
+ * cm_set_heater_autotune()   - start an autotune at the given temperature, or 0 to cancel
+ * cm_get_heater_ku()         - get the ultimate gain found by the last autotune (x100)
+ * cm_get_heater_tu()         - get the ultimate period found by the last autotune (seconds)
+ *
+ *  The heater is left off when the autotune finishes or is cancelled. A finished autotune
+ *  writes its gains to he<n>p, he<n>i and he<n>d (see _autotune_report()).
+ */
+
+static PID *_get_heater_pid(const uint8_t heater)
+{
+    switch(heater) {
+        case 1: { return &pid1; }
+        case 2: { return &pid2; }
+        case 3: { return &pid3; }
+        default: { break; }
+    }
+    return nullptr;
+}
+
+stat_t cm_start_heater_autotune(const uint8_t heater, const float temperature, const uint8_t cycles)
+{
+    PID *pid = _get_heater_pid(heater);
+    if (pid == nullptr) {
+        return (STAT_INPUT_VALUE_RANGE_ERROR);
+    }
+    if (temperature < TEMP_OFF_BELOW) {
+        return (STAT_INPUT_LESS_THAN_MIN_VALUE);
+    }
+    if (temperature > TEMP_MAX_SETPOINT - TEMP_AUTOTUNE_MAX_OVERSHOOT) {
+        return (STAT_INPUT_EXCEEDS_MAX_VALUE);
+    }
+    if (!pid->_enable) {
+        return (STAT_COMMAND_NOT_ACCEPTED);
+    }
+    pid->_set_point = 0.0;
+    pid->_autotune.start(temperature, TEMP_PID_PERIOD_MS / 1000.0, (cycles == 0) ? TEMP_AUTOTUNE_CYCLES : cycles,
+                         pid->_min_rise_over_time);
+    return (STAT_OK);
+}
+
+stat_t cm_get_heater_autotune(nvObj_t *nv)
+{
+    PID *pid = _get_heater_pid(_get_heater_number(nv) - '0');
+    nv->value_int = (pid == nullptr) ? 0 : pid->_autotune.state;
+    nv->valuetype = TYPE_INTEGER;
+    return (STAT_OK);
+}
+
+stat_t cm_set_heater_autotune(nvObj_t *nv)
+{
+    uint8_t heater = _get_heater_number(nv) - '0';
+    if (nv->value_flt > 0.0) {
+        return (cm_start_heater_autotune(heater, nv->value_flt, 0));
+    }
+    PID *pid = _get_heater_pid(heater);
+    if ((pid != nullptr) && (pid->_autotune.state == PIDAutotune::Running)) {
+        pid->_autotune.stop();
+    }
+    return (STAT_OK);
+}
+
+stat_t cm_get_heater_ku(nvObj_t *nv)
+{
+    PID *pid = _get_heater_pid(_get_heater_number(nv) - '0');
+    nv->value_flt = (pid == nullptr) ? 0.0 : pid->_autotune.ku * 100.0;
+    nv->precision = GET_TABLE_WORD(precision);
+    nv->valuetype = TYPE_FLOAT;
+    return (STAT_OK);
+}
+
+stat_t cm_get_heater_tu(nvObj_t *nv)
+{
+    PID *pid = _get_heater_pid(_get_heater_number(nv) - '0');
+    nv->value_flt = (pid == nullptr) ? 0.0 : pid->_autotune.tu;
+    nv->precision = GET_TABLE_WORD(precision);
+    nv->valuetype = TYPE_FLOAT;
+    return (STAT_OK);
+}
+
+/****************************************************************************************
+ * cm_get_heater_model_enable() - get whether the heater is run from its model
+ * cm_set_heater_model_enable() - select model-based control (true) or the PID (false)
+ * cm_get_heater_model()        - get a heater model parameter
+ * cm_set_heater_model()        - set a heater model parameter
+ *
+ *  The model parameters are selected by the last letter of the token:
+ *    he<n>mw - heater power (W)           he<n>mf - extra loss with the part fan full on (W/K)
+ *    he<n>mc - block heat capacity (J/K)  he<n>me - filament heat capacity (J/K per mm)
+ *    he<n>mh - loss to ambient (W/K)      he<n>mr - sensor response (1/s)
+ *
+ *  he<n>mh is refined while the heater holds temperature. Reading it returns the current
+ *  estimate, which can be written back to keep it.
+ */
+
+static float *_get_model_parameter(nvObj_t *nv)
+{
+    PID *pid = _get_heater_pid(_get_heater_number(nv) - '0');
+    if (pid == nullptr) {
+        return nullptr;
+    }
+    switch(nv->token[strlen(nv->token)-1]) {
+        case 'w': { return &pid->_model._power; }
+        case 'c': { return &pid->_model._capacity; }
+        case 'h': { return &pid->_model._loss; }
+        case 'f': { return &pid->_model._fan_loss; }
+        case 'e': { return &pid->_model._filament; }
+        case 'r': { return &pid->_model._sensor_response; }
+        default: { break; }
+    }
+    return nullptr;
+}
+
+stat_t cm_get_heater_model_enable(nvObj_t *nv)
+{
+    PID *pid = _get_heater_pid(_get_heater_number(nv) - '0');
+    if (pid == nullptr) {
+        return (STAT_INPUT_VALUE_RANGE_ERROR);
+    }
+    nv->value_int = pid->_model._enable;
+    nv->valuetype = TYPE_BOOLEAN;
+    return (STAT_OK);
+}
+
+stat_t cm_set_heater_model_enable(nvObj_t *nv)
+{
+    PID *pid = _get_heater_pid(_get_heater_number(nv) - '0');
+    if (pid == nullptr) {
+        return (STAT_INPUT_VALUE_RANGE_ERROR);
+    }
+    pid->_model._enable = nv->value_int;
+    return (STAT_OK);
+}
+
+stat_t cm_get_heater_model(nvObj_t *nv)
+{
+    float *parameter = _get_model_parameter(nv);
+    nv->value_flt = (parameter == nullptr) ? 0.0 : *parameter;
+    nv->precision = GET_TABLE_WORD(precision);
+    nv->valuetype = TYPE_FLOAT;
+    return (STAT_OK);
+}
+
+stat_t cm_set_heater_model(nvObj_t *nv)
+{
+    float *parameter = _get_model_parameter(nv);
+    if (parameter == nullptr) {
+        return (STAT_INPUT_VALUE_RANGE_ERROR);
+    }
+    if (nv->value_flt < 0.0) {
+        return (STAT_INPUT_LESS_THAN_MIN_VALUE);
+    }
+    *parameter = nv->value_flt;
+    return (STAT_OK);
+}
+
 /****************************************************************************************
  * cm_get_set_temperature() - get the set value of the PID
  * cm_set_set_temperature() - set the set value of the PID
@@ -949,9 +1572,9 @@ stat_t cm_get_heater_output(nvObj_t *nv)
 stat_t cm_get_heater_adc(nvObj_t *nv)
 {
     switch(_get_heater_number(nv)) {
-        case '1': { nv->value_flt = (float)thermistor1.raw_adc_value; break; }
-        case '2': { nv->value_flt = (float)thermistor2.raw_adc_value; break; }
-        case '3': { nv->value_flt = (float)thermistor3.raw_adc_value; break; }
+        case '1': { nv->value_flt = thermistor1.raw_adc_value; break; }
+        case '2': { nv->value_flt = thermistor2.raw_adc_value; break; }
+        case '3': { nv->value_flt = thermistor3.raw_adc_value; break; }
         default: { nv->value_flt = 0.0; break; }
     }
     nv->precision = GET_TABLE_WORD(precision);
@@ -966,9 +1589,9 @@ stat_t cm_get_heater_adc(nvObj_t *nv)
 float cm_get_temperature(const uint8_t heater)
 {
     switch(heater) {
-        case 1: { return (last_reported_temp1 = thermistor1.temperature_exact()); }
-        case 2: { return (last_reported_temp2 = thermistor2.temperature_exact()); }
-        case 3: { return (last_reported_temp3 = thermistor3.temperature_exact()); }
+        case 1: { return (last_reported_temp1 = thermistor1.temperature()); }
+        case 2: { return (last_reported_temp2 = thermistor2.temperature()); }
+        case 3: { return (last_reported_temp3 = thermistor3.temperature()); }
         default: { break; }
     }
     return 0.0;
@@ -46,6 +46,15 @@ stat_t cm_get_heater_i(nvObj_t* nv);
 stat_t cm_set_heater_i(nvObj_t* nv);
 stat_t cm_get_heater_d(nvObj_t* nv);
 stat_t cm_set_heater_d(nvObj_t* nv);
+stat_t cm_start_heater_autotune(const uint8_t heater, const float temperature, const uint8_t cycles);
+stat_t cm_get_heater_autotune(nvObj_t* nv);
+stat_t cm_set_heater_autotune(nvObj_t* nv);
+stat_t cm_get_heater_ku(nvObj_t* nv);
+stat_t cm_get_heater_tu(nvObj_t* nv);
+stat_t cm_get_heater_model_enable(nvObj_t* nv);
+stat_t cm_set_heater_model_enable(nvObj_t* nv);
+stat_t cm_get_heater_model(nvObj_t* nv);
+stat_t cm_set_heater_model(nvObj_t* nv);
 stat_t cm_get_pid_p(nvObj_t* nv);
 stat_t cm_get_pid_i(nvObj_t* nv);
 stat_t cm_get_pid_d(nvObj_t* nv);
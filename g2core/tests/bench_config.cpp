@@ -0,0 +1,39 @@
+/*
+ * bench_config.cpp - nv_get_index() cost, linear scan vs sorted index
+ * This file is part of the g2core project
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "g2core.h"
+#include "config.h"
+#include "test.h"
+
+static void lookup_all()
+{
+    index_t index_max = nv_index_max();
+    for (index_t i=0; i < index_max; i++) {
+        bench_sink += nv_get_index("", cfgArray[i].token);
+    }
+    bench_sink += nv_get_index("", "zzzz");
+}
+
+int main()
+{
+    long count = 2000;
+    printf("%d tokens per pass\n", nv_index_max() + 1);
+    BENCH("nv_get_index linear scan", count, lookup_all());
+    nv_index_init();
+    BENCH("nv_get_index sorted index", count, lookup_all());
+    return (0);
+}
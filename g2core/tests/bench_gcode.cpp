@@ -0,0 +1,44 @@
+/*
+ * bench_gcode.cpp - Gcode block scanning cost per line
+ * This file is part of the g2core project
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "../gcode_parser.cpp"
+#include "test.h"
+
+static const char *lines[] = {
+    "G1 X10.5 Y-3.25 F1200",
+    "N123456 G1 X100.125 Y200.5 Z-1.25 A45 F3000*84",
+    "g0 x0123.004 y-0234.003 (plain comment here)",
+    "G2 X20 Y20 I5 J5 ({msg:\"arc\"}) (comment)",
+    "G1 X1 Y2 Z3 A4 B5 C6 U7 V8 W9 I1 J2 K3 R4",
+    "G1 X[2*3] Y[1/4] ; comment to end of line",
+};
+
+int main()
+{
+    static char line[RX_BUFFER_SIZE];
+    char *comment;
+    uint8_t block_delete;
+    long count = 500000;
+
+    for (const char *in : lines) {
+        BENCH(in, count, {
+            strcpy(line, in);
+            bench_sink += _scan_gcode_block(line, &comment, &block_delete);
+        });
+    }
+    return (0);
+}
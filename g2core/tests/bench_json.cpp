@@ -0,0 +1,43 @@
+/*
+ * bench_json.cpp - JSON input parser cost per command
+ * This file is part of the g2core project
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "../json_parser.cpp"
+#include "test.h"
+
+static const char *commands[] = {
+    "{\"gc\":\"G1 X10.125 Y-3.5 F1200\"}",
+    "{\"xvm\":1200.5}",
+    "{\"sr\":null}",
+    "{\"x\":{\"vm\":12000,\"fr\":8000,\"jm\":5000}}",
+    "{\"sr\":{\"posx\":t,\"posy\":t,\"posz\":t,\"vel\":t,\"stat\":t}}",
+    "{\"gc\":\"G2 X20 Y20 I5 J5 (arc with a long Comment here)\"}",
+};
+
+int main()
+{
+    static char buf[JSON_INPUT_STRING_MAX+1];
+    long count = 200000;
+
+    nv_index_init();
+    for (const char *cmd : commands) {
+        BENCH(cmd, count, {
+            strcpy(buf, cmd);
+            bench_sink += _json_parser_kernal(nv_reset_nv_list(), buf);
+        });
+    }
+    return (0);
+}
@@ -0,0 +1,40 @@
+/*
+ * bench_util.cpp - floattoa() against sprintf
+ * This file is part of the g2core project
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "g2core.h"
+#include "util.h"
+#include "test.h"
+
+#include <stdlib.h>
+
+#define VALUES 4096
+
+int main()
+{
+    static float values[VALUES];
+    char out[32];
+    long count = 500 * VALUES;
+
+    srand(1);
+    for (int i=0; i < VALUES; i++) {
+        values[i] = (rand() % 2000000 - 1000000) / 1000.0f;     // positions, mostly
+    }
+    BENCH("floattoa precision 3", count, bench_sink += floattoa(out, values[bench_pass % VALUES], 3, 16));
+    BENCH("sprintf %.3f", count, bench_sink += sprintf(out, "%.3f", (double)values[bench_pass % VALUES]));
+    BENCH("inttoa", count, bench_sink += inttoa(out, (int)(values[bench_pass % VALUES] * 1000)));
+    return (0);
+}
@@ -0,0 +1,142 @@
+/*
+ * host/MotateBuffer.h - serial transfer rings for host devices
+ * This file is part of the g2core project
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef MOTATEBUFFER_H_ONCE
+#define MOTATEBUFFER_H_ONCE
+
+#include <stdint.h>
+#include <string.h>
+
+namespace Motate {
+
+/* RXBuffer and TXBuffer - the transfer rings xio builds on
+ *
+ *  As in Motate, the owner (a pointer to the device) moves the data: the buffer hands it a
+ *  region with startRXTransfer() or startTXTransfer(), and the device calls back when the
+ *  transfer is done. The RX write offset is wherever the device has got to in the current
+ *  transfer, so bytes are readable as soon as they arrive. A device that never transfers
+ *  (getRXTransferPosition() returns nullptr) leaves the ring empty.
+ */
+
+template <uint16_t _size, typename owner_type, typename value_type = char>
+struct RXBuffer {
+    owner_type _owner;
+    value_type _data[_size];
+    uint16_t _read_offset = 0;
+    uint16_t _last_known_write_offset = 0;
+
+    RXBuffer(owner_type owner) : _owner{owner} {};
+
+    void init() {
+        _owner->setRXTransferDoneCallback([&]() { _restartTransfer(); });
+        _restartTransfer();
+    };
+
+    void flush() { _read_offset = _getWriteOffset(); };
+    bool isEmpty() { return (_read_offset == _getWriteOffset()); };
+
+    uint16_t _getWriteOffset() {
+        const value_type *position = _owner->getRXTransferPosition();
+        if ((position != nullptr) && (position >= _data) && (position <= (_data + _size))) {
+            _last_known_write_offset = (position - _data) % _size;
+        }
+        return (_last_known_write_offset);
+    };
+
+    // true if offset holds a byte that has been received and not yet read
+    bool _canBeRead(uint16_t offset) {
+        uint16_t write_offset = _getWriteOffset();
+        if (_read_offset <= write_offset) {
+            return ((offset >= _read_offset) && (offset < write_offset));
+        }
+        return ((offset >= _read_offset) || (offset < write_offset));
+    };
+
+    // start a transfer into the free space after the write offset, stopping short of the read offset
+    void _restartTransfer() {
+        uint16_t write_offset = _getWriteOffset();
+        uint16_t length;
+        if (_read_offset > write_offset) {
+            length = _read_offset - write_offset - 1;
+        } else {
+            length = _size - write_offset - ((_read_offset == 0) ? 1 : 0);
+        }
+        if (length == 0) {
+            return;
+        }
+        value_type *buffer = _data + write_offset;
+        _owner->startRXTransfer(buffer, length);    // refused while a transfer is already running
+    };
+};
+
+template <uint16_t _size, typename owner_type, typename value_type = char>
+struct TXBuffer {
+    owner_type _owner;
+    value_type _data[_size];
+    uint16_t _read_offset = 0;              // start of the bytes not yet sent
+    uint16_t _write_offset = 0;
+    uint16_t _transfer_length = 0;          // bytes in the transfer in progress, 0 if none
+
+    TXBuffer(owner_type owner) : _owner{owner} {};
+
+    void init() {
+        _owner->setTXTransferDoneCallback([&]() { _transferDone(); });
+    };
+
+    // drop anything not yet handed to the device - a transfer in progress is finished by the device
+    void flush() {
+        _read_offset = _write_offset = 0;
+        _transfer_length = 0;
+    };
+
+    bool isEmpty() { return ((_read_offset == _write_offset) && (_transfer_length == 0)); };
+
+    // copy in as much as fits, return the number of bytes taken
+    int16_t write(const value_type *buffer, uint16_t length) {
+        uint16_t available = (_read_offset + _size - _write_offset - 1) % _size;
+        if (length > available) {
+            length = available;
+        }
+        for (uint16_t i = 0; i < length; i++) {
+            _data[_write_offset] = buffer[i];
+            _write_offset = (_write_offset + 1) % _size;
+        }
+        _restartTransfer();
+        return (length);
+    };
+
+    void _restartTransfer() {
+        if ((_transfer_length != 0) || (_read_offset == _write_offset)) {
+            return;
+        }
+        uint16_t length = (_write_offset > _read_offset) ? (_write_offset - _read_offset) : (_size - _read_offset);
+        value_type *buffer = _data + _read_offset;
+        if (_owner->startTXTransfer(buffer, length)) {
+            _transfer_length = length;
+        }
+    };
+
+    void _transferDone() {
+        _read_offset = (_read_offset + _transfer_length) % _size;
+        _transfer_length = 0;
+        _restartTransfer();
+    };
+};
+
+}  // namespace Motate
+
+#endif  // MOTATEBUFFER_H_ONCE
@@ -0,0 +1,168 @@
+/*
+ * host/MotatePins.h - host stand-ins for the Motate pin classes used by the firmware
+ * This file is part of the g2core project
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef MOTATEPINS_H_ONCE
+#define MOTATEPINS_H_ONCE
+
+#include <stdint.h>
+#include "MotateTimers.h"
+
+// What a board pinout file would say. The host has USB serial only, and no heater outputs.
+// Job files are plain files in a directory (xio_stdio_storage in xio.cpp), and a Unix-domain
+// socket stands in for a serial port (device/host_socket).
+#define XIO_HAS_USB 1
+#define XIO_HAS_UART 0
+#define XIO_HAS_STORAGE 1
+#define XIO_HAS_STDIO_STORAGE 1
+#define XIO_HAS_HOST_SOCKET 1
+#define XIO_HAS_SPI 0
+#define XIO_HAS_I2C 0
+#define TEMPERATURE_OUTPUT_ON 0
+
+namespace Motate {
+
+typedef int16_t pin_number;
+
+enum PinMode { kUnchanged, kInput, kOutput };
+
+enum PinOptions {
+    kNormal = 0,
+    kStartHigh = 1 << 0,
+    kStartLow = 1 << 1,
+    kPullUp = 1 << 2,
+    kDebounce = 1 << 3,
+};
+
+enum PinInterruptOptions {
+    kPinInterruptOnChange = 1 << 0,
+    kPinInterruptOnRisingEdge = 1 << 1,
+    kPinInterruptOnFallingEdge = 1 << 2,
+    kInterruptPriorityLowest = 1 << 3,
+    kInterruptPriorityLow = 1 << 4,
+    kInterruptPriorityMedium = 1 << 5,
+    kInterruptPriorityHigh = 1 << 6,
+    kInterruptPriorityHighest = 1 << 7,
+    kPinInterruptPriorityMedium = kInterruptPriorityMedium,
+    kInterruptOnOverflow = 1 << 8,
+    kInterruptOnMatch = 1 << 9,
+    kInterruptOnSoftwareTrigger = 1 << 10,
+};
+
+// Pin numbers the firmware names directly. The board pinout files normally provide these.
+constexpr pin_number kOutputSAFE_PinNumber = 1;
+constexpr pin_number kADC0_PinNumber = 2;
+constexpr pin_number kADC1_PinNumber = 3;
+constexpr pin_number kADC2_PinNumber = 4;
+constexpr pin_number kLED_USBRXPinNumber = 5;
+constexpr pin_number kDebug1_PinNumber = 20;
+constexpr pin_number kDebug2_PinNumber = 21;
+constexpr pin_number kDebug3_PinNumber = 22;
+constexpr pin_number kDebug4_PinNumber = 23;
+constexpr pin_number kOutput1_PinNumber = 31;
+constexpr pin_number kOutput2_PinNumber = 32;
+constexpr pin_number kOutput3_PinNumber = 33;
+constexpr pin_number kOutput4_PinNumber = 34;
+constexpr pin_number kOutput5_PinNumber = 35;
+constexpr pin_number kOutput6_PinNumber = 36;
+constexpr pin_number kOutput7_PinNumber = 37;
+constexpr pin_number kOutput8_PinNumber = 38;
+constexpr pin_number kOutput9_PinNumber = 39;
+constexpr pin_number kOutput10_PinNumber = 40;
+constexpr pin_number kOutput11_PinNumber = 41;
+constexpr pin_number kOutput12_PinNumber = 42;
+constexpr pin_number kOutput13_PinNumber = 43;
+constexpr pin_number kInput1_PinNumber = 101;
+constexpr pin_number kInput2_PinNumber = 102;
+constexpr pin_number kInput3_PinNumber = 103;
+constexpr pin_number kInput4_PinNumber = 104;
+constexpr pin_number kInput5_PinNumber = 105;
+constexpr pin_number kInput6_PinNumber = 106;
+constexpr pin_number kInput7_PinNumber = 107;
+constexpr pin_number kInput8_PinNumber = 108;
+constexpr pin_number kInput9_PinNumber = 109;
+constexpr pin_number kInput10_PinNumber = 110;
+constexpr pin_number kInput11_PinNumber = 111;
+constexpr pin_number kInput12_PinNumber = 112;
+constexpr pin_number kSpindle_PwmPinNumber = 150;
+constexpr pin_number kSpindle_Pwm2PinNumber = 151;
+
+template<pin_number n>
+struct Pin {
+    Pin() {};
+    Pin(const PinMode, const int = kNormal) {};
+    void set() {};
+    void clear() {};
+    void write(const bool) {};
+    void toggle() {};
+    void setMode(const PinMode) {};
+    bool get() { return false; };
+    operator bool() { return false; };
+};
+
+template<pin_number n>
+struct OutputPin : Pin<n> {
+    OutputPin() {};
+    OutputPin(const int) {};
+    void operator=(const bool) {};
+};
+
+template<pin_number n>
+struct IRQPin : Pin<n> {
+    template<typename F> IRQPin(const int, F) {};
+    void setInterrupts(const int) {};
+};
+
+template<pin_number n>
+struct PWMOutputPin : Pin<n> {
+    PWMOutputPin() {};
+    PWMOutputPin(const int, const uint32_t = 0) {};
+    bool isNull() { return false; };
+    void setFrequency(const uint32_t) {};
+    void setInterrupts(const int) {};
+    void write(const float) {};
+    void operator=(const float) {};
+    operator float() { return 0.0; };
+};
+
+template<pin_number n>
+struct PWMLikeOutputPin : PWMOutputPin<n> {
+    PWMLikeOutputPin() {};
+};
+
+// An ADC pin with a 12 bit converter, as on the SAM3X and SAMS70. Tests set raw directly.
+template<pin_number n>
+struct ADCPin {
+    int32_t raw = 0;
+    ADCPin() {};
+    uint16_t getTop() { return 4095; };
+    int32_t getRaw() { return raw; };
+    float getVoltage() { return raw * 3.3 / 4095; };
+    void setInterrupts(const int) {};
+    static void startSampling() {};
+    static void interrupt();
+};
+
+typedef ADCPin<0> ADC_Module;
+
+}  // namespace Motate
+
+inline void __disable_irq() {}
+inline void __enable_irq() {}
+inline uint32_t __get_PRIMASK() { return 0; }
+inline uint32_t __get_IPSR() { return 0; }          // always thread mode
+
+#endif  // MOTATEPINS_H_ONCE
@@ -0,0 +1,56 @@
+/*
+ * host/MotateTimers.h - host stand-ins for the Motate SysTick timer and Timeout
+ * This file is part of the g2core project
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/*
+ *  SysTick time only moves when a test sets SysTickTimer.value (milliseconds) or calls delay().
+ */
+
+#ifndef MOTATETIMERS_H_ONCE
+#define MOTATETIMERS_H_ONCE
+
+#include <stdint.h>
+
+namespace Motate {
+
+struct SysTickEvent {
+    template<typename F> SysTickEvent(F, SysTickEvent *next_) : next{next_} {};
+    SysTickEvent *next;
+};
+
+struct SysTickTimer_t {
+    uint32_t value = 0;
+    uint32_t getValue() { return value; };
+    void registerEvent(SysTickEvent *) {};
+    void unregisterEvent(SysTickEvent *) {};
+};
+extern SysTickTimer_t SysTickTimer;
+
+inline void delay(const uint32_t ms) { SysTickTimer.value += ms; }
+
+struct Timeout {
+    uint32_t start = 0;
+    uint32_t length = 0;
+    bool is_set = false;
+
+    bool isSet() { return is_set; };
+    bool isPast() { return is_set && ((SysTickTimer.getValue() - start) >= length); };
+    void set(const uint32_t length_) { start = SysTickTimer.getValue(); length = length_; is_set = true; };
+    void clear() { is_set = false; };
+};
+
+}  // namespace Motate
+
+#endif  // MOTATETIMERS_H_ONCE
@@ -0,0 +1,52 @@
+/*
+ * host/board_stepper.h - motors that accept every call and do nothing
+ * This file is part of the g2core project
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef BOARD_STEPPER_H_ONCE
+#define BOARD_STEPPER_H_ONCE
+
+#include "hardware.h"
+
+struct HostStepper {
+    void init() {};
+    void enable() {};
+    void disable() {};
+    void motionStopped() {};
+    void step() {};
+    void stepEnd() {};
+    void setDirection(uint8_t) {};
+    void setMicrosteps(uint16_t) {};
+    void setPowerLevel(float) {};
+    void setPowerMode(uint8_t) {};
+    void setActivityTimeout(float) {};
+    void setStepPolarity(uint8_t) {};
+    void setEnablePolarity(uint8_t) {};
+    void periodicCheck(bool) {};
+    uint8_t getPowerMode() { return 0; };
+    uint8_t getStepPolarity() { return 0; };
+    uint8_t getEnablePolarity() { return 0; };
+    float getCurrentPowerLevel() { return 0.0; };
+    bool isEnabled() { return false; };
+};
+
+extern HostStepper motor_1, motor_2, motor_3, motor_4, motor_5, motor_6;
+
+class Stepper;
+extern Stepper* Motors[MOTORS];
+
+void board_stepper_init();
+
+#endif  // BOARD_STEPPER_H_ONCE
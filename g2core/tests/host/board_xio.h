@@ -0,0 +1,43 @@
+/*
+ * host/board_xio.h - a USB serial port that is never connected
+ * This file is part of the g2core project
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef BOARD_XIO_H_ONCE
+#define BOARD_XIO_H_ONCE
+
+#include "settings.h"
+#include <functional>
+
+struct HostSerial {
+    bool isConnected() { return false; };
+    void setConnectionCallback(std::function<void(bool)> &&) {};
+    void setRXTransferDoneCallback(std::function<void()> &&) {};
+    void setTXTransferDoneCallback(std::function<void()> &&) {};
+    const char *getRXTransferPosition() { return nullptr; };
+    const char *getTXTransferPosition() { return nullptr; };
+    bool startRXTransfer(char *&, uint16_t) { return false; };     // never connected, nothing moves
+    bool startTXTransfer(char *&, uint16_t) { return false; };
+    void flush() {};
+    void flushRead() {};
+};
+
+extern HostSerial SerialUSB;
+extern HostSerial SerialUSB1;
+
+void board_hardware_init(void);
+void board_xio_init(void);
+
+#endif  // BOARD_XIO_H_ONCE
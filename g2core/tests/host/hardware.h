@@ -0,0 +1,96 @@
+/*
+ * host/hardware.h - the host "board" for the tests: no motors to speak of, no timers that run
+ * This file is part of the g2core project
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "config.h"
+#include "error.h"
+
+#ifndef HARDWARE_H_ONCE
+#define HARDWARE_H_ONCE
+
+#define G2CORE_HARDWARE_PLATFORM    "host"
+#define G2CORE_HARDWARE_VERSION     "test"
+
+#define MOTORS 6                    // number of motors supported the hardware
+#define PWMS 2                      // number of PWM channels supported the hardware
+#define MILLISECONDS_PER_TICK 1     // MS for system tick (systick * N)
+#define SYS_ID_DIGITS 16            // actual digits in system ID (up to 16)
+#define SYS_ID_LEN 24               // total length including dashes and NUL
+
+#include "MotatePins.h"
+#include "MotateTimers.h"
+
+using Motate::pin_number;
+using Motate::Pin;
+using Motate::PWMOutputPin;
+using Motate::OutputPin;
+
+#define FREQUENCY_DDA		150000UL
+#define FREQUENCY_DWELL		1000UL
+#define FREQUENCY_SGI		200000UL
+
+// stepper.cpp isn't built for the host, but stepper.h names the timer types
+struct HostTimer {
+    HostTimer() {};
+    template<typename... A> HostTimer(A...) {};
+    template<typename... A> void setModeAndFrequency(A...) {};
+    template<typename... A> void setInterrupts(A...) {};
+    void start() {};
+    void stop() {};
+    void setInterruptPending() {};
+    int getInterruptCause() { return 0; };
+};
+typedef HostTimer dda_timer_type;
+typedef HostTimer exec_timer_type;
+typedef HostTimer fwd_plan_timer_type;
+
+static PWMOutputPin<Motate::kLED_USBRXPinNumber> IndicatorLed;
+static OutputPin<10> spindle_enable_pin;
+static OutputPin<11> spindle_dir_pin;
+static OutputPin<12> flood_enable_pin;
+static OutputPin<13> mist_enable_pin;
+
+void hardware_init(void);			// master hardware init
+stat_t hardware_periodic();  // callback from the main loop (time sensitive)
+void hw_hard_reset(void);
+stat_t hw_flash(nvObj_t *nv);
+stat_t hw_get_fb(nvObj_t *nv);
+stat_t hw_get_fv(nvObj_t *nv);
+stat_t hw_get_hp(nvObj_t *nv);
+stat_t hw_get_hv(nvObj_t *nv);
+stat_t hw_get_fbs(nvObj_t *nv);
+stat_t hw_get_fbc(nvObj_t *nv);
+stat_t hw_get_id(nvObj_t *nv);
+
+#ifdef __TEXT_MODE
+    void hw_print_fb(nvObj_t *nv);
+    void hw_print_fv(nvObj_t *nv);
+    void hw_print_fbs(nvObj_t *nv);
+    void hw_print_fbc(nvObj_t *nv);
+    void hw_print_hp(nvObj_t *nv);
+    void hw_print_hv(nvObj_t *nv);
+    void hw_print_id(nvObj_t *nv);
+#else
+    #define hw_print_fb tx_print_stub
+    #define hw_print_fv tx_print_stub
+    #define hw_print_fbs tx_print_stub
+    #define hw_print_fbc tx_print_stub
+    #define hw_print_hp tx_print_stub
+    #define hw_print_hv tx_print_stub
+    #define hw_print_id tx_print_stub
+#endif // __TEXT_MODE
+
+#endif	// end of include guard: HARDWARE_H_ONCE
@@ -0,0 +1,168 @@
+/*
+ * host/host_stubs.cpp - the board and stepper symbols the host build links against
+ * This file is part of the g2core project
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/*
+ * main.cpp, stepper.cpp and gpio.cpp touch the hardware directly and are left out of the
+ * host build. Everything the rest of the firmware calls in them is stubbed here: the
+ * getters and setters report STAT_OK and leave the nvObj untouched, motion calls do nothing.
+ */
+
+#include "g2core.h"
+#include "config.h"
+#include "hardware.h"
+#include "stepper.h"
+#include "gpio.h"
+#include "xio.h"
+#include "board_xio.h"
+#include "board_stepper.h"
+
+/**** main.cpp ****/
+
+stat_t status_code;
+
+char *get_status_message(stat_t status)
+{
+    return ((char *)GET_TEXT_ITEM(stat_msg, status));
+}
+
+/**** Motate and board ****/
+
+Motate::SysTickTimer_t Motate::SysTickTimer;
+HostSerial SerialUSB;
+HostSerial SerialUSB1;
+HostStepper motor_1, motor_2, motor_3, motor_4, motor_5, motor_6;
+
+void board_xio_init(void) {}
+void hw_hard_reset(void) {}
+stat_t hardware_periodic() { return (STAT_OK); }
+
+#define NV_STUB(f) stat_t f(nvObj_t *nv) { return (STAT_OK); }
+#define PRINT_STUB(f) void f(nvObj_t *nv) {}
+
+NV_STUB(hw_flash)
+NV_STUB(hw_get_fb)
+NV_STUB(hw_get_fbc)
+NV_STUB(hw_get_fbs)
+NV_STUB(hw_get_fv)
+NV_STUB(hw_get_hp)
+NV_STUB(hw_get_hv)
+NV_STUB(hw_get_id)
+
+/**** gpio.cpp ****/
+
+void gpio_set_homing_mode(const uint8_t input_num, const bool is_homing) {}
+void gpio_set_probing_mode(const uint8_t input_num, const bool is_probing) {}
+int8_t gpio_get_probing_input(void) { return (-1); }
+bool gpio_read_input(const uint8_t input_num) { return (false); }
+float gpio_get_output(const uint8_t output_num) { return (0.0); }
+
+stat_t gpio_output_control(const ioOutputControl control, const float P_word, const bool P_flag,
+                           const float Q_word, const bool Q_flag)
+{
+    return (STAT_OK);
+}
+
+NV_STUB(io_get_mo)
+NV_STUB(io_set_mo)
+NV_STUB(io_get_ac)
+NV_STUB(io_set_ac)
+NV_STUB(io_get_fn)
+NV_STUB(io_set_fn)
+NV_STUB(io_get_input)
+NV_STUB(io_get_domode)
+NV_STUB(io_set_domode)
+NV_STUB(io_get_output)
+NV_STUB(io_set_output)
+
+/**** stepper.cpp ****/
+
+stConfig_t st_cfg;
+stPrepSingleton_t st_pre;
+
+void stepper_reset(void) {}
+stat_t stepper_test_assertions(void) { return (STAT_OK); }
+bool st_runtime_isbusy(void) { return (false); }
+uint32_t st_get_dda_ticks_remaining(void) { return (0); }
+stat_t st_motor_power_callback(void) { return (STAT_OK); }
+void st_request_forward_plan(void) {}
+void st_request_exec_move(void) {}
+void st_prep_null(void) {}
+void st_prep_command(void *bf) {}
+void st_prep_dwell(float microseconds) {}
+void st_prep_out_of_band_dwell(float microseconds) {}
+void st_prep_laser(float duty) {}
+void st_prep_outputs(const uint16_t on, const uint16_t off) {}
+stat_t st_prep_line(float travel_steps[], float following_error[], float segment_time) { return (STAT_OK); }
+
+NV_STUB(st_clc)
+NV_STUB(st_get_ma)
+NV_STUB(st_set_ma)
+NV_STUB(st_get_sa)
+NV_STUB(st_set_sa)
+NV_STUB(st_get_tr)
+NV_STUB(st_set_tr)
+NV_STUB(st_get_mi)
+NV_STUB(st_set_mi)
+NV_STUB(st_get_su)
+NV_STUB(st_set_su)
+NV_STUB(st_get_po)
+NV_STUB(st_set_po)
+NV_STUB(st_get_ep)
+NV_STUB(st_set_ep)
+NV_STUB(st_get_sp)
+NV_STUB(st_set_sp)
+NV_STUB(st_get_pm)
+NV_STUB(st_set_pm)
+NV_STUB(st_get_pl)
+NV_STUB(st_set_pl)
+NV_STUB(st_get_pwr)
+NV_STUB(st_get_mt)
+NV_STUB(st_set_mt)
+NV_STUB(st_set_md)
+NV_STUB(st_set_me)
+NV_STUB(st_get_dw)
+
+#ifdef __TEXT_MODE
+
+PRINT_STUB(hw_print_fb)
+PRINT_STUB(hw_print_fbc)
+PRINT_STUB(hw_print_fbs)
+PRINT_STUB(hw_print_fv)
+PRINT_STUB(hw_print_hp)
+PRINT_STUB(hw_print_hv)
+PRINT_STUB(hw_print_id)
+PRINT_STUB(io_print_mo)
+PRINT_STUB(io_print_ac)
+PRINT_STUB(io_print_fn)
+PRINT_STUB(io_print_in)
+PRINT_STUB(io_print_domode)
+PRINT_STUB(io_print_out)
+PRINT_STUB(st_print_ma)
+PRINT_STUB(st_print_sa)
+PRINT_STUB(st_print_tr)
+PRINT_STUB(st_print_mi)
+PRINT_STUB(st_print_su)
+PRINT_STUB(st_print_po)
+PRINT_STUB(st_print_ep)
+PRINT_STUB(st_print_sp)
+PRINT_STUB(st_print_pm)
+PRINT_STUB(st_print_pl)
+PRINT_STUB(st_print_pwr)
+PRINT_STUB(st_print_mt)
+PRINT_STUB(st_print_me)
+PRINT_STUB(st_print_md)
+
+#endif // __TEXT_MODE
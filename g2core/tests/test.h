@@ -0,0 +1,63 @@
+/*
+ * test.h - check and benchmark helpers for the host tests
+ * This file is part of the g2core project
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/*
+ * Each test_*.cpp and bench_*.cpp is its own program. CHECK() records a failure and
+ * carries on; test_exit() prints the tally and returns the process status. BENCH()
+ * runs a body 'count' times and prints the mean time per pass; the body can read the
+ * pass number as bench_pass.
+ */
+
+#ifndef TEST_H_ONCE
+#define TEST_H_ONCE
+
+#include <stdio.h>
+#include <chrono>
+
+static int test_checks = 0;
+static int test_failures = 0;
+
+#define CHECK(cond) _test_check((cond), #cond, __FILE__, __LINE__)
+#define CHECK_MSG(cond, ...) do { if (!CHECK(cond)) { printf("    "); printf(__VA_ARGS__); printf("\n"); } } while (0)
+
+static inline bool _test_check(bool ok, const char *what, const char *file, int line)
+{
+    test_checks++;
+    if (!ok) {
+        test_failures++;
+        printf("%s:%d: FAILED: %s\n", file, line, what);
+    }
+    return (ok);
+}
+
+static inline int test_exit(const char *name)
+{
+    printf("%s: %d checks, %d failed\n", name, test_checks, test_failures);
+    return (test_failures ? 1 : 0);
+}
+
+static volatile int bench_sink;     // results written here are not optimised away
+
+#define BENCH(label, count, body)                                                           \
+    do {                                                                                    \
+        auto _start = std::chrono::steady_clock::now();                                     \
+        for (long bench_pass = 0; bench_pass < (long)(count); bench_pass++) { body; }      \
+        auto _end = std::chrono::steady_clock::now();                                       \
+        double _ns = std::chrono::duration<double, std::nano>(_end - _start).count();       \
+        printf("%-40s %10.1f ns/pass  (%ld passes)\n", label, _ns / (count), (long)(count)); \
+    } while (0)
+
+#endif  // TEST_H_ONCE
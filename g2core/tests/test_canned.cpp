@@ -0,0 +1,205 @@
+/*
+ * test_canned.cpp - canned drilling cycles: the moves, dwells and spindle commands queued
+ * This file is part of the g2core project
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/*
+ * Includes cycle_canned.cpp to tell its spindle execs apart. Blocks go through the Gcode
+ * parser, cm_canned_cycle_callback() is called as the main loop would, and the planner
+ * queue is emptied as it fills - the buffers are written down and the spindle commands
+ * run, as the runtime would run them.
+ */
+
+#include "../cycle_canned.cpp"
+#include "controller.h"
+#include "gcode_parser.h"
+#include "persistence.h"
+#include "xio.h"
+#include "test.h"
+
+#include <string>
+
+static std::string queued;                  // what was queued, '|' separated
+
+static const char *_spindle_state()
+{
+    return ((spindle.state == SPINDLE_CW) ? "CW" : (spindle.state == SPINDLE_CCW) ? "CCW" : "OFF");
+}
+
+static void drain()
+{
+    char entry[64];
+    while (mp_get_r() != mp_get_w()) {                      // queued, planned or not
+        mpBuf_t *bf = mp_get_r();
+        if (bf->block_type == BLOCK_TYPE_ALINE) {
+            sprintf(entry, "G%d X%g Y%g Z%g", (bf->gm.motion_mode == MOTION_MODE_STRAIGHT_TRAVERSE) ? 0 : 1,
+                    (double)bf->gm.target[AXIS_X], (double)bf->gm.target[AXIS_Y], (double)bf->gm.target[AXIS_Z]);
+        } else if (bf->block_type == BLOCK_TYPE_DWELL) {
+            sprintf(entry, "G4 P%g", (double)bf->block_time);
+        } else if (bf->block_type == BLOCK_TYPE_COMMAND) {
+            bf->cm_func(bf->unit, bf->axis_flags);
+            sprintf(entry, "%s %s", (bf->cm_func == _exec_spindle_stop) ? "stop" :
+                                    (bf->cm_func == _exec_spindle_reverse) ? "reverse" :
+                                    (bf->cm_func == _exec_spindle_restore) ? "restore" : "command", _spindle_state());
+        } else {
+            sprintf(entry, "type %d", bf->block_type);
+        }
+        queued += queued.empty() ? "" : "|";
+        queued += entry;
+        mp_free_run_buffer();
+    }
+}
+
+// run a block and the cycle it starts - returns the block's status
+static stat_t gcode(const char *block)
+{
+    char line[RX_BUFFER_SIZE];
+    strcpy(line, block);
+    queued.clear();
+    stat_t status = gcode_parser(line);
+    int calls = 0;
+    while ((cm_canned_cycle_callback() == STAT_EAGAIN) && (calls++ < 1000)) {
+        drain();
+    }
+    drain();
+    return (status);
+}
+
+static void start_at(const char *position)
+{
+    CHECK(gcode("G80 G17 G21 G90 G94") == STAT_OK);
+    CHECK(gcode(position) == STAT_OK);
+}
+
+static bool at(float x, float y, float z)
+{
+    return (fp_EQ(cm->gmx.position[AXIS_X], x) && fp_EQ(cm->gmx.position[AXIS_Y], y) &&
+            fp_EQ(cm->gmx.position[AXIS_Z], z));
+}
+
+static void test_g81()
+{
+    // G99 retracts to R, and the next hole starts from there
+    start_at("G0 X0 Y0 Z10");
+    CHECK(gcode("G99 G81 X10 Y10 Z-5 R1 F300") == STAT_OK);
+    CHECK_MSG(queued == "G0 X10 Y10 Z10|G0 X10 Y10 Z1|G1 X10 Y10 Z-5|G0 X10 Y10 Z1", "'%s'", queued.c_str());
+    CHECK(at(10, 10, 1));
+    CHECK(gcode("X20") == STAT_OK);                             // R and Z are sticky
+    CHECK_MSG(queued == "G0 X20 Y10 Z1|G1 X20 Y10 Z-5|G0 X20 Y10 Z1", "'%s'", queued.c_str());
+    CHECK(gcode("F200") == STAT_OK);                            // no hole words - no hole
+    CHECK_MSG(queued.empty(), "'%s'", queued.c_str());
+
+    // G98 retracts to where the block started
+    start_at("G0 X0 Y0 Z10");
+    CHECK(gcode("G98 G81 X10 Y10 Z-5 R1 F300") == STAT_OK);
+    CHECK_MSG(queued == "G0 X10 Y10 Z10|G0 X10 Y10 Z1|G1 X10 Y10 Z-5|G0 X10 Y10 Z10", "'%s'", queued.c_str());
+    CHECK(at(10, 10, 10));
+
+    // ...or to R if that is higher, after a rapid up to R before moving across
+    start_at("G0 X0 Y0 Z0");
+    CHECK(gcode("G98 G81 X10 Y10 Z-5 R1 F300") == STAT_OK);
+    CHECK_MSG(queued == "G0 X0 Y0 Z1|G0 X10 Y10 Z1|G1 X10 Y10 Z-5|G0 X10 Y10 Z1", "'%s'", queued.c_str());
+    CHECK(at(10, 10, 1));
+}
+
+static void test_g83()
+{
+    start_at("G0 X0 Y0 Z10");
+    CHECK(gcode("G98 G83 Z-5 R1 Q2 F300") == STAT_OK);
+    CHECK_MSG(queued == "G0 X0 Y0 Z1|"
+                        "G1 X0 Y0 Z-1|G0 X0 Y0 Z1|G0 X0 Y0 Z-0.75|"     // back down to the peck clearance
+                        "G1 X0 Y0 Z-3|G0 X0 Y0 Z1|G0 X0 Y0 Z-2.75|"
+                        "G1 X0 Y0 Z-5|G0 X0 Y0 Z10", "'%s'", queued.c_str());
+}
+
+static void test_g91_repeats()
+{
+    // steps by X each repeat, R from the start level, Z from R
+    start_at("G0 X0 Y0 Z10");
+    CHECK(gcode("G91 G99 G81 X5 Z-6 R-9 L3 F300") == STAT_OK);
+    CHECK_MSG(queued == "G0 X5 Y0 Z10|G0 X5 Y0 Z1|G1 X5 Y0 Z-5|G0 X5 Y0 Z1|"
+                        "G0 X10 Y0 Z1|G1 X10 Y0 Z-5|G0 X10 Y0 Z1|"
+                        "G0 X15 Y0 Z1|G1 X15 Y0 Z-5|G0 X15 Y0 Z1", "'%s'", queued.c_str());
+    CHECK(at(15, 0, 1));
+    CHECK((gcode("G90") == STAT_OK) && queued.empty());          // a modal word alone doesn't drill
+}
+
+static void test_dwell_and_spindle()
+{
+    start_at("G0 X0 Y0 Z10");
+    CHECK(gcode("G99 G82 Z-5 R1 P0.5 F300") == STAT_OK);
+    CHECK_MSG(queued == "G0 X0 Y0 Z1|G1 X0 Y0 Z-5|G4 P0.5|G0 X0 Y0 Z1", "'%s'", queued.c_str());
+    CHECK(gcode("G89 Z-4") == STAT_OK);                         // P is sticky, feeds out
+    CHECK_MSG(queued == "G1 X0 Y0 Z-4|G4 P0.5|G1 X0 Y0 Z1", "'%s'", queued.c_str());
+
+    // G84 reverses the spindle at the bottom, feeds out and puts it back
+    spindle_control_immediate(SPINDLE_CW);
+    start_at("G0 X0 Y0 Z10");
+    CHECK(gcode("G98 G84 Z-5 R1 F300") == STAT_OK);
+    CHECK_MSG(queued == "G0 X0 Y0 Z1|G1 X0 Y0 Z-5|reverse CCW|G1 X0 Y0 Z1|G0 X0 Y0 Z10|restore CW", "'%s'", queued.c_str());
+    CHECK(spindle.state == SPINDLE_CW);
+
+    // G86 stops it at the bottom and starts it again after the rapid out
+    CHECK(gcode("G86 X5") == STAT_OK);
+    CHECK_MSG(queued == "G0 X5 Y0 Z10|G0 X5 Y0 Z1|G1 X5 Y0 Z-5|stop OFF|G0 X5 Y0 Z10|restore CW", "'%s'", queued.c_str());
+    CHECK(spindle.state == SPINDLE_CW);
+
+    // ...and leaves a stopped spindle stopped
+    spindle_control_immediate(SPINDLE_OFF);
+    CHECK(gcode("G86 X0") == STAT_OK);
+    CHECK_MSG(queued == "G0 X0 Y0 Z10|G0 X0 Y0 Z1|G1 X0 Y0 Z-5|stop OFF|G0 X0 Y0 Z10|restore OFF", "'%s'", queued.c_str());
+}
+
+static void test_errors()
+{
+    start_at("G0 X0 Y0 Z10");
+    CHECK(gcode("G81 X1 Z-5 F300") == STAT_R_WORD_IS_MISSING);
+    CHECK(gcode("G80") == STAT_OK);                             // forgets the sticky Z
+    CHECK(gcode("G81 X1 R1 F300") == STAT_AXIS_IS_MISSING);
+    CHECK(gcode("G80") == STAT_OK);
+    CHECK(gcode("G83 X1 Z-5 R1 F300") == STAT_Q_WORD_IS_MISSING);
+    CHECK(gcode("G83 X1 Q-1") == STAT_Q_WORD_IS_INVALID);
+    CHECK(gcode("G81 X1 Z2 R1 F300") == STAT_R_WORD_IS_INVALID);    // R below Z
+    CHECK(gcode("G81 X1 Z1 R1 F300") == STAT_R_WORD_IS_INVALID);
+    CHECK(gcode("G82 X1 Z-5 R1 P-1 F300") == STAT_P_WORD_IS_NEGATIVE);
+    CHECK(gcode("G80") == STAT_OK);
+    CHECK(gcode("G81 X1 Z-5 R1 L0 F300") == STAT_L_WORD_IS_INVALID);
+    CHECK(gcode("G93 G81 X1 Z-5 R1 F1") == STAT_INVERSE_TIME_MODE_CANNOT_BE_USED);
+    CHECK(gcode("G94 G80") == STAT_OK);
+    CHECK(queued.empty());                                      // none of them moved...
+    CHECK(at(0, 0, 10));                                        // ...even in the model
+    CHECK(cm_canned_cycle_callback() == STAT_NOOP);
+}
+
+int main()
+{
+    remove(NVM_FILE);
+    persistence_init();
+    xio_init();
+    cm = &cm1;
+    canonical_machine_inits();
+    controller_init();
+    config_init();
+    canonical_machine_reset_rotation(cm);
+    for (uint8_t axis = AXIS_X; axis <= AXIS_Z; axis++) {
+        cm->a[axis].axis_mode = AXIS_STANDARD;              // the default settings leave them disabled
+    }
+
+    test_g81();
+    test_g83();
+    test_g91_repeats();
+    test_dwell_and_spindle();
+    test_errors();
+    return (test_exit("test_canned"));
+}
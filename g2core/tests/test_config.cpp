@@ -0,0 +1,62 @@
+/*
+ * test_config.cpp - nv_get_index() binary search against the linear scan
+ * This file is part of the g2core project
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "g2core.h"
+#include "config.h"
+#include "test.h"
+
+#include <string>
+#include <vector>
+
+static const char *misses[] = { "", "q", "zzzz", "1zz", "xvmq", "stat3", "fbx", "~", "!" };
+
+int main()
+{
+    index_t index_max = nv_index_max();
+    std::vector<index_t> scanned;
+
+    // nv_get_index() falls back to the linear scan until the index is sorted
+    for (index_t i=0; i < index_max; i++) {
+        scanned.push_back(nv_get_index("", cfgArray[i].token));
+    }
+    std::vector<index_t> scanned_misses;
+    for (const char *m : misses) {
+        scanned_misses.push_back(nv_get_index("", m));
+    }
+
+    nv_index_init();
+
+    for (index_t i=0; i < index_max; i++) {
+        const char *token = cfgArray[i].token;
+        index_t found = nv_get_index("", token);
+        CHECK_MSG(found == scanned[i], "token '%s': search %d, scan %d", token, found, scanned[i]);
+        CHECK_MSG(found <= i, "token '%s' at %d resolved to later entry %d", token, i, found);
+        CHECK_MSG(strncmp(cfgArray[found].token, token, 5) == 0, "token '%s' resolved to '%s'", token, cfgArray[found].token);
+    }
+    for (size_t m=0; m < sizeof(misses)/sizeof(misses[0]); m++) {
+        CHECK_MSG(nv_get_index("", misses[m]) == scanned_misses[m], "miss '%s'", misses[m]);
+    }
+    CHECK(nv_get_index("", "zzzz") == NO_MATCH);
+
+    // group + token is the same lookup as the joined token
+    CHECK(nv_get_index("1", "ma") == nv_get_index("", "1ma"));
+    CHECK(nv_get_index("x", "vm") == nv_get_index("", "xvm"));
+    CHECK(nv_get_index("sys", "") == nv_get_index("", "sys"));
+    CHECK(nv_get_index("1", "ma") != NO_MATCH);
+
+    return (test_exit("test_config"));
+}
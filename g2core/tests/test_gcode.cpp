@@ -0,0 +1,417 @@
+/*
+ * test_gcode.cpp - Gcode block scanning, parameters, expressions and O word programs
+ * This file is part of the g2core project
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/*
+ * Includes gcode_parser.cpp to reach _scan_gcode_block() and the scanned word list, and
+ * gcode_program.cpp to see how much of the program store is in use.
+ * Programs are run the way the controller runs them: each line goes through
+ * gcode_program_filter(), and the store is replayed before the next line is streamed.
+ */
+
+#include "../gcode_parser.cpp"
+#include "../gcode_program.cpp"
+#include "test.h"
+
+#include <climits>
+#include <string>
+#include <vector>
+
+static char line[RX_BUFFER_SIZE];
+static char *comment;
+static uint8_t block_delete;
+
+static stat_t scan(const char *in)
+{
+    strcpy(line, in);
+    return (_scan_gcode_block(line, &comment, &block_delete));
+}
+
+static void test_normalize()
+{
+    CHECK((scan("g1 x100 Y100 f400") == STAT_OK) && (strcmp(line, "G1X100Y100F400") == 0));
+    CHECK((scan("G1 X0123.004 Y-0234.003") == STAT_OK) && (strcmp(line, "G1X123.004Y-234.003") == 0));
+    CHECK((scan("G0 X1 (plain comment) Y2") == STAT_OK) && (strcmp(line, "G0X1Y2") == 0));
+    CHECK((scan("G0 X1 ; rest of line") == STAT_OK) && (strcmp(line, "G0X1") == 0));
+    CHECK((scan("G0 ({blah: t}) x10 (comment)") == STAT_OK) && (strcmp(line, "G0X10") == 0));
+    CHECK(strcmp(comment, "{blah:t}") == 0);
+    CHECK((scan("/G1 X5") == STAT_OK) && block_delete);
+    CHECK((scan("G1 X5") == STAT_OK) && !block_delete);
+}
+
+static void test_words()
+{
+    CHECK(scan("N12 G1 X-10.5 Y.25 F1200") == STAT_OK);
+    CHECK((gp.words == 5) && (gp.word_status == STAT_COMPLETE));
+    CHECK((gp.word[0].letter == 'N') && (gp.word[0].value_int == 12));
+    CHECK((gp.word[1].letter == 'G') && (gp.word[1].value == 1));
+    CHECK((gp.word[2].letter == 'X') && (gp.word[2].value == -10.5) && (gp.word[2].value_int == -10));
+    CHECK((gp.word[3].letter == 'Y') && (gp.word[3].value == 0.25f));
+    CHECK((gp.word[4].letter == 'F') && (gp.word[4].value == 1200));
+    CHECK(line[gp.word[2].next] == 'Y');
+
+    CHECK((scan("N123456789 G1") == STAT_OK) && (gp.word[0].value_int == 123456789));   // over 2^24
+    CHECK((scan("G1 X1.23456789012") == STAT_OK) && (fabs(gp.word[1].value - 1.23456789) < 1e-6));
+
+    CHECK((scan("G1 X--1") == STAT_OK) && (gp.word_status == STAT_INVALID_OR_MALFORMED_COMMAND));
+    CHECK((scan("G1 X Y1") == STAT_OK) && (gp.word_status == STAT_BAD_NUMBER_FORMAT));
+}
+
+static void test_saturation()
+{
+    // integer parts saturate at +/-INT32_MAX instead of wrapping
+    CHECK((scan("N2147483647") == STAT_OK) && (gp.word[0].value_int == INT32_MAX));
+    CHECK((scan("N2147483648") == STAT_OK) && (gp.word[0].value_int == INT32_MAX));
+    CHECK((scan("N99999999999999999999") == STAT_OK) && (gp.word[0].value_int == INT32_MAX));
+    CHECK((scan("X-99999999999") == STAT_OK) && (gp.word[0].value_int == -INT32_MAX));
+    CHECK(gp.word[0].value == -99999999999.0f);
+    CHECK((scan("P4294967297") == STAT_OK) && (gp.word[0].value_int == INT32_MAX));     // 2^32+1 doesn't wrap to 1
+    CHECK((scan("X[1000000000000]") == STAT_OK) && (gp.word[0].value_int == INT32_MAX));
+    CHECK((scan("X-[1000000000000]") == STAT_OK) && (gp.word[0].value_int == -INT32_MAX));
+}
+
+static void test_checksum()
+{
+    char in[32];
+    uint8_t sum = 0;
+    for (const char *p = "N5 G1X1"; *p; p++) { sum ^= *p; }
+    sprintf(in, "N5 G1X1*%d", sum);
+    CHECK((scan(in) == STAT_OK) && gp.checksum && (strcmp(line, "N5G1X1") == 0));
+    sprintf(in, "N5 G1X1*%d", sum ^ 1);
+    CHECK(scan(in) == STAT_CHECKSUM_MATCH_FAILED);
+}
+
+/**** expressions ****/
+
+static stat_t eval(const char *expr, float *value)
+{
+    const char *p = expr;
+    return (gcode_expression_value(&p, value));
+}
+
+static bool is_value(const char *expr, float expect)
+{
+    float value;
+    return ((eval(expr, &value) == STAT_OK) && (fabs(value - expect) < 0.0001));
+}
+
+static void test_precedence()
+{
+    CHECK(is_value("[2+3*4]", 14));
+    CHECK(is_value("[[2+3]*4]", 20));
+    CHECK(is_value("[2*3**2]", 18));                    // ** binds tighter than *
+    CHECK(is_value("[2**3**2]", 64));                   // left to right
+    CHECK(is_value("[-2**2]", 4));                      // the sign belongs to the operand
+    CHECK(is_value("[10-4-3]", 3));
+    CHECK(is_value("[10/4]", 2.5));
+    CHECK(is_value("[7 MOD 3]", 1));
+    CHECK(is_value("[-7 MOD 3]", 2));                   // MOD is never negative
+    CHECK(is_value("[7.5 mod 2]", 1.5));
+    CHECK(is_value("[1+2 EQ 3]", 1));                   // comparisons after arithmetic
+    CHECK(is_value("[1 LT 2 AND 3 GT 4]", 0));          // logic after comparisons
+    CHECK(is_value("[1 OR 0 XOR 1]", 0));
+    CHECK(is_value("[2 NE 2.000001]", 0));               // compared within EPSILON
+    CHECK(is_value("SQRT[16]", 4));
+    CHECK(is_value("[ABS[-3] + FUP[1.2] + FIX[-1.5]]", 3));
+    CHECK(is_value("ATAN[1]/[1]", 45));                 // degrees
+    CHECK(is_value("COS[60]", 0.5));
+    CHECK(is_value("-+-5", 5));
+
+    float value;
+    const char *p = "[1+1]X5";
+    CHECK((gcode_expression_value(&p, &value) == STAT_OK) && (*p == 'X'));     // left past the operand
+    CHECK(eval("[1+]", &value) == STAT_EXPRESSION_SYNTAX_ERROR);
+    CHECK(eval("[1", &value) == STAT_EXPRESSION_SYNTAX_ERROR);
+    CHECK(eval("FOO[1]", &value) == STAT_EXPRESSION_SYNTAX_ERROR);
+    CHECK(eval("ATAN[1]", &value) == STAT_EXPRESSION_SYNTAX_ERROR);
+}
+
+static void test_domain_and_depth()
+{
+    float value;
+    CHECK(eval("[1/0]", &value) == STAT_EXPRESSION_DOMAIN_ERROR);
+    CHECK(eval("[5 MOD 0]", &value) == STAT_EXPRESSION_DOMAIN_ERROR);
+    CHECK(eval("SQRT[-1]", &value) == STAT_EXPRESSION_DOMAIN_ERROR);
+    CHECK(eval("LN[0]", &value) == STAT_EXPRESSION_DOMAIN_ERROR);
+    CHECK(eval("ACOS[1.5]", &value) == STAT_EXPRESSION_DOMAIN_ERROR);
+    CHECK(eval("ASIN[-2]", &value) == STAT_EXPRESSION_DOMAIN_ERROR);
+    CHECK(eval("[10**100]", &value) == STAT_EXPRESSION_DOMAIN_ERROR);   // overflows a float
+
+    // brackets, signs and indirections each count against GCODE_EXPRESSION_DEPTH
+    std::string open(GCODE_EXPRESSION_DEPTH, '['), close(GCODE_EXPRESSION_DEPTH, ']');
+    CHECK(is_value((open + "1" + close).c_str(), 1));
+    CHECK(eval(("[" + open + "1" + close + "]").c_str(), &value) == STAT_MAX_DEPTH_EXCEEDED);
+    std::string signs(GCODE_EXPRESSION_DEPTH, '-');
+    CHECK(is_value((signs + "1").c_str(), 1));
+    CHECK(eval(("-" + signs + "1").c_str(), &value) == STAT_MAX_DEPTH_EXCEEDED);
+    CHECK(eval((std::string(10000, '-') + "1").c_str(), &value) == STAT_MAX_DEPTH_EXCEEDED);
+    CHECK(eval((std::string(10000, '#') + "1").c_str(), &value) == STAT_MAX_DEPTH_EXCEEDED);
+}
+
+/**** parameters ****/
+
+static void test_parameters()
+{
+    gcode_program_init();
+    CHECK((scan("#1=5 #2=[#1+1] G0 X#1") == STAT_OK) && (gp.words == 2));
+    CHECK(gp.word[1].value == 0);                       // settings take effect at the end of the line
+    CHECK(is_value("#1", 5) && is_value("#2", 1));
+    CHECK((scan("G0 X#1 Y-#2 Z[#1*#2]") == STAT_OK) && (gp.word[1].value == 5) &&
+          (gp.word[2].value == -1) && (gp.word[3].value == 5));
+    CHECK((scan("#3=2") == STAT_OK) && is_value("##3", 1));     // #[#3]
+
+    CHECK((scan("#<Feed Rate>=1200") == STAT_OK) && is_value("#<feedrate>", 1200));  // no case or spaces
+    CHECK((scan("G1 F#<FEEDRATE>") == STAT_OK) && (gp.word[1].value == 1200));
+    CHECK(is_value("EXISTS[#<feedrate>]", 1) && is_value("EXISTS[#<nope>]", 0));
+    CHECK(scan("G1 F#<nope>") == STAT_PARAMETER_INVALID);
+    CHECK(scan("#<averyverylongname>=1") == STAT_PARAMETER_INVALID);
+
+    CHECK((scan("#1=7 G1 X Y1") == STAT_OK) && is_value("#1", 5));     // not set from a bad line
+    CHECK((scan("/#1=9") == STAT_OK) && is_value("#1", 5));            // nor from a deleted block
+    CHECK(scan("#5220=2") == STAT_PARAMETER_IS_READ_ONLY);
+    CHECK(scan("#0=1") == STAT_PARAMETER_INVALID);
+    CHECK(scan("#1.5=1") == STAT_PARAMETER_INVALID);
+    CHECK(scan("#1 5") == STAT_EXPRESSION_SYNTAX_ERROR);
+    CHECK(scan("#1=1 #2=1 #3=1 #4=1 #5=1 #6=1 #7=1 #8=1 #9=1") == STAT_INPUT_EXCEEDS_MAX_LENGTH);
+}
+
+/**** O words ****/
+
+static std::string ran;                                 // words of the lines run, '|' separated
+
+static stat_t run_line(const char *in)
+{
+    bool execute;
+    ritorno(gcode_program_filter(in, &execute));
+    if (!execute) {
+        return (STAT_OK);
+    }
+    ritorno(scan(in));
+    if (gp.words == 0) {
+        return (STAT_OK);                               // parameter settings only
+    }
+    char word[24];
+    ran += ran.empty() ? "" : "|";
+    for (uint8_t i = 0; i < gp.words; i++) {
+        sprintf(word, "%s%c%g", (i == 0) ? "" : " ", gp.word[i].letter, (double)gp.word[i].value);
+        ran += word;
+    }
+    return (STAT_OK);
+}
+
+// stream the lines of a program, replaying from the store ahead of each one
+static stat_t run(const std::vector<const char *> &program)
+{
+    ran.clear();
+    for (const char *in : program) {
+        stat_t status = run_line(in);
+        for (char *replay; (status == STAT_OK) && ((replay = gcode_program_next_line()) != nullptr); ) {
+            status = run_line(replay);
+        }
+        if (status != STAT_OK) {
+            gcode_program_reset();                      // as the controller does
+            return (status);
+        }
+    }
+    return (STAT_OK);
+}
+
+static void test_if()
+{
+    const std::vector<const char *> program = {
+        "O1 if [#1 EQ 1]",
+        "G0 X1",
+        "O1 elseif [#1 EQ 2]",
+        "O2 if [#2]",
+        "G0 X2",
+        "O2 else",
+        "G0 X3",
+        "O2 endif",
+        "O1 else",
+        "O3 if [1]",                                    // nested in the else branch
+        "G0 X9",
+        "O3 endif",
+        "G0 X4",
+        "O1 endif",
+        "G0 X5"
+    };
+    gcode_program_init();
+    CHECK((scan("#1=1") == STAT_OK) && (run(program) == STAT_OK));
+    CHECK_MSG(ran == "G0 X1|G0 X5", "'%s'", ran.c_str());
+    CHECK((scan("#1=2 #2=1") == STAT_OK) && (run(program) == STAT_OK));
+    CHECK_MSG(ran == "G0 X2|G0 X5", "'%s'", ran.c_str());
+    CHECK((scan("#2=0") == STAT_OK) && (run(program) == STAT_OK));
+    CHECK_MSG(ran == "G0 X3|G0 X5", "'%s'", ran.c_str());
+    CHECK((scan("#1=3") == STAT_OK) && (run(program) == STAT_OK));
+    CHECK_MSG(ran == "G0 X9|G0 X4|G0 X5", "'%s'", ran.c_str());
+    CHECK(gcode_program_is_idle());
+
+    CHECK(run({ "O1 if [1]", "O2 endif" }) == STAT_O_WORD_INVALID);     // mismatched numbers
+    CHECK(gcode_program_is_idle());
+    CHECK(run({ "O1 else" }) == STAT_O_WORD_INVALID);
+    CHECK(run({ "O1 if 1" }) == STAT_EXPRESSION_SYNTAX_ERROR);
+    CHECK(run({ "O1 frob" }) == STAT_O_WORD_INVALID);
+}
+
+static void test_loops()
+{
+    gcode_program_init();
+    CHECK(run({
+        "#1=0",
+        "O10 while [#1 LT 10]",
+        "#1=[#1+1]",
+        "O11 if [#1 EQ 3]",
+        "O10 continue",
+        "O11 endif",
+        "O12 if [#1 EQ 6]",
+        "O10 break",
+        "O12 endif",
+        "G0 X#1",
+        "O10 endwhile",
+        "G0 Y1"
+    }) == STAT_OK);
+    CHECK_MSG(ran == "G0 X1|G0 X2|G0 X4|G0 X5|G0 Y1", "'%s'", ran.c_str());
+    CHECK(is_value("#1", 6));
+    CHECK(gcode_program_is_idle());                     // the recording is dropped...
+    CHECK(pg.tail == 0);                                // ...and its room given back
+
+    CHECK(run({ "O10 while [0]", "G0 X1", "O10 endwhile", "G0 Y1" }) == STAT_OK);
+    CHECK_MSG(ran == "G0 Y1", "'%s'", ran.c_str());
+
+    CHECK(run({
+        "#2=0",
+        "O20 repeat [3]",
+        "#2=[#2+1]",
+        "G1 X#2",
+        "O20 endrepeat",
+        "O21 repeat [0]",
+        "G1 X9",
+        "O21 endrepeat"
+    }) == STAT_OK);
+    CHECK_MSG(ran == "G1 X1|G1 X2|G1 X3", "'%s'", ran.c_str());
+
+    CHECK(run({
+        "O30 repeat [2]",
+        "O31 repeat [2]",
+        "G0 A1",
+        "O31 endrepeat",
+        "G0 B1",
+        "O30 endrepeat"
+    }) == STAT_OK);
+    CHECK_MSG(ran == "G0 A1|G0 A1|G0 B1|G0 A1|G0 A1|G0 B1", "'%s'", ran.c_str());
+
+    CHECK(run({ "#3=0", "O40 do", "#3=[#3+1]", "G0 Z#3", "O40 while [#3 LT 2]" }) == STAT_OK);
+    CHECK_MSG(ran == "G0 Z1|G0 Z2", "'%s'", ran.c_str());
+    CHECK(gcode_program_is_idle() && (pg.tail == 0));
+
+    CHECK(run({ "O50 break" }) == STAT_O_WORD_INVALID);          // not in a loop
+    std::vector<const char *> deep;
+    char lines[GCODE_O_WORD_DEPTH+1][24];
+    for (int i = 0; i <= GCODE_O_WORD_DEPTH; i++) {
+        sprintf(lines[i], "O%d repeat [2]", 60+i);
+        deep.push_back(lines[i]);
+    }
+    CHECK(run(deep) == STAT_O_WORD_NESTING_TOO_DEEP);
+    CHECK(gcode_program_is_idle() && (pg.tail == 0));
+}
+
+static void test_subroutines()
+{
+    gcode_program_init();
+    CHECK(run({
+        "#1=11 #2=22 #30=33",
+        "O100 sub",
+        "G0 X#1 Y#2",
+        "O101 if [#2 EQ 0]",
+        "O100 return",
+        "O101 endif",
+        "#1=99",
+        "G0 Z#1",
+        "O100 endsub",
+        "O100 call [5] [6]",
+        "G0 X#1 Y#2 Z#30",
+        "O100 call [7]",
+        "G0 X#1"
+    }) == STAT_OK);
+    CHECK_MSG(ran == "G0 X5 Y6|G0 Z99|G0 X11 Y22 Z33|G0 X7 Y0|G0 X11", "'%s'", ran.c_str());
+    CHECK(is_value("#1", 11) && is_value("#2", 22) && is_value("#30", 33));  // the caller's #1 - #30
+    CHECK(gcode_program_is_idle());
+
+    // a call from a loop returns into the loop
+    CHECK(run({ "O20 repeat [2]", "O100 call [1] [0]", "G0 A1", "O20 endrepeat" }) == STAT_OK);
+    CHECK_MSG(ran == "G0 X1 Y0|G0 A1|G0 X1 Y0|G0 A1", "'%s'", ran.c_str());
+
+    CHECK(run({ "O999 call" }) == STAT_O_WORD_SUBROUTINE_UNDEFINED);
+    CHECK(run({ "O100 return" }) == STAT_O_WORD_INVALID);
+    CHECK(run({ "O1 if [1]", "O200 sub" }) == STAT_O_WORD_INVALID);  // only at the top level
+    CHECK(run({ "O110 sub", "O110 call", "O110 endsub", "O110 call" }) == STAT_O_WORD_NESTING_TOO_DEEP);
+    CHECK(gcode_program_is_idle());
+    CHECK(is_value("#1", 11) && is_value("#30", 33));   // an error gives the caller's back too
+}
+
+static void test_store_full()
+{
+    char body[GCODE_PROGRAM_LINE_LEN];
+    memset(body, 'X', sizeof(body));
+    body[sizeof(body)-1] = NUL;
+    body[0] = '(';
+    body[sizeof(body)-2] = ')';                         // a comment, the longest line stored
+
+    gcode_program_init();
+    CHECK(run({ "O1 sub", "G0 X1", "O1 endsub" }) == STAT_OK);
+    uint16_t tail = pg.tail;
+    stat_t status = run_line("O2 sub");
+    int lines = 0;
+    while ((status == STAT_OK) && (lines < 100)) {
+        status = run_line(body);
+        lines++;
+    }
+    CHECK_MSG(status == STAT_O_WORD_STORE_FULL, "%d", status);
+    CHECK_MSG(lines == (GCODE_PROGRAM_STORE_SIZE - tail) / GCODE_PROGRAM_LINE_LEN + 1, "%d lines", lines);
+    CHECK(gcode_program_is_idle() && (pg.tail == tail));    // the half stored subroutine is dropped
+    CHECK(run({ "O2 call" }) == STAT_O_WORD_SUBROUTINE_UNDEFINED);
+    CHECK((run({ "O1 call" }) == STAT_OK) && (ran == "G0 X1"));
+
+    // a loop too long to record ends, and its recording is dropped
+    CHECK(run_line("O10 repeat [2]") == STAT_OK);
+    for (status = STAT_OK, lines = 0; (status == STAT_OK) && (lines < 100); lines++) {
+        status = run_line(body);
+    }
+    CHECK(status == STAT_O_WORD_STORE_FULL);
+    CHECK(gcode_program_is_idle() && (pg.tail == tail));
+
+    body[sizeof(body)-2] = 'X';
+    body[sizeof(body)-1] = ')';
+    CHECK(run_line("O10 repeat [2]") == STAT_OK);
+    CHECK(run_line(body) == STAT_INPUT_EXCEEDS_MAX_LENGTH);
+    CHECK(gcode_program_is_idle() && (pg.tail == tail));
+}
+
+int main()
+{
+    cm = &cm1;
+    test_normalize();
+    test_words();
+    test_saturation();
+    test_checksum();
+    test_precedence();
+    test_domain_and_depth();
+    test_parameters();
+    test_if();
+    test_loops();
+    test_subroutines();
+    test_store_full();
+    return (test_exit("test_gcode"));
+}
@@ -0,0 +1,222 @@
+/*
+ * test_json.cpp - JSON input parser conformance
+ * This file is part of the g2core project
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/*
+ * Includes json_parser.cpp to reach _json_parser_kernal() directly, so the tests see the
+ * parsed nv list without the response and execution paths.
+ */
+
+#include "../json_parser.cpp"
+#include "test.h"
+
+static char buf[JSON_INPUT_STRING_MAX * 2];
+
+static stat_t parse(const char *in)
+{
+    strcpy(buf, in);
+    return (_json_parser_kernal(nv_reset_nv_list(), buf));
+}
+
+static nvObj_t *body(int n)
+{
+    nvObj_t *nv = nv_body;
+    while (n--) { nv = nv->nx; }
+    return (nv);
+}
+
+static bool is_token(nvObj_t *nv, const char *token)
+{
+    return (nv->index == nv_get_index("", token));
+}
+
+static bool is_string(nvObj_t *nv, const char *str)
+{
+    return ((nv->valuetype == TYPE_STRING) && (strcmp(*nv->stringp, str) == 0));
+}
+
+static void test_values()
+{
+    CHECK(parse("{\"xvm\":1200.5}") == STAT_OK);
+    CHECK(is_token(body(0), "xvm") && (body(0)->valuetype == TYPE_FLOAT) && (body(0)->value_flt == 1200.5));
+    CHECK(body(1)->valuetype == TYPE_EMPTY);
+
+    CHECK(parse("{ \"xvm\" : 12 , \"yvm\":-3e2 }") == STAT_OK);
+    CHECK(is_token(body(0), "xvm") && (body(0)->value_flt == 12));
+    CHECK(is_token(body(1), "yvm") && (body(1)->value_flt == -300));
+
+    CHECK(parse("{xvm:5}") == STAT_OK);                         // relaxed: unquoted names
+    CHECK(is_token(body(0), "xvm"));
+    CHECK(parse("  {\"XVM\":5}  ") == STAT_OK);                 // names are lower cased
+    CHECK(is_token(body(0), "xvm"));
+
+    CHECK(parse("{\"xvm\":null}") == STAT_OK);
+    CHECK(body(0)->valuetype == TYPE_NULL);
+    CHECK(parse("{\"xvm\":n}") == STAT_OK);
+    CHECK(body(0)->valuetype == TYPE_NULL);
+    CHECK(parse("{\"xvm\":\"\"}") == STAT_OK);                  // "" is a GET
+    CHECK(body(0)->valuetype == TYPE_NULL);
+
+    CHECK(parse("{\"sr\":{\"posx\":t,\"posy\":false,\"stat\":true}}") == STAT_OK);
+    CHECK(is_token(body(0), "sr") && (body(0)->valuetype == TYPE_PARENT));
+    CHECK(is_token(body(1), "posx") && (body(1)->depth == body(0)->depth+1));
+    CHECK((body(1)->valuetype == TYPE_BOOLEAN) && (body(1)->value_int == true));
+    CHECK(is_token(body(2), "posy") && (body(2)->value_int == false));
+    CHECK(is_token(body(3), "stat") && (body(3)->value_int == true));
+}
+
+static void test_groups()
+{
+    CHECK(parse("{\"x\":{\"vm\":1,\"fr\":2},\"y\":{\"vm\":3}}") == STAT_OK);
+    CHECK(is_token(body(0), "x") && (body(0)->valuetype == TYPE_PARENT));
+    CHECK(is_token(body(1), "xvm") && (body(1)->value_flt == 1));
+    CHECK(is_token(body(2), "xfr") && (body(2)->value_flt == 2));
+    CHECK(is_token(body(3), "y") && (body(3)->depth == body(0)->depth));
+    CHECK(is_token(body(4), "yvm") && (body(4)->value_flt == 3));
+
+    CHECK(parse("{\"1\":{\"ma\":2}}") == STAT_OK);
+    CHECK(is_token(body(1), "1ma"));
+}
+
+static void test_strings()
+{
+    CHECK(parse("{\"gc\":\"G1 X10 (Comment Here) Y2\"}") == STAT_OK);
+    CHECK(is_token(body(0), "gc"));
+    CHECK(is_string(body(0), "g1x10(Comment Here)y2"));     // comments keep case and spacing
+
+    CHECK(parse("{\"gc\":\"a\\\"b\\\\c\\/d\"}") == STAT_OK);
+    CHECK(is_string(body(0), "a\"b\\c/d"));
+    CHECK(parse("{\"gc\":\"a\\nb\"}") == STAT_JSON_SYNTAX_ERROR);
+
+    CHECK(parse("{\"gc\":\"0x1f\"}") == STAT_OK);
+    CHECK(body(0)->valuetype == TYPE_DATA);
+
+    CHECK(parse("{\"file\":\"Jobs/My Part.NC\"}") == STAT_OK);  // F_VERBATIM
+    CHECK(is_string(body(0), "Jobs/My Part.NC"));
+}
+
+static void test_errors()
+{
+    CHECK(parse("{}") == STAT_JSON_SYNTAX_ERROR);
+    CHECK(parse("") == STAT_JSON_SYNTAX_ERROR);
+    CHECK(parse("[1]") == STAT_JSON_SYNTAX_ERROR);
+    CHECK(parse("{\"xvm\":1") == STAT_BAD_NUMBER_FORMAT);
+    CHECK(parse("{\"gc\":\"g0\"") == STAT_JSON_SYNTAX_ERROR);
+    CHECK(parse("{\"xvm\" 1}") == STAT_JSON_SYNTAX_ERROR);
+    CHECK(parse("{\"xvm\":1;}") == STAT_BAD_NUMBER_FORMAT);
+    CHECK(parse("{\"xvm\":12abc}") == STAT_BAD_NUMBER_FORMAT);
+    CHECK(parse("{\"xvm\":-}") == STAT_BAD_NUMBER_FORMAT);
+    CHECK(parse("{\"xvm\":[1,2]}") == STAT_VALUE_TYPE_ERROR);
+    CHECK(parse("{\"xvm\":maybe}") == STAT_JSON_SYNTAX_ERROR);
+    CHECK(parse("{\"bogus\":1}") == STAT_UNRECOGNIZED_NAME);
+    CHECK(parse("{\"toolongname\":1}") == STAT_INPUT_EXCEEDS_MAX_LENGTH);
+    CHECK(parse("{\"gc\":\"unterminated}") == STAT_JSON_SYNTAX_ERROR);
+
+    CHECK(parse("{\"xvm\":1,\"bogus\":2}") == STAT_UNRECOGNIZED_NAME);
+    CHECK(body(1)->valuetype == TYPE_NULL);                     // the failing pair is marked
+}
+
+static void test_limits()
+{
+    char in[JSON_INPUT_STRING_MAX * 2];
+
+    // nesting: JSON_MAX_DEPTH objects are allowed, one more is not
+    for (int levels = JSON_MAX_DEPTH; levels <= JSON_MAX_DEPTH+1; levels++) {
+        in[0] = NUL;
+        for (int i=0; i < levels-1; i++) { strcat(in, "{\"sys\":"); }
+        strcat(in, "{\"fv\":null}");
+        for (int i=0; i < levels-1; i++) { strcat(in, "}"); }
+        stat_t status = parse(in);
+        CHECK_MSG(status == ((levels > JSON_MAX_DEPTH) ? STAT_MAX_DEPTH_EXCEEDED : STAT_OK), "%d levels: status %d", levels, status);
+    }
+
+    // pairs: the list holds NV_BODY_LEN-1 of them
+    for (int pairs = NV_BODY_LEN-1; pairs <= NV_BODY_LEN; pairs++) {
+        strcpy(in, "{");
+        for (int i=0; i < pairs; i++) { strcat(in, (i ? ",xvm:1" : "xvm:1")); }
+        strcat(in, "}");
+        stat_t status = parse(in);
+        CHECK_MSG(status == ((pairs >= NV_BODY_LEN) ? STAT_JSON_TOO_MANY_PAIRS : STAT_OK), "%d pairs: status %d", pairs, status);
+    }
+}
+
+static void test_input_length()
+{
+    char in[JSON_INPUT_STRING_MAX * 2];
+
+    // exactly JSON_INPUT_STRING_MAX characters is accepted
+    strcpy(in, "{\"gc\":\"");
+    size_t fill = JSON_INPUT_STRING_MAX - strlen(in) - 2;
+    memset(in + strlen(in), 'g', fill);
+    strcpy(in + JSON_INPUT_STRING_MAX - 2, "\"}");
+    CHECK(strlen(in) == JSON_INPUT_STRING_MAX);
+    CHECK(parse(in) == STAT_OK);
+    CHECK((body(0)->valuetype == TYPE_STRING) && (strlen(*body(0)->stringp) == fill));
+
+    // one more is rejected before the string is compacted or linked
+    strcpy(in, "{\"gc\":\"");
+    memset(in + strlen(in), 'G', fill + 1);
+    strcpy(in + JSON_INPUT_STRING_MAX - 1, "\"}");
+    strcpy(buf, in);
+    CHECK(_json_parser_kernal(nv_reset_nv_list(), buf) == STAT_INPUT_EXCEEDS_MAX_LENGTH);
+    CHECK(strcmp(buf, in) == 0);
+    CHECK(nv_body->stringp == NULL);
+
+    // a string run that would be compacted past the limit is never touched
+    memset(buf, ' ', sizeof(buf));
+    memcpy(buf, "{\"gc\":\"", 7);
+    buf[sizeof(buf)-3] = '\"';
+    buf[sizeof(buf)-2] = '}';
+    buf[sizeof(buf)-1] = NUL;
+    memcpy(in, buf, sizeof(in));
+    CHECK(_json_parser_kernal(nv_reset_nv_list(), buf) == STAT_INPUT_EXCEEDS_MAX_LENGTH);
+    CHECK(memcmp(buf, in, sizeof(in)) == 0);
+}
+
+// a group read from the exec (M100, active comments) fills the exec list and prints nothing
+static void test_exec_gets()
+{
+    strcpy(buf, "{\"co\":null}");
+    json_parse_for_exec(buf, true);
+    CHECK(nv_exec->valuetype == TYPE_PARENT);
+    int children = 0;
+    for (nvObj_t *nv = nv_exec->nx; (nv != NULL) && (nv->valuetype != TYPE_EMPTY); nv = nv->nx) {
+        CHECK_MSG(strcmp(cfgArray[nv->index].group, "co") == 0, "'%s' is not in the co group", nv->token);
+        children++;
+    }
+    CHECK_MSG(children == 5, "%d children", children);
+    CHECK(!jstream.enabled && (jstream.length == 0));
+
+    // the main loop turns streaming on only while it produces a response
+    CHECK(nv_stream_begin(nv_body) == false);
+    nv_stream_enable(true);
+    strcpy(buf, "{\"co\":null}");
+    json_parse_for_exec(buf, true);
+    CHECK(nv_exec->nx->valuetype != TYPE_EMPTY);    // still filled, not streamed
+    CHECK(nv_stream_enable(false) == true);         // and the setting is put back
+}
+
+int main()
+{
+    nv_index_init();
+    test_values();
+    test_groups();
+    test_strings();
+    test_errors();
+    test_limits();
+    test_input_length();
+    test_exec_gets();
+    return (test_exit("test_json"));
+}
@@ -0,0 +1,310 @@
+/*
+ * test_persistence.cpp - config snapshots through the JSON parser
+ * This file is part of the g2core project
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/*
+ * Includes persistence.cpp to build snapshot chunks the way {"cfgs":null} does. The NVM
+ * device is the NVM_FILE the Makefile names, removed at the start of each run.
+ */
+
+#include "../persistence.cpp"
+#include "canonical_machine.h"
+#include "controller.h"
+#include "json_parser.h"
+#include "test.h"
+
+#include <string>
+#include <vector>
+
+static void machine_init()
+{
+    remove(NVM_FILE);
+    persistence_init();
+    xio_init();
+    cm = &cm1;
+    canonical_machine_inits();
+    controller_init();
+    config_init();
+}
+
+static float get_float(const char *token)
+{
+    nvObj_t nv;
+    nv.index = nv_get_index("", token);
+    strcpy(nv.token, token);
+    nv.group[0] = NUL;
+    cfgArray[nv.index].get(&nv);
+    return (nv.value_flt);
+}
+
+static stat_t set_float(const char *token, float value)
+{
+    nvObj_t nv;
+    nv.index = nv_get_index("", token);
+    strcpy(nv.token, token);
+    nv.group[0] = NUL;
+    nv.valuetype = TYPE_FLOAT;
+    nv.value_flt = value;
+    return (cfgArray[nv.index].set(&nv));
+}
+
+static stat_t send(std::string line)
+{
+    char buf[RX_BUFFER_SIZE];
+    snprintf(buf, sizeof(buf), "%s", line.c_str());
+    return (json_parser(buf, true));
+}
+
+static stat_t persist(const char *token, float value)       // write and flush, as the callback would
+{
+    nvObj_t nv;
+    nv.index = nv_get_index("", token);
+    nv.value_flt = value;
+    ritorno(write_persistent_value(&nv));
+    return (persistence_callback());
+}
+
+static float persisted(const char *token)
+{
+    nvObj_t nv;
+    nv.index = nv_get_index("", token);
+    if (read_persistent_value(&nv) != STAT_OK) {
+        return (NAN);
+    }
+    return (nv.value_flt);
+}
+
+static void reboot()                                        // reopen the device and scan the log
+{
+    fclose(nvm_file);
+    persistence_init();
+}
+
+static uint32_t header_address(uint8_t sector)
+{
+    return ((uint32_t)sector * NVM_SECTOR_SIZE);
+}
+
+// the snapshot as {"cfgs":null} sends it, one {"cfgs":"..."} restore line per chunk
+static std::vector<std::string> snapshot()
+{
+    std::vector<std::string> lines;
+    nvmSnapshotChunk_t chunk;
+    char encoded[8 * ((sizeof(chunk) + 4) / 5) + 1];
+    uint16_t total = _persisted_count();
+    index_t i = 0;
+    for (uint16_t ordinal=0; ordinal < total; ordinal += chunk.h.count) {
+        i = _snapshot_chunk(&chunk, ordinal, total, i);
+        base32_encode(encoded, &chunk, _chunk_length(&chunk));
+        lines.push_back(std::string("{\"cfgs\":\"") + encoded + "\"}");
+    }
+    return (lines);
+}
+
+/**** Config snapshots ****/
+
+static void test_snapshot_round_trip()
+{
+    float xvm = get_float("xvm");
+    float ytr = get_float("1tr");
+    std::vector<std::string> lines = snapshot();
+    CHECK(lines.size() == (size_t)(_persisted_count() + NVM_SNAPSHOT_CHUNK - 1) / NVM_SNAPSHOT_CHUNK);
+
+    bool fits = true, has_upper = false;
+    for (auto &line : lines) {
+        fits &= (line.length() < JSON_INPUT_STRING_MAX);
+        for (char c : line) { has_upper |= ((c >= 'A') && (c <= 'Z')); }
+    }
+    CHECK(fits);
+    CHECK(has_upper);                                   // so the parser's lower casing is exercised
+
+    CHECK(set_float("xvm", xvm + 1000) == STAT_OK);
+    CHECK(set_float("1tr", ytr + 1) == STAT_OK);
+    CHECK(get_float("xvm") == xvm + 1000);
+
+    stat_t status = STAT_OK;
+    for (auto &line : lines) {
+        if (status == STAT_OK) {
+            status = send(line);
+        }
+    }
+    CHECK_MSG(status == STAT_OK, "restore: status %d", status);
+    CHECK(nvm.import_ordinal == _persisted_count());
+    CHECK(get_float("xvm") == xvm);
+    CHECK(get_float("1tr") == ytr);
+
+    // refused chunks change nothing
+    CHECK(set_float("xvm", xvm + 1000) == STAT_OK);
+    std::string corrupt = lines[0];
+    corrupt[20] = (corrupt[20] == 'A') ? 'B' : 'A';
+    CHECK(send(corrupt) == STAT_CHECKSUM_MATCH_FAILED);
+    CHECK(send("{\"cfgs\":\"not base32!\"}") == STAT_CONFIG_SNAPSHOT_MISMATCH);
+    if (lines.size() > 2) {
+        CHECK(send(lines[0]) == STAT_OK);
+        CHECK(send(lines[2]) == STAT_CONFIG_SNAPSHOT_MISMATCH);     // out of order
+    }
+    CHECK(get_float("xvm") == xvm + 1000);
+}
+
+/**** Append log ****/
+
+static void test_append_log()
+{
+    CHECK(persistence_callback() == STAT_OK);           // writes left queued by the restore
+    CHECK(persistence_is_loaded());
+    CHECK(nvm.pending == 0);
+
+    uint16_t next = nvm.next;
+    CHECK(persist("xvm", 1234.5) == STAT_OK);
+    CHECK(nvm.next == next + 1);                        // one record appended
+    CHECK(persist("xvm", 1234.5) == STAT_OK);
+    CHECK(nvm.next == next + 1);                        // an unchanged value isn't
+
+    // queued writes to the same index replace each other
+    nvObj_t nv;
+    nv.index = nv_get_index("", "yvm");
+    for (int i=1; i<=3; i++) {
+        nv.value_flt = 100 * i;
+        CHECK(write_persistent_value(&nv) == STAT_OK);
+    }
+    CHECK(nvm.pending == 1);
+    CHECK(persisted("yvm") == 300);                     // read back from the queue
+    CHECK(persistence_callback() == STAT_OK);
+    CHECK(nvm.pending == 0);
+    CHECK(nvm.next == next + 2);
+
+    reboot();
+    CHECK(persistence_is_loaded());
+    CHECK(nvm.next == next + 2);
+    CHECK(persisted("xvm") == 1234.5);
+    CHECK(persisted("yvm") == 300);
+
+    // a torn record is skipped and the previous value stands
+    CHECK(persist("xvm", 2000) == STAT_OK);
+    uint32_t zero = 0;
+    CHECK(nvm_device_program(_record_address(nvm.sector, nvm.next - 1) + offsetof(nvmRecord_t, value),
+                             &zero, sizeof(zero)) == STAT_OK);
+    reboot();
+    CHECK(nvm.next == next + 3);                        // it still takes up its space
+    CHECK(persisted("xvm") == 1234.5);
+}
+
+/**** Compaction ****/
+
+static void test_compaction()
+{
+    uint8_t sector = nvm.sector;
+    uint32_t sequence = nvm.sequence;
+    uint32_t compactions = nvm.compactions;
+    float yvm = persisted("yvm");
+
+    uint32_t writes = 0;
+    while ((nvm.compactions == compactions) && (writes <= NVM_RECORDS)) {
+        CHECK(persist("xvm", ++writes) == STAT_OK);
+    }
+    CHECK_MSG(nvm.compactions == compactions + 1, "no compaction after %u writes", writes);
+    CHECK(nvm.sector == (sector + 1) % NVM_SECTORS);
+    CHECK(nvm.sequence == sequence + 1);
+
+    uint16_t live = 0;
+    for (index_t i=0; i<nv_index_max(); i++) {
+        live += (nvm_slot[i] != 0);
+    }
+    CHECK_MSG(nvm.next == live, "%u records in the new sector, %u live", nvm.next, live);
+    CHECK(live < NVM_RECORDS);
+
+    reboot();
+    CHECK(persistence_is_loaded());
+    CHECK(nvm.sector == (sector + 1) % NVM_SECTORS);
+    CHECK(persisted("xvm") == writes);
+    CHECK(persisted("yvm") == yvm);                     // copied across
+
+    // a power loss before the header is written leaves the old sector in charge
+    uint32_t zero = 0;
+    CHECK(nvm_device_program(header_address(nvm.sector) + offsetof(nvmHeader_t, magic),
+                             &zero, sizeof(zero)) == STAT_OK);
+    reboot();
+    CHECK(persistence_is_loaded());
+    CHECK(nvm.sector == sector);
+    CHECK(persisted("xvm") == writes - 1);              // the last write went to the new sector
+    CHECK(persisted("yvm") == yvm);
+
+    // the old sector is still full, so the next write compacts again over the torn sector
+    CHECK(persist("xvm", ++writes) == STAT_OK);
+    CHECK(nvm.sector == (sector + 1) % NVM_SECTORS);
+    CHECK(nvm.sequence == sequence + 1);
+    reboot();
+    CHECK(persisted("xvm") == writes);
+}
+
+/**** Table signature ****/
+
+static void test_table_signature()
+{
+    // a newer log written by a build with a different cfgArray is not loaded
+    uint8_t sector = (nvm.sector + 1) % NVM_SECTORS;
+    uint32_t sequence = nvm.sequence;
+    nvmHeader_t h;
+    h.magic = NVM_MAGIC;
+    h.sequence = sequence + 1;
+    h.signature = nvm.signature ^ 0x5555;
+    h.crc = _header_crc(&h);
+    h.reserved = 0xFFFFFFFF;
+    CHECK(nvm_device_erase(sector) == STAT_OK);
+    CHECK(nvm_device_program(header_address(sector), &h, sizeof(h)) == STAT_OK);
+
+    reboot();
+    CHECK(!persistence_is_loaded());
+    CHECK(isnan(persisted("xvm")));
+
+    // the next write starts a new log after it
+    CHECK(persist("xvm", 42) == STAT_OK);
+    CHECK(nvm.sequence == sequence + 2);
+    reboot();
+    CHECK(persistence_is_loaded());
+    CHECK(persisted("xvm") == 42);
+    CHECK(isnan(persisted("yvm")));
+}
+
+/**** File device ****/
+
+static void test_file_device()
+{
+    uint8_t sector = (nvm.sector + 1) % NVM_SECTORS;
+    uint32_t address = header_address(sector) + 100;
+    uint8_t bits;
+
+    CHECK(nvm_device_erase(sector) == STAT_OK);
+    CHECK((nvm_device_read(address, &bits, 1) == STAT_OK) && (bits == 0xFF));
+    bits = 0xF0;
+    CHECK(nvm_device_program(address, &bits, 1) == STAT_OK);
+    bits = 0x3C;
+    CHECK(nvm_device_program(address, &bits, 1) == STAT_OK);
+    CHECK((nvm_device_read(address, &bits, 1) == STAT_OK) && (bits == 0x30));    // program only clears bits
+    CHECK(nvm_device_erase(sector) == STAT_OK);
+    CHECK((nvm_device_read(address, &bits, 1) == STAT_OK) && (bits == 0xFF));
+    CHECK(nvm_device_read(NVM_SECTORS * NVM_SECTOR_SIZE, &bits, 1) == STAT_PERSISTENCE_ERROR);
+}
+
+int main()
+{
+    machine_init();
+    test_snapshot_round_trip();
+    test_append_log();
+    test_compaction();
+    test_table_signature();
+    test_file_device();
+    return (test_exit("test_persistence"));
+}
@@ -0,0 +1,355 @@
+/*
+ * test_temperature.cpp - thermistor sampling and conversion, PID autotune and model-based
+ *                        control, off the board
+ * This file is part of the g2core project
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/*
+ * Includes temperature.cpp to reach the file-scope thermistors and helper structs.
+ */
+
+#include "../temperature.cpp"
+#include "test.h"
+
+#include <deque>
+#include <random>
+
+/**** Thermistor table ****/
+
+#define TABLE_MAX_ERROR (float)0.5      // degrees C, anywhere from min_temp to max_temp
+
+template<typename T>
+static void check_table(const char *name, T &thermistor)
+{
+    float worst = 0;
+    int worst_adc = 0;
+    int codes = 0;
+    int top = thermistor.adc_pin.getTop();
+
+    for (int adc=0; adc <= top; adc++) {
+        thermistor.raw_adc_value = adc;
+        float exact = thermistor.temperature_exact();
+        float table = thermistor.temperature();
+        if ((exact < 0) || (exact > 300)) {             // outside the table - the exact formula is used
+            CHECK_MSG(table == exact, "%s adc %d: table %f, exact %f", name, adc, table, exact);
+            continue;
+        }
+        codes++;
+        float error = fabs(table - exact);
+        if (error > worst) {
+            worst = error;
+            worst_adc = adc;
+        }
+    }
+    thermistor.raw_adc_value = worst_adc;
+    printf("  %s: %d codes in range, worst error %.3f C at adc %d (%.1f C)\n", name, codes, worst, worst_adc,
+           thermistor.temperature_exact());
+    CHECK(codes > 1000);
+    CHECK_MSG(worst < TABLE_MAX_ERROR, "%s: worst error %.3f C", name, worst);
+
+    // the table entries read back as their own temperatures. The exact formula loses float
+    // precision near the top of the ADC range, so it only agrees to within the table error.
+    for (uint32_t i=1; i < sizeof(thermistor.adc_table)/sizeof(thermistor.adc_table[0]) - 1; i++) {
+        thermistor.raw_adc_value = thermistor.adc_table[i];
+        CHECK(fabs(thermistor.temperature() - (i * thermistor.temp_step)) < 0.01);
+        CHECK(fabs(thermistor.temperature_exact() - (i * thermistor.temp_step)) < TABLE_MAX_ERROR);
+    }
+}
+
+static void test_thermistor_table()
+{
+    check_table("thermistor1", thermistor1);
+    check_table("thermistor2", thermistor2);
+    check_table("thermistor3", thermistor3);
+
+    thermistor1.raw_adc_value = 0;                      // failed or shorted sensor
+    CHECK(thermistor1.temperature() == -1);
+}
+
+/**** PID autotune ****/
+
+// A heater block with losses to ambient, a sensor that lags the block, and a transport
+// delay on the output. 'loose' is a sensor that has come off the block, 'extra_loss' the
+// part fan or filament flow taking heat away.
+struct Plant {
+    double capacity;                // J/K
+    double loss;                    // W/K
+    double power;                   // W at full output
+    double sensor_lag;              // s
+    double ambient = 25;
+    double block, sensor;
+    std::deque<double> delay;
+    bool loose = false;
+    double extra_loss = 0;          // W/K
+
+    Plant(double capacity_, double loss_, double power_, double sensor_lag_, int delay_samples, double ambient_ = 25)
+    : capacity{capacity_}, loss{loss_}, power{power_}, sensor_lag{sensor_lag_}, ambient{ambient_},
+      block{ambient_}, sensor{ambient_}, delay(delay_samples, 0.0) {}
+
+    double step(double output, double dt) {
+        delay.push_back(output);
+        output = delay.front();
+        delay.pop_front();
+        for (int i=0; i < 10; i++) {
+            double h = dt / 10;
+            block += h * ((power * output) - ((loss + extra_loss) * (block - ambient))) / capacity;
+            sensor += h * ((loose ? ambient : block) - sensor) / sensor_lag;
+        }
+        return (sensor);
+    }
+};
+
+#define AUTOTUNE_PERIOD (float)0.1
+
+// run an autotune to completion - returns the seconds it took
+static float autotune(PIDAutotune &tune, Plant plant, float set_point, float min_rise, float loose_at = -1)
+{
+    tune.start(set_point, AUTOTUNE_PERIOD, TEMP_AUTOTUNE_CYCLES, min_rise);
+    double temp = plant.sensor;
+    long n = 0;
+    for (; (n < 4 * 3600 / AUTOTUNE_PERIOD) && (tune.state == PIDAutotune::Running); n++) {
+        if ((loose_at >= 0) && (n * AUTOTUNE_PERIOD >= loose_at)) {
+            plant.loose = true;
+        }
+        temp = plant.step(tune.step(temp), AUTOTUNE_PERIOD);
+    }
+    return (n * AUTOTUNE_PERIOD);
+}
+
+static bool failed_with(PIDAutotune &tune, const char *why)
+{
+    return ((tune.state == PIDAutotune::Failed) && tune.report_pending && (strcmp(tune.failure, why) == 0));
+}
+
+static void test_autotune()
+{
+    PIDAutotune tune;
+    struct { const char *name; Plant plant; float set_point; float min_rise; } good[] = {
+        { "hotend", Plant(10, 0.12, 40, 3, 10), 200, TEMP_MIN_RISE_DEGREES_OVER_TIME },
+        { "bed", Plant(300, 1.5, 250, 10, 20), 80, TEMP_MIN_BED_RISE_DEGREES_OVER_TIME },
+        { "big bed", Plant(900, 1.5, 250, 10, 20), 100, TEMP_MIN_BED_RISE_DEGREES_OVER_TIME },
+    };
+    for (auto &g : good) {
+        float seconds = autotune(tune, g.plant, g.set_point, g.min_rise);
+        printf("  autotune %s: %.0fs ku %.4f tu %.1fs\n", g.name, seconds, tune.ku, tune.tu);
+        CHECK_MSG((tune.state == PIDAutotune::Done) && tune.report_pending, "%s: %s", g.name, tune.failure ? tune.failure : "still running");
+        CHECK((tune.ku > 0) && (tune.tu > 1) && (tune.tu < TEMP_AUTOTUNE_HALF_CYCLE_TIME));
+
+        float p, i, d;
+        tune.gains(p, i, d);
+        CHECK((p > 0) && (i > 0) && (d > 0));
+    }
+
+    // not enough power to climb 10 degrees a minute near the set point
+    float seconds = autotune(tune, Plant(10, 0.12, 15, 3, 10), 200, TEMP_MIN_RISE_DEGREES_OVER_TIME);
+    CHECK_MSG(failed_with(tune, "temperature failed to rise fast enough"), "weak heater: %s", tune.failure);
+
+    // a sensor that falls off at the start, or part way up, fails within a rise check or two
+    seconds = autotune(tune, Plant(10, 0.12, 40, 3, 10), 200, TEMP_MIN_RISE_DEGREES_OVER_TIME, 10);
+    CHECK_MSG(failed_with(tune, "temperature failed to rise fast enough"), "loose sensor: %s", tune.failure);
+    CHECK(seconds <= (2 * TEMP_MIN_RISE_TIME / 1000));
+    seconds = autotune(tune, Plant(10, 0.12, 40, 3, 10), 200, TEMP_MIN_RISE_DEGREES_OVER_TIME, 90);
+    CHECK_MSG(failed_with(tune, "temperature failed to rise fast enough"), "sensor loose late: %s", tune.failure);
+    CHECK(seconds <= 90 + (2 * TEMP_MIN_RISE_TIME / 1000));
+
+    // ambient just under the set point: it can never cool back through it
+    seconds = autotune(tune, Plant(10, 0.12, 40, 3, 10, 199.8), 200, TEMP_MIN_RISE_DEGREES_OVER_TIME);
+    CHECK_MSG(failed_with(tune, "heater did not cross the set point"), "stuck hot: %s", tune.failure);
+    CHECK(seconds <= TEMP_AUTOTUNE_HALF_CYCLE_TIME + 60);
+
+    // overshoot and sensor failures stop it at once
+    tune.start(200, AUTOTUNE_PERIOD, TEMP_AUTOTUNE_CYCLES, TEMP_MIN_RISE_DEGREES_OVER_TIME);
+    CHECK((tune.step(200 + TEMP_AUTOTUNE_MAX_OVERSHOOT + 1) == 0) && failed_with(tune, "temperature overshot"));
+    tune.start(200, AUTOTUNE_PERIOD, TEMP_AUTOTUNE_CYCLES, TEMP_MIN_RISE_DEGREES_OVER_TIME);
+    CHECK((tune.step(-1) == 0) && failed_with(tune, "sensor read failed"));
+}
+
+/**** Model-based control ****/
+
+#define MODEL_PERIOD (TEMP_PID_PERIOD_MS / 1000.0)
+#define MODEL_FILAMENT (float)0.05      // J/K per mm of filament
+
+// The hotend autotuned above, with the model set up the way it would be from the config
+struct ModelRun {
+    Plant plant = Plant(10, 0.12, 40, 3, 10);
+    HeaterModel model;
+    float temp = 25;
+    float output = 0;
+
+    ModelRun(float loss) {
+        model._enable = true;
+        model._power = 40;
+        model._capacity = 10;
+        model._loss = loss;
+        model._filament = MODEL_FILAMENT;
+        model._sensor_response = 1.0 / 3;
+    }
+
+    // run for some seconds with the filament feeding at 'feed' mm/s - returns the lowest and
+    // highest temperatures seen. The model is told the feed only if 'told'.
+    void run(float set_point, float seconds, float feed, bool told, float &low, float &high) {
+        plant.extra_loss = feed * MODEL_FILAMENT;
+        float model_feed = told ? feed : 0;
+        low = TEMP_MAX_SETPOINT;
+        high = 0;
+        for (int n = 0; n < seconds / MODEL_PERIOD; n++) {
+            bool holding = (fabs(set_point - temp) < TEMP_MODEL_ESTIMATE_BAND);
+            model.update(temp, output, 0, model_feed, MODEL_PERIOD, holding);
+            output = model.getNewOutput(set_point, 0, model_feed);
+            temp = plant.step(output, MODEL_PERIOD);
+            low = min(low, temp);
+            high = max(high, temp);
+        }
+    }
+};
+
+static void test_model_control()
+{
+    float low, high;
+
+    // heat up from cold: full power most of the way, then settle without much overshoot
+    ModelRun hot(0.12);
+    CHECK(hot.model.getNewOutput(200, 0, 0) == 0);          // nothing until it has a reading
+    float peak;
+    hot.run(200, 90, 0, true, low, peak);
+    float at_90s = hot.temp;
+    hot.run(200, 210, 0, true, low, high);
+    peak = max(peak, high);
+    printf("  model heat-up: %.1f C at 90s, peak %.2f C, settled at %.2f C\n", at_90s, peak, hot.temp);
+    CHECK_MSG(at_90s > 199, "%.1f C after 90s", at_90s);
+    CHECK_MSG(peak < 200 + 1, "overshoot %.2f C", peak - 200);
+    CHECK_MSG(fabs(hot.temp - 200) < 0.5, "settled at %.2f C", hot.temp);
+
+    // filament starts flowing: the model knows and heats harder before the sensor sees the dip
+    ModelRun blind = hot;
+    float blind_low;
+    hot.run(200, 60, 2, true, low, high);
+    blind.run(200, 60, 2, false, blind_low, high);
+    printf("  flow step: dip %.2f C with feed forward, %.2f C without\n", 200 - low, 200 - blind_low);
+    CHECK_MSG(200 - low < 2, "dip %.2f C", 200 - low);
+    CHECK(low > blind_low + 2);
+    CHECK_MSG(fabs(hot.temp - 200) < 0.5, "%.2f C a minute after the flow step", hot.temp);
+
+    // started with half the real ambient loss, it learns it while holding
+    ModelRun learn(0.06);
+    learn.run(200, 120, 0, true, low, high);
+    float error_at_120s = fabs(learn.temp - 200);
+    learn.run(200, 600, 0, true, low, high);
+    printf("  loss estimate: %.4f W/K (plant %.4f), %.2f C off after 2 min, %.2f C after 12\n",
+           learn.model._loss, learn.plant.loss, error_at_120s, fabs(learn.temp - 200));
+    CHECK_MSG(fabs(learn.model._loss - 0.12) < 0.01, "loss %.4f W/K", learn.model._loss);
+    CHECK_MSG(fabs(learn.temp - 200) < 0.5, "%.2f C", learn.temp);
+
+    // not configured: no output
+    HeaterModel unset;
+    unset.update(25, 0, 0, 0, MODEL_PERIOD, false);
+    CHECK(unset.getNewOutput(200, 0, 0) == 0);
+}
+
+/**** ADC sampling ****/
+
+// The previous filter: a 9:1 IIR updated on every conversion
+struct IIRFilter {
+    float value = 0;
+    void add(uint16_t sample) { value = (sample + (9 * value)) / 10; }
+};
+
+struct FilterError {
+    double sum_squares = 0;
+    double worst = 0;
+    long n = 0;
+    void add(double error) { sum_squares += error * error; worst = max(worst, fabs(error)); n++; }
+    double rms() { return (sqrt(sum_squares / n)); }
+};
+
+// A heater coming up to temperature: the ADC falls from 600 to 150 counts over a minute
+// then holds. Conversions every TEMP_ADC_SAMPLE_TICKS ms, read once per PID period.
+static void run_filters(double noise_counts, double spike_rate, FilterError &iir_error, FilterError &sampler_error)
+{
+    std::mt19937 rng(1);
+    std::normal_distribution<double> noise(0.0, noise_counts);
+    std::uniform_real_distribution<double> uniform(0, 1);
+    ADCSampler<TEMP_ADC_SAMPLES> sampler;
+    IIRFilter iir;
+
+    for (int ms=0; ms < 120000; ms++) {
+        double truth = (ms < 60000) ? (600 - (7.5 * ms / 1000)) : 150;
+        if ((ms % TEMP_ADC_SAMPLE_TICKS) == 0) {
+            double v = truth + noise(rng);
+            if (uniform(rng) < spike_rate) {
+                v += (uniform(rng) < 0.5) ? -300 : 300;
+            }
+            uint16_t sample = (uint16_t)std::min(4095.0, std::max(0.0, round(v)));
+            iir.add(sample);
+            sampler.add(sample);
+        }
+        if (((ms % TEMP_PID_PERIOD_MS) == TEMP_PID_PERIOD_MS-1) && (ms > 2000)) {
+            iir_error.add(iir.value - truth);
+            sampler_error.add(sampler.value() - truth);
+        }
+    }
+}
+
+static void test_adc_sampling()
+{
+    FilterError iir, sampler;
+    run_filters(3.0, 0.0, iir, sampler);
+    printf("  gaussian noise: IIR rms %.2f max %.2f, sampler rms %.2f max %.2f counts\n", iir.rms(), iir.worst, sampler.rms(), sampler.worst);
+    CHECK(sampler.rms() < 1.5 * iir.rms());             // about the same on plain noise
+
+    FilterError iir_spikes, sampler_spikes;
+    run_filters(3.0, 0.02, iir_spikes, sampler_spikes);
+    printf("  2%% spikes:      IIR rms %.2f max %.2f, sampler rms %.2f max %.2f counts\n", iir_spikes.rms(), iir_spikes.worst, sampler_spikes.rms(), sampler_spikes.worst);
+    CHECK(sampler_spikes.rms() < 0.5 * iir_spikes.rms());  // far better with spikes
+
+    // lag on the ramp alone, no noise
+    ADCSampler<TEMP_ADC_SAMPLES> ramp_sampler;
+    IIRFilter ramp_iir;
+    double truth = 0;
+    for (int ms=0; ms < 10000; ms++) {
+        truth = 600 - (7.5 * ms / 1000);
+        if ((ms % TEMP_ADC_SAMPLE_TICKS) == 0) {
+            ramp_iir.add((uint16_t)lround(truth));
+            ramp_sampler.add((uint16_t)lround(truth));
+        }
+    }
+    double iir_lag = (ramp_iir.value - truth) / 7.5 * 1000;
+    double sampler_lag = (ramp_sampler.value() - truth) / 7.5 * 1000;
+    printf("  lag on a ramp:  IIR %.0fms, sampler %.0fms\n", iir_lag, sampler_lag);
+    CHECK((sampler_lag > 0) && (sampler_lag < iir_lag));
+
+    // the thermistor reduces what its conversions fed it once per period
+    Thermistor<kADC1_PinNumber> thermistor { 20.0, 195.0, 255.0, 140000.0, 593.0, 189.0, 4700, 4700 };
+    const uint16_t samples[] = { 2000, 2002, 4095, 1998, 2001, 0, 1999, 2003, 2000, 1997 };
+    for (uint16_t sample : samples) {
+        thermistor.adc_pin.raw = sample;
+        thermistor.adc_has_new_value();
+    }
+    thermistor.update();
+    CHECK(fabs(thermistor.raw_adc_value - 2000.0) < 1.0);  // the spikes are dropped
+
+    ADCSampler<TEMP_ADC_SAMPLES> empty;
+    CHECK(empty.value() == 0);
+    empty.add(100);
+    CHECK(empty.value() == 100);                        // a partly filled window only uses what it has
+}
+
+int main()
+{
+    test_thermistor_table();
+    test_autotune();
+    test_model_control();
+    test_adc_sampling();
+    return (test_exit("test_temperature"));
+}
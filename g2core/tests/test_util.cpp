@@ -0,0 +1,162 @@
+/*
+ * test_util.cpp - floattoa() and inttoa() against printf, and base32
+ * This file is part of the g2core project
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "g2core.h"
+#include "config.h"
+#include "xio.h"
+#include "util.h"
+#include "test.h"
+
+#include <stdlib.h>
+#include <climits>
+
+// printf's %.*f is exact, trailing zeros and the decimal point stripped the way floattoa() does
+static void reference(char *out, float f, int precision)
+{
+    sprintf(out, "%.*f", precision, (double)f);
+    if (strchr(out, '.')) {
+        char *e = out + strlen(out);
+        while (e[-1] == '0') { *--e = NUL; }
+        if (e[-1] == '.') { *--e = NUL; }
+    }
+    if (strcmp(out, "-0") == 0) {
+        strcpy(out, "0");
+    }
+}
+
+// printf rounds exact ties to even, floattoa() rounds them up
+static bool is_tie(float f, int precision)
+{
+    double scaled = fabs((double)f * pow(10, precision));
+    return ((scaled - floor(scaled)) == 0.5);
+}
+
+static void test_random()
+{
+    char out[32], ref[32];
+    long differ = 0;
+    srand(1);
+    for (long k=0; k < 1000000; k++) {
+        int precision = rand() % 8;
+        float f;
+        switch (k % 4) {
+            case 0: f = (rand() % 2000000 - 1000000) / 1000.0f; break;
+            case 1: f = ldexpf((float)rand() / RAND_MAX, rand() % 40 - 20) * ((rand() % 2) ? 1 : -1); break;
+            case 2: f = (rand() % 100000) / (float)pow(10, rand() % 6); break;
+            default: f = (float)(rand() - RAND_MAX/2); break;
+        }
+        uint8_t length = floattoa(out, f, precision, 30);
+        CHECK(length == strlen(out));
+        if (is_tie(f, precision)) {
+            continue;
+        }
+        reference(ref, f, precision);
+        if (strcmp(out, ref) != 0) {
+            if (differ++ < 5) {
+                printf("    %.9g precision %d: floattoa %s, printf %s\n", f, precision, out, ref);
+            }
+        }
+        // round trip: reading it back lands within half a digit of the value
+        CHECK(fabs(strtod(out, NULL) - (double)f) <= 0.5 * pow(10, -precision) * (1 + 1e-9));
+    }
+    CHECK_MSG(differ == 0, "%ld values differ from printf", differ);
+}
+
+static void test_cases()
+{
+    struct { float f; int precision; const char *expect; } cases[] = {
+        { 0.0,      3, "0" },
+        { -0.0,     3, "0" },
+        { -0.0004,  3, "0" },           // no "-0"
+        { -0.0005,  3, "-0.001" },      // float just above the tie
+        { 0.125,    2, "0.13" },        // exact tie rounds up
+        { -1.5,     0, "-2" },
+        { 20.1,     3, "20.1" },
+        { 20.0,     3, "20" },
+        { 99.9999,  3, "100" },         // carry into the integer part
+        { 123.456,  3, "123.456" },
+        { 1.0,      9, "1" },
+        { 0.1,      12, "0.100000001" },    // precision clamps to 9
+        { 2.5,      -1, "3" },              // and to 0
+        { 4294967296.0, 3, "4294967296" },
+        { -1e12,    3, "-999999995904" },
+    };
+    char out[32];
+    for (auto &c : cases) {
+        floattoa(out, c.f, c.precision, 30);
+        CHECK_MSG(strcmp(out, c.expect) == 0, "%g precision %d: '%s', expected '%s'", c.f, c.precision, out, c.expect);
+    }
+
+    CHECK((floattoa(out, NAN, 3) == 3) && (strcmp(out, "nan") == 0));
+    CHECK((floattoa(out, INFINITY, 3) == 3) && (strcmp(out, "inf") == 0));
+    CHECK((floattoa(out, -INFINITY, 3) == 3) && (strcmp(out, "inf") == 0));
+    CHECK((floattoa(out, 1e20, 3) == 3) && (strcmp(out, "inf") == 0));
+
+    CHECK((floattoa(out, 123456.789, 3, 8) == 0) && (out[0] == NUL));   // longer than maxlen
+    CHECK(floattoa(out, 123456.75, 2, 9) == 9);
+
+    // nothing may land past str[maxlen], whatever the value and however short maxlen is
+    const float longest[] = { -4294967295.0, -1.7e19, -4000000000.123, 0.000000001, NAN };
+    for (float f : longest) {
+        for (int maxlen = 0; maxlen <= 22; maxlen++) {
+            memset(out, '#', sizeof(out));
+            int length = floattoa(out, f, 9, maxlen);
+            bool clean = (length <= maxlen) && (out[length] == NUL);
+            for (int i = maxlen+1; i < (int)sizeof(out); i++) {
+                clean = clean && (out[i] == '#');
+            }
+            CHECK_MSG(clean, "%g maxlen %d: wrote past maxlen ('%s')", f, maxlen, out);
+        }
+    }
+    CHECK(floattoa(out, -4294967295.0, 9, 21) == 11);
+    CHECK((floattoa(out, 2.5, 0, 0) == 0) && (out[0] == NUL));
+}
+
+static void test_inttoa()
+{
+    char out[16], ref[16];
+    for (int n : { 0, 7, 255, 256, -1, -255, 123456, INT_MAX, INT_MIN }) {
+        sprintf(ref, "%d", n);
+        CHECK_MSG(((size_t)inttoa(out, n) == strlen(ref)) && (strcmp(out, ref) == 0), "%d: '%s'", n, out);
+    }
+}
+
+static void test_base32()
+{
+    // RFC 4648 test vectors, less the padding
+    const char *plain[] = { "", "f", "fo", "foo", "foob", "fooba", "foobar" };
+    const char *coded[] = { "", "MY", "MZXQ", "MZXW6", "MZXW6YQ", "MZXW6YTB", "MZXW6YTBOI" };
+    char out[32], lower[32];
+    uint8_t back[32];
+    for (int i=0; i < 7; i++) {
+        CHECK((base32_encode(out, plain[i], strlen(plain[i])) == strlen(coded[i])) && (strcmp(out, coded[i]) == 0));
+        for (int k=0; (lower[k] = tolower(out[k])) != NUL; k++);
+        int16_t length = base32_decode(back, lower, sizeof(back));      // either case decodes
+        CHECK((length == (int16_t)strlen(plain[i])) && (memcmp(back, plain[i], length) == 0));
+    }
+    CHECK(base32_decode(back, "MZXW1", sizeof(back)) == -1);           // not in the alphabet
+    CHECK(base32_decode(back, "MZXW6YTBOI", 5) == -1);                 // doesn't fit
+}
+
+int main()
+{
+    test_random();
+    test_cases();
+    test_inttoa();
+    test_base32();
+    return (test_exit("test_util"));
+}
@@ -0,0 +1,304 @@
+/*
+ * test_xio.cpp - xio devices on the host: job files from stdio storage, and the socket device
+ * This file is part of the g2core project
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/*
+ * Includes xio.cpp to reach the device wrappers. Job files are written to the
+ * XIO_STDIO_STORAGE_PATH the Makefile names, and read back through the job file device.
+ * The socket tests play the host end of XIO_HOST_SOCKET_PATH, and move the data by
+ * calling xio_callback() as the main loop would.
+ */
+
+#include "../xio.cpp"
+#include "canonical_machine.h"
+#include "json_parser.h"
+#include "persistence.h"
+#include "test.h"
+
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+
+static void write_job(const char *name, const std::string &body)
+{
+    std::string path = std::string(XIO_STDIO_STORAGE_PATH) + "/" + name;
+    FILE *f = fopen(path.c_str(), "wb");
+    fwrite(body.data(), 1, body.size(), f);
+    fclose(f);
+}
+
+static const char *next_line(devflags_t flags = DEV_IS_DATA)
+{
+    uint16_t size;
+    return (storageFileWrapper.readline(flags, size));
+}
+
+static bool is_line(const char *line, const char *expect)
+{
+    return ((line != nullptr) && (strcmp(line, expect) == 0));
+}
+
+static std::vector<std::pair<std::string, int32_t>> listed;
+
+static void list_callback(const char *name, int32_t size)
+{
+    listed.push_back({name, size});
+}
+
+static void test_read_ahead()
+{
+    std::string body;
+    for (int i = 0; i < 1000; i++) {
+        body += "G1 X" + std::to_string(i) + " F1000\n";
+    }
+    write_job("big.nc", body);
+
+    listed.clear();
+    CHECK(xio_list_job_files(list_callback));
+    bool found = false;
+    for (auto &f : listed) {
+        found = found || ((f.first == "big.nc") && (f.second == (int32_t)body.size()));
+    }
+    CHECK(found);
+    CHECK(!xio_select_job_file("missing.nc"));
+
+    CHECK(xio_select_job_file("big.nc"));
+    CHECK(storageFileWrapper._count == XIO_FILE_BLOCK_SIZE);   // select() primes one block
+    int32_t position, size;
+    CHECK(xio_job_file_progress(position, size) && (position == 0) && (size == (int32_t)body.size()));
+    CHECK(next_line() == nullptr);                              // nothing until the job is started
+
+    // one block per main loop pass until the ring is full, then nothing more is read
+    for (int pass = 1; pass < 12; pass++) {
+        xio_callback();
+        uint16_t expect = std::min(XIO_FILE_BLOCK_SIZE * (pass+1), XIO_FILE_READ_AHEAD_SIZE);
+        CHECK_MSG(storageFileWrapper._count == expect, "pass %d: %d bytes read ahead", pass, storageFileWrapper._count);
+    }
+
+    // every line comes back in order, across ring wraps, with or without the callback running
+    CHECK(xio_start_job_file());
+    int lines = 0;
+    const char *line;
+    while ((line = next_line()) != nullptr) {
+        std::string expect = "G1 X" + std::to_string(lines) + " F1000";
+        CHECK_MSG(is_line(line, expect.c_str()), "line %d: '%s'", lines, line);
+        if ((lines++ % 3) == 0) {
+            xio_callback();
+        }
+    }
+    CHECK_MSG(lines == 1000, "%d lines", lines);
+    CHECK(!storageFileWrapper._is_open);                        // closed at the end of the file
+    CHECK(!xio_job_file_progress(position, size));
+}
+
+static void test_line_splitting()
+{
+    std::string long_line(RX_BUFFER_SIZE + 100, 'x');
+    write_job("split.nc", "G0 X1\r\n\r\n\nG0 X2\rG0 X3\n" + long_line + "\n!\nM2");
+
+    CHECK(xio_select_job_file("split.nc") && xio_start_job_file());
+    CHECK(next_line(DEV_IS_CTRL) == nullptr);                   // Gcode is data, not control
+    CHECK(is_line(next_line(), "G0 X1"));                       // CRLF is one terminator
+    CHECK(is_line(next_line(), "G0 X2"));                       // blank lines are skipped, CR alone ends a line
+    CHECK(is_line(next_line(), "G0 X3"));
+    const char *line = next_line();
+    CHECK((line != nullptr) && (strlen(line) == RX_BUFFER_SIZE-1));     // over-long lines are truncated
+    CHECK(is_line(next_line(DEV_IS_CTRL), "!"));                // a control line can be read as control
+    CHECK(is_line(next_line(), "M2"));                          // the last line needs no terminator
+    CHECK(next_line() == nullptr);
+    CHECK(!storageFileWrapper._is_open);
+}
+
+static void test_pause_resume()
+{
+    std::string body;
+    for (int i = 0; i < 10; i++) {
+        body += "N" + std::to_string(i) + " G0 X" + std::to_string(i) + "\n";
+    }
+    write_job("pause.nc", body);
+
+    CHECK(xio_select_job_file("pause.nc") && xio_start_job_file());
+    CHECK(is_line(next_line(), "N0 G0 X0"));
+    CHECK(cs.responses_suppressed);                             // job lines don't get responses
+    CHECK(is_line(next_line(), "N1 G0 X1"));
+    CHECK(is_line(next_line(), "N2 G0 X2"));
+
+    xio_pause_job_file();
+    CHECK(!cs.responses_suppressed);                            // the host is talking to us again
+    int32_t position, size;
+    CHECK(xio_job_file_progress(position, size));               // the file stays selected
+    int32_t paused_at = position;
+    CHECK(next_line() == nullptr);
+    xio_callback();
+    CHECK(next_line() == nullptr);
+    CHECK(xio_job_file_progress(position, size) && (position == paused_at));
+
+    CHECK(xio_start_job_file());                                // resume where it left off
+    CHECK(is_line(next_line(), "N3 G0 X3"));
+
+    nvObj_t nv;
+    nv.valuetype = TYPE_STRING;
+    nv_copy_string(&nv, "split.nc");
+    CHECK(xio_set_file(&nv) == STAT_COMMAND_NOT_ACCEPTED);      // no other job while it's running
+    int lines = 4;
+    while (next_line() != nullptr) {
+        lines++;
+    }
+    CHECK_MSG(lines == 10, "%d lines", lines);
+    CHECK(!cs.responses_suppressed);
+}
+
+/**** socket device ****/
+
+static int client_connect()
+{
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, XIO_HOST_SOCKET_PATH);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return (-1);
+    }
+    return (fd);
+}
+
+static void client_send(int fd, const char *str)
+{
+    send(fd, str, strlen(str), MSG_NOSIGNAL);
+}
+
+static std::string client_receive(int fd)
+{
+    std::string received;
+    char buf[1024];
+    ssize_t length;
+    while ((length = recv(fd, buf, sizeof(buf), MSG_DONTWAIT)) > 0) {
+        received.append(buf, length);
+    }
+    return (received);
+}
+
+static void pump(int passes = 4)
+{
+    for (int i = 0; i < passes; i++) {
+        xio_callback();
+    }
+}
+
+static const char *read_socket_line(devflags_t flags)
+{
+    uint16_t size;
+    return (xio_readline(flags, size));
+}
+
+static void test_socket()
+{
+    CHECK(!serialSocketWrapper.isConnected());
+    int fd = client_connect();
+    CHECK(fd >= 0);
+    pump();
+    CHECK(serialSocketWrapper.isConnected() && serialSocketWrapper.isCtrlAndActive());
+    CHECK(cs.controller_state == CONTROLLER_CONNECTED);
+
+    // controls are read ahead of the data lines they arrived behind
+    client_send(fd, "G0 X1\n{\"xvm\":null}\nG1 X2 F100\n");
+    pump();
+    char line[RX_BUFFER_SIZE];
+    strcpy(line, read_socket_line(DEV_IS_CTRL));
+    CHECK_MSG(strcmp(line, "{\"xvm\":null}\n") == 0, "'%s'", line);  // controls keep their terminator
+    CHECK(is_line(read_socket_line(DEV_IS_BOTH), "G0 X1"));
+    CHECK(is_line(read_socket_line(DEV_IS_BOTH), "G1 X2 F100"));
+    CHECK(read_socket_line(DEV_IS_BOTH) == nullptr);
+
+    // the response goes back through the TX queue and buffer to the client
+    js.json_mode = JSON_MODE;
+    json_parser(line);
+    pump();
+    std::string response = client_receive(fd);
+    CHECK_MSG(response.compare(0, 12, "{\"r\":{\"xvm\":") == 0, "'%s'", response.c_str());
+    CHECK(response.back() == '\n');
+
+    // more than the TX queue and buffer hold at once arrives whole and in order
+    std::string sent, received;
+    for (int i = 0; sent.size() < 5000; i++) {
+        std::string out = "line " + std::to_string(i) + "\n";
+        xio_writeline(out.c_str());
+        sent += out;
+        if ((i % 50) == 0) {
+            pump();
+            received += client_receive(fd);
+        }
+    }
+    for (int i = 0; (i < 100) && (received.size() < sent.size()); i++) {
+        pump();
+        received += client_receive(fd);
+    }
+    CHECK(received == sent);
+
+    // lines longer than the RX buffer's ring arrive across transfers
+    std::string long_lines;
+    for (int i = 0; i < 40; i++) {
+        long_lines += "G1 X" + std::to_string(i) + " Y" + std::string(40, '1') + "\n";
+    }
+    client_send(fd, long_lines.c_str());
+    int lines = 0;
+    for (int pass = 0; pass < 100; pass++) {
+        pump(1);
+        const char *l;
+        while ((l = read_socket_line(DEV_IS_BOTH)) != nullptr) {
+            std::string expect = "G1 X" + std::to_string(lines) + " Y" + std::string(40, '1');
+            CHECK_MSG(is_line(l, expect.c_str()), "line %d: '%s'", lines, l);
+            lines++;
+        }
+    }
+    CHECK_MSG(lines == 40, "%d lines", lines);
+
+    // hanging up disconnects the device and the controller, and unread input is dropped
+    client_send(fd, "G0 X9\n");
+    pump();
+    close(fd);
+    pump();
+    CHECK(!serialSocketWrapper.isConnected());
+    CHECK(cs.controller_state == CONTROLLER_NOT_CONNECTED);
+
+    fd = client_connect();                                      // a new client can connect
+    pump();
+    CHECK(serialSocketWrapper.isConnected());
+    CHECK(read_socket_line(DEV_IS_BOTH) == nullptr);
+    close(fd);
+    pump();
+    CHECK(!serialSocketWrapper.isConnected());
+}
+
+int main()
+{
+    mkdir(XIO_STDIO_STORAGE_PATH, 0777);
+    remove(NVM_FILE);
+    persistence_init();
+    xio_init();
+    cm = &cm1;
+    canonical_machine_inits();
+    controller_init();
+    config_init();
+    CHECK(xio_has_storage());
+
+    test_read_ahead();
+    test_line_splitting();
+    test_pause_resume();
+    test_socket();
+    return (test_exit("test_xio"));
+}
@@ -218,6 +218,25 @@ uint16_t compute_checksum(char const *string, const uint16_t length)
     return (h % HASHMASK);
 }
 
+/*
+ * crc16() - CRC-16/CCITT (poly 0x1021) of length bytes, continuing from crc
+ *
+ *  Start with crc = 0xFFFF. Bitwise rather than table driven - it's only used for
+ *  stored data, where a 512 byte table would cost more than the time it saves.
+ */
+
+uint16_t crc16(uint16_t crc, const void *data, uint16_t length)
+{
+    const uint8_t *p = (const uint8_t *)data;
+    while (length--) {
+        crc ^= (uint16_t)(*p++) << 8;
+        for (uint8_t i=0; i<8; i++) {
+            crc = (crc & 0x8000) ? ((crc << 1) ^ 0x1021) : (crc << 1);
+        }
+    }
+    return (crc);
+}
+
 /*
  * SysTickTimer_getValue() - this is a hack to get around some compatibility problems
  */
@@ -238,7 +257,9 @@ uint32_t SysTickTimer_getValue()
  *  It suppresses trailing zeros and decimal points, 20.100 --> 20.1, 20.000 --> 20
  *  Like sprintf, floattoa returns length of string, less the terminating NUL character 
  *
- *  !!! Precision cannot be greater than 10 !!!
+ *  Precision is clamped to 0..FLOATTOA_MAX_PRECISION (9). Returns 0 and an empty string
+ *  if the result would be longer than maxlen, so at most maxlen+1 bytes (with the NUL)
+ *  are ever written to str. The longest result is 21 characters.
  */
 
 #if 0 // olde version using sprintf. Does not do trailing zero suppression
@@ -269,108 +290,112 @@ char floattoa(char *str, float n, int precision, int maxlen /*= 16*/)
 #endif
 
 // *** floattoa() starts here ***
+//
+// The float is split exactly into its integer part and a 32 bit binary fraction. The fraction
+// is scaled by 10^precision in 64 bit integer math, so the digits and the round-half-up are
+// exact for the value the float actually holds - no float multiplies, no sprintf.
+
+#define FLOATTOA_MAX_PRECISION 9        // 10^9 * 2^32 still fits in 64 bits
+#define FLOATTOA_BUFFER_SIZE 24         // longest result is 21 chars: "-4294967295.123456789"
 
-constexpr float round_lookup_[] = {
-    0.5,          // precision 0
-    0.05,         // precision 1
-    0.005,        // precision 2
-    0.0005,       // precision 3
-    0.00005,      // precision 4
-    0.000005,     // precision 5
-    0.0000005,    // precision 6
-    0.00000005,   // precision 7
-    0.000000005,  // precision 8
-    0.0000000005, // precision 9
-    0.00000000005 // precision 10
+static const uint32_t pow10_lookup_[] = {
+    1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
 };
 
-// It's assumed that the string buffer contains at least count_ non-\0 chars
-int c_strreverse(char * const t, const int count_, char hold = 0) {
-    return count_>1
-    // Note: It always returns the count_, for a consistent interface.
-    ? (hold=*t, *t=*(t+(count_-1)), *(t+(count_-1))=hold), c_strreverse(t+1, count_-2), count_
-    : count_;
+// _utoa() - write an unsigned integer, most significant digit first. Not NUL terminated.
+template <typename T>
+static int _utoa(char *str, T n)
+{
+    char digits[20];
+    int length = 0;
+    do {
+        digits[length++] = '0' + (n % 10);
+        n /= 10;
+    } while (n > 0);
+    for (int i = 0; i < length; i++) {
+        str[i] = digits[length-1 - i];
+    }
+    return (length);
 }
 
 char floattoa(char *str, float n, int precision, int maxlen /*= 16*/) // maxlen = 16
 {
-    // handle special cases
-    if (isnan(n)) {
-        strcpy(str, "nan");
-        return (3);
+    char buf_[FLOATTOA_BUFFER_SIZE];                // formatted here, copied out only if it fits
+    char *b_ = buf_;
+
+    if (precision < 0) {
+        precision = 0;
+    } else if (precision > FLOATTOA_MAX_PRECISION) {
+        precision = FLOATTOA_MAX_PRECISION;
     }
-    else if (isinf(n)) {
-        strcpy(str, "inf");
-        return (3);
+    bool negative = (n < 0.0);
+    if (negative) {
+        n = -n;
     }
 
-    int length_ = 0;
-    char *b_ = str;
-
-    if (n < 0.0) {
-        *b_++ = '-';
-        return floattoa(b_, -n, precision, maxlen-1) + 1;
+    // handle special cases
+    if (isnan(n)) {
+        strcpy(b_, "nan");
+        b_ += 3;
     }
-
-    n += round_lookup_[precision];
-    int int_length_ = 0;
-    int integer_part_ = (int)n;
-
-    // do integer part
-    while (integer_part_ > 0) {
-        if (length_++ > maxlen) {
-            *str = 0;
-            return 0;
-        }
-        int t_ = integer_part_ / 10;
-        *b_++ = '0' + (integer_part_ - (t_*10));
-        integer_part_ = t_;
-        int_length_++;
+    else if (isinf(n) || (n >= 1.8e19)) {           // beyond 64 bits as well
+        strcpy(b_, "inf");
+        b_ += 3;
     }
-    if (length_ > 0) {
-        c_strreverse(str, int_length_);
+    else if (n >= 4294967296.0) {                        // floats this large have no fractional part
+        if (negative) {
+            *b_++ = '-';
+        }
+        b_ += _utoa(b_, (uint64_t)n);
     } else {
-        *b_++ = '0';
-        int_length_++;
-    }
-
-    // do fractional part
-    *b_++ = '.';
-    length_ = int_length_+1;
-
-    float frac_part_ = n;
-    frac_part_ -= (int)frac_part_;
-    while (precision-- > 0) {
-        if (length_++ > maxlen) {
-            *str = 0;
-            return 0;
+        uint32_t integer_part_ = (uint32_t)n;
+        float fraction_ = (n - (float)integer_part_) * 4294967296.0;  // exact: scaling by 2^32
+        uint32_t fraction_bits_ = (uint32_t)fraction_;
+        uint64_t scaled_ = (uint64_t)fraction_bits_ * pow10_lookup_[precision];
+        scaled_ += (uint32_t)((fraction_ - fraction_bits_) * pow10_lookup_[precision]); // bits below 2^-32 (tiny values)
+        uint32_t frac_digits_ = (uint32_t)(scaled_ >> 32);
+        if ((uint32_t)scaled_ >= 0x80000000) {      // round half up
+            frac_digits_++;
+        }
+        if (frac_digits_ >= pow10_lookup_[precision]) {
+            frac_digits_ -= pow10_lookup_[precision];
+            integer_part_++;
+        }
+        if (negative && ((integer_part_ != 0) || (frac_digits_ != 0))) {
+            *b_++ = '-';                            // no "-0" for values that round to zero
+        }
+        b_ += _utoa(b_, integer_part_);
+
+        if (frac_digits_ != 0) {                    // suppress trailing zeros and the decimal point
+            while ((frac_digits_ % 10) == 0) {
+                frac_digits_ /= 10;
+                precision--;
+            }
+            *b_++ = '.';
+            for (int i = precision-1; i >= 0; i--) {
+                b_[i] = '0' + (frac_digits_ % 10);
+                frac_digits_ /= 10;
+            }
+            b_ += precision;
         }
-        frac_part_ *= 10.0;
-        // if (precision==0) {
-        //     t_ += 0.5;
-        // }
-        *b_++ = ('0' + (int)frac_part_);
-        frac_part_ -= (int)frac_part_;
-    }
-
-    // right strip trailing zeroes (OPTIONAL)
-    while (*(b_-1) == '0' && length_>1) {
-        *(b_--) = 0;
-        length_--;
     }
 
-    if (*(b_-1) == '.') {
-        *(b_--) = 0;
-        length_--;
+    int length_ = b_ - buf_;
+    if (length_ > maxlen) {
+        *str = 0;
+        return 0;
     }
-    return length_;
+    memcpy(str, buf_, length_);
+    str[length_] = 0;
+    return (length_);
 }
 
 /***********************************************************************************
  * inttoa() - integer to ASCII
+ * hextoa() - unsigned integer to lower case hex ASCII, no prefix
  *
  *  Taking advantage of the fact that most ints we display are 8 bit quantities,
- *  and we have plenty of FLASH
+ *  and we have plenty of FLASH. Both return the length, less the terminating NUL.
  */
 // static ASCII numbers
 static const char itoa_00[] = "0";
@@ -666,36 +691,164 @@ static const char *const itoa_str[] = {
     itoa_250, itoa_251, itoa_252, itoa_253, itoa_254, itoa_255
 };
 
-static int _i2a(char *s, int n)
+char inttoa(char *str, int n)
+{
+    if ((n >= 0) && (n < 256)) {
+        strcpy(str, GET_TEXT_ITEM(itoa_str, n));
+        return (strlen(str));
+    }
+    char *p = str;
+    uint32_t u = n;
+    if (n < 0) {
+        *p++ = '-';
+        u = 0 - u;                                  // also right for INT_MIN
+    }
+    p += _utoa(p, u);
+    *p = NUL;
+    return (p - str);
+}
+
+char hextoa(char *str, uint32_t n)
 {
-    div_t qr;
-    int pos;
+    char *p = str;
+    int shift = 28;
+    while ((shift > 0) && (((n >> shift) & 0x0F) == 0)) {
+        shift -= 4;                                 // skip leading zeros, but always write one digit
+    }
+    for ( ; shift >= 0; shift -= 4) {
+        *p++ = "0123456789abcdef"[(n >> shift) & 0x0F];
+    }
+    *p = NUL;
+    return (p - str);
+}
 
-    if (n == 0) {
-        return 0;
+/*
+ * base64_encode() - encode length bytes as NUL terminated base64. Returns the string length.
+ * base64_decode() - decode base64 into at most max bytes. Returns the byte count, or -1
+ *                   if the string is not base64 or does not fit.
+ *
+ *  For carrying binary data in JSON strings. dst for base64_encode() needs room for
+ *  4 * ((length + 2) / 3) + 1 chars.
+ */
+
+static const char b64_chars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+uint16_t base64_encode(char *dst, const void *src, uint16_t length)
+{
+    const uint8_t *s = (const uint8_t *)src;
+    char *p = dst;
+
+    for (uint16_t i=0; i<length; i+=3) {
+        uint32_t n = (uint32_t)s[i] << 16;
+        if (i+1 < length) { n |= (uint32_t)s[i+1] << 8; }
+        if (i+2 < length) { n |= s[i+2]; }
+        *p++ = b64_chars[(n >> 18) & 0x3F];
+        *p++ = b64_chars[(n >> 12) & 0x3F];
+        *p++ = (i+1 < length) ? b64_chars[(n >> 6) & 0x3F] : '=';
+        *p++ = (i+2 < length) ? b64_chars[n & 0x3F] : '=';
     }
+    *p = NUL;
+    return (p - dst);
+}
 
-    qr = div(n, 10);
-    pos = _i2a(s, qr.quot);
-    s[pos] = qr.rem + '0';
-    return (pos + 1);
+static int8_t _b64_value(char c)
+{
+    if ((c >= 'A') && (c <= 'Z')) { return (c - 'A'); }
+    if ((c >= 'a') && (c <= 'z')) { return (c - 'a' + 26); }
+    if ((c >= '0') && (c <= '9')) { return (c - '0' + 52); }
+    if (c == '+') { return (62); }
+    if (c == '/') { return (63); }
+    return (-1);
 }
 
-char inttoa(char *str, int n)
+int16_t base64_decode(uint8_t *dst, const char *src, uint16_t max)
 {
-    if (n < 256) {
-        strcpy(str, GET_TEXT_ITEM(itoa_str, n));
-    } else {
-        char *p = str;
-        if (n < 0){
-            *p++ = '-';
-            n *= -1;
-        } else if(n == 0) {
-            *p++ = '0';
+    uint16_t count = 0;
+    uint32_t n = 0;
+    uint8_t bits = 0;
+
+    for ( ; (*src != NUL) && (*src != '='); src++) {
+        int8_t v = _b64_value(*src);
+        if (v < 0) {
+            return (-1);
+        }
+        n = (n << 6) | v;
+        bits += 6;
+        if (bits >= 8) {
+            if (count == max) {
+                return (-1);
+            }
+            bits -= 8;
+            dst[count++] = (n >> bits) & 0xFF;
         }
-        p[_i2a(p, n)]='\0';
+    }
+    return (count);
+}
+
+/*
+ * base32_encode() - encode length bytes as NUL terminated base32. Returns the string length.
+ * base32_decode() - decode base32 into at most max bytes. Returns the byte count, or -1
+ *                   if the string is not base32 or does not fit.
+ *
+ *  RFC 4648 base32, without the '=' padding. For binary data in strings that get lower
+ *  cased on the way in, such as JSON string values, as the decoder takes either case.
+ *  dst for base32_encode() needs room for 8 * ((length + 4) / 5) + 1 chars.
+ */
+
+static const char b32_chars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ234567";
+
+uint16_t base32_encode(char *dst, const void *src, uint16_t length)
+{
+    const uint8_t *s = (const uint8_t *)src;
+    char *p = dst;
+    uint32_t n = 0;
+    uint8_t bits = 0;
+
+    for (uint16_t i=0; i<length; i++) {
+        n = (n << 8) | s[i];
+        bits += 8;
+        while (bits >= 5) {
+            bits -= 5;
+            *p++ = b32_chars[(n >> bits) & 0x1F];
+        }
+    }
+    if (bits > 0) {
+        *p++ = b32_chars[(n << (5 - bits)) & 0x1F];
+    }
+    *p = NUL;
+    return (p - dst);
+}
+
+static int8_t _b32_value(char c)
+{
+    if ((c >= 'A') && (c <= 'Z')) { return (c - 'A'); }
+    if ((c >= 'a') && (c <= 'z')) { return (c - 'a'); }
+    if ((c >= '2') && (c <= '7')) { return (c - '2' + 26); }
+    return (-1);
+}
+
+int16_t base32_decode(uint8_t *dst, const char *src, uint16_t max)
+{
+    uint16_t count = 0;
+    uint32_t n = 0;
+    uint8_t bits = 0;
+
+    for ( ; (*src != NUL) && (*src != '='); src++) {
+        int8_t v = _b32_value(*src);
+        if (v < 0) {
+            return (-1);
         }
-    return (strlen(str));
+        n = (n << 5) | v;
+        bits += 5;
+        if (bits >= 8) {
+            if (count == max) {
+                return (-1);
+            }
+            bits -= 8;
+            dst[count++] = (n >> bits) & 0xFF;
+        }
+    }
+    return (count);
 }
 
 //*** debug utilities ***
@@ -703,7 +856,7 @@ char inttoa(char *str, int n)
 void LAGER(const char * msg)
 {
     char message[64];
-    sprintf(message, "%lu: %s\n", SysTickTimer_getValue(), msg);
+    sprintf(message, "%lu: %s\n", (unsigned long)SysTickTimer_getValue(), msg);
     xio_writeline(message);
 }
 
@@ -711,9 +864,9 @@ void LAGER_cm(const char * msg)
 {
     char message[64];
     if (cm == &cm1) {
-        sprintf(message, "%lu: p1 %s\n", SysTickTimer_getValue(), msg);
+        sprintf(message, "%lu: p1 %s\n", (unsigned long)SysTickTimer_getValue(), msg);
     } else {
-        sprintf(message, "%lu: p2 %s\n", SysTickTimer_getValue(), msg);
+        sprintf(message, "%lu: p2 %s\n", (unsigned long)SysTickTimer_getValue(), msg);
     }
     xio_writeline(message);
 }
@@ -95,8 +95,14 @@ float max4(float x1, float x2, float x3, float x4);
 uint8_t isnumber(char c);
 char *escape_string(char *dst, char *src);
 uint16_t compute_checksum(char const *string, const uint16_t length);
+uint16_t crc16(uint16_t crc, const void *data, uint16_t length);
 char floattoa(char *buffer, float in, int precision, int maxlen = 16);
 char inttoa(char *str, int n);
+char hextoa(char *str, uint32_t n);
+uint16_t base64_encode(char *dst, const void *src, uint16_t length);
+int16_t base64_decode(uint8_t *dst, const char *src, uint16_t max);
+uint16_t base32_encode(char *dst, const void *src, uint16_t length);
+int16_t base32_decode(uint8_t *dst, const char *src, uint16_t max);
 
 //*** other utilities ***
 
@@ -114,7 +120,7 @@ using std::max;
 template <typename T>
 inline T square(const T x) { return (x)*(x); }        /* UNSAFE */
 
-inline float abs(const float a) { return fabs(a); }
+using std::abs;
 
 #ifndef avg
 template <typename T>
@@ -151,9 +151,9 @@ struct xioDeviceWrapperBase {                // C++ base class for device primit
     void setAsMuted() { flags = (flags & ~(DEV_IS_PRIMARY | DEV_IS_DATA | DEV_IS_CTRL)) | DEV_IS_MUTED; };
     void clearFlags() { flags = DEV_FLAGS_CLEAR; }
 
-    xioDeviceWrapperBase(uint8_t _caps) : caps(_caps),
+    xioDeviceWrapperBase(uint8_t _caps, const char *_name) : caps(_caps),
     flags((_caps & DEV_IS_ALWAYS_BOTH) ? (DEV_IS_CTRL | DEV_IS_DATA) : DEV_FLAGS_CLEAR),
-                                          next_flags(DEV_FLAGS_CLEAR)
+                                          next_flags(DEV_FLAGS_CLEAR), name(_name), stats(nullptr)
     {
     };
 
@@ -164,9 +164,15 @@ struct xioDeviceWrapperBase {                // C++ base class for device primit
     virtual void flushRead() {};       // This should call _flushLine() before flushing the device.
     virtual bool flushToCommand() { return false; };
     virtual int16_t write(const char *buffer, int16_t len) { return -1; };
+    virtual int16_t writeStatusReport(const char *buffer, int16_t len) { return write(buffer, len); };
+    virtual bool writeFrame(const char *buffer, int16_t len) { return false; };
+    virtual void drainTX() {};         // push queued output to the device - must never block
 
     virtual char *readline(devflags_t limit_flags, uint16_t &size) { return nullptr; };
 
+    const char *name;                  // channel name reported by {"io0":n}, etc.
+    xioChannelStats *stats;            // set by the xio_t constructor - see xio_stats[]
+
 #if MARLIN_COMPAT_ENABLED == true
     virtual void exitFakeBootloaderMode() {};
 #endif
@@ -179,9 +185,15 @@ struct xio_t {
     xioDeviceWrapperBase* DeviceWrappers[DEV_MAX];
     const uint8_t _dev_count;
 
+    int8_t _last_data_dev = -1;        // device that the last line came from in the data pass
+    bool _planner_stalled = false;
+    uint32_t _stall_start_tick;
+
     template<typename... ds>
     xio_t(ds... args) : magic_start(MAGICNUM), DeviceWrappers {args...}, _dev_count(sizeof...(args)), magic_end(MAGICNUM) {
-
+        for (int8_t i = 0; i < _dev_count; ++i) {
+            DeviceWrappers[i]->stats = &xio_stats[i];
+        }
     };
 
     // ##### Connection management functions
@@ -252,8 +264,8 @@ struct xio_t {
      * 1) If a device fails to write the data, or all the data, then it's ignored
      * 2) Only the amount written by the *last* device to match (CTRL|ACTIVE) is returned.
      *
-     * In the current environment, these are not foreseen to cause trouble since these
-     * are blocking writes and we expect to only really be writing to one device.
+     * In the current environment, these are not foreseen to cause trouble since the devices
+     * queue the whole write (see xioTXQueue) and we expect to only really be writing to one device.
      */
     size_t write(const char *buffer, size_t size, bool only_to_muted)
     {
@@ -269,7 +281,10 @@ struct xio_t {
                 const char *buf = buffer;
                 int16_t to_write = size;
                 while (to_write > 0) {
-                    size_t written = DeviceWrappers[i]->write(buf, to_write);
+                    int16_t written = DeviceWrappers[i]->write(buf, to_write);
+                    if (written <= 0) {     // device went away - don't spin on it
+                        break;
+                    }
                     buf += written;
                     to_write -= written;
                     total_written += written;
@@ -279,6 +294,43 @@ struct xio_t {
         return total_written;
     }
 
+    /*
+     * writeStatusReport() - write a status report to the control device(s)
+     *
+     *  Unlike write(), a report that is still waiting to go out is replaced, not queued.
+     */
+    size_t writeStatusReport(const char *buffer, size_t size)
+    {
+        size_t total_written = -1;
+        for (int8_t i = 0; i < _dev_count; ++i) {
+            if (DeviceWrappers[i]->isCtrlAndActive()) {
+                total_written = DeviceWrappers[i]->writeStatusReport(buffer, size);
+            }
+        }
+        return total_written;
+    }
+
+    /*
+     * writeFrame() - queue a binary frame on one device, whatever its role - non-blocking
+     */
+    bool writeFrame(uint8_t dev, const char *buffer, size_t size)
+    {
+        if (dev >= _dev_count) {
+            return false;
+        }
+        return DeviceWrappers[dev]->writeFrame(buffer, size);
+    }
+
+    /*
+     * drainTX() - push queued output from all devices - non-blocking
+     */
+    void drainTX()
+    {
+        for (int8_t i = 0; i < _dev_count; ++i) {
+            DeviceWrappers[i]->drainTX();
+        }
+    }
+
     /*
      * writeline() - write a complete line to the controldevice
      *
@@ -365,6 +417,7 @@ struct xio_t {
             ret_buffer = DeviceWrappers[dev]->readline(DEV_IS_CTRL, size);
 
             if (size > 0) {
+                DeviceWrappers[dev]->stats->rx_lines++;
                 flags = DeviceWrappers[dev]->flags;
                 return ret_buffer;
             }
@@ -379,6 +432,8 @@ struct xio_t {
                 ret_buffer = DeviceWrappers[dev]->readline(limit_flags, size);
 
                 if (size > 0) {
+                    DeviceWrappers[dev]->stats->rx_lines++;
+                    _last_data_dev = dev;
                     flags = DeviceWrappers[dev]->flags;
                     return ret_buffer;
                 }
@@ -390,6 +445,22 @@ struct xio_t {
         return (NULL);
     };
 
+    /*
+     * plannerStalled() - time planner-full stalls and charge them to the data channel being read
+     */
+    void plannerStalled(bool stalled)
+    {
+        if (stalled == _planner_stalled) {
+            return;
+        }
+        _planner_stalled = stalled;
+        if (stalled) {
+            _stall_start_tick = SysTickTimer_getValue();
+        } else if (_last_data_dev >= 0) {
+            DeviceWrappers[_last_data_dev]->stats->planner_stall.add(SysTickTimer_getValue() - _stall_start_tick);
+        }
+    }
+
 #if MARLIN_COMPAT_ENABLED == true
     void exitFakeBootloaderMode() {
         for (int8_t i = 0; i < _dev_count; ++i) {
@@ -446,6 +517,43 @@ struct LineRXBuffer : RXBuffer<_size, owner_type, char> {
 
     uint16_t _lines_found;              // count of complete non-control lines that were found during scanning.
 
+    // Line dwell timing. Ticks are kept for the oldest _header_count pending lines. Once that
+    // fills, newer lines are only counted (_untimed_lines) until the timed ones are all read,
+    // which keeps the ticks in line order without a tick per buffer slot.
+    xioChannelStats *_stats = nullptr;
+    uint32_t _line_found_tick[_header_count];
+    uint8_t _tick_read_idx = 0;
+    uint8_t _tick_write_idx = 0;
+    uint8_t _timed_lines = 0;
+    uint16_t _untimed_lines = 0;
+
+    void _lineFound() {
+        _lines_found++;
+        if ((_timed_lines < _header_count) && (_untimed_lines == 0)) {
+            _line_found_tick[_tick_write_idx] = SysTickTimer_getValue();
+            _tick_write_idx = (_tick_write_idx + 1) & (_header_count-1);
+            _timed_lines++;
+        } else {
+            _untimed_lines++;
+        }
+    }
+
+    void _lineRead() {
+        --_lines_found;
+        if (_timed_lines > 0) {
+            _stats->line_dwell.add(SysTickTimer_getValue() - _line_found_tick[_tick_read_idx]);
+            _tick_read_idx = (_tick_read_idx + 1) & (_header_count-1);
+            _timed_lines--;
+        } else if (_untimed_lines > 0) {
+            _untimed_lines--;
+        }
+    }
+
+    void _clearLineTicks() {
+        _tick_read_idx = _tick_write_idx = _timed_lines = 0;
+        _untimed_lines = 0;
+    }
+
     volatile uint16_t _last_scan_offset;  // DIAGNOSTIC
 
     bool _last_returned_a_control = false;
@@ -758,6 +866,7 @@ struct LineRXBuffer : RXBuffer<_size, owner_type, char> {
             // bump the _scan_offset
             _scan_offset = _getNextScanOffset();
             _last_line_length++;
+            _stats->rx_bytes++;
 
             if (ends_line) {
                 // _scan_offset is now one past the end of the line,
@@ -787,14 +896,14 @@ struct LineRXBuffer : RXBuffer<_size, owner_type, char> {
                     }
                     return true;
                 } else {                // we did find one more line, though.
-                    _lines_found++;
+                    _lineFound();
                 }
             } // if ends_line
             else if (_last_line_length == (_line_buffer_size - 1)) {
                 // force an end-of-line, splitting this line into two lines
                 _ignore_until_next_line = true;
                 _line_start_offset = _scan_offset;
-                _lines_found++;
+                _lineFound();
             }
         } //while (_isMoreToScan())
 
@@ -937,7 +1046,7 @@ struct LineRXBuffer : RXBuffer<_size, owner_type, char> {
             *dst_ptr++ = '\n';
         }
 
-        --_lines_found;
+        _lineRead();
 
         _restartTransfer();
 
@@ -958,6 +1067,7 @@ struct LineRXBuffer : RXBuffer<_size, owner_type, char> {
 
         // record that we have 0 lines (of data) in the buffer
         _lines_found = 0;
+        _clearLineTicks();
 
         // and clear out any skip sections we have
         while (!_skip_sections.isEmpty()) {
@@ -989,6 +1099,7 @@ struct LineRXBuffer : RXBuffer<_size, owner_type, char> {
 
         // record that we have 0 lines (of data) in the buffer
         _lines_found = 0;
+        _clearLineTicks();
 
         // and clear out any skip sections we have
         while (!_skip_sections.isEmpty()) {
@@ -1002,6 +1113,57 @@ struct LineRXBuffer : RXBuffer<_size, owner_type, char> {
 
 }; // LineRXBuffer
 
+// xioTXQueue sits in front of the Motate TXBuffer and holds output until the main loop drains it.
+// Writers never wait on the device unless the queue is completely full, small writes from one pass
+// of the main loop go out in a single TXBuffer write (one DMA transfer), and the whole thing is
+// only touched from the main loop, so no locking is needed. The device wrappers enforce that:
+// a write made from an interrupt handler is dropped (see _xio_in_interrupt()).
+
+static_assert(XIO_SR_SLOT_SIZE <= (XIO_TX_QUEUE_SIZE - XIO_TX_PACKET_SIZE),
+              "XIO_SR_SLOT_SIZE must fit in the TX queue behind a packet");
+
+static inline bool _xio_in_interrupt() { return (__get_IPSR() != 0); }
+
+template <uint16_t _size>
+struct xioTXQueue {
+    char _data[_size];
+    uint16_t _read_offset = 0;              // next byte to hand to the device
+    uint16_t _write_offset = 0;             // next free byte
+    uint16_t _count = 0;                    // bytes queued
+
+    uint16_t count() { return _count; };
+    uint16_t available() { return _size - _count; };
+    bool isEmpty() { return _count == 0; };
+
+    // copy in as much of the buffer as fits, return the number of bytes taken
+    uint16_t put(const char *buffer, uint16_t len) {
+        if (len > available()) {
+            len = available();
+        }
+        uint16_t first = std::min(len, uint16_t(_size - _write_offset));
+        memcpy(_data + _write_offset, buffer, first);
+        memcpy(_data, buffer + first, len - first);
+        _write_offset = (_write_offset + len) % _size;
+        _count += len;
+        return len;
+    };
+
+    // return the longest contiguous run of queued bytes (may be less than count() if wrapped)
+    uint16_t peek(const char *&buffer) {
+        buffer = _data + _read_offset;
+        return std::min(_count, uint16_t(_size - _read_offset));
+    };
+
+    void consume(uint16_t len) {
+        _read_offset = (_read_offset + len) % _size;
+        _count -= len;
+    };
+
+    void clear() {
+        _read_offset = _write_offset = _count = 0;
+    };
+};
+
 /* xioDeviceWrapper<typename Device>
  * Implements a xioDeviceWrapperBase around a Device. The Device must implement:
  *   For RXBuffer:
@@ -1023,8 +1185,12 @@ struct xioDeviceWrapper : xioDeviceWrapperBase {    // describes a device for re
     // TODO - make _buffer_size, _header_count, and _line_buffer_size configurable
     LineRXBuffer<1024, Device> _rx_buffer;
     TXBuffer<1024, Device> _tx_buffer;
+    xioTXQueue<XIO_TX_QUEUE_SIZE> _tx_queue;
+
+    char _sr_slot[XIO_SR_SLOT_SIZE];        // latest status report not yet moved to the TX queue
+    uint16_t _sr_length = 0;                // 0 if no report is waiting
 
-    xioDeviceWrapper(Device dev, uint8_t _caps) : xioDeviceWrapperBase(_caps), _dev{dev}, _rx_buffer{_dev}, _tx_buffer{_dev}
+    xioDeviceWrapper(Device dev, uint8_t _caps, const char *_name) : xioDeviceWrapperBase(_caps, _name), _dev{dev}, _rx_buffer{_dev}, _tx_buffer{_dev}
     {
 //        _dev->setDataAvailableCallback([&](const size_t &length) {
 //
@@ -1036,11 +1202,15 @@ struct xioDeviceWrapper : xioDeviceWrapperBase {    // describes a device for re
             connectedStateChanged(connected);
         });
 
+        _rx_buffer._stats = stats;
         _rx_buffer.init();
         _tx_buffer.init();
     };
 
     void flush() final {
+        stats->tx_dropped += _tx_queue.count() + _sr_length;
+        _tx_queue.clear();
+        _sr_length = 0;
         _tx_buffer.flush();
         return _dev->flush();
     }
@@ -1060,11 +1230,96 @@ struct xioDeviceWrapper : xioDeviceWrapperBase {    // describes a device for re
         return _rx_buffer.flushToCommand();
     }
 
+    // _pushTX() - hand as much queued output to the TXBuffer as it will take. Returns bytes moved.
+    uint16_t _pushTX() {
+        uint16_t total = 0;
+        const char *chunk;
+        uint16_t chunk_length;
+        while ((chunk_length = _tx_queue.peek(chunk)) > 0) {
+            int16_t written = _tx_buffer.write(chunk, chunk_length);
+            if (written <= 0) {
+                break;
+            }
+            _tx_queue.consume(written);
+            total += written;
+        }
+        return total;
+    }
+
+    // write() - queue the buffer. Only waits on the device if the queue is full.
     virtual int16_t write(const char *buffer, int16_t len) final {
         if (!isConnected()) {
             return -1;
         }
-        return _tx_buffer.write(buffer, len);
+        if (_xio_in_interrupt()) {
+            stats->tx_dropped += len;
+            return -1;
+        }
+        int16_t written = _tx_queue.put(buffer, len);
+        if (written < len) {
+            uint32_t start_tick = SysTickTimer_getValue();
+            stats->tx_overflows++;
+            while (written < len) {             // pseudo-blocking fallback - large dumps, help screens, etc.
+                _pushTX();
+                if (!isConnected()) {
+                    stats->tx_dropped += len - written;
+                    break;
+                }
+                written += _tx_queue.put(buffer + written, len - written);
+            }
+            stats->tx_backpressure.add(SysTickTimer_getValue() - start_tick);
+        }
+        if (_tx_queue.count() >= XIO_TX_PACKET_SIZE) {
+            _pushTX();
+        }
+        return written;
+    }
+
+    // writeFrame() - queue the whole buffer or none of it. Never waits on the device.
+    virtual bool writeFrame(const char *buffer, int16_t len) final {
+        if (!isConnected() || _xio_in_interrupt() || (len > _tx_queue.available())) {
+            return false;
+        }
+        _tx_queue.put(buffer, len);
+        if (_tx_queue.count() >= XIO_TX_PACKET_SIZE) {
+            _pushTX();
+        }
+        return true;
+    }
+
+    // writeStatusReport() - park the report in the SR slot, replacing any report still waiting there
+    virtual int16_t writeStatusReport(const char *buffer, int16_t len) final {
+        if (!isConnected()) {
+            return -1;
+        }
+        if (_xio_in_interrupt()) {
+            stats->tx_dropped += len;
+            return -1;
+        }
+        if (len > XIO_SR_SLOT_SIZE) {
+            return write(buffer, len);
+        }
+        if (_sr_length != 0) {
+            stats->sr_superseded++;
+        }
+        memcpy(_sr_slot, buffer, len);
+        _sr_length = len;
+        drainTX();
+        return len;
+    }
+
+    // drainTX() - called from the main loop. A parked status report only joins the queue once the
+    // host has caught up (less than a packet pending), so a slow host never accumulates stale reports.
+    virtual void drainTX() final {
+        if (!isConnected()) {
+            return;
+        }
+        _pushTX();
+        if ((_sr_length != 0) && (_tx_queue.count() < XIO_TX_PACKET_SIZE)) {
+            _tx_queue.put(_sr_slot, _sr_length);    // always fits, see the static_assert above xioTXQueue
+            _sr_length = 0;
+            _pushTX();
+        }
     }
 
     virtual char *readline(devflags_t limit_flags, uint16_t &size) final {
@@ -1200,7 +1455,7 @@ struct xioFlashFileDeviceWrapper : xioDeviceWrapperBase {    // describes a devi
 
     char _line_buffer[_line_buffer_size]; // hold exactly one line to return -- flash files are read-only, so we copy it
 
-    xioFlashFileDeviceWrapper() : xioDeviceWrapperBase(DEV_CAN_READ | DEV_IS_ALWAYS_BOTH)
+    xioFlashFileDeviceWrapper() : xioDeviceWrapperBase(DEV_CAN_READ | DEV_IS_ALWAYS_BOTH, "flash")
     {
     };
 
@@ -1265,24 +1520,286 @@ struct xioFlashFileDeviceWrapper : xioDeviceWrapperBase {    // describes a devi
         // null-terminate the string
         *dst_ptr = 0;
 
+        stats->rx_bytes += line_size + 1;
         cs.responses_suppressed = true;
         return _line_buffer;
     };
 };
 
+xioChannelStats xio_stats[DEV_MAX];
+
 xioFlashFileDeviceWrapper<> flashFileWrapper {};
 
+#if XIO_HAS_STORAGE == 1
+// Job files streamed from an xio_storage backend (SD card, SPI flash, host file).
+// Storage is read ahead into a ring one block per main loop pass (see fill(), called from
+// xio_callback()), and lines are assembled from the ring into _line_buffer. A line that is
+// only partly read ahead is kept in _line_buffer and finished on a later call.
+template<uint16_t _read_ahead_size = XIO_FILE_READ_AHEAD_SIZE, uint16_t _line_buffer_size = RX_BUFFER_SIZE>
+struct xioStorageFileDeviceWrapper : xioDeviceWrapperBase {    // describes a device for reading and writing
+    xio_storage *_storage = nullptr;
+
+    char _name[XIO_FILE_NAME_LEN] = "";
+    bool _is_open = false;                  // a file is selected
+    bool _is_running = false;               // ...and lines are being returned from it
+    bool _at_eof = false;                   // storage has returned everything - only the ring is left
+    int32_t _size = -1;                     // file size, if the backend knows it
+    int32_t _position = 0;                  // bytes consumed from the file by readline()
+
+    char _read_ahead[_read_ahead_size];
+    uint16_t _read_offset = 0;
+    uint16_t _write_offset = 0;
+    uint16_t _count = 0;                    // bytes in the read-ahead ring
+
+    char _line_buffer[_line_buffer_size];
+    uint16_t _line_length = 0;              // length of the (partial) line in _line_buffer
+
+    xioStorageFileDeviceWrapper() : xioDeviceWrapperBase(DEV_CAN_READ | DEV_IS_ALWAYS_BOTH, "file")
+    {
+    };
+
+    void init() {
+    };
+
+    void setStorage(xio_storage *storage) {
+        close();
+        _storage = storage;
+    }
+
+    bool select(const char *name) {
+        if ((nullptr == _storage) || _is_running) {
+            return false;
+        }
+        close();
+        if (!_storage->open(name)) {
+            return false;
+        }
+        strncpy(_name, name, XIO_FILE_NAME_LEN-1);
+        _name[XIO_FILE_NAME_LEN-1] = NUL;
+        _is_open = true;
+        _size = _storage->size();
+        fill();                             // prime the read-ahead so the first lines are ready
+        return true;
+    }
+
+    // Responses are suppressed from the first line returned after start(), not from start()
+    // itself, so the M24 or {"file":...} that started the job still gets its response.
+    bool start() {
+        if (!_is_open) {
+            return false;
+        }
+        _is_running = true;
+        setActive();
+        return true;
+    }
+
+    void pause() {
+        if (_is_running) {
+            cs.responses_suppressed = false;    // the host is talking to us again
+        }
+        _is_running = false;                // readline() returns nothing until start() is called again
+    }
+
+    void close() {
+        if (_is_open) {
+            _storage->close();
+        }
+        if (_is_running) {
+            cs.responses_suppressed = false;
+            clearActive();
+        }
+        _is_open = _is_running = _at_eof = false;
+        _name[0] = NUL;
+        _size = -1;
+        _position = 0;
+        _read_offset = _write_offset = _count = 0;
+        _line_length = 0;
+    }
+
+    // fill() - read one block from storage if the ring has room for it. Called from the main loop.
+    void fill() {
+        if (!_is_open || _at_eof) {
+            return;
+        }
+        uint16_t room = std::min(uint16_t(_read_ahead_size - _count), uint16_t(_read_ahead_size - _write_offset));
+        if (room < std::min(uint16_t(XIO_FILE_BLOCK_SIZE), uint16_t(_read_ahead_size - _write_offset))) {
+            return;                         // wait until a whole block fits (or the ring wraps)
+        }
+        int32_t length = _storage->read(_read_ahead + _write_offset, std::min(room, uint16_t(XIO_FILE_BLOCK_SIZE)));
+        if (length <= 0) {                  // end of file, or a read error - run out what we have
+            _at_eof = true;
+            return;
+        }
+        _write_offset = (_write_offset + length) % _read_ahead_size;
+        _count += length;
+        stats->rx_bytes += length;
+    }
+
+    void flush() final {
+        // nothing to do
+    }
+
+    void flushRead() final {
+        close();                            // flushing the job cancels it
+    }
+
+    bool flushToCommand() final {
+        close();
+        return false;
+    }
+
+    int16_t write(const char *buffer, int16_t len) final {
+        return -1;
+    }
+
+    char *readline(devflags_t limit_flags, uint16_t &line_size) final {
+        line_size = 0;
+        if (!_is_running) {
+            return nullptr;
+        }
+        if (_count == 0) {
+            fill();                         // don't wait for the callback if we've run dry
+        }
+        if (!(limit_flags & DEV_IS_DATA) &&
+            ((_line_length != 0) || (_count == 0) || !xio_is_control_char(_read_ahead[_read_offset]))) {
+            return nullptr;
+        }
+
+        while (true) {
+            while (_count > 0) {
+                char c = _read_ahead[_read_offset];
+                _read_offset = (_read_offset + 1) % _read_ahead_size;
+                _count--;
+                _position++;
+
+                if ((c == LF) || (c == CR)) {
+                    if (_line_length == 0) {    // skip blank lines and the LF of a CRLF pair
+                        continue;
+                    }
+                    return _returnLine(line_size);
+                }
+                if (_line_length < _line_buffer_size-1) {   // over-long lines are truncated
+                    _line_buffer[_line_length++] = c;
+                }
+            }
+            if (_at_eof) {
+                break;
+            }
+            // Finish a partial line now rather than returning nothing, which would let
+            // another channel's data in ahead of the rest of the job.
+            fill();
+            if ((_count == 0) && !_at_eof) {
+                return nullptr;             // backend had nothing yet - keep the partial line
+            }
+        }
+
+        if (_line_length != 0) {            // last line had no terminator
+            return _returnLine(line_size);
+        }
+        close();                            // all done sending this file, close it
+        return nullptr;
+    };
+
+    char *_returnLine(uint16_t &line_size) {
+        _line_buffer[_line_length] = NUL;
+        line_size = _line_length;
+        _line_length = 0;
+        cs.responses_suppressed = true;
+        return _line_buffer;
+    }
+};
+
+xioStorageFileDeviceWrapper<> storageFileWrapper {};
+#endif // XIO_HAS_STORAGE
+
+#if XIO_HAS_STDIO_STORAGE == 1
+// xio_storage on stdio, for host builds. Job files are plain files in XIO_STDIO_STORAGE_PATH.
+#include <cstdio>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#ifndef XIO_STDIO_STORAGE_PATH
+#define XIO_STDIO_STORAGE_PATH "."
+#endif
+
+struct xio_stdio_storage : xio_storage {
+    FILE *_file = nullptr;
+    int32_t _size = -1;
+
+    bool _path(char *path, const char *name) {
+        return (snprintf(path, 256, "%s/%s", XIO_STDIO_STORAGE_PATH, name) < 256);
+    }
+
+    bool open(const char *name) override {
+        char path[256];
+        struct stat st;
+        if (!_path(path, name) || (stat(path, &st) != 0) || ((_file = fopen(path, "rb")) == nullptr)) {
+            return false;
+        }
+        _size = st.st_size;
+        return true;
+    };
+
+    int32_t read(char *buffer, int32_t size) override {
+        size_t length = fread(buffer, 1, size, _file);
+        return ((length == 0) && ferror(_file)) ? -1 : length;
+    };
+
+    void close() override {
+        if (_file != nullptr) {
+            fclose(_file);
+            _file = nullptr;
+        }
+        _size = -1;
+    };
+
+    int32_t size() override { return _size; };
+
+    bool list(void (*callback)(const char *name, int32_t size)) override {
+        DIR *dir = opendir(XIO_STDIO_STORAGE_PATH);
+        if (dir == nullptr) {
+            return false;
+        }
+        char path[256];
+        struct stat st;
+        struct dirent *entry;
+        while ((entry = readdir(dir)) != nullptr) {
+            if (_path(path, entry->d_name) && (stat(path, &st) == 0) && S_ISREG(st.st_mode)) {
+                callback(entry->d_name, st.st_size);
+            }
+        }
+        closedir(dir);
+        return true;
+    };
+};
+
+xio_stdio_storage stdioStorage;
+#endif // XIO_HAS_STDIO_STORAGE
+
+#if XIO_HAS_HOST_SOCKET == 1
+// Serial-like device on a Unix-domain socket, for host builds. Connect with e.g. Resources/debug/stream_bench.py
+#include "host_socket.h"
+
+#ifndef XIO_HOST_SOCKET_PATH
+#define XIO_HOST_SOCKET_PATH "/tmp/g2core.sock"
+#endif
+
+HostSocketSerial SerialSocket {XIO_HOST_SOCKET_PATH};
+#endif // XIO_HAS_HOST_SOCKET
+
 // ALLOCATIONS
 // Declare a device wrapper class for SerialUSB and SerialUSB1
 #if XIO_HAS_USB == 1
 xioDeviceWrapper<decltype(&SerialUSB)> serialUSB0Wrapper {
     &SerialUSB,
-    (DEV_CAN_READ | DEV_CAN_WRITE | DEV_CAN_BE_CTRL | DEV_CAN_BE_DATA)
+    (DEV_CAN_READ | DEV_CAN_WRITE | DEV_CAN_BE_CTRL | DEV_CAN_BE_DATA),
+    "usb0"
 };
 #if USB_SERIAL_PORTS_EXPOSED == 2
 xioDeviceWrapper<decltype(&SerialUSB1)> serialUSB1Wrapper {
     &SerialUSB1,
-    (DEV_CAN_READ | DEV_CAN_WRITE | DEV_CAN_BE_CTRL | DEV_CAN_BE_DATA)
+    (DEV_CAN_READ | DEV_CAN_WRITE | DEV_CAN_BE_CTRL | DEV_CAN_BE_DATA),
+    "usb1"
 };
 #endif
 #endif // XIO_HAS_USB
@@ -1294,14 +1811,28 @@ constexpr devflags_t _serial0ExtraFlags = DEV_IS_ALWAYS_BOTH;
 #endif
 xioDeviceWrapper<decltype(&Serial)> serial0Wrapper {
     &Serial,
-    (DEV_CAN_READ | DEV_CAN_WRITE | _serial0ExtraFlags)
+    (DEV_CAN_READ | DEV_CAN_WRITE | _serial0ExtraFlags),
+    "uart"
 };
 #endif // XIO_HAS_UART
+#if XIO_HAS_HOST_SOCKET == 1
+xioDeviceWrapper<decltype(&SerialSocket)> serialSocketWrapper {
+    &SerialSocket,
+    (DEV_CAN_READ | DEV_CAN_WRITE | DEV_CAN_BE_CTRL | DEV_CAN_BE_DATA),
+    "sock"
+};
+#endif // XIO_HAS_HOST_SOCKET
 
 // Define the xio singleton (and initialize it to hold our two deviceWrappers)
 //xio_t xio = { &serialUSB0Wrapper, &serialUSB1Wrapper };
 xio_t xio = {
     &flashFileWrapper,
+#if XIO_HAS_STORAGE == 1
+    &storageFileWrapper,
+#endif
+#if XIO_HAS_HOST_SOCKET == 1
+    &serialSocketWrapper,
+#endif // XIO_HAS_HOST_SOCKET
 #if XIO_HAS_USB == 1
     &serialUSB0Wrapper,
 #if USB_SERIAL_PORTS_EXPOSED == 2
@@ -1330,6 +1861,9 @@ xio_t xio = {
 
 void xio_init()
 {
+#if XIO_HAS_STDIO_STORAGE == 1
+    xio_set_storage(&stdioStorage);     // a board may replace this from board_xio_init()
+#endif
     board_xio_init();
 
 #if XIO_HAS_USB == 1
@@ -1341,6 +1875,10 @@ void xio_init()
 #if XIO_HAS_UART == 1
     serial0Wrapper.init();
 #endif
+#if XIO_HAS_HOST_SOCKET == 1
+    serialSocketWrapper.init();
+    SerialSocket.begin();
+#endif
 }
 
 stat_t xio_test_assertions()
@@ -1377,6 +1915,46 @@ int16_t xio_writeline(const char *buffer, bool only_to_muted /*= false*/)
     return xio.writeline(buffer, only_to_muted);
 }
 
+/*
+ * xio_write_frame() - queue a binary frame on device dev (xio list order, as ioN) - never blocks
+ *
+ *  Returns false if the device isn't connected or can't take the whole frame right now.
+ */
+
+bool xio_write_frame(uint8_t dev, const char *buffer, size_t size)
+{
+    return xio.writeFrame(dev, buffer, size);
+}
+
+/*
+ * xio_write_status_report() - write a NUL terminated status report to the control device(s)
+ *
+ *  A report that has not been sent by the time the next one arrives is discarded (superseded).
+ */
+
+int16_t xio_write_status_report(const char *buffer)
+{
+    return xio.writeStatusReport(buffer, strlen(buffer));
+}
+
+/*
+ * xio_callback() - main loop callback to push queued output to the devices
+ *
+ *  Never returns EAGAIN - output must not hold up reading and planning commands.
+ */
+
+stat_t xio_callback()
+{
+#if XIO_HAS_HOST_SOCKET == 1
+    SerialSocket.periodic();            // no interrupts on the host - move socket data here
+#endif
+    xio.drainTX();
+#if XIO_HAS_STORAGE == 1
+    storageFileWrapper.fill();
+#endif
+    return (STAT_OK);
+}
+
 /*
  * write() - return true of the device is currently "connected" (there's a fair bit of interpretation)
  */
@@ -1394,6 +1972,68 @@ bool xio_send_file(xio_flash_file &file) {
     return flashFileWrapper.sendFile(file);
 }
 
+/*
+ * xio_set_storage()         - register the job file backend (call from board_xio_init())
+ * xio_has_storage()         - true if a backend has been registered
+ * xio_list_job_files()      - call back with the name and size of each file in storage
+ * xio_select_job_file()     - open a job file and start reading ahead - returns false if it can't be opened
+ * xio_start_job_file()      - run the selected job file, or resume a paused one
+ * xio_pause_job_file()      - stop returning lines from the job file (the file stays open)
+ * xio_job_file_progress()   - bytes consumed and file size (-1 if not known) of the selected file
+ */
+
+#if XIO_HAS_STORAGE == 1
+
+void xio_set_storage(xio_storage *storage) {
+    storageFileWrapper.setStorage(storage);
+}
+
+bool xio_has_storage() {
+    return (nullptr != storageFileWrapper._storage);
+}
+
+bool xio_list_job_files(void (*callback)(const char *name, int32_t size)) {
+    if (!xio_has_storage()) {
+        return false;
+    }
+    return storageFileWrapper._storage->list(callback);
+}
+
+bool xio_select_job_file(const char *name) {
+    return storageFileWrapper.select(name);
+}
+
+bool xio_start_job_file() {
+    return storageFileWrapper.start();
+}
+
+void xio_pause_job_file() {
+    storageFileWrapper.pause();
+}
+
+bool xio_job_file_progress(int32_t &position, int32_t &size) {
+    position = storageFileWrapper._position;
+    size = storageFileWrapper._size;
+    return storageFileWrapper._is_open;
+}
+
+#else // no job file storage on this board
+
+void xio_set_storage(xio_storage *storage) {}
+bool xio_has_storage() { return false; }
+bool xio_list_job_files(void (*callback)(const char *name, int32_t size)) { return false; }
+bool xio_select_job_file(const char *name) { return false; }
+bool xio_start_job_file() { return false; }
+void xio_pause_job_file() {}
+
+bool xio_job_file_progress(int32_t &position, int32_t &size) {
+    position = 0;
+    size = -1;
+    return false;
+}
+
+#endif // XIO_HAS_STORAGE
+
 /*
  * xio_flush_to_command() - clear the last read channel up until the command that was read
  */
@@ -1448,6 +2088,104 @@ int _write( int file, char *ptr, int len )
 //    return (STAT_OK);
 //}
 
+/*
+ * xio_get_file() - get name of the selected job file ("" if none)
+ * xio_set_file() - select a job file and run it, e.g. {"file":"part1.nc"}
+ */
+
+stat_t xio_get_file(nvObj_t *nv)
+{
+#if XIO_HAS_STORAGE == 1
+    ritorno(nv_copy_string(nv, storageFileWrapper._name));
+#else
+    ritorno(nv_copy_string(nv, ""));
+#endif
+    nv->valuetype = TYPE_STRING;
+    return (STAT_OK);
+}
+
+stat_t xio_set_file(nvObj_t *nv)
+{
+    if (nv->valuetype != TYPE_STRING) {
+        return (STAT_UNSUPPORTED_TYPE);
+    }
+#if XIO_HAS_STORAGE == 1
+    if (storageFileWrapper._is_running) {
+        return (STAT_COMMAND_NOT_ACCEPTED);
+    }
+#endif
+    if (!xio_select_job_file(*nv->stringp)) {
+        return (STAT_FILE_NOT_OPEN);
+    }
+    xio_start_job_file();
+    return (STAT_OK);
+}
+
+/*
+ * xio_get_txo() - get TX queue overflow count, summed across devices
+ * xio_get_txd() - get TX bytes dropped, summed across devices
+ * xio_get_txs() - get status reports superseded, summed across devices
+ */
+
+static stat_t _get_tx_stat(nvObj_t *nv, uint32_t xioChannelStats::*stat)
+{
+    uint32_t total = 0;
+    for (uint8_t i = 0; i < xio._dev_count; ++i) {
+        total += xio_stats[i].*stat;
+    }
+    nv->value_int = total;
+    nv->valuetype = TYPE_INTEGER;
+    return (STAT_OK);
+}
+
+stat_t xio_get_txo(nvObj_t *nv) { return (_get_tx_stat(nv, &xioChannelStats::tx_overflows)); }
+stat_t xio_get_txd(nvObj_t *nv) { return (_get_tx_stat(nv, &xioChannelStats::tx_dropped)); }
+stat_t xio_get_txs(nvObj_t *nv) { return (_get_tx_stat(nv, &xioChannelStats::sr_superseded)); }
+
+/*
+ * xio_get_nm()      - get the name of the channel whose xio_stats[] entry is the target
+ * xio_get_hist()    - get a histogram as an array of bucket counts, e.g. "io2dw":[10,4,1,0,...]
+ * xio_clr_stats()   - clear statistics for all channels, e.g. {"ioclr":t}
+ * xio_planner_stalled() - called by the controller each time it checks for a free planner buffer
+ */
+
+stat_t xio_get_nm(nvObj_t *nv)
+{
+    uint8_t dev = (xioChannelStats *)GET_TABLE_WORD(target) - xio_stats;
+    ritorno(nv_copy_string(nv, (dev < xio._dev_count) ? xio.DeviceWrappers[dev]->name : ""));
+    nv->valuetype = TYPE_STRING;
+    return (STAT_OK);
+}
+
+stat_t xio_get_hist(nvObj_t *nv)
+{
+    xioHistogram *hist = (xioHistogram *)GET_TABLE_WORD(target);
+    char buffer[XIO_HISTOGRAM_BUCKETS * 11];
+    char *str = buffer;
+
+    for (uint8_t i = 0; i < XIO_HISTOGRAM_BUCKETS; i++) {
+        if (i != 0) {
+            *str++ = ',';
+        }
+        str += sprintf(str, "%lu", (unsigned long)hist->bucket[i]);
+    }
+    ritorno(nv_copy_string(nv, buffer));
+    nv->valuetype = TYPE_ARRAY;
+    return (STAT_OK);
+}
+
+stat_t xio_clr_stats(nvObj_t *nv)
+{
+    memset(xio_stats, 0, sizeof(xio_stats));
+    nv->valuetype = TYPE_NULL;
+    return (STAT_OK);
+}
+
+void xio_planner_stalled(bool stalled)
+{
+    xio.plannerStalled(stalled);
+}
+
 /***********************************************************************************
  * TEXT MODE SUPPORT
  * Functions to print variables from the cfgArray table
@@ -1456,6 +2194,12 @@ int _write( int file, char *ptr, int len )
 #ifdef __TEXT_MODE
 
 static const char fmt_spi[] = "[spi] SPI state%20d [0=disabled,1=enabled]\n";
+static const char fmt_txo[] = "[txo] TX queue overflows%11lu\n";
+static const char fmt_txd[] = "[txd] TX bytes dropped%13lu\n";
+static const char fmt_txs[] = "[txs] status reports superseded%4lu\n";
 void xio_print_spi(nvObj_t *nv) { text_print(nv, fmt_spi);} // TYPE_INT
+void xio_print_txo(nvObj_t *nv) { text_print(nv, fmt_txo);} // TYPE_INT
+void xio_print_txd(nvObj_t *nv) { text_print(nv, fmt_txd);} // TYPE_INT
+void xio_print_txs(nvObj_t *nv) { text_print(nv, fmt_txs);} // TYPE_INT
 
 #endif // __TEXT_MODE
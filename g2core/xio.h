@@ -98,6 +98,8 @@ enum xioDeviceEnum {                        // reconfigure this enum as you add
     DEV_UART1,                              // must be 2
 //  DEV_SPI0,                               // We can't have it here until we actually define it
     DEV_FLASH_FILE,                         // must be 0
+    DEV_STORAGE_FILE,                       // job file streamed from xio_storage
+    DEV_HOST_SOCKET,                        // Unix-domain socket in host builds
     DEV_MAX
 };
 
@@ -111,6 +113,62 @@ enum xioSPIMode {
 
 #define RX_BUFFER_SIZE       512            // maximum length of recieved lines from xio_readline
 
+/**** TX queue stuff *****/
+
+// Every serial device wrapper carries a TX queue and an SR slot on top of its 1K TX buffer,
+// so these come out of RAM once per device. A board may set its own in its pinout file.
+// The queues have a single writer - the main loop. Output from an interrupt is dropped.
+
+#ifndef XIO_TX_QUEUE_SIZE
+#define XIO_TX_QUEUE_SIZE   1024            // per-device output queue ahead of the (DMA) TX buffer
+#endif
+#define XIO_TX_PACKET_SIZE  64              // push to the device once this much is queued (one USB FS bulk packet)
+#ifndef XIO_SR_SLOT_SIZE
+#define XIO_SR_SLOT_SIZE    256             // largest status report that can be superseded (else it's queued)
+#endif
+
+/**** channel instrumentation *****/
+
+#define XIO_HISTOGRAM_BUCKETS 12            // [0]=0ms [1]=1ms [2]=2-3ms [3]=4-7ms ... [11]=1024ms and up
+
+struct xioHistogram {
+    uint32_t bucket[XIO_HISTOGRAM_BUCKETS];
+
+    void add(uint32_t ms) {
+        uint8_t i = 0;
+        while ((ms != 0) && (i < XIO_HISTOGRAM_BUCKETS-1)) {
+            ms >>= 1;
+            i++;
+        }
+        bucket[i]++;
+    };
+};
+
+struct xioChannelStats {                    // one per device, in xio device list order
+    uint32_t rx_bytes;                      // bytes received
+    uint32_t rx_lines;                      // lines (data and control) returned by readline
+    uint32_t tx_overflows;                  // times a write found the TX queue full and had to wait
+    uint32_t tx_dropped;                    // bytes discarded (disconnect, flush, or written from an interrupt)
+    uint32_t sr_superseded;                 // status reports replaced by a newer one before they were sent
+    xioHistogram line_dwell;                // time complete data lines waited in the RX buffer
+    xioHistogram planner_stall;             // planner-full stalls while this was the data channel being read
+    xioHistogram tx_backpressure;           // time writes waited on a full TX queue
+};
+
+extern xioChannelStats xio_stats[DEV_MAX];  // indexed as the ioN groups: io0 is the first device in the list
+
+/**** job file stuff *****/
+
+// A board that registers an xio_storage backend sets XIO_HAS_STORAGE 1 in its pinout file.
+// Without it the job file device and its read-ahead ring are compiled out.
+#ifndef XIO_HAS_STORAGE
+#define XIO_HAS_STORAGE 0
+#endif
+
+#define XIO_FILE_READ_AHEAD_SIZE 4096       // job file read-ahead buffer
+#define XIO_FILE_BLOCK_SIZE      512        // bytes read from storage per main loop pass (one SD sector)
+#define XIO_FILE_NAME_LEN        32         // longest job file name, including NUL
+
 /**** function prototypes ****/
 
 void xio_init(void);
@@ -119,6 +177,9 @@ stat_t xio_test_assertions(void);
 size_t xio_write(const char *buffer, size_t size, bool only_to_muted = false);
 char *xio_readline(devflags_t &flags, uint16_t &size);
 int16_t xio_writeline(const char *buffer, bool only_to_muted = false);
+int16_t xio_write_status_report(const char *buffer);
+bool xio_write_frame(uint8_t dev, const char *buffer, size_t size);
+stat_t xio_callback(void);
 bool xio_connected();
 void xio_flush_to_command();
 #if MARLIN_COMPAT_ENABLED == true
@@ -126,6 +187,13 @@ void xio_exit_fake_bootloader();
 #endif
 
 stat_t xio_set_spi(nvObj_t *nv);
+stat_t xio_get_txo(nvObj_t *nv);            // TX queue overflows (writer had to wait for the device)
+stat_t xio_get_txd(nvObj_t *nv);            // TX bytes dropped (discarded on disconnect or flush)
+stat_t xio_get_txs(nvObj_t *nv);            // status reports superseded before they were sent
+stat_t xio_get_nm(nvObj_t *nv);             // get channel name - target is &xio_stats[N]
+stat_t xio_get_hist(nvObj_t *nv);           // get a histogram as an array - target is an xioHistogram
+stat_t xio_clr_stats(nvObj_t *nv);          // clear all channel statistics
+void xio_planner_stalled(bool stalled);     // called from the controller when the planner is (not) full
 
 /**** newlib-nano support function(s) ****/
 extern "C" {
@@ -164,6 +232,17 @@ extern "C" {
 #define CHAR_CYCLE_START (char)'~'  // Feedhold Exit and Resume
 #define CHAR_QUEUE_FLUSH (char)'%'  // Feedhold Exit and Flush  
 
+/**** xio_is_control_char() - true if a line starting with c is a control (not data) line ****/
+
+inline bool xio_is_control_char(const char c) {
+    return ((c == '!')         ||
+            (c == '~')         ||
+            (c == ENQ)         ||             // request ENQ/ack
+            (c == CHAR_RESET)  ||             // ^X - reset (aka cancel, terminate)
+            (c == CHAR_ALARM)  ||             // ^D - request job kill (end of transmission)
+            (c == '%' && cm_has_hold()));     // flush (only in feedhold or part of control header)
+}
+
 /**** xio_flash_file - object to hold in-flash (compiled-in) "files" to run ****/
 
 struct xio_flash_file {
@@ -182,19 +261,8 @@ struct xio_flash_file {
         line_size = 0;
         if (_read_offset == _length) { return nullptr; }
 
-        if (control_only) {
-            char c = _data[_read_offset];
-            if (!
-                ((c == '!')         ||
-                 (c == '~')         ||
-                 (c == ENQ)         ||        // request ENQ/ack
-                 (c == CHAR_RESET)  ||        // ^X - reset (aka cancel, terminate)
-                 (c == CHAR_ALARM)  ||        // ^D - request job kill (end of transmission)
-                 (c == '%' && cm_has_hold())  // flush (only in feedhold or part of control header)
-                ))
-            {
-                return nullptr;
-            }
+        if (control_only && !xio_is_control_char(_data[_read_offset])) {
+            return nullptr;
         }
 
         const char *line_start = _data + _read_offset;
@@ -228,13 +296,52 @@ constexpr xio_flash_file make_xio_flash_file(const char (&data)[length]) {
 
 bool xio_send_file(xio_flash_file &file);
 
+/**** xio_storage - backing store for job files ****
+ *
+ *  A board with an SD card or SPI flash provides one of these, sets XIO_HAS_STORAGE, and
+ *  registers it with xio_set_storage() from board_xio_init(). The job file device streams
+ *  the selected file through a read-ahead buffer, so a job can run untethered. Host builds
+ *  set XIO_HAS_STDIO_STORAGE to serve plain files from XIO_STDIO_STORAGE_PATH.
+ *
+ *  On a board without storage these functions are stubs: the file list is empty, every
+ *  select fails and M21 reports "SD init fail".
+ *
+ *  These are called from the main loop only, one block at a time, so they may block briefly.
+ *  As with xioDeviceWrapperBase, don't use pure virtuals - but a backend overrides all of these.
+ */
+
+struct xio_storage {
+    virtual bool open(const char *name) { return false; };              // open for reading, true if OK
+    virtual int32_t read(char *buffer, int32_t size) { return -1; };   // bytes read, 0 at end of file, -1 on error
+    virtual void close() {};
+    virtual int32_t size() { return -1; };                              // size of the open file, -1 if unknown
+    virtual bool list(void (*callback)(const char *name, int32_t size)) { return false; };
+};
+
+void xio_set_storage(xio_storage *storage);
+bool xio_has_storage();
+bool xio_list_job_files(void (*callback)(const char *name, int32_t size));
+bool xio_select_job_file(const char *name);     // open the file and start the read-ahead
+bool xio_start_job_file();                      // run (or resume) the selected file
+void xio_pause_job_file();
+bool xio_job_file_progress(int32_t &position, int32_t &size);  // false if no file is selected
+
+stat_t xio_get_file(nvObj_t *nv);               // get name of the selected job file
+stat_t xio_set_file(nvObj_t *nv);               // select and run a job file
+
 #ifdef __TEXT_MODE
 
     void xio_print_spi(nvObj_t *nv);
+    void xio_print_txo(nvObj_t *nv);
+    void xio_print_txd(nvObj_t *nv);
+    void xio_print_txs(nvObj_t *nv);
 
 #else
 
     #define xio_print_spi tx_print_stub
+    #define xio_print_txo tx_print_stub
+    #define xio_print_txd tx_print_stub
+    #define xio_print_txs tx_print_stub
 
 #endif // __TEXT_MODE
 